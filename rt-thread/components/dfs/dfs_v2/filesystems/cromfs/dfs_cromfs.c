@@ -508,10 +508,12 @@ static void cromfs_dirent_cache_destroy(cromfs_info *ci)
 
 #ifdef RT_USING_PAGECACHE
 static ssize_t dfs_cromfs_page_read(struct dfs_file *file, struct dfs_page *page);
+static ssize_t dfs_cromfs_page_readpages(struct dfs_file *file, struct dfs_page **pages, size_t nr);
 
 static struct dfs_aspace_ops dfs_cromfs_aspace_ops =
 {
-    .read = dfs_cromfs_page_read
+    .read = dfs_cromfs_page_read,
+    .readpages = dfs_cromfs_page_readpages,
 };
 #endif
 
@@ -1329,6 +1331,13 @@ static ssize_t dfs_cromfs_page_read(struct dfs_file *file, struct dfs_page *page
 
     return ret;
 }
+
+static ssize_t dfs_cromfs_page_readpages(struct dfs_file *file, struct dfs_page **pages, size_t nr)
+{
+    off_t fpos = pages[0]->fpos;
+
+    return dfs_cromfs_read(file, pages[0]->page, pages[0]->size * nr, &fpos);
+}
 #endif
 
 static int dfs_cromfs_readlink(struct dfs_dentry *dentry, char *buf, int len)
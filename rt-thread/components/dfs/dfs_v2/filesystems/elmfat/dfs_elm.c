@@ -42,12 +42,14 @@ static int dfs_elm_truncate(struct dfs_file *file, off_t offset);
 
 #ifdef RT_USING_PAGECACHE
 static ssize_t dfs_elm_page_read(struct dfs_file *file, struct dfs_page *page);
+static ssize_t dfs_elm_page_readpages(struct dfs_file *file, struct dfs_page **pages, size_t nr);
 static ssize_t dfs_elm_page_write(struct dfs_page *page);
 
 static struct dfs_aspace_ops dfs_elm_aspace_ops =
 {
     .read = dfs_elm_page_read,
     .write = dfs_elm_page_write,
+    .readpages = dfs_elm_page_readpages,
 };
 #endif
 
@@ -1036,6 +1038,14 @@ static ssize_t dfs_elm_page_read(struct dfs_file *file, struct dfs_page *page)
     return ret;
 }
 
+static ssize_t dfs_elm_page_readpages(struct dfs_file *file, struct dfs_page **pages, size_t nr)
+{
+    off_t fpos = pages[0]->fpos;
+
+    /* whole sectors go straight into the pages with multi-sector reads */
+    return dfs_elm_read(file, pages[0]->page, pages[0]->size * nr, &fpos);
+}
+
 ssize_t dfs_elm_page_write(struct dfs_page *page)
 {
     FIL *fd;
@@ -34,12 +34,14 @@
 
 #ifdef RT_USING_PAGECACHE
 static ssize_t dfs_tmp_page_read(struct dfs_file *file, struct dfs_page *page);
+static ssize_t dfs_tmp_page_readpages(struct dfs_file *file, struct dfs_page **pages, size_t nr);
 static ssize_t dfs_tmp_page_write(struct dfs_page *page);
 
 static struct dfs_aspace_ops dfs_tmp_aspace_ops =
 {
     .read = dfs_tmp_page_read,
     .write = dfs_tmp_page_write,
+    .readpages = dfs_tmp_page_readpages,
 };
 #endif
 
@@ -806,6 +808,13 @@ static ssize_t dfs_tmp_page_read(struct dfs_file *file, struct dfs_page *page)
     return ret;
 }
 
+static ssize_t dfs_tmp_page_readpages(struct dfs_file *file, struct dfs_page **pages, size_t nr)
+{
+    off_t fpos = pages[0]->fpos;
+
+    return dfs_tmpfs_read(file, pages[0]->page, pages[0]->size * nr, &fpos);
+}
+
 ssize_t dfs_tmp_page_write(struct dfs_page *page)
 {
     off_t pos;
@@ -53,6 +53,9 @@ struct dfs_file_ops
     int (*flock)(struct dfs_file *file, int, struct file_lock *flock);
 };
 
+/* set by who caches something parsed from the file, cleared on write or truncate */
+#define DFS_VNODE_F_UNCHANGED   0x01
+
 struct dfs_vnode
 {
     uint32_t flags;
@@ -82,6 +85,14 @@ struct dfs_vnode
 
 /* file descriptor */
 #define DFS_FD_MAGIC 0xfdfd
+/* sequential access detection for the read-ahead of the page cache */
+struct dfs_ra_state
+{
+    off_t prev;                 /* end of the last access */
+    off_t end;                  /* end of the queued read-ahead */
+    size_t pages;               /* current read-ahead window */
+};
+
 struct dfs_file
 {
     uint16_t magic;
@@ -98,6 +109,7 @@ struct dfs_file
     struct dfs_vnode *vnode;    /* vnode of this file */
 
     void *mmap_context;         /* used by mmap routine */
+    struct dfs_ra_state ra;     /* read-ahead of read() */
 
     void *data;
 };
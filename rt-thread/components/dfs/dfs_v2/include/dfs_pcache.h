@@ -25,6 +25,7 @@ extern "C"
 
 struct rt_varea;
 struct rt_aspace;
+struct rt_memcg;
 struct dfs_vnode;
 struct dfs_dentry;
 struct dfs_aspace;
@@ -42,6 +43,8 @@ struct dfs_page
     rt_list_t dirty_node;
     struct util_avl_struct avl_node;
     rt_list_t mmap_head;
+    rt_list_t lru_node;         /* on the global 2Q lists */
+    int lru;
 
     rt_atomic_t ref_count;
 
@@ -53,12 +56,18 @@ struct dfs_page
     rt_tick_t tick_ms;
 
     struct dfs_aspace *aspace;
+    struct rt_memcg *memcg;     /* memory group charged, with a reference */
 };
 
 struct dfs_aspace_ops
 {
     ssize_t (*read)(struct dfs_file *file, struct dfs_page *page);
     ssize_t (*write)(struct dfs_page *page);
+    /*
+     * optional, read nr pages of a contiguous file range in one request. The
+     * buffers of the pages are virtually contiguous, starting at pages[0]->page.
+     */
+    ssize_t (*readpages)(struct dfs_file *file, struct dfs_page **pages, size_t nr);
 };
 
 struct dfs_aspace
@@ -66,6 +75,7 @@ struct dfs_aspace
     rt_list_t hash_node, cache_node;
     char *fullpath, *pathname;
     struct dfs_mnt *mnt;
+    uint32_t key;               /* identity of the file in the ghost entries */
 
     rt_list_t list_active, list_inactive;
     rt_list_t list_dirty;
@@ -74,6 +84,8 @@ struct dfs_aspace
     struct util_avl_root avl_root;
     struct dfs_page *avl_page;
 
+    struct dfs_ra_state ra; /* read-ahead of the faults */
+
     rt_bool_t is_active;
 
     struct rt_mutex lock;
@@ -87,6 +99,18 @@ struct dfs_aspace
 #define RT_PAGECACHE_HASH_NR   1024
 #endif
 
+#ifndef RT_PAGECACHE_GHOST_HASH_NR
+#define RT_PAGECACHE_GHOST_HASH_NR  256
+#endif
+
+/* a page recently evicted from the first-in list, remembered by identity only */
+struct dfs_pcache_ghost
+{
+    rt_list_t hash_node;
+    uint32_t key;
+    off_t index;
+};
+
 struct dfs_pcache
 {
     rt_list_t head[RT_PAGECACHE_HASH_NR];
@@ -95,6 +119,20 @@ struct dfs_pcache
     struct rt_mutex lock;
     struct rt_messagequeue *mqueue;
     rt_tick_t last_time_wb;
+
+    /*
+     * 2Q replacement over all aspaces: the pages referenced once are kept in
+     * the FIFO lru_in, the pages referenced again after being evicted from it
+     * are kept in the LRU lru_main. A scan only churns lru_in.
+     */
+    struct rt_spinlock lru_lock;
+    rt_list_t lru_in, lru_main;
+    size_t in_count, main_count;
+    struct dfs_pcache_ghost *ghost;
+    size_t ghost_nr, ghost_next;
+    rt_list_t ghost_head[RT_PAGECACHE_GHOST_HASH_NR];
+
+    rt_atomic_t hits, misses, evictions, ghost_hits;
 };
 
 struct dfs_aspace *dfs_aspace_create(struct dfs_dentry *dentry, struct dfs_vnode *vnode, const struct dfs_aspace_ops *ops);
@@ -105,7 +143,7 @@ int dfs_aspace_write(struct dfs_file *file, const void *buf, size_t count, off_t
 int dfs_aspace_flush(struct dfs_aspace *aspace);
 int dfs_aspace_clean(struct dfs_aspace *aspace);
 
-void *dfs_aspace_mmap(struct dfs_file *file, struct rt_varea *varea, void *vaddr);
+void *dfs_aspace_mmap(struct dfs_file *file, struct rt_varea *varea, void *vaddr, rt_bool_t *major);
 int dfs_aspace_unmap(struct dfs_file *file, struct rt_varea *varea);
 int dfs_aspace_page_unmap(struct dfs_file *file, struct rt_varea *varea, void *vaddr);
 int dfs_aspace_page_dirty(struct dfs_file *file, struct rt_varea *varea, void *vaddr);
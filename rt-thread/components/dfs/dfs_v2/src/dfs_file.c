@@ -557,6 +557,7 @@ int dfs_file_open(struct dfs_file *file, const char *path, int oflags, mode_t mo
                         }
 #endif
                         ret = file->fops->truncate(file, 0);
+                        file->vnode->flags &= ~DFS_VNODE_F_UNCHANGED;
                     }
                     else
                     {
@@ -764,6 +765,7 @@ ssize_t dfs_file_pwrite(struct dfs_file *file, const void *buf, size_t len, off_
                     {
                         ret = file->fops->write(file, buf, len, &pos);
                     }
+                    file->vnode->flags &= ~DFS_VNODE_F_UNCHANGED;
 
                     if (file->flags & O_SYNC)
                     {
@@ -830,6 +832,7 @@ ssize_t dfs_file_write(struct dfs_file *file, const void *buf, size_t len)
                     {
                         ret = file->fops->write(file, buf, len, &pos);
                     }
+                    file->vnode->flags &= ~DFS_VNODE_F_UNCHANGED;
 
                     if (file->flags & O_SYNC)
                     {
@@ -1652,6 +1655,7 @@ int dfs_file_ftruncate(struct dfs_file *file, off_t length)
                 }
 #endif
                 ret = file->fops->truncate(file, length);
+                file->vnode->flags &= ~DFS_VNODE_F_UNCHANGED;
             }
             else
             {
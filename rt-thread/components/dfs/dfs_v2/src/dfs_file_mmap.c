@@ -105,7 +105,7 @@ static void on_page_fault(struct rt_varea *varea, struct rt_aspace_fault_msg *ms
             LOG_I("file: %s%s", file->dentry->mnt->fullpath, file->dentry->pathname);
         }
 
-        page = dfs_aspace_mmap(file, varea, msg->fault_vaddr);
+        page = dfs_aspace_mmap(file, varea, msg->fault_vaddr, &msg->response.major);
         if (page)
         {
             msg->response.status = MM_FAULT_STATUS_OK_MAPPED;
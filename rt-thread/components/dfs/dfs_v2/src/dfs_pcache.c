@@ -16,6 +16,7 @@
 #include "dfs_pcache.h"
 #include "dfs_dentry.h"
 #include "dfs_mnt.h"
+#include "mm_memcg.h"
 #include "mm_page.h"
 #include <mmu.h>
 #include <tlb.h>
@@ -44,8 +45,34 @@
 #define RT_PAGECACHE_GC_STOP_LEVEL  70
 #endif
 
+#ifndef RT_PAGECACHE_FAULT_AROUND
+#define RT_PAGECACHE_FAULT_AROUND   16
+#endif
+
+#ifndef RT_PAGECACHE_READAHEAD_MAX
+#define RT_PAGECACHE_READAHEAD_MAX  64
+#endif
+
+#ifndef RT_PAGECACHE_READ_BATCH
+#define RT_PAGECACHE_READ_BATCH     32
+#endif
+
+#ifndef RT_PAGECACHE_LRU_IN_LEVEL
+#define RT_PAGECACHE_LRU_IN_LEVEL   25
+#endif
+
+#ifndef RT_PAGECACHE_GHOST_LEVEL
+#define RT_PAGECACHE_GHOST_LEVEL    50
+#endif
+
+#define PCACHE_LRU_NONE 0
+#define PCACHE_LRU_IN   1
+#define PCACHE_LRU_MAIN 2
+
 #define PCACHE_MQ_GC    1
 #define PCACHE_MQ_WB    2
+#define PCACHE_MQ_RA    3
+#define PCACHE_MQ_MEMCG 4
 
 struct dfs_aspace_mmap_obj
 {
@@ -60,9 +87,22 @@ struct dfs_pcache_mq_obj
 {
     struct rt_mailbox *ack;
     rt_uint32_t cmd;
+
+    /* PCACHE_MQ_RA */
+    struct dfs_file *file;
+    off_t fpos;
+    size_t count;
+
+    /* PCACHE_MQ_MEMCG, with count */
+    struct rt_memcg *memcg;
 };
 
-static struct dfs_page *dfs_page_lookup(struct dfs_file *file, off_t pos);
+static struct dfs_page *dfs_page_lookup(struct dfs_file *file, off_t pos, size_t nr, rt_bool_t *loaded);
+static struct dfs_page *dfs_page_search(struct dfs_aspace *aspace, off_t fpos);
+static struct dfs_page *dfs_aspace_load_page(struct dfs_file *file, off_t pos);
+static size_t dfs_aspace_load_pages(struct dfs_file *file, off_t pos, size_t nr);
+static void dfs_aspace_readahead(struct dfs_file *file, struct dfs_ra_state *ra,
+                                 off_t start, off_t end, size_t init);
 static void dfs_page_ref(struct dfs_page *page);
 static int dfs_page_inactive(struct dfs_page *page);
 static int dfs_page_remove(struct dfs_page *page);
@@ -77,87 +117,207 @@ static int dfs_aspace_unlock(struct dfs_aspace *aspace);
 static int dfs_pcache_lock(void);
 static int dfs_pcache_unlock(void);
 
+static struct dfs_page *_dfs_page_find(struct dfs_aspace *aspace, off_t fpos);
+
 
 static struct dfs_pcache __pcache;
 
 
-static int dfs_aspace_gc(struct dfs_aspace *aspace, int count)
+static struct dfs_pcache_ghost *dfs_pcache_ghost_find(uint32_t key, off_t index)
 {
-    int cnt = count;
+    struct dfs_pcache_ghost *ghost;
 
-    if (aspace)
+    rt_list_for_each_entry(ghost, &__pcache.ghost_head[(key ^ index) & (RT_PAGECACHE_GHOST_HASH_NR - 1)], hash_node)
     {
-        dfs_aspace_lock(aspace);
-
-        if (aspace->pages_count > 0)
+        if (ghost->key == key && ghost->index == index)
         {
-            struct dfs_page *page = RT_NULL;
-            rt_list_t *node = aspace->list_inactive.next;
+            return ghost;
+        }
+    }
 
-            while (cnt && node != &aspace->list_active)
-            {
-                page = rt_list_entry(node, struct dfs_page, space_node);
-                node = node->next;
-                if (dfs_page_remove(page) == 0)
-                {
-                    cnt --;
-                }
-            }
+    return RT_NULL;
+}
 
-            node = aspace->list_active.next;
-            while (cnt && node != &aspace->list_inactive)
-            {
-                page = rt_list_entry(node, struct dfs_page, space_node);
-                node = node->next;
-                if (dfs_page_remove(page) == 0)
-                {
-                    cnt --;
-                }
-            }
-        }
+/* remember a page evicted from lru_in, recycling the oldest ghost */
+static void dfs_pcache_ghost_add(uint32_t key, off_t index)
+{
+    struct dfs_pcache_ghost *ghost;
 
-        dfs_aspace_unlock(aspace);
+    if (__pcache.ghost_nr == 0)
+    {
+        return;
     }
 
-    return count - cnt;
+    rt_spin_lock(&__pcache.lru_lock);
+    ghost = &__pcache.ghost[__pcache.ghost_next];
+    __pcache.ghost_next = (__pcache.ghost_next + 1) % __pcache.ghost_nr;
+    if (ghost->hash_node.next != RT_NULL)
+    {
+        rt_list_remove(&ghost->hash_node);
+    }
+    ghost->key = key;
+    ghost->index = index;
+    rt_list_insert_after(&__pcache.ghost_head[(key ^ index) & (RT_PAGECACHE_GHOST_HASH_NR - 1)], &ghost->hash_node);
+    rt_spin_unlock(&__pcache.lru_lock);
 }
 
-void dfs_pcache_release(size_t count)
+/* a new page goes to lru_in, or to lru_main if it left lru_in recently */
+static void dfs_pcache_lru_add(struct dfs_page *page)
+{
+    struct dfs_pcache_ghost *ghost = RT_NULL;
+
+    rt_spin_lock(&__pcache.lru_lock);
+    if (__pcache.ghost_nr)
+    {
+        ghost = dfs_pcache_ghost_find(page->aspace->key, page->fpos / ARCH_PAGE_SIZE);
+    }
+    if (ghost)
+    {
+        rt_list_remove(&ghost->hash_node);
+        rt_list_insert_before(&__pcache.lru_main, &page->lru_node);
+        page->lru = PCACHE_LRU_MAIN;
+        __pcache.main_count ++;
+        rt_atomic_add(&(__pcache.ghost_hits), 1);
+    }
+    else
+    {
+        rt_list_insert_before(&__pcache.lru_in, &page->lru_node);
+        page->lru = PCACHE_LRU_IN;
+        __pcache.in_count ++;
+    }
+    rt_spin_unlock(&__pcache.lru_lock);
+}
+
+static void dfs_pcache_lru_del(struct dfs_page *page)
+{
+    rt_spin_lock(&__pcache.lru_lock);
+    if (page->lru == PCACHE_LRU_IN)
+    {
+        rt_list_remove(&page->lru_node);
+        __pcache.in_count --;
+    }
+    else if (page->lru == PCACHE_LRU_MAIN)
+    {
+        rt_list_remove(&page->lru_node);
+        __pcache.main_count --;
+    }
+    page->lru = PCACHE_LRU_NONE;
+    rt_spin_unlock(&__pcache.lru_lock);
+}
+
+/* the hits in lru_in are taken as correlated references and ignored */
+static void dfs_pcache_lru_hit(struct dfs_page *page)
+{
+    rt_spin_lock(&__pcache.lru_lock);
+    if (page->lru == PCACHE_LRU_MAIN)
+    {
+        rt_list_remove(&page->lru_node);
+        rt_list_insert_before(&__pcache.lru_main, &page->lru_node);
+    }
+    rt_spin_unlock(&__pcache.lru_lock);
+
+    rt_atomic_add(&(__pcache.hits), 1);
+}
+
+/**
+ * @brief Pick the next page to evict: the head of lru_in while it's over its
+ * share of the cache, otherwise the head of lru_main. The page is rotated to
+ * the tail, so that a page in use is passed over on the next pick.
+ *
+ * @note the caller holds the pcache lock, which keeps the aspace alive
+ *
+ * @return struct dfs_aspace* the aspace of the page, RT_NULL if the cache is empty
+ */
+static struct dfs_aspace *dfs_pcache_lru_victim(off_t *fpos)
+{
+    rt_list_t *head;
+    struct dfs_page *page;
+    struct dfs_aspace *aspace = RT_NULL;
+
+    rt_spin_lock(&__pcache.lru_lock);
+    if (__pcache.in_count > RT_PAGECACHE_COUNT * RT_PAGECACHE_LRU_IN_LEVEL / 100 || __pcache.main_count == 0)
+    {
+        head = &__pcache.lru_in;
+    }
+    else
+    {
+        head = &__pcache.lru_main;
+    }
+    if (!rt_list_isempty(head))
+    {
+        page = rt_list_first_entry(head, struct dfs_page, lru_node);
+        rt_list_remove(&page->lru_node);
+        rt_list_insert_before(head, &page->lru_node);
+        aspace = page->aspace;
+        *fpos = page->fpos;
+    }
+    rt_spin_unlock(&__pcache.lru_lock);
+
+    return aspace;
+}
+
+/* evict count pages over all aspaces, or only the clean pages charged to memcg */
+static size_t dfs_pcache_reclaim(struct rt_memcg *memcg, size_t count)
 {
     rt_list_t *node = RT_NULL;
     struct dfs_aspace *aspace = RT_NULL;
+    struct dfs_page *page;
+    size_t total = count;
+    size_t scan = rt_atomic_load(&(__pcache.pages_count));
+    off_t fpos = 0;
 
     dfs_pcache_lock();
 
-    if (count == 0)
+    while (count && scan --)
     {
-        count = rt_atomic_load(&(__pcache.pages_count)) - RT_PAGECACHE_COUNT * RT_PAGECACHE_GC_STOP_LEVEL / 100;
-    }
+        aspace = dfs_pcache_lru_victim(&fpos);
+        if (!aspace)
+        {
+            break;
+        }
 
-    node = __pcache.list_inactive.next;
-    while (count && node != &__pcache.list_active)
-    {
-        aspace = rt_list_entry(node, struct dfs_aspace, cache_node);
-        node = node->next;
-        if (aspace)
+        dfs_aspace_lock(aspace);
+        page = _dfs_page_find(aspace, fpos);
+        if (page && !(memcg && (page->memcg != memcg || page->is_dirty)))
         {
-            count -= dfs_aspace_gc(aspace, count);
-            dfs_aspace_release(aspace);
+            int lru = page->lru;
+            off_t index = page->fpos / ARCH_PAGE_SIZE;
+
+            if (dfs_page_remove(page) == 0)
+            {
+                if (lru == PCACHE_LRU_IN)
+                {
+                    dfs_pcache_ghost_add(aspace->key, index);
+                }
+                rt_atomic_add(&(__pcache.evictions), 1);
+                count --;
+            }
         }
+        dfs_aspace_unlock(aspace);
     }
 
-    node = __pcache.list_active.next;
-    while (count && node != &__pcache.list_inactive)
+    /* free the closed files left without pages */
+    node = __pcache.list_inactive.next;
+    while (node != &__pcache.list_active)
     {
         aspace = rt_list_entry(node, struct dfs_aspace, cache_node);
         node = node->next;
-        if (aspace)
-        {
-            count -= dfs_aspace_gc(aspace, count);
-        }
+        dfs_aspace_release(aspace);
     }
 
     dfs_pcache_unlock();
+
+    return total - count;
+}
+
+void dfs_pcache_release(size_t count)
+{
+    if (count == 0)
+    {
+        count = rt_atomic_load(&(__pcache.pages_count)) - RT_PAGECACHE_COUNT * RT_PAGECACHE_GC_STOP_LEVEL / 100;
+    }
+
+    dfs_pcache_reclaim(RT_NULL, count);
 }
 
 void dfs_pcache_unmount(struct dfs_mnt *mnt)
@@ -207,6 +367,59 @@ static int dfs_pcache_limit_check(void)
     return 0;
 }
 
+static void dfs_pcache_file_put(struct dfs_file *file)
+{
+    dfs_file_lock();
+    if (rt_atomic_load(&(file->ref_count)) == 1)
+    {
+        dfs_file_close(file);
+    }
+    else
+    {
+        rt_atomic_sub(&(file->ref_count), 1);
+    }
+    dfs_file_unlock();
+}
+
+static void dfs_pcache_readahead(struct dfs_file *file, off_t fpos, size_t count)
+{
+    struct dfs_aspace *aspace = file->vnode->aspace;
+
+    while (count)
+    {
+        size_t nr;
+        struct dfs_page *page;
+
+        /* read-ahead is speculative, never push the cache into reclaim for it */
+        if (rt_atomic_load(&(__pcache.pages_count)) >= RT_PAGECACHE_COUNT * RT_PAGECACHE_GC_WORK_LEVEL / 100)
+        {
+            break;
+        }
+
+        /* take the lock per batch so that the faulting threads are not held off */
+        dfs_aspace_lock(aspace);
+        page = dfs_page_search(aspace, fpos);
+        if (page)
+        {
+            dfs_page_release(page);
+            nr = 1;
+        }
+        else
+        {
+            nr = dfs_aspace_load_pages(file, fpos, count);
+        }
+        dfs_aspace_unlock(aspace);
+
+        if (!nr)
+        {
+            break;
+        }
+
+        fpos += nr * ARCH_PAGE_SIZE;
+        count -= nr > count ? count : nr;
+    }
+}
+
 static void dfs_pcache_thread(void *parameter)
 {
     struct dfs_pcache_mq_obj work;
@@ -219,6 +432,16 @@ static void dfs_pcache_thread(void *parameter)
             {
                 dfs_pcache_limit_check();
             }
+            else if (work.cmd == PCACHE_MQ_RA)
+            {
+                dfs_pcache_readahead(work.file, work.fpos, work.count);
+                dfs_pcache_file_put(work.file);
+            }
+            else if (work.cmd == PCACHE_MQ_MEMCG)
+            {
+                rt_memcg_reclaim_done(work.memcg, dfs_pcache_reclaim(work.memcg, work.count));
+                rt_memcg_put(work.memcg);
+            }
             else if (work.cmd == PCACHE_MQ_WB)
             {
                 int count = 0;
@@ -304,6 +527,26 @@ static void dfs_pcache_thread(void *parameter)
     }
 }
 
+#ifdef RT_USING_MM_MEMCG
+/* reclaim the clean pages of a memory group over its soft limit */
+static void dfs_pcache_mq_memcg_reclaim(struct rt_memcg *memcg, rt_size_t count)
+{
+    rt_err_t err;
+    struct dfs_pcache_mq_obj work = { 0 };
+
+    work.cmd = PCACHE_MQ_MEMCG;
+    work.memcg = rt_memcg_get(memcg);
+    work.count = count;
+
+    err = rt_mq_send_wait(__pcache.mqueue, (const void *)&work, sizeof(struct dfs_pcache_mq_obj), 0);
+    if (err != RT_EOK)
+    {
+        rt_memcg_reclaim_done(memcg, 0);
+        rt_memcg_put(memcg);
+    }
+}
+#endif /* RT_USING_MM_MEMCG */
+
 static int dfs_pcache_init(void)
 {
     rt_thread_t tid;
@@ -321,6 +564,20 @@ static int dfs_pcache_init(void)
 
     rt_mutex_init(&__pcache.lock, "pcache", RT_IPC_FLAG_PRIO);
 
+    rt_spin_lock_init(&__pcache.lru_lock);
+    rt_list_init(&__pcache.lru_in);
+    rt_list_init(&__pcache.lru_main);
+    for (int i = 0; i < RT_PAGECACHE_GHOST_HASH_NR; i++)
+    {
+        rt_list_init(&__pcache.ghost_head[i]);
+    }
+    __pcache.ghost_nr = RT_PAGECACHE_COUNT * RT_PAGECACHE_GHOST_LEVEL / 100;
+    __pcache.ghost = rt_calloc(__pcache.ghost_nr, sizeof(struct dfs_pcache_ghost));
+    if (!__pcache.ghost)
+    {
+        __pcache.ghost_nr = 0;
+    }
+
     __pcache.mqueue = rt_mq_create("pcache", sizeof(struct dfs_pcache_mq_obj), 1024, RT_IPC_FLAG_FIFO);
     tid = rt_thread_create("pcache", dfs_pcache_thread, 0, 8192, 25, 5);
     if (tid)
@@ -330,6 +587,8 @@ static int dfs_pcache_init(void)
 
     __pcache.last_time_wb = rt_tick_get_millisecond();
 
+    rt_memcg_reclaimer_set(dfs_pcache_mq_memcg_reclaim);
+
     return 0;
 }
 INIT_PREV_EXPORT(dfs_pcache_init);
@@ -346,6 +605,25 @@ static rt_ubase_t dfs_pcache_mq_work(rt_uint32_t cmd)
     return err;
 }
 
+static void dfs_pcache_mq_readahead(struct dfs_file *file, off_t fpos, size_t count)
+{
+    rt_err_t err;
+    struct dfs_pcache_mq_obj work = { 0 };
+
+    work.cmd = PCACHE_MQ_RA;
+    work.file = file;
+    work.fpos = fpos;
+    work.count = count;
+
+    /* the pcache thread holds the file until the read-ahead is done */
+    rt_atomic_add(&(file->ref_count), 1);
+    err = rt_mq_send_wait(__pcache.mqueue, (const void *)&work, sizeof(struct dfs_pcache_mq_obj), 0);
+    if (err != RT_EOK)
+    {
+        dfs_pcache_file_put(file);
+    }
+}
+
 static int dfs_pcache_lock(void)
 {
     rt_mutex_take(&__pcache.lock, RT_WAITING_FOREVER);
@@ -358,7 +636,7 @@ static int dfs_pcache_unlock(void)
     return 0;
 }
 
-static uint32_t dfs_aspace_hash(struct dfs_mnt *mnt, const char *path)
+static uint32_t dfs_aspace_key(struct dfs_mnt *mnt, const char *path)
 {
     uint32_t val = 0;
 
@@ -370,7 +648,12 @@ static uint32_t dfs_aspace_hash(struct dfs_mnt *mnt, const char *path)
         }
     }
 
-    return (val ^ (unsigned long)mnt) & (RT_PAGECACHE_HASH_NR - 1);
+    return val ^ (unsigned long)mnt;
+}
+
+static uint32_t dfs_aspace_hash(struct dfs_mnt *mnt, const char *path)
+{
+    return dfs_aspace_key(mnt, path) & (RT_PAGECACHE_HASH_NR - 1);
 }
 
 static struct dfs_aspace *dfs_aspace_hash_lookup(struct dfs_dentry *dentry, const struct dfs_aspace_ops *ops)
@@ -473,6 +756,7 @@ static struct dfs_aspace *_dfs_aspace_create(struct dfs_dentry *dentry,
             aspace->mnt = dentry->mnt;
             aspace->fullpath = rt_strdup(dentry->mnt->fullpath);
             aspace->pathname = rt_strdup(dentry->pathname);
+            aspace->key = dfs_aspace_key(dentry->mnt, dentry->pathname);
         }
 
         dfs_aspace_insert(aspace);
@@ -627,6 +911,10 @@ static int dfs_pcache_dump(int argc, char **argv)
     dfs_pcache_lock();
 
     rt_kprintf("total pages count: %d / %d\n", rt_atomic_load(&(__pcache.pages_count)), RT_PAGECACHE_COUNT);
+    rt_kprintf("2Q in: %d main: %d ghosts: %d\n", __pcache.in_count, __pcache.main_count, __pcache.ghost_nr);
+    rt_kprintf("hits: %d misses: %d evictions: %d ghost hits: %d\n",
+               rt_atomic_load(&(__pcache.hits)), rt_atomic_load(&(__pcache.misses)),
+               rt_atomic_load(&(__pcache.evictions)), rt_atomic_load(&(__pcache.ghost_hits)));
 
     rt_list_for_each(node, &__pcache.list_active)
     {
@@ -693,19 +981,25 @@ static int dfs_page_unmap(struct dfs_page *page)
     return 0;
 }
 
-static struct dfs_page *dfs_page_create(void)
+/* frame is the page frame to cache, RT_NULL to allocate one */
+static struct dfs_page *dfs_page_create(void *frame)
 {
     struct dfs_page *page = RT_NULL;
 
     page = rt_calloc(1, sizeof(struct dfs_page));
     if (page)
     {
-        page->page = rt_pages_alloc_ext(0, PAGE_ANY_AVAILABLE);
+        page->page = frame ? frame : rt_pages_alloc_ext(0, PAGE_ANY_AVAILABLE);
         if (page->page)
         {
             //memset(page->page, 0x00, ARCH_PAGE_SIZE);
             rt_list_init(&page->mmap_head);
             rt_atomic_store(&(page->ref_count), 1);
+
+            /* charged to the process loading it */
+            page->memcg = rt_memcg_get(rt_memcg_current());
+            rt_memcg_charge(page->memcg, RT_MEMCG_PCACHE, 1);
+            rt_memcg_check(page->memcg);
         }
         else
         {
@@ -755,6 +1049,8 @@ static void dfs_page_release(struct dfs_page *page)
 
         rt_pages_free(page->page, 0);
         page->page = RT_NULL;
+        rt_memcg_uncharge(page->memcg, RT_MEMCG_PCACHE, 1);
+        rt_memcg_put(page->memcg);
         rt_free(page);
     }
 
@@ -829,6 +1125,7 @@ static int dfs_page_insert(struct dfs_page *page)
     {
         RT_ASSERT(0);
     }
+    dfs_pcache_lru_add(page);
 
     if (aspace->pages_count > RT_PAGECACHE_ASPACE_COUNT)
     {
@@ -863,6 +1160,7 @@ static int dfs_page_remove(struct dfs_page *page)
             page->space_node.next = RT_NULL;
             aspace->pages_count--;
             _dfs_page_remove(aspace, page);
+            dfs_pcache_lru_del(page);
         }
         if (page->dirty_node.next != RT_NULL)
         {
@@ -936,23 +1234,13 @@ static int dfs_page_dirty(struct dfs_page *page)
     return 0;
 }
 
-static struct dfs_page *dfs_page_search(struct dfs_aspace *aspace, off_t fpos)
+/* the page at fpos, the caller holds the aspace lock */
+static struct dfs_page *_dfs_page_find(struct dfs_aspace *aspace, off_t fpos)
 {
     int cmp;
     struct dfs_page *page;
     struct util_avl_struct *avl_node;
 
-    dfs_aspace_lock(aspace);
-
-    if (aspace->avl_page && dfs_page_compare(fpos, aspace->avl_page->fpos) == 0)
-    {
-        page = aspace->avl_page;
-        dfs_page_active(page);
-        dfs_page_ref(page);
-        dfs_aspace_unlock(aspace);
-        return page;
-    }
-
     avl_node = aspace->avl_root.root_node;
     while (avl_node)
     {
@@ -969,17 +1257,41 @@ static struct dfs_page *dfs_page_search(struct dfs_aspace *aspace, off_t fpos)
         }
         else
         {
-            aspace->avl_page = page;
-            dfs_page_active(page);
-            dfs_page_ref(page);
-            dfs_aspace_unlock(aspace);
             return page;
         }
     }
 
+    return RT_NULL;
+}
+
+static struct dfs_page *dfs_page_search(struct dfs_aspace *aspace, off_t fpos)
+{
+    struct dfs_page *page;
+
+    dfs_aspace_lock(aspace);
+
+    if (aspace->avl_page && dfs_page_compare(fpos, aspace->avl_page->fpos) == 0)
+    {
+        page = aspace->avl_page;
+    }
+    else
+    {
+        page = _dfs_page_find(aspace, fpos);
+        if (page)
+        {
+            aspace->avl_page = page;
+        }
+    }
+
+    if (page)
+    {
+        dfs_page_active(page);
+        dfs_page_ref(page);
+    }
+
     dfs_aspace_unlock(aspace);
 
-    return RT_NULL;
+    return page;
 }
 
 static struct dfs_page *dfs_aspace_load_page(struct dfs_file *file, off_t pos)
@@ -991,7 +1303,7 @@ static struct dfs_page *dfs_aspace_load_page(struct dfs_file *file, off_t pos)
         struct dfs_vnode *vnode = file->vnode;
         struct dfs_aspace *aspace = vnode->aspace;
 
-        page = dfs_page_create();
+        page = dfs_page_create(RT_NULL);
         if (page)
         {
             page->aspace = aspace;
@@ -1007,49 +1319,140 @@ static struct dfs_page *dfs_aspace_load_page(struct dfs_file *file, off_t pos)
     return page;
 }
 
-static struct dfs_page *dfs_page_lookup(struct dfs_file *file, off_t pos)
+/**
+ * @brief Load up to nr missing pages from pos on, stopping at the first cached
+ * page or at the end of the file. When the file system has readpages(), the
+ * pages are read into contiguous frames with a single request. The caller
+ * holds the aspace lock.
+ *
+ * @return the number of pages loaded
+ */
+static size_t dfs_aspace_load_pages(struct dfs_file *file, off_t pos, size_t nr)
 {
-    struct dfs_page *page = RT_NULL;
     struct dfs_aspace *aspace = file->vnode->aspace;
+    struct dfs_page *pages[RT_PAGECACHE_READ_BATCH];
+    off_t fpos = pos / ARCH_PAGE_SIZE * ARCH_PAGE_SIZE;
+    off_t fsize = file->vnode->size;
+    size_t count = 0, index;
+    char *frame = RT_NULL;
+    int order = 0;
+
+    if (nr > RT_PAGECACHE_READ_BATCH)
+    {
+        nr = RT_PAGECACHE_READ_BATCH;
+    }
+    /* the page at pos is loaded even past the end of the file */
+    if (fpos < fsize && nr > (size_t)((fsize - fpos + ARCH_PAGE_SIZE - 1) / ARCH_PAGE_SIZE))
+    {
+        nr = (fsize - fpos + ARCH_PAGE_SIZE - 1) / ARCH_PAGE_SIZE;
+    }
+    else if (fpos >= fsize || nr == 0)
+    {
+        nr = 1;
+    }
 
-    dfs_aspace_lock(aspace);
-    page = dfs_page_search(aspace, pos);
-    if (!page)
+    while (count < nr)
     {
-        int count = RT_PAGECACHE_PRELOAD;
-        struct dfs_page *tmp = RT_NULL;
-        off_t fpos = pos / ARCH_PAGE_SIZE * ARCH_PAGE_SIZE;
+        struct dfs_page *page = dfs_page_search(aspace, fpos + count * ARCH_PAGE_SIZE);
 
-        do
+        if (page)
         {
-            page = dfs_aspace_load_page(file, fpos);
-            if (page)
+            dfs_page_release(page);
+            break;
+        }
+        count ++;
+    }
+
+    if (count > 1 && aspace->ops->readpages)
+    {
+        while ((2ul << order) <= count)
+        {
+            order ++;
+        }
+        frame = rt_pages_alloc_ext(order, PAGE_ANY_AVAILABLE);
+    }
+
+    if (frame)
+    {
+        size_t batch = 1ul << order;
+
+        /* every frame of the batch is freed as a single page */
+        rt_pages_split(frame, order);
+        for (index = 0; index < batch; index ++)
+        {
+            pages[index] = dfs_page_create(frame + index * ARCH_PAGE_SIZE);
+            if (!pages[index])
             {
-                if (tmp == RT_NULL)
-                {
-                    tmp = page;
-                }
-                else
-                {
-                    dfs_page_release(page);
-                }
+                break;
             }
-            else
+            pages[index]->aspace = aspace;
+            pages[index]->size = ARCH_PAGE_SIZE;
+            pages[index]->fpos = fpos + index * ARCH_PAGE_SIZE;
+        }
+        for (count = index; index < batch; index ++)
+        {
+            rt_pages_free(frame + index * ARCH_PAGE_SIZE, 0);
+        }
+
+        if (count && aspace->ops->readpages(file, pages, count) < 0)
+        {
+            for (index = 0; index < count; index ++)
             {
-                break;
+                dfs_page_release(pages[index]);
             }
+            count = 0;
+        }
 
-            fpos += ARCH_PAGE_SIZE;
-            page = dfs_page_search(aspace, fpos);
-            if (page)
+        /* the pages are left in the cache with the reference of creation */
+        for (index = 0; index < count; index ++)
+        {
+            dfs_page_insert(pages[index]);
+        }
+    }
+
+    if (!frame || count == 0)
+    {
+        count = count > 1 ? count : 1;
+        for (index = 0; index < count; index ++)
+        {
+            struct dfs_page *page = dfs_aspace_load_page(file, fpos + index * ARCH_PAGE_SIZE);
+
+            if (!page)
             {
-                dfs_page_release(page);
+                break;
             }
-            count --;
+            dfs_page_release(page);
+        }
+        count = index;
+    }
+
+    return count;
+}
 
-        } while (count && page == RT_NULL);
+/* nr is the number of pages to load from pos on when the page at pos misses */
+static struct dfs_page *dfs_page_lookup(struct dfs_file *file, off_t pos, size_t nr, rt_bool_t *loaded)
+{
+    struct dfs_page *page = RT_NULL;
+    struct dfs_aspace *aspace = file->vnode->aspace;
+
+    dfs_aspace_lock(aspace);
+    page = dfs_page_search(aspace, pos);
+    if (loaded)
+    {
+        *loaded = page ? RT_FALSE : RT_TRUE;
+    }
+    if (page)
+    {
+        dfs_pcache_lru_hit(page);
+    }
+    else
+    {
+        rt_atomic_add(&(__pcache.misses), 1);
+        if (dfs_aspace_load_pages(file, pos, nr))
+        {
+            page = dfs_page_search(aspace, pos);
+        }
 
-        page = tmp;
         if (page)
         {
             dfs_aspace_unlock(aspace);
@@ -1084,12 +1487,20 @@ int dfs_aspace_read(struct dfs_file *file, void *buf, size_t count, off_t *pos)
 
         struct dfs_page *page;
         char *ptr = (char *)buf;
+        size_t nr;
 
         ret = 0;
 
+        /* the window grows with the size of the requests */
+        nr = (*pos % ARCH_PAGE_SIZE + count + ARCH_PAGE_SIZE - 1) / ARCH_PAGE_SIZE;
+        dfs_aspace_readahead(file, &file->ra, *pos, *pos + count,
+                             nr * 2 > RT_PAGECACHE_PRELOAD ? nr * 2 : RT_PAGECACHE_PRELOAD);
+
         while (count)
         {
-            page = dfs_page_lookup(file, *pos);
+            /* the rest of the request is loaded with the missing page */
+            nr = (*pos % ARCH_PAGE_SIZE + count + ARCH_PAGE_SIZE - 1) / ARCH_PAGE_SIZE;
+            page = dfs_page_lookup(file, *pos, nr > RT_PAGECACHE_PRELOAD ? nr : RT_PAGECACHE_PRELOAD, RT_NULL);
             if (page)
             {
                 off_t len;
@@ -1150,7 +1561,7 @@ int dfs_aspace_write(struct dfs_file *file, const void *buf, size_t count, off_t
 
         while (count)
         {
-            page = dfs_page_lookup(file, *pos);
+            page = dfs_page_lookup(file, *pos, RT_PAGECACHE_PRELOAD, RT_NULL);
             if (page)
             {
                 off_t len;
@@ -1272,57 +1683,191 @@ int dfs_aspace_clean(struct dfs_aspace *aspace)
     return 0;
 }
 
-void *dfs_aspace_mmap(struct dfs_file *file, struct rt_varea *varea, void *vaddr)
+static int dfs_page_map(struct dfs_page *page, struct rt_varea *varea, void *vaddr)
 {
-    void *ret = RT_NULL;
-    struct dfs_page *page;
+    int err = -RT_ENOMEM;
+    struct dfs_aspace *aspace = page->aspace;
+    struct dfs_mmap *map = (struct dfs_mmap *)rt_calloc(1, sizeof(struct dfs_mmap));
+
+    if (map)
+    {
+        void *pg_vaddr = page->page;
+        void *pg_paddr = rt_kmem_v2p(pg_vaddr);
+
+        err = rt_varea_map_range(varea, vaddr, pg_paddr, page->size);
+        if (err == RT_EOK)
+        {
+            /**
+             * Note: While the page is mapped into user area, the data writing into the page
+             * is not guaranteed to be visible for machines with the *weak* memory model and
+             * those Harvard architecture (especially for those ARM64) cores for their
+             * out-of-order pipelines of data buffer. Besides if the instruction cache in the
+             * L1 memory system is a VIPT cache, there are chances to have the alias matching
+             * entry if we reuse the same page frame and map it into the same virtual address
+             * of the previous one.
+             *
+             * That's why we have to do synchronization and cleanup manually to ensure that
+             * fetching of the next instruction can see the coherent data with the data cache,
+             * TLB, MMU, main memory, and all the other observers in the computer system.
+             */
+            rt_hw_cpu_dcache_ops(RT_HW_CACHE_FLUSH, vaddr, ARCH_PAGE_SIZE);
+            rt_hw_cpu_icache_ops(RT_HW_CACHE_INVALIDATE, vaddr, ARCH_PAGE_SIZE);
+
+            map->aspace = varea->aspace;
+            map->vaddr = vaddr;
+            dfs_aspace_lock(aspace);
+            rt_list_insert_after(&page->mmap_head, &map->mmap_node);
+            dfs_aspace_unlock(aspace);
+        }
+        else
+        {
+            rt_free(map);
+        }
+    }
+
+    return err;
+}
+
+/**
+ * @brief Map the pages around the fault address which are already in the page
+ * cache, so that the neighbouring accesses do not trap again. Nothing is read
+ * from the file system here.
+ */
+static void dfs_aspace_fault_around(struct dfs_file *file, struct rt_varea *varea, void *vaddr)
+{
+#if RT_PAGECACHE_FAULT_AROUND > 1
     struct dfs_aspace *aspace = file->vnode->aspace;
-    rt_aspace_t target_aspace = varea->aspace;
+    rt_ubase_t window = RT_PAGECACHE_FAULT_AROUND * ARCH_PAGE_SIZE;
+    char *start = (char *)((rt_ubase_t)vaddr / window * window);
+    char *end = start + window;
+    char *va;
 
-    page = dfs_page_lookup(file, dfs_aspace_fpos(varea, vaddr));
-    if (page)
+    if (start < (char *)varea->start)
     {
-        struct dfs_mmap *map = (struct dfs_mmap *)rt_calloc(1, sizeof(struct dfs_mmap));
-        if (map)
+        start = varea->start;
+    }
+    if (end > (char *)varea->start + varea->size)
+    {
+        end = (char *)varea->start + varea->size;
+    }
+
+    dfs_aspace_lock(aspace);
+    for (va = start; va < end; va += ARCH_PAGE_SIZE)
+    {
+        off_t fpos;
+        struct dfs_page *page;
+
+        /* a busy fault lock means the page is being fixed by its own fault */
+        if (va == vaddr || !rt_aspace_fault_trylock(varea->aspace, va))
+        {
+            continue;
+        }
+
+        fpos = dfs_aspace_fpos(varea, va);
+        if (fpos >= file->vnode->size)
+        {
+            rt_aspace_fault_unlock(varea->aspace, va);
+            break;
+        }
+
+        if (rt_hw_mmu_v2p(varea->aspace, va) == ARCH_MAP_FAILED)
         {
-            void *pg_vaddr = page->page;
-            void *pg_paddr = rt_kmem_v2p(pg_vaddr);
-            int err = rt_varea_map_range(varea, vaddr, pg_paddr, page->size);
-            if (err == RT_EOK)
+            page = dfs_page_search(aspace, fpos);
+            if (page)
             {
-                /**
-                 * Note: While the page is mapped into user area, the data writing into the page
-                 * is not guaranteed to be visible for machines with the *weak* memory model and
-                 * those Harvard architecture (especially for those ARM64) cores for their
-                 * out-of-order pipelines of data buffer. Besides if the instruction cache in the
-                 * L1 memory system is a VIPT cache, there are chances to have the alias matching
-                 * entry if we reuse the same page frame and map it into the same virtual address
-                 * of the previous one.
-                 *
-                 * That's why we have to do synchronization and cleanup manually to ensure that
-                 * fetching of the next instruction can see the coherent data with the data cache,
-                 * TLB, MMU, main memory, and all the other observers in the computer system.
-                 */
-                rt_hw_cpu_dcache_ops(RT_HW_CACHE_FLUSH, vaddr, ARCH_PAGE_SIZE);
-                rt_hw_cpu_icache_ops(RT_HW_CACHE_INVALIDATE, vaddr, ARCH_PAGE_SIZE);
-
-                ret = pg_vaddr;
-                map->aspace = target_aspace;
-                map->vaddr = vaddr;
-                dfs_aspace_lock(aspace);
-                rt_list_insert_after(&page->mmap_head, &map->mmap_node);
+                dfs_page_map(page, varea, va);
                 dfs_page_release(page);
-                dfs_aspace_unlock(aspace);
             }
-            else
+        }
+        rt_aspace_fault_unlock(varea->aspace, va);
+    }
+    dfs_aspace_unlock(aspace);
+#endif /* RT_PAGECACHE_FAULT_AROUND > 1 */
+}
+
+/**
+ * @brief Detect the sequential accesses of [start, end) and queue an
+ * asynchronous read-ahead to the pcache thread. The window starts at init
+ * pages and doubles on each sequential access up to RT_PAGECACHE_READAHEAD_MAX.
+ * It's refilled when less than half of it is left ahead of the access.
+ */
+static void dfs_aspace_readahead(struct dfs_file *file, struct dfs_ra_state *ra,
+                                 off_t start, off_t end, size_t init)
+{
+#if RT_PAGECACHE_READAHEAD_MAX > 0
+    struct dfs_aspace *aspace = file->vnode->aspace;
+    off_t window = RT_PAGECACHE_FAULT_AROUND * ARCH_PAGE_SIZE;
+    off_t fsize = (file->vnode->size + ARCH_PAGE_SIZE - 1) / ARCH_PAGE_SIZE * ARCH_PAGE_SIZE;
+    off_t base = start / ARCH_PAGE_SIZE * ARCH_PAGE_SIZE;
+    off_t ra_start = 0, ra_end = 0;
+
+    dfs_aspace_lock(aspace);
+    if (start >= ra->prev && start - ra->prev < window)
+    {
+        if (ra->pages == 0)
+        {
+            ra->pages = init;
+        }
+        else if (ra->pages < RT_PAGECACHE_READAHEAD_MAX)
+        {
+            ra->pages *= 2;
+        }
+        if (ra->pages > RT_PAGECACHE_READAHEAD_MAX)
+        {
+            ra->pages = RT_PAGECACHE_READAHEAD_MAX;
+        }
+
+        if (ra->end <= base + (off_t)(ra->pages * ARCH_PAGE_SIZE / 2))
+        {
+            /* the pages of the access itself are loaded synchronously */
+            ra_start = (end + ARCH_PAGE_SIZE - 1) / ARCH_PAGE_SIZE * ARCH_PAGE_SIZE;
+            ra_start = ra->end > ra_start ? ra->end : ra_start;
+            ra_end = base + ra->pages * ARCH_PAGE_SIZE;
+            if (ra_end > fsize)
             {
-                dfs_page_release(page);
-                rt_free(map);
+                ra_end = fsize;
+            }
+            if (ra_start < ra_end)
+            {
+                ra->end = ra_end;
             }
         }
-        else
+    }
+    else
+    {
+        ra->pages = 0;
+        ra->end = 0;
+    }
+    ra->prev = end;
+    dfs_aspace_unlock(aspace);
+
+    if (ra_start < ra_end)
+    {
+        dfs_pcache_mq_readahead(file, ra_start, (ra_end - ra_start) / ARCH_PAGE_SIZE);
+    }
+#endif /* RT_PAGECACHE_READAHEAD_MAX > 0 */
+}
+
+void *dfs_aspace_mmap(struct dfs_file *file, struct rt_varea *varea, void *vaddr, rt_bool_t *major)
+{
+    void *ret = RT_NULL;
+    struct dfs_page *page;
+    off_t fpos = dfs_aspace_fpos(varea, vaddr);
+
+    page = dfs_page_lookup(file, fpos, RT_PAGECACHE_PRELOAD, major);
+    if (page)
+    {
+        if (dfs_page_map(page, varea, vaddr) == RT_EOK)
         {
-            dfs_page_release(page);
+            ret = page->page;
+        }
+        dfs_page_release(page);
+
+        if (ret)
+        {
+            dfs_aspace_fault_around(file, varea, vaddr);
+            dfs_aspace_readahead(file, &file->vnode->aspace->ra, fpos, fpos + ARCH_PAGE_SIZE,
+                                 RT_PAGECACHE_FAULT_AROUND);
         }
     }
 
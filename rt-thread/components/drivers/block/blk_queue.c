@@ -0,0 +1,338 @@
+/*
+ * Copyright (c) 2006-2023, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2024-03-02     RTT          the first version
+ */
+
+#include <rthw.h>
+#include <rtthread.h>
+#include <rtdevice.h>
+
+#define DBG_TAG "blk.queue"
+#define DBG_LVL DBG_INFO
+#include <rtdbg.h>
+
+static rt_list_t _blk_queue_list = RT_LIST_OBJECT_INIT(_blk_queue_list);
+static struct rt_spinlock _blk_queue_lock = RT_SPINLOCK_INIT;
+
+struct rt_blk_queue *rt_blk_queue_create(rt_device_t dev, const struct rt_blk_queue_ops *ops,
+                                         rt_size_t sector_size, rt_uint32_t depth,
+                                         rt_uint32_t max_segments, rt_size_t max_sectors)
+{
+    struct rt_blk_queue *queue;
+    struct rt_blk_request *reqs;
+    /* twice the depth, so that the bios keep merging while the driver is busy */
+    rt_uint32_t nr = depth * 2;
+    rt_base_t level;
+
+    RT_ASSERT(ops && ops->submit && depth > 0 && max_segments > 0);
+
+    queue = rt_calloc(1, sizeof(struct rt_blk_queue) + nr * sizeof(struct rt_blk_request));
+    if (queue)
+    {
+        queue->dev = dev;
+        queue->ops = ops;
+        queue->sector_size = sector_size;
+        queue->depth = depth;
+        queue->max_segments = max_segments;
+        queue->max_sectors = max_sectors;
+
+        rt_spin_lock_init(&queue->lock);
+        rt_list_init(&queue->pending);
+        rt_list_init(&queue->free);
+        reqs = (struct rt_blk_request *)(queue + 1);
+        for (rt_uint32_t i = 0; i < nr; i++)
+        {
+            rt_list_insert_before(&queue->free, &reqs[i].node);
+        }
+        rt_sem_init(&queue->free_sem, "blkq", nr, RT_IPC_FLAG_FIFO);
+
+        level = rt_spin_lock_irqsave(&_blk_queue_lock);
+        rt_list_insert_before(&_blk_queue_list, &queue->node);
+        rt_spin_unlock_irqrestore(&_blk_queue_lock, level);
+    }
+
+    return queue;
+}
+
+void rt_blk_queue_delete(struct rt_blk_queue *queue)
+{
+    rt_base_t level;
+
+    if (queue)
+    {
+        RT_ASSERT(queue->inflight == 0 && rt_list_isempty(&queue->pending));
+
+        level = rt_spin_lock_irqsave(&_blk_queue_lock);
+        rt_list_remove(&queue->node);
+        rt_spin_unlock_irqrestore(&_blk_queue_lock, level);
+
+        rt_sem_detach(&queue->free_sem);
+        rt_free(queue);
+    }
+}
+
+struct rt_blk_queue *rt_blk_queue_get(rt_device_t dev)
+{
+    struct rt_blk_queue *queue = RT_NULL;
+
+    if (rt_device_control(dev, RT_DEVICE_CTRL_BLK_QUEUE, &queue) != RT_EOK)
+    {
+        queue = RT_NULL;
+    }
+
+    return queue;
+}
+
+static void _blk_queue_dispatch(struct rt_blk_queue *queue)
+{
+    struct rt_blk_request *req;
+    rt_base_t level;
+    rt_err_t err;
+
+    level = rt_spin_lock_irqsave(&queue->lock);
+
+    /* one dispatcher at a time, it picks up what the others queued meanwhile */
+    if (!queue->dispatching)
+    {
+        queue->dispatching = RT_TRUE;
+
+        while (queue->inflight < queue->depth && !queue->barrier && !rt_list_isempty(&queue->pending))
+        {
+            req = rt_list_first_entry(&queue->pending, struct rt_blk_request, node);
+            if (req->op == RT_BIO_FLUSH)
+            {
+                if (queue->inflight)
+                {
+                    break;
+                }
+                queue->barrier = RT_TRUE;
+            }
+            rt_list_remove(&req->node);
+            queue->inflight++;
+            queue->requests++;
+            rt_spin_unlock_irqrestore(&queue->lock, level);
+
+            err = queue->ops->submit(queue, req);
+            if (err != RT_EOK)
+            {
+                rt_blk_request_end(queue, req, err);
+            }
+
+            level = rt_spin_lock_irqsave(&queue->lock);
+        }
+
+        queue->dispatching = RT_FALSE;
+    }
+
+    rt_spin_unlock_irqrestore(&queue->lock, level);
+}
+
+/* merge the bio into a pending request, never across a flush */
+static rt_bool_t _blk_queue_merge(struct rt_blk_queue *queue, struct rt_bio *bio)
+{
+    rt_list_t *node;
+    struct rt_blk_request *req;
+    struct rt_bio *edge;
+    rt_bool_t contig;
+
+    if (bio->op == RT_BIO_FLUSH || bio->op == RT_BIO_DISCARD)
+    {
+        return RT_FALSE;
+    }
+
+    for (node = queue->pending.prev; node != &queue->pending; node = node->prev)
+    {
+        req = rt_list_entry(node, struct rt_blk_request, node);
+
+        if (req->op == RT_BIO_FLUSH)
+        {
+            break;
+        }
+        if (req->op != bio->op ||
+            (queue->max_sectors && req->count + bio->count > queue->max_sectors))
+        {
+            continue;
+        }
+
+        if (req->sector + req->count == bio->sector)
+        {
+            edge = rt_list_entry(req->bios.prev, struct rt_bio, node);
+            contig = (char *)edge->buffer + edge->count * queue->sector_size == bio->buffer;
+            if (contig || req->nr_segments < queue->max_segments)
+            {
+                rt_list_insert_before(&req->bios, &bio->node);
+                req->count += bio->count;
+                req->nr_segments += contig ? 0 : 1;
+                queue->merges++;
+                return RT_TRUE;
+            }
+        }
+        else if (bio->sector + bio->count == req->sector)
+        {
+            edge = rt_list_first_entry(&req->bios, struct rt_bio, node);
+            contig = (char *)bio->buffer + bio->count * queue->sector_size == edge->buffer;
+            if (contig || req->nr_segments < queue->max_segments)
+            {
+                rt_list_insert_after(&req->bios, &bio->node);
+                req->sector = bio->sector;
+                req->count += bio->count;
+                req->nr_segments += contig ? 0 : 1;
+                queue->merges++;
+                return RT_TRUE;
+            }
+        }
+    }
+
+    return RT_FALSE;
+}
+
+static void _bio_queue(struct rt_bio *bio)
+{
+    struct rt_blk_queue *queue = bio->queue;
+    struct rt_blk_request *req;
+    rt_base_t level;
+
+    level = rt_spin_lock_irqsave(&queue->lock);
+    queue->bios++;
+    if (_blk_queue_merge(queue, bio))
+    {
+        rt_spin_unlock_irqrestore(&queue->lock, level);
+        return;
+    }
+    rt_spin_unlock_irqrestore(&queue->lock, level);
+
+    if (rt_sem_trytake(&queue->free_sem) != RT_EOK)
+    {
+        /* the pending requests may be the ones to wait for */
+        _blk_queue_dispatch(queue);
+        rt_sem_take(&queue->free_sem, RT_WAITING_FOREVER);
+    }
+
+    level = rt_spin_lock_irqsave(&queue->lock);
+    if (_blk_queue_merge(queue, bio))
+    {
+        rt_spin_unlock_irqrestore(&queue->lock, level);
+        rt_sem_release(&queue->free_sem);
+        return;
+    }
+
+    req = rt_list_first_entry(&queue->free, struct rt_blk_request, node);
+    rt_list_remove(&req->node);
+    req->op = bio->op;
+    req->sector = bio->sector;
+    req->count = bio->count;
+    req->nr_segments = 1;
+    rt_list_init(&req->bios);
+    rt_list_insert_before(&req->bios, &bio->node);
+    rt_list_insert_before(&queue->pending, &req->node);
+    rt_spin_unlock_irqrestore(&queue->lock, level);
+}
+
+void rt_bio_submit(struct rt_bio *bio)
+{
+    RT_ASSERT(bio && bio->queue);
+    RT_DEBUG_NOT_IN_INTERRUPT;
+
+    bio->status = RT_EOK;
+    _bio_queue(bio);
+    _blk_queue_dispatch(bio->queue);
+}
+
+void rt_blk_request_end(struct rt_blk_queue *queue, struct rt_blk_request *req, rt_err_t status)
+{
+    struct rt_bio *bio, *next;
+    rt_base_t level;
+
+    rt_list_for_each_entry_safe(bio, next, &req->bios, node)
+    {
+        rt_list_remove(&bio->node);
+        bio->status = status;
+        if (bio->end_io)
+        {
+            bio->end_io(bio);
+        }
+    }
+
+    level = rt_spin_lock_irqsave(&queue->lock);
+    if (req->op == RT_BIO_FLUSH)
+    {
+        queue->barrier = RT_FALSE;
+    }
+    if (status != RT_EOK)
+    {
+        queue->errors++;
+    }
+    queue->inflight--;
+    rt_list_insert_after(&queue->free, &req->node);
+    rt_spin_unlock_irqrestore(&queue->lock, level);
+
+    rt_sem_release(&queue->free_sem);
+    _blk_queue_dispatch(queue);
+}
+
+static void _bio_end_sync(struct rt_bio *bio)
+{
+    rt_completion_done((struct rt_completion *)bio->private);
+}
+
+rt_ssize_t rt_blk_queue_rw(struct rt_blk_queue *queue, int op, rt_off_t sector, void *buffer, rt_size_t count)
+{
+    struct rt_bio bio = { 0 };
+    struct rt_completion done;
+
+    rt_completion_init(&done);
+
+    bio.queue = queue;
+    bio.op = op;
+    bio.sector = sector;
+    bio.count = count;
+    bio.buffer = buffer;
+    bio.end_io = _bio_end_sync;
+    bio.private = &done;
+
+    rt_bio_submit(&bio);
+    rt_completion_wait(&done, RT_WAITING_FOREVER);
+
+    return bio.status == RT_EOK ? (rt_ssize_t)count : bio.status;
+}
+
+rt_err_t rt_blk_queue_flush(struct rt_blk_queue *queue)
+{
+    rt_ssize_t ret = rt_blk_queue_rw(queue, RT_BIO_FLUSH, 0, RT_NULL, 0);
+
+    return ret < 0 ? ret : RT_EOK;
+}
+
+rt_err_t rt_blk_queue_discard(struct rt_blk_queue *queue, rt_off_t sector, rt_size_t count)
+{
+    rt_ssize_t ret = rt_blk_queue_rw(queue, RT_BIO_DISCARD, sector, RT_NULL, count);
+
+    return ret < 0 ? ret : RT_EOK;
+}
+
+static int list_blk_queue(void)
+{
+    struct rt_blk_queue *queue;
+    rt_base_t level;
+
+    rt_kprintf("device   depth inflight       bios   requests     merges errors\n");
+    rt_kprintf("-------- ----- -------- ---------- ---------- ---------- ------\n");
+
+    level = rt_spin_lock_irqsave(&_blk_queue_lock);
+    rt_list_for_each_entry(queue, &_blk_queue_list, node)
+    {
+        rt_kprintf("%-8.*s %5d %8d %10d %10d %10d %6d\n", RT_NAME_MAX,
+                   queue->dev ? queue->dev->parent.name : "-",
+                   queue->depth, queue->inflight, queue->bios,
+                   queue->requests, queue->merges, queue->errors);
+    }
+    rt_spin_unlock_irqrestore(&_blk_queue_lock, level);
+
+    return 0;
+}
+MSH_CMD_EXPORT(list_blk_queue, list block request queues);
@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) 2006-2023, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2024-03-02     RTT          the first version
+ */
+
+#ifndef __BLK_QUEUE_H__
+#define __BLK_QUEUE_H__
+
+#include <rtdef.h>
+
+#define RT_BIO_READ     0
+#define RT_BIO_WRITE    1
+#define RT_BIO_FLUSH    2   /* completes after all the writes before it */
+#define RT_BIO_DISCARD  3   /* the sectors are unused, no buffer */
+
+struct rt_bio;
+struct rt_blk_queue;
+
+typedef void (*rt_bio_end_t)(struct rt_bio *bio);
+
+/**
+ * Block I/O on the contiguous sectors of one buffer. The bio belongs to the
+ * queue from the submission until end_io is called, which can be in the
+ * interrupt context.
+ */
+struct rt_bio
+{
+    rt_list_t node;
+    struct rt_blk_queue *queue;
+
+    int op;
+    rt_off_t sector;                /* in the sectors of the device */
+    rt_size_t count;                /* number of sectors */
+    void *buffer;
+
+    rt_err_t status;
+    rt_bio_end_t end_io;
+    void *private;
+};
+
+/**
+ * Request to the driver, the bios on adjacent sectors merged in the order of
+ * the sectors.
+ */
+struct rt_blk_request
+{
+    rt_list_t node;
+    int op;
+    rt_off_t sector;
+    rt_size_t count;
+    rt_list_t bios;
+    rt_uint32_t nr_segments;        /* number of discontiguous buffers */
+};
+
+struct rt_blk_queue_ops
+{
+    /**
+     * Start the request. It can be called in the interrupt context on the
+     * completion of another request, so it shall not block unless the queue
+     * depth is 1. rt_blk_request_end() is called when the request is done.
+     */
+    rt_err_t (*submit)(struct rt_blk_queue *queue, struct rt_blk_request *req);
+};
+
+struct rt_blk_queue
+{
+    rt_list_t node;
+    rt_device_t dev;
+    const struct rt_blk_queue_ops *ops;
+    void *private;
+
+    rt_size_t sector_size;
+    rt_uint32_t depth;              /* max requests in flight */
+    rt_uint32_t max_segments;       /* max discontiguous buffers of a request */
+    rt_size_t max_sectors;          /* max sectors of a request, 0 for no limit */
+
+    struct rt_spinlock lock;
+    rt_list_t pending;              /* requests not dispatched yet */
+    rt_list_t free;
+    struct rt_semaphore free_sem;
+    rt_uint32_t inflight;
+    rt_bool_t dispatching;
+    rt_bool_t barrier;              /* a flush is in flight */
+
+    rt_uint32_t bios, requests, merges, errors;
+};
+
+struct rt_blk_queue *rt_blk_queue_create(rt_device_t dev, const struct rt_blk_queue_ops *ops,
+                                         rt_size_t sector_size, rt_uint32_t depth,
+                                         rt_uint32_t max_segments, rt_size_t max_sectors);
+void rt_blk_queue_delete(struct rt_blk_queue *queue);
+
+/**
+ * @brief Get the request queue of a block device
+ *
+ * @param dev the block device
+ * @return struct rt_blk_queue* the queue, RT_NULL if the driver has none
+ */
+struct rt_blk_queue *rt_blk_queue_get(rt_device_t dev);
+
+/**
+ * @brief Submit a bio, bio->queue and the I/O fields shall be set. It's
+ *        merged with the pending requests if it can be.
+ *
+ * @param bio the bio
+ */
+void rt_bio_submit(struct rt_bio *bio);
+
+/* called by the driver when the request is done, it can be in interrupt */
+void rt_blk_request_end(struct rt_blk_queue *queue, struct rt_blk_request *req, rt_err_t status);
+
+/* synchronous I/O, returns count or the negative error */
+rt_ssize_t rt_blk_queue_rw(struct rt_blk_queue *queue, int op, rt_off_t sector, void *buffer, rt_size_t count);
+rt_err_t rt_blk_queue_flush(struct rt_blk_queue *queue);
+rt_err_t rt_blk_queue_discard(struct rt_blk_queue *queue, rt_off_t sector, rt_size_t count);
+
+#endif /* __BLK_QUEUE_H__ */
@@ -19,6 +19,7 @@
 #define RT_DEVICE_CTRL_BLK_ERASE        (RT_DEVICE_CTRL_BASE(Block) + 3)            /**< erase block on block device */
 #define RT_DEVICE_CTRL_BLK_AUTOREFRESH  (RT_DEVICE_CTRL_BASE(Block) + 4)            /**< block device : enter/exit auto refresh mode */
 #define RT_DEVICE_CTRL_BLK_PARTITION    (RT_DEVICE_CTRL_BASE(Block) + 5)            /**< get block device partition */
+#define RT_DEVICE_CTRL_BLK_QUEUE        (RT_DEVICE_CTRL_BASE(Block) + 6)            /**< get block device request queue */
 
 /**
  * block device geometry structure
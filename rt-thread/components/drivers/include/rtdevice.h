@@ -75,6 +75,10 @@ extern "C" {
 #include "drivers/mtd_nand.h"
 #endif /* RT_USING_MTD_NAND */
 
+#ifdef RT_USING_BLK_QUEUE
+#include "drivers/blk_queue.h"
+#endif /* RT_USING_BLK_QUEUE */
+
 #ifdef RT_USING_USB_DEVICE
 #include "drivers/usb_device.h"
 #endif /* RT_USING_USB_DEVICE */
@@ -18,83 +18,150 @@
 
 #include <virtio_blk.h>
 
-static void virtio_blk_rw(struct virtio_blk_device *virtio_blk_dev, rt_off_t pos, void *buffer, rt_size_t count,
-    int flags)
+#define VIRTIO_BLK_HAS(dev, feature)    ((dev)->features & (1UL << (feature)))
+
+static rt_err_t virtio_blk_submit(struct rt_blk_queue *queue, struct rt_blk_request *req)
 {
-    rt_uint16_t idx[3];
-    rt_size_t size = count * virtio_blk_dev->config->blk_size;
+    rt_uint16_t idx[VIRTIO_BLK_SEGS_MAX + 2];
+    rt_uint16_t head;
+    rt_base_t level;
+    int i, nr = 1, flags;
+    char *end = RT_NULL;
+    struct rt_bio *bio;
+    struct virtq_desc *desc;
+    struct virtio_blk_device *virtio_blk_dev = (struct virtio_blk_device *)queue->private;
     struct virtio_device *virtio_dev = &virtio_blk_dev->virtio_dev;
+    rt_uint32_t blk_size = virtio_blk_dev->config->blk_size;
+    rt_bool_t indirect = VIRTIO_BLK_HAS(virtio_blk_dev, VIRTIO_F_RING_INDIRECT_DESC);
 
-#ifdef RT_USING_SMP
-    rt_base_t level = rt_spin_lock_irqsave(&virtio_dev->spinlock);
-#endif
-
-    /* Allocate 3 descriptors */
-    while (virtio_alloc_desc_chain(virtio_dev, 0, 3, idx))
+    /* without a volatile write cache, a write is on the disk when it's done */
+    if (req->op == RT_BIO_FLUSH && !VIRTIO_BLK_HAS(virtio_blk_dev, VIRTIO_BLK_F_FLUSH))
     {
-#ifdef RT_USING_SMP
-        rt_spin_unlock_irqrestore(&virtio_dev->spinlock, level);
-#endif
-        rt_thread_yield();
+        rt_blk_request_end(queue, req, RT_EOK);
+        return RT_EOK;
+    }
 
-#ifdef RT_USING_SMP
-        level = rt_spin_lock_irqsave(&virtio_dev->spinlock);
-#endif
+    level = rt_spin_lock_irqsave(&virtio_blk_dev->lock);
+
+    /* the queue depth keeps the requests within the ring */
+    if (virtio_alloc_desc_chain(virtio_dev, VIRTIO_BLK_QUEUE, indirect ? 1 : req->nr_segments + 2, idx))
+    {
+        rt_spin_unlock_irqrestore(&virtio_blk_dev->lock, level);
+        return -RT_EBUSY;
     }
 
-    virtio_blk_dev->info[idx[0]].status = 0xff;
-    virtio_blk_dev->info[idx[0]].valid = RT_TRUE;
-    virtio_blk_dev->info[idx[0]].req.type = flags;
-    virtio_blk_dev->info[idx[0]].req.ioprio = 0;
-    virtio_blk_dev->info[idx[0]].req.sector = pos * (virtio_blk_dev->config->blk_size / 512);
+    head = idx[0];
+    desc = virtio_blk_dev->info[head].desc;
 
-    flags = flags == VIRTIO_BLK_T_OUT ? 0 : VIRTQ_DESC_F_WRITE;
+    virtio_blk_dev->info[head].request = req;
+    virtio_blk_dev->info[head].status = 0xff;
+    virtio_blk_dev->info[head].req.ioprio = 0;
+    virtio_blk_dev->info[head].req.sector = req->sector * (blk_size / 512);
 
-    virtio_fill_desc(virtio_dev, VIRTIO_BLK_QUEUE, idx[0],
-            VIRTIO_VA2PA(&virtio_blk_dev->info[idx[0]].req), sizeof(struct virtio_blk_req), VIRTQ_DESC_F_NEXT, idx[1]);
+    desc[0].addr = VIRTIO_VA2PA(&virtio_blk_dev->info[head].req);
+    desc[0].len = sizeof(struct virtio_blk_req);
+    desc[0].flags = 0;
 
-    virtio_fill_desc(virtio_dev, VIRTIO_BLK_QUEUE, idx[1],
-            VIRTIO_VA2PA(buffer), size, flags | VIRTQ_DESC_F_NEXT, idx[2]);
+    switch (req->op)
+    {
+    case RT_BIO_FLUSH:
+        virtio_blk_dev->info[head].req.type = VIRTIO_BLK_T_FLUSH;
+        virtio_blk_dev->info[head].req.sector = 0;
+        break;
+    case RT_BIO_DISCARD:
+        virtio_blk_dev->info[head].req.type = VIRTIO_BLK_T_DISCARD;
+        virtio_blk_dev->info[head].discard.sector = req->sector * (blk_size / 512);
+        virtio_blk_dev->info[head].discard.num_sectors = req->count * (blk_size / 512);
+        virtio_blk_dev->info[head].discard.flags = 0;
+
+        desc[nr].addr = VIRTIO_VA2PA(&virtio_blk_dev->info[head].discard);
+        desc[nr].len = sizeof(struct virtio_blk_discard_write_zeroes);
+        desc[nr].flags = 0;
+        nr++;
+        break;
+    default:
+        virtio_blk_dev->info[head].req.type = req->op == RT_BIO_WRITE ? VIRTIO_BLK_T_OUT : VIRTIO_BLK_T_IN;
+        flags = req->op == RT_BIO_WRITE ? 0 : VIRTQ_DESC_F_WRITE;
 
-    virtio_fill_desc(virtio_dev, VIRTIO_BLK_QUEUE, idx[2],
-            VIRTIO_VA2PA(&virtio_blk_dev->info[idx[0]].status), sizeof(rt_uint8_t), VIRTQ_DESC_F_WRITE, 0);
+        /* the bios with contiguous buffers make one segment */
+        rt_list_for_each_entry(bio, &req->bios, node)
+        {
+            if (end == (char *)bio->buffer)
+            {
+                desc[nr - 1].len += bio->count * blk_size;
+            }
+            else
+            {
+                desc[nr].addr = VIRTIO_VA2PA(bio->buffer);
+                desc[nr].len = bio->count * blk_size;
+                desc[nr].flags = flags;
+                nr++;
+            }
+            end = (char *)bio->buffer + bio->count * blk_size;
+        }
+        break;
+    }
 
-    virtio_submit_chain(virtio_dev, VIRTIO_BLK_QUEUE, idx[0]);
+    RT_ASSERT(nr <= req->nr_segments + 1);
 
-    virtio_queue_notify(virtio_dev, VIRTIO_BLK_QUEUE);
+    desc[nr].addr = VIRTIO_VA2PA(&virtio_blk_dev->info[head].status);
+    desc[nr].len = sizeof(rt_uint8_t);
+    desc[nr].flags = VIRTQ_DESC_F_WRITE;
+    nr++;
 
-    /* Wait for virtio_blk_isr() to done */
-    while (virtio_blk_dev->info[idx[0]].valid)
+    if (indirect)
     {
-#ifdef RT_USING_SMP
-        rt_spin_unlock_irqrestore(&virtio_dev->spinlock, level);
-#endif
-        rt_thread_yield();
+        for (i = 0; i < nr - 1; i++)
+        {
+            desc[i].flags |= VIRTQ_DESC_F_NEXT;
+            desc[i].next = i + 1;
+        }
+        desc[i].next = 0;
+        rt_hw_dsb();
 
-#ifdef RT_USING_SMP
-        level = rt_spin_lock_irqsave(&virtio_dev->spinlock);
-#endif
+        virtio_fill_desc(virtio_dev, VIRTIO_BLK_QUEUE, head,
+                VIRTIO_VA2PA(desc), nr * sizeof(struct virtq_desc), VIRTQ_DESC_F_INDIRECT, 0);
+    }
+    else
+    {
+        /* a flush or a discard takes fewer descriptors than it was given */
+        for (i = nr; i < req->nr_segments + 2; i++)
+        {
+            virtio_free_desc(virtio_dev, VIRTIO_BLK_QUEUE, idx[i]);
+        }
+        for (i = 0; i < nr; i++)
+        {
+            virtio_fill_desc(virtio_dev, VIRTIO_BLK_QUEUE, idx[i], desc[i].addr, desc[i].len,
+                    desc[i].flags | (i < nr - 1 ? VIRTQ_DESC_F_NEXT : 0), i < nr - 1 ? idx[i + 1] : 0);
+        }
     }
 
-    virtio_free_desc_chain(virtio_dev, VIRTIO_BLK_QUEUE, idx[0]);
+    virtio_submit_chain(virtio_dev, VIRTIO_BLK_QUEUE, head);
 
-#ifdef RT_USING_SMP
-    rt_spin_unlock_irqrestore(&virtio_dev->spinlock, level);
-#endif
+    virtio_queue_notify(virtio_dev, VIRTIO_BLK_QUEUE);
+
+    rt_spin_unlock_irqrestore(&virtio_blk_dev->lock, level);
+
+    return RT_EOK;
 }
 
+static const struct rt_blk_queue_ops virtio_blk_queue_ops =
+{
+    .submit = virtio_blk_submit,
+};
+
 static rt_ssize_t virtio_blk_read(rt_device_t dev, rt_off_t pos, void *buffer, rt_size_t count)
 {
-    virtio_blk_rw((struct virtio_blk_device *)dev, pos, buffer, count, VIRTIO_BLK_T_IN);
+    struct virtio_blk_device *virtio_blk_dev = (struct virtio_blk_device *)dev;
 
-    return count;
+    return rt_blk_queue_rw(virtio_blk_dev->queue, RT_BIO_READ, pos, buffer, count);
 }
 
 static rt_ssize_t virtio_blk_write(rt_device_t dev, rt_off_t pos, const void *buffer, rt_size_t count)
 {
-    virtio_blk_rw((struct virtio_blk_device *)dev, pos, (void *)buffer, count, VIRTIO_BLK_T_OUT);
+    struct virtio_blk_device *virtio_blk_dev = (struct virtio_blk_device *)dev;
 
-    return count;
+    return rt_blk_queue_rw(virtio_blk_dev->queue, RT_BIO_WRITE, pos, (void *)buffer, count);
 }
 
 static rt_err_t virtio_blk_control(rt_device_t dev, int cmd, void *args)
@@ -119,6 +186,47 @@ static rt_err_t virtio_blk_control(rt_device_t dev, int cmd, void *args)
             geometry->sector_count = virtio_blk_dev->config->capacity;
         }
         break;
+    case RT_DEVICE_CTRL_BLK_SYNC:
+        status = rt_blk_queue_flush(virtio_blk_dev->queue);
+        break;
+    case RT_DEVICE_CTRL_BLK_ERASE:
+        {
+            /* the first and the last sector, as CTRL_TRIM of FatFs */
+            rt_uint32_t *sectors = (rt_uint32_t *)args;
+            rt_uint32_t sector, count, max;
+
+            if (sectors == RT_NULL || sectors[0] > sectors[1])
+            {
+                status = -RT_ERROR;
+                break;
+            }
+            if (!VIRTIO_BLK_HAS(virtio_blk_dev, VIRTIO_BLK_F_DISCARD))
+            {
+                status = -RT_ENOSYS;
+                break;
+            }
+
+            max = virtio_blk_dev->config->max_discard_sectors / (virtio_blk_dev->config->blk_size / 512);
+            max = max ? max : RT_UINT32_MAX;
+            for (sector = sectors[0]; status == RT_EOK && sector <= sectors[1]; sector += count)
+            {
+                count = sectors[1] - sector + 1 > max ? max : sectors[1] - sector + 1;
+                status = rt_blk_queue_discard(virtio_blk_dev->queue, sector, count);
+                if (count == 0)
+                {
+                    break;
+                }
+            }
+        }
+        break;
+    case RT_DEVICE_CTRL_BLK_QUEUE:
+        if (args == RT_NULL)
+        {
+            status = -RT_ERROR;
+            break;
+        }
+        *(struct rt_blk_queue **)args = virtio_blk_dev->queue;
+        break;
     default:
         status = -RT_EINVAL;
         break;
@@ -142,13 +250,14 @@ const static struct rt_device_ops virtio_blk_ops =
 static void virtio_blk_isr(int irqno, void *param)
 {
     rt_uint32_t id;
+    rt_base_t level;
+    rt_err_t status;
+    struct rt_blk_request *req;
     struct virtio_blk_device *virtio_blk_dev = (struct virtio_blk_device *)param;
     struct virtio_device *virtio_dev = &virtio_blk_dev->virtio_dev;
     struct virtq *queue = &virtio_dev->queues[VIRTIO_BLK_QUEUE];
 
-#ifdef RT_USING_SMP
-    rt_base_t level = rt_spin_lock_irqsave(&virtio_dev->spinlock);
-#endif
+    level = rt_spin_lock_irqsave(&virtio_blk_dev->lock);
 
     virtio_interrupt_ack(virtio_dev);
     rt_hw_dsb();
@@ -159,17 +268,22 @@ static void virtio_blk_isr(int irqno, void *param)
         rt_hw_dsb();
         id = queue->used->ring[queue->used_idx % queue->num].id;
 
-        RT_ASSERT(virtio_blk_dev->info[id].status == 0);
+        req = virtio_blk_dev->info[id].request;
+        status = virtio_blk_dev->info[id].status == 0 ? RT_EOK : -RT_EIO;
+        virtio_blk_dev->info[id].request = RT_NULL;
 
         /* Done with buffer */
-        virtio_blk_dev->info[id].valid = RT_FALSE;
+        virtio_free_desc_chain(virtio_dev, VIRTIO_BLK_QUEUE, id);
 
         queue->used_idx++;
+
+        /* the completion can submit the next request */
+        rt_spin_unlock_irqrestore(&virtio_blk_dev->lock, level);
+        rt_blk_request_end(virtio_blk_dev->queue, req, status);
+        level = rt_spin_lock_irqsave(&virtio_blk_dev->lock);
     }
 
-#ifdef RT_USING_SMP
-    rt_spin_unlock_irqrestore(&virtio_dev->spinlock, level);
-#endif
+    rt_spin_unlock_irqrestore(&virtio_blk_dev->lock, level);
 }
 
 rt_err_t rt_virtio_blk_init(rt_ubase_t *mmio_base, rt_uint32_t irq)
@@ -178,6 +292,8 @@ rt_err_t rt_virtio_blk_init(rt_ubase_t *mmio_base, rt_uint32_t irq)
     char dev_name[RT_NAME_MAX];
     struct virtio_device *virtio_dev;
     struct virtio_blk_device *virtio_blk_dev;
+    rt_uint32_t depth, max_segments;
+    rt_size_t max_sectors = 0;
 
     virtio_blk_dev = rt_malloc(sizeof(struct virtio_blk_device));
 
@@ -195,19 +311,20 @@ rt_err_t rt_virtio_blk_init(rt_ubase_t *mmio_base, rt_uint32_t irq)
 #ifdef RT_USING_SMP
     rt_spin_lock_init(&virtio_dev->spinlock);
 #endif
+    rt_spin_lock_init(&virtio_blk_dev->lock);
 
     virtio_reset_device(virtio_dev);
     virtio_status_acknowledge_driver(virtio_dev);
 
     /* Negotiate features */
-    virtio_dev->mmio_config->driver_features = virtio_dev->mmio_config->device_features & ~(
+    virtio_blk_dev->features = virtio_dev->mmio_config->device_features & ~(
             (1 << VIRTIO_BLK_F_RO) |
             (1 << VIRTIO_BLK_F_MQ) |
             (1 << VIRTIO_BLK_F_SCSI) |
             (1 << VIRTIO_BLK_F_CONFIG_WCE) |
             (1 << VIRTIO_F_ANY_LAYOUT) |
-            (1 << VIRTIO_F_RING_EVENT_IDX) |
-            (1 << VIRTIO_F_RING_INDIRECT_DESC));
+            (1 << VIRTIO_F_RING_EVENT_IDX));
+    virtio_dev->mmio_config->driver_features = virtio_blk_dev->features;
 
     /* Tell device that feature negotiation is complete and we're completely ready */
     virtio_status_driver_ok(virtio_dev);
@@ -223,6 +340,39 @@ rt_err_t rt_virtio_blk_init(rt_ubase_t *mmio_base, rt_uint32_t irq)
         goto _alloc_fail;
     }
 
+    max_segments = VIRTIO_BLK_SEGS_MAX;
+    if (VIRTIO_BLK_HAS(virtio_blk_dev, VIRTIO_BLK_F_SEG_MAX) && virtio_blk_dev->config->seg_max < max_segments)
+    {
+        max_segments = virtio_blk_dev->config->seg_max ? virtio_blk_dev->config->seg_max : 1;
+    }
+    if (VIRTIO_BLK_HAS(virtio_blk_dev, VIRTIO_BLK_F_SIZE_MAX))
+    {
+        max_sectors = virtio_blk_dev->config->size_max / virtio_blk_dev->config->blk_size;
+    }
+
+    /* a request takes one descriptor of the ring when indirect, otherwise its whole chain */
+    if (VIRTIO_BLK_HAS(virtio_blk_dev, VIRTIO_F_RING_INDIRECT_DESC))
+    {
+        depth = VIRTIO_BLK_QUEUE_RING_SIZE;
+    }
+    else
+    {
+        /* still keep 8 requests in flight */
+        if (max_segments > VIRTIO_BLK_QUEUE_RING_SIZE / 8 - 2)
+        {
+            max_segments = VIRTIO_BLK_QUEUE_RING_SIZE / 8 - 2;
+        }
+        depth = VIRTIO_BLK_QUEUE_RING_SIZE / (max_segments + 2);
+    }
+
+    virtio_blk_dev->queue = rt_blk_queue_create(&virtio_blk_dev->parent, &virtio_blk_queue_ops,
+            virtio_blk_dev->config->blk_size, depth, max_segments, max_sectors);
+    if (virtio_blk_dev->queue == RT_NULL)
+    {
+        goto _alloc_fail;
+    }
+    virtio_blk_dev->queue->private = virtio_blk_dev;
+
     virtio_blk_dev->parent.type = RT_Device_Class_Block;
 #ifdef RT_USING_DEVICE_OPS
     virtio_blk_dev->parent.ops  = &virtio_blk_ops;
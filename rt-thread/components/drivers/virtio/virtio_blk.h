@@ -18,12 +18,17 @@
 
 #define VIRTIO_BLK_QUEUE            0
 #define VIRTIO_BLK_BYTES_PER_SECTOR 512
-#define VIRTIO_BLK_QUEUE_RING_SIZE  4
+#define VIRTIO_BLK_QUEUE_RING_SIZE  64
+#define VIRTIO_BLK_SEGS_MAX         16  /* Data segments of a request */
 
+#define VIRTIO_BLK_F_SIZE_MAX       1   /* Maximum size of any single segment is in size_max */
+#define VIRTIO_BLK_F_SEG_MAX        2   /* Maximum number of segments in a request is in seg_max */
 #define VIRTIO_BLK_F_RO             5   /* Disk is read-only */
 #define VIRTIO_BLK_F_SCSI           7   /* Supports scsi command passthru */
 #define VIRTIO_BLK_F_CONFIG_WCE     11  /* Writeback mode available in config */
+#define VIRTIO_BLK_F_FLUSH          9   /* Cache flush command support */
 #define VIRTIO_BLK_F_MQ             12  /* Support more than one vq */
+#define VIRTIO_BLK_F_DISCARD        13  /* Device can support discard command */
 
 #define VIRTIO_BLK_T_IN             0   /* Read the blk */
 #define VIRTIO_BLK_T_OUT            1   /* Write the blk */
@@ -31,6 +36,7 @@
 #define VIRTIO_BLK_T_SCSI_CMD_OUT   3
 #define VIRTIO_BLK_T_FLUSH          4
 #define VIRTIO_BLK_T_FLUSH_OUT      5
+#define VIRTIO_BLK_T_DISCARD        11
 
 struct virtio_blk_req
 {
@@ -39,6 +45,13 @@ struct virtio_blk_req
     rt_uint64_t sector;
 };
 
+struct virtio_blk_discard_write_zeroes
+{
+    rt_uint64_t sector;
+    rt_uint32_t num_sectors;
+    rt_uint32_t flags;
+};
+
 struct virtio_blk_config
 {
     rt_uint64_t capacity;           /* The capacity (in 512-byte sectors). */
@@ -82,6 +95,9 @@ struct virtio_blk_config
     rt_uint32_t secure_erase_sector_alignment;
 } __attribute__((packed));
 
+struct rt_blk_queue;
+struct rt_blk_request;
+
 struct virtio_blk_device
 {
     struct rt_device parent;
@@ -90,12 +106,21 @@ struct virtio_blk_device
 
     struct virtio_blk_config *config;
 
+    struct rt_blk_queue *queue;
+    struct rt_spinlock lock;        /* of the ring, taken in the isr too */
+    rt_uint32_t features;           /* negotiated */
+
+    /* indexed by the head descriptor of the request */
     struct
     {
-        rt_bool_t valid;
+        struct rt_blk_request *request;
         rt_uint8_t status;
 
         struct virtio_blk_req req;
+        struct virtio_blk_discard_write_zeroes discard;
+
+        /* the header, the data segments and the status */
+        struct virtq_desc desc[VIRTIO_BLK_SEGS_MAX + 2];
 
     } info[VIRTIO_BLK_QUEUE_RING_SIZE];
 };
@@ -39,6 +39,7 @@ static void _dlmodule_set_name(struct rt_dlmodule *module, const char *path)
     int size;
     struct rt_object *object;
     const char *first, *end, *ptr;
+    char name[RT_NAME_MAX];
 
     object = &(module->parent);
     ptr   = first = (char *)path;
@@ -55,10 +56,13 @@ static void _dlmodule_set_name(struct rt_dlmodule *module, const char *path)
     }
 
     size = end - first + 1;
-    if (size > RT_NAME_MAX) size = RT_NAME_MAX;
+    if (size > RT_NAME_MAX - 1) size = RT_NAME_MAX - 1;
 
-    rt_strncpy(object->name, first, size);
-    object->name[size] = '\0';
+    rt_strncpy(name, first, size);
+    name[size] = '\0';
+
+    /* rename through the object system to keep it findable */
+    rt_object_set_name(object, name);
 }
 
 #define RT_MODULE_ARG_MAX    8
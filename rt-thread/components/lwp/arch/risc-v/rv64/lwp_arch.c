@@ -151,7 +151,7 @@ long sys_fork(void)
 long _sys_vfork(void);
 long sys_vfork(void)
 {
-    return _sys_fork();
+    return _sys_vfork();
 }
 
 /**
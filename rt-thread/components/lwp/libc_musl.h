@@ -23,11 +23,31 @@
 #define FUTEX_UNLOCK_PI   7
 #define FUTEX_TRYLOCK_PI  8
 #define FUTEX_WAIT_BITSET 9
+#define FUTEX_WAKE_BITSET 10
 
 #define FUTEX_PRIVATE 128
 
 #define FUTEX_CLOCK_REALTIME 256
 
+#define FUTEX_BITSET_MATCH_ANY 0xffffffff
+
+/* from linux/futex.h, encoding of the FUTEX_WAKE_OP operation */
+
+#define FUTEX_OP_SET        0
+#define FUTEX_OP_ADD        1
+#define FUTEX_OP_OR         2
+#define FUTEX_OP_ANDN       3
+#define FUTEX_OP_XOR        4
+
+#define FUTEX_OP_OPARG_SHIFT 8
+
+#define FUTEX_OP_CMP_EQ     0
+#define FUTEX_OP_CMP_NE     1
+#define FUTEX_OP_CMP_LT     2
+#define FUTEX_OP_CMP_LE     3
+#define FUTEX_OP_CMP_GT     4
+#define FUTEX_OP_CMP_GE     5
+
 #define FUTEX_WAITERS		0x80000000
 #define FUTEX_OWNER_DIED	0x40000000
 #define FUTEX_TID_MASK		0x3fffffff
@@ -1313,7 +1313,26 @@ rt_err_t lwp_children_unregister(struct rt_lwp *parent, struct rt_lwp *child)
     return 0;
 }
 
-pid_t lwp_execve(char *filename, int debug, int argc, char **argv, char **envp)
+#ifdef ARCH_MM_MMU
+/* posix_spawn(): the child starts with the files, cwd and terminal of the caller */
+static int lwp_spawn_inherit(struct rt_lwp *lwp, struct rt_lwp *self_lwp)
+{
+    if (lwp_copy_files(lwp, self_lwp) != 0)
+    {
+        return -RT_ENOMEM;
+    }
+
+    rt_strcpy(lwp->working_directory, self_lwp->working_directory);
+    lwp->tty = self_lwp->tty;
+    lwp->background = self_lwp->background;
+    lwp->term_ctrlterm = self_lwp->term_ctrlterm;
+
+    return RT_EOK;
+}
+#endif /* ARCH_MM_MMU */
+
+static pid_t _lwp_execve(char *filename, int debug, int argc, char **argv, char **envp,
+                         rt_bool_t spawn)
 {
     int result;
     struct rt_lwp *lwp;
@@ -1369,13 +1388,29 @@ pid_t lwp_execve(char *filename, int debug, int argc, char **argv, char **envp)
         lwp_unmap_user(lwp, (void *)(USER_VADDR_TOP - ARCH_PAGE_SIZE));
         result = load_ldso(lwp, filename, argv, envp);
     }
+#endif /* ARCH_MM_MMU */
+#ifdef ARCH_MM_MMU
+    if (result == RT_EOK && spawn)
+    {
+        result = lwp_spawn_inherit(lwp, lwp_self());
+    }
 #endif /* ARCH_MM_MMU */
     if (result == RT_EOK)
     {
         rt_thread_t thread = RT_NULL;
         rt_uint32_t priority = 25, tick = 200;
 
-        lwp_execve_setup_stdio(lwp);
+        if (spawn)
+        {
+            rt_thread_t self_thread = rt_thread_self();
+
+            priority = RT_SCHED_PRIV(self_thread).init_priority;
+            tick = RT_SCHED_PRIV(self_thread).init_tick;
+        }
+        else
+        {
+            lwp_execve_setup_stdio(lwp);
+        }
 
         /* obtain the base name */
         thread_name = strrchr(filename, '/');
@@ -1420,8 +1455,17 @@ pid_t lwp_execve(char *filename, int debug, int argc, char **argv, char **envp)
             session = RT_NULL;
             group = RT_NULL;
 
-            group = lwp_pgrp_create(lwp);
-            if (group)
+            if (spawn && self_lwp)
+            {
+                /* stay in the process group of the caller */
+                group = lwp_pgrp_find(lwp_pgid_get_byprocess(self_lwp));
+                if (group)
+                {
+                    lwp_pgrp_insert(group, lwp);
+                }
+                thread->signal.sigset_mask = rt_thread_self()->signal.sigset_mask;
+            }
+            else if ((group = lwp_pgrp_create(lwp)) != RT_NULL)
             {
                 lwp_pgrp_insert(group, lwp);
                 if (self_lwp == RT_NULL)
@@ -1470,6 +1514,27 @@ pid_t lwp_execve(char *filename, int debug, int argc, char **argv, char **envp)
     return -RT_ERROR;
 }
 
+pid_t lwp_execve(char *filename, int debug, int argc, char **argv, char **envp)
+{
+    return _lwp_execve(filename, debug, argc, argv, envp, RT_FALSE);
+}
+
+/**
+ * @brief Create a child of the current process straight from the ELF loader,
+ * without duplicating the address space of the caller as fork() + execve() do.
+ *
+ * @param filename the path of the image
+ * @param argc the number of arguments
+ * @param argv the arguments in kernel space
+ * @param envp the environments in kernel space, terminated by RT_NULL
+ *
+ * @return the pid of the child on success, otherwise a negative error code
+ */
+pid_t lwp_spawn(char *filename, int argc, char **argv, char **envp)
+{
+    return _lwp_execve(filename, 0, argc, argv, envp, RT_TRUE);
+}
+
 #ifdef RT_USING_MUSLLIBC
 extern char **__environ;
 #else
@@ -117,11 +117,14 @@ struct rt_processgroup {
     unsigned int is_orphaned:1;
 };
 
+struct rt_completion;
+
 struct rt_lwp
 {
 #ifdef ARCH_MM_MMU
     size_t end_heap;
     rt_aspace_t aspace;
+    struct rt_completion *vfork_done; /* vfork: the aspace is borrowed from the parent waiting on it */
 #else
 #ifdef ARCH_MM_MPU
     struct rt_mpu_info mpu_info;
@@ -181,7 +184,7 @@ struct rt_lwp
     struct rt_wqueue wait_queue; /* for console */
     struct tty_struct *tty; /* NULL if no tty */
 
-    struct lwp_avl_struct *address_search_head; /* for addressed object fast search */
+    rt_list_t futex_list; /* private futexes of the lwp */
     char working_directory[DFS_PATH_MAX];
 
     int debug;
@@ -237,6 +240,8 @@ void lwp_tid_dec_ref(rt_thread_t thread);
 void lwp_tid_set_thread(int tid, rt_thread_t thread);
 
 int lwp_execve(char *filename, int debug, int argc, char **argv, char **envp);
+pid_t lwp_spawn(char *filename, int argc, char **argv, char **envp);
+int lwp_copy_files(struct rt_lwp *dst, struct rt_lwp *src);
 
 /*create by lwp_setsid.c*/
 int setsid(void);
@@ -257,6 +262,8 @@ pid_t exec(char *filename, int debug, int argc, char **argv);
 int timer_list_free(rt_list_t *timer_list);
 
 rt_err_t lwp_futex_init(void);
+void lwp_futex_private_clear(struct rt_lwp *lwp);
+void lwp_futex_shared_reap(void);
 rt_err_t lwp_futex(struct rt_lwp *lwp, int *uaddr, int op, int val,
                    const struct timespec *timeout, int *uaddr2, int val3);
 
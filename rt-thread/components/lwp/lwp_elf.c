@@ -59,9 +59,15 @@ typedef struct
     int fd;
     char *filename;
     rt_size_t file_len;
+    time_t mtime;
     Elf_Ehdr ehdr;
     Elf_Phdr *phdr;
     rt_ubase_t map_size;
+#ifdef LWP_USING_ELF_CACHE
+    rt_bool_t cached;           /* ehdr/phdr/interp are taken from the image cache */
+    struct dfs_vnode *vnode;    /* the vnode opened, to validate the cache entry */
+    char *interp;               /* PT_INTERP of a cached image, RT_NULL for none */
+#endif /* LWP_USING_ELF_CACHE */
 } elf_info_t;
 
 typedef struct
@@ -157,7 +163,7 @@ static int elf_file_close(int fd)
     return close(fd);
 }
 
-static int elf_file_length(char *filename, rt_size_t *file_len)
+static int elf_file_length(char *filename, rt_size_t *file_len, time_t *mtime)
 {
     int ret;
     struct stat s = { 0 };
@@ -169,6 +175,7 @@ static int elf_file_length(char *filename, rt_size_t *file_len)
         return -RT_ERROR;
     }
     *file_len = (rt_size_t)s.st_size;
+    *mtime = s.st_mtime;
 
     return RT_EOK;
 }
@@ -198,6 +205,231 @@ static int elf_file_read(rt_int32_t fd, rt_uint8_t *buffer, size_t size, off_t o
     return RT_EOK;
 }
 
+#ifdef LWP_USING_ELF_CACHE
+
+#ifndef LWP_ELF_CACHE_NR
+#define LWP_ELF_CACHE_NR 16
+#endif
+
+/**
+ * The parsed headers of the recently loaded images, keyed by the normalized
+ * path. An entry is valid for the vnode it was parsed from only, as long as
+ * the vnode is not written or truncated since, which clears its
+ * DFS_VNODE_F_UNCHANGED. The file is not kept opened, so the entry doesn't
+ * hold the file system busy. The vnode of an entry is only compared with the
+ * opened one, and a new vnode at the same address starts with the flag cleared.
+ */
+struct elf_cache_entry
+{
+    rt_list_t node;
+    char *path;
+    struct dfs_vnode *vnode;
+    time_t mtime;
+    rt_size_t file_len;
+    Elf_Ehdr ehdr;
+    Elf_Phdr *phdr;
+    char *interp;
+};
+
+static rt_list_t _elf_cache_list = RT_LIST_OBJECT_INIT(_elf_cache_list);
+static struct rt_mutex _elf_cache_lock;
+static int _elf_cache_count;
+static rt_atomic_t _elf_cache_hit;
+static rt_atomic_t _elf_cache_miss;
+
+static int _elf_cache_init(void)
+{
+    rt_mutex_init(&_elf_cache_lock, "elfcache", RT_IPC_FLAG_PRIO);
+    return 0;
+}
+INIT_PREV_EXPORT(_elf_cache_init);
+
+static void _elf_cache_free(struct elf_cache_entry *entry)
+{
+    rt_list_remove(&entry->node);
+    _elf_cache_count--;
+
+    rt_free(entry->interp);
+    rt_free(entry->phdr);
+    rt_free(entry->path);
+    rt_free(entry);
+}
+
+static struct elf_cache_entry *_elf_cache_find(const char *path)
+{
+    struct elf_cache_entry *entry;
+
+    rt_list_for_each_entry(entry, &_elf_cache_list, node)
+    {
+        if (rt_strcmp(entry->path, path) == 0)
+        {
+            return entry;
+        }
+    }
+
+    return RT_NULL;
+}
+
+/**
+ * fill the headers of elf_info from the cache, the file is already opened. On
+ * a miss, the vnode is flagged before the headers are read, so a write in the
+ * meantime keeps them out of the cache.
+ */
+static int elf_cache_get(elf_info_t *elf_info)
+{
+    int ret = -RT_ERROR;
+    char *path;
+    struct dfs_file *file;
+    struct elf_cache_entry *entry;
+
+    file = fd_get(elf_info->fd);
+    if (!file || !file->vnode)
+    {
+        return -RT_ERROR;
+    }
+    elf_info->vnode = file->vnode;
+
+    path = dfs_normalize_path(NULL, elf_info->filename);
+    if (!path)
+    {
+        return -RT_ENOMEM;
+    }
+
+    rt_mutex_take(&_elf_cache_lock, RT_WAITING_FOREVER);
+    entry = _elf_cache_find(path);
+    if (entry && (entry->vnode != elf_info->vnode ||
+                  !(elf_info->vnode->flags & DFS_VNODE_F_UNCHANGED) ||
+                  entry->mtime != elf_info->mtime || entry->file_len != elf_info->file_len))
+    {
+        /* the image is replaced or modified */
+        _elf_cache_free(entry);
+        entry = RT_NULL;
+    }
+
+    if (!entry)
+    {
+        elf_info->vnode->flags |= DFS_VNODE_F_UNCHANGED;
+    }
+
+    if (entry)
+    {
+        rt_size_t size = sizeof(Elf_Phdr) * entry->ehdr.e_phnum;
+
+        elf_info->phdr = rt_malloc(size);
+        if (elf_info->phdr)
+        {
+            rt_memcpy(elf_info->phdr, entry->phdr, size);
+            rt_memcpy(&elf_info->ehdr, &entry->ehdr, sizeof(Elf_Ehdr));
+            elf_info->interp = entry->interp ? rt_strdup(entry->interp) : RT_NULL;
+            if (!entry->interp || elf_info->interp)
+            {
+                elf_info->cached = RT_TRUE;
+                ret = RT_EOK;
+            }
+            else
+            {
+                rt_free(elf_info->phdr);
+                elf_info->phdr = RT_NULL;
+            }
+        }
+
+        /* most recently used first */
+        rt_list_remove(&entry->node);
+        rt_list_insert_after(&_elf_cache_list, &entry->node);
+    }
+    rt_mutex_release(&_elf_cache_lock);
+    rt_free(path);
+
+    rt_atomic_add(ret == RT_EOK ? &_elf_cache_hit : &_elf_cache_miss, 1);
+
+    return ret;
+}
+
+/* record the headers of a successfully parsed image */
+static void elf_cache_put(elf_info_t *elf_info, const char *interp)
+{
+    rt_size_t size = sizeof(Elf_Phdr) * elf_info->ehdr.e_phnum;
+    struct elf_cache_entry *entry;
+
+    if (elf_info->cached || !elf_info->phdr || !elf_info->vnode)
+    {
+        return;
+    }
+
+    entry = rt_calloc(1, sizeof(struct elf_cache_entry));
+    if (!entry)
+    {
+        return;
+    }
+
+    entry->path = dfs_normalize_path(NULL, elf_info->filename);
+    entry->phdr = rt_malloc(size);
+    entry->interp = interp ? rt_strdup(interp) : RT_NULL;
+    if (!entry->path || !entry->phdr || (interp && !entry->interp))
+    {
+        goto _err;
+    }
+
+    entry->vnode = elf_info->vnode;
+    entry->mtime = elf_info->mtime;
+    entry->file_len = elf_info->file_len;
+    rt_memcpy(&entry->ehdr, &elf_info->ehdr, sizeof(Elf_Ehdr));
+    rt_memcpy(entry->phdr, elf_info->phdr, size);
+
+    rt_mutex_take(&_elf_cache_lock, RT_WAITING_FOREVER);
+    if (_elf_cache_find(entry->path) || !(entry->vnode->flags & DFS_VNODE_F_UNCHANGED))
+    {
+        /* loaded by another spawn or written in the meantime */
+        rt_mutex_release(&_elf_cache_lock);
+        goto _err;
+    }
+
+    if (_elf_cache_count >= LWP_ELF_CACHE_NR)
+    {
+        _elf_cache_free(rt_list_entry(_elf_cache_list.prev, struct elf_cache_entry, node));
+    }
+    rt_list_insert_after(&_elf_cache_list, &entry->node);
+    _elf_cache_count++;
+    rt_mutex_release(&_elf_cache_lock);
+    return;
+
+_err:
+    rt_free(entry->interp);
+    rt_free(entry->phdr);
+    rt_free(entry->path);
+    rt_free(entry);
+}
+
+static int elf_cache(int argc, char **argv)
+{
+    struct elf_cache_entry *entry;
+
+    if (argc > 1 && rt_strcmp(argv[1], "flush") == 0)
+    {
+        rt_mutex_take(&_elf_cache_lock, RT_WAITING_FOREVER);
+        while (!rt_list_isempty(&_elf_cache_list))
+        {
+            _elf_cache_free(rt_list_entry(_elf_cache_list.next, struct elf_cache_entry, node));
+        }
+        rt_mutex_release(&_elf_cache_lock);
+        return 0;
+    }
+
+    rt_kprintf("hit %d miss %d\n", (int)rt_atomic_load(&_elf_cache_hit), (int)rt_atomic_load(&_elf_cache_miss));
+    rt_mutex_take(&_elf_cache_lock, RT_WAITING_FOREVER);
+    rt_list_for_each_entry(entry, &_elf_cache_list, node)
+    {
+        rt_kprintf("%-32s size %8d phnum %2d %s\n", entry->path, (int)entry->file_len,
+                   entry->ehdr.e_phnum, entry->interp ? entry->interp : "");
+    }
+    rt_mutex_release(&_elf_cache_lock);
+
+    return 0;
+}
+MSH_CMD_EXPORT(elf_cache, list or flush the elf image cache: elf_cache [flush]);
+
+#endif /* LWP_USING_ELF_CACHE */
+
 static rt_int32_t elf_check_ehdr(const Elf_Ehdr *ehdr, rt_uint32_t file_len)
 {
     if (memcmp(ehdr->e_ident, ELFMAG, SELFMAG) != 0)
@@ -273,12 +505,19 @@ static int elf_load_ehdr(elf_info_t *elf_info)
 
     elf_info->fd = ret;
 
-    ret = elf_file_length(elf_info->filename, &elf_info->file_len);
+    ret = elf_file_length(elf_info->filename, &elf_info->file_len, &elf_info->mtime);
     if (ret != RT_EOK)
     {
         return -RT_ERROR;
     }
 
+#ifdef LWP_USING_ELF_CACHE
+    if (elf_cache_get(elf_info) == RT_EOK)
+    {
+        return RT_EOK;
+    }
+#endif /* LWP_USING_ELF_CACHE */
+
     ret = elf_file_read(elf_info->fd, (rt_uint8_t *)&elf_info->ehdr, sizeof(Elf_Ehdr), 0);
     if (ret != RT_EOK)
     {
@@ -302,6 +541,13 @@ static int elf_load_phdr(elf_info_t *elf_info)
     uint32_t size;
     int ret;
 
+#ifdef LWP_USING_ELF_CACHE
+    if (elf_info->cached)
+    {
+        return RT_EOK;
+    }
+#endif /* LWP_USING_ELF_CACHE */
+
     if (ehdr->e_phnum < 1)
     {
         return -RT_ERROR;
@@ -337,12 +583,53 @@ static int elf_load_phdr(elf_info_t *elf_info)
     return RT_EOK;
 }
 
+static int elf_load_interp_info(elf_load_info_t *load_info)
+{
+    int ret;
+
+    LOG_D("%s : elf interpreter : %s", __func__, load_info->interp_info.filename);
+
+    ret = elf_load_ehdr(&load_info->interp_info);
+    if (ret != RT_EOK)
+    {
+        LOG_E("%s : elf_load_ehdr failed, ret = %d", __func__, ret);
+        return ret;
+    }
+
+    ret = elf_load_phdr(&load_info->interp_info);
+    if (ret != RT_EOK)
+    {
+        LOG_E("%s : elf_load_phdr failed, ret = %d", __func__, ret);
+        return ret;
+    }
+
+    return RT_EOK;
+}
+
 static int elf_load_interp(elf_load_info_t *load_info)
 {
     Elf_Phdr *phdr = load_info->exec_info.phdr;
     int ret;
     int i;
 
+#ifdef LWP_USING_ELF_CACHE
+    if (load_info->exec_info.cached)
+    {
+        if (load_info->exec_info.interp == RT_NULL)
+        {
+            return RT_EOK;
+        }
+
+        load_info->interp_info.filename = rt_strdup(load_info->exec_info.interp);
+        if (load_info->interp_info.filename == RT_NULL)
+        {
+            return -RT_ENOMEM;
+        }
+
+        return elf_load_interp_info(load_info);
+    }
+#endif /* LWP_USING_ELF_CACHE */
+
     for (i = 0; i < load_info->exec_info.ehdr.e_phnum; ++i, ++phdr)
     {
         if (phdr->p_type != PT_INTERP)
@@ -390,19 +677,9 @@ static int elf_load_interp(elf_load_info_t *load_info)
             goto error_exit;
         }
 
-        LOG_D("%s : elf interpreter : %s", __func__, load_info->interp_info.filename);
-
-        ret = elf_load_ehdr(&load_info->interp_info);
+        ret = elf_load_interp_info(load_info);
         if (ret != RT_EOK)
         {
-            LOG_E("%s : elf_load_ehdr failed, ret = %d", __func__, ret);
-            goto error_exit;
-        }
-
-        ret = elf_load_phdr(&load_info->interp_info);
-        if (ret != RT_EOK)
-        {
-            LOG_E("%s : elf_load_phdr failed, ret = %d", __func__, ret);
             goto error_exit;
         }
         break;
@@ -708,6 +985,11 @@ static void elf_load_deinit(elf_load_info_t *load_info)
     {
         rt_free(load_info->interp_info.filename);
     }
+
+#ifdef LWP_USING_ELF_CACHE
+    rt_free(load_info->exec_info.interp);
+    rt_free(load_info->interp_info.interp);
+#endif /* LWP_USING_ELF_CACHE */
 }
 
 static int elf_load_app(elf_info_t *exec_info)
@@ -745,6 +1027,14 @@ static int elf_file_load(elf_load_info_t *load_info)
         goto OUT;
     }
 
+#ifdef LWP_USING_ELF_CACHE
+    elf_cache_put(&load_info->exec_info, load_info->interp_info.filename);
+    if (load_info->interp_info.filename)
+    {
+        elf_cache_put(&load_info->interp_info, RT_NULL);
+    }
+#endif /* LWP_USING_ELF_CACHE */
+
     ret = elf_load_segment(load_info);
     if (ret != RT_EOK)
     {
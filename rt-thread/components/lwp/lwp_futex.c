@@ -19,314 +19,341 @@
 #include "sys/time.h"
 #include <stdatomic.h>
 
-struct rt_mutex _glob_futex;
-
 rt_err_t lwp_futex_init(void)
 {
-    return rt_mutex_init(&_glob_futex, "glob_ftx", RT_IPC_FLAG_PRIO);
+    futex_hash_init();
+    return RT_EOK;
 }
 
-static void _futex_lock(rt_lwp_t lwp, int op_flags)
+/**
+ * Take the locks of two buckets in address order, they can be the same one
+ */
+static void _futex_bucket_lock2(futex_hash_bucket_t bucket1,
+                                futex_hash_bucket_t bucket2)
 {
-    rt_err_t error;
-    if (op_flags & FUTEX_PRIVATE)
+    futex_hash_bucket_t tmp;
+
+    if (bucket1 > bucket2)
     {
-        LWP_LOCK(lwp);
+        tmp = bucket1;
+        bucket1 = bucket2;
+        bucket2 = tmp;
     }
-    else
+
+    rt_spin_lock(&bucket1->lock);
+    if (bucket1 != bucket2)
     {
-        error = lwp_mutex_take_safe(&_glob_futex, RT_WAITING_FOREVER, 0);
-        if (error)
-        {
-            LOG_E("%s: Should not failed", __func__);
-            RT_ASSERT(0);
-        }
+        rt_spin_lock(&bucket2->lock);
     }
 }
 
-static void _futex_unlock(rt_lwp_t lwp, int op_flags)
+static void _futex_bucket_unlock2(futex_hash_bucket_t bucket1,
+                                  futex_hash_bucket_t bucket2)
 {
-    rt_err_t error;
-    if (op_flags & FUTEX_PRIVATE)
+    if (bucket1 != bucket2)
     {
-        LWP_UNLOCK(lwp);
+        rt_spin_unlock(&bucket2->lock);
     }
-    else
+    rt_spin_unlock(&bucket1->lock);
+}
+
+static void _futex_free(rt_futex_t futex)
+{
+    futex_hash_delete(futex);
+
+    if (futex->mutex)
     {
-        error = lwp_mutex_release_safe(&_glob_futex);
-        if (error)
-        {
-            LOG_E("%s: Should not failed", __func__);
-            RT_ASSERT(0);
-        }
+        rt_mutex_delete(futex->mutex);
+        futex->mutex = RT_NULL;
     }
+    rt_free(futex);
 }
 
 /**
- * Destroy a Private FuTeX (pftx)
- * Note: must have futex address_search_head taken
+ * Release all the Private FuTeX (pftx) of the lwp on exit or exec, no
+ * thread of the lwp can be waiting on them at this point.
  */
-static rt_err_t _pftx_destroy_locked(void *data)
+void lwp_futex_private_clear(struct rt_lwp *lwp)
 {
-    rt_err_t ret = -1;
-    rt_futex_t futex = (rt_futex_t)data;
+    rt_futex_t futex, next;
 
-    if (futex)
+    LWP_LOCK(lwp);
+    rt_list_for_each_entry_safe(futex, next, &lwp->futex_list, lwp_node)
+    {
+        rt_list_remove(&futex->lwp_node);
+        _futex_free(futex);
+    }
+    LWP_UNLOCK(lwp);
+}
+
+/* a shared futex nobody is using, waiting on or holding the pi mutex of */
+static rt_bool_t _futex_unused_locked(rt_futex_t futex)
+{
+    return futex->shared && futex->ref_count == 0 &&
+           rt_list_isempty(&futex->waiting_thread) &&
+           (futex->mutex == RT_NULL || futex->mutex->owner == RT_NULL);
+}
+
+/**
+ * Release the Shared FuTeX (sftx) left unused in the table, such as the one
+ * whose pi mutex was given up by an exited owner. Called on the exit of lwp.
+ */
+void lwp_futex_shared_reap(void)
+{
+    rt_list_t reaped;
+    rt_futex_t futex, next;
+
+    rt_list_init(&reaped);
+    futex_hash_reap(_futex_unused_locked, &reaped);
+
+    rt_list_for_each_entry_safe(futex, next, &reaped, lwp_node)
+    {
+        rt_list_remove(&futex->lwp_node);
+        _futex_free(futex);
+    }
+}
+
+/**
+ * Take a reference of the shared futex, the bucket lock must be taken. The
+ * stale pi mutex left by an exited owner is returned to be deleted.
+ */
+static rt_mutex_t _futex_ref_locked(rt_futex_t futex)
+{
+    rt_mutex_t stale = RT_NULL;
+
+    if (futex->shared)
     {
-        /**
-         * Brief: Delete the futex from lwp address_search_head
-         *
-         * Note: Critical Section
-         * - the lwp (READ. share by thread)
-         * - the lwp address_search_head (RW. protected by caller. for destroy
-         *   routine, it's always safe because it has already taken a write lock
-         *    to the lwp.)
-         */
-        lwp_avl_remove(&futex->node,
-                       (struct lwp_avl_struct **)futex->node.data);
-
-        /* release object */
-        if (futex->mutex)
+        if (futex->ref_count == 0 && futex->mutex && futex->mutex->owner == RT_NULL)
         {
-            rt_mutex_delete(futex->mutex);
+            stale = futex->mutex;
             futex->mutex = RT_NULL;
         }
-        rt_free(futex);
-        ret = 0;
+        futex->ref_count++;
     }
-    return ret;
+
+    return stale;
 }
 
 /**
- * Create a Private FuTeX (pftx)
- * Note: must have futex address_search_head taken
+ * Drop the reference taken by _futex_get(), the shared futex is released once
+ * it's unused
  */
-static rt_futex_t _pftx_create_locked(int *uaddr, struct rt_lwp *lwp)
+static void _futex_put(rt_futex_t futex)
 {
-    rt_futex_t futex = RT_NULL;
-    struct rt_object *obj = RT_NULL;
+    futex_hash_bucket_t bucket;
+    rt_bool_t unused;
 
-    /**
-     * Brief: Create a futex under current lwp
-     *
-     * Note: Critical Section
-     * - lwp (READ; share with thread)
-     */
-    if (lwp)
+    if (futex && futex->shared)
     {
-        futex = (rt_futex_t)rt_malloc(sizeof(struct rt_futex));
-        if (futex)
+        bucket = futex->bucket;
+
+        rt_spin_lock(&bucket->lock);
+        futex->ref_count--;
+        unused = _futex_unused_locked(futex);
+        if (unused)
         {
-            /* Create a Private FuTeX (pftx) */
-            obj = rt_custom_object_create("pftx", (void *)futex,
-                                          _pftx_destroy_locked);
-            if (!obj)
-            {
-                rt_free(futex);
-                futex = RT_NULL;
-            }
-            else
-            {
-                /**
-                 * Brief: Add futex to user object tree for resource recycling
-                 *
-                 * Note: Critical Section
-                 * - lwp user object tree (RW; protected by API)
-                 * - futex (if the adding is successful, others can find the
-                 *   unready futex. However, only the lwp_free will do this,
-                 *   and this is protected by the ref taken by the lwp thread
-                 *   that the lwp_free will never execute at the same time)
-                 */
-                if (lwp_user_object_add(lwp, obj))
-                {
-                    /* this will call a _pftx_destroy_locked, but that's okay */
-                    rt_object_delete(obj);
-                    rt_free(futex);
-                    futex = RT_NULL;
-                }
-                else
-                {
-                    futex->node.avl_key = (avl_key_t)uaddr;
-                    futex->node.data = &lwp->address_search_head;
-                    futex->custom_obj = obj;
-                    futex->mutex = RT_NULL;
-                    rt_list_init(&(futex->waiting_thread));
-
-                    /**
-                     * Brief: Insert into futex head
-                     *
-                     * Note: Critical Section
-                     * - lwp address_search_head (RW; protected by caller)
-                     */
-                    lwp_avl_insert(&futex->node, &lwp->address_search_head);
-                }
-            }
+            rt_list_remove(&futex->hash_node);
+            futex->bucket = RT_NULL;
+        }
+        rt_spin_unlock(&bucket->lock);
+
+        if (unused)
+        {
+            _futex_free(futex);
         }
     }
-    return futex;
 }
 
 /**
- * Get a Private FuTeX (pftx) match the (lwp, uaddr, op)
+ * Make up the key of futex. A Private FuTeX (pftx) is identified by the
+ * address in the aspace of lwp, while a Shared FuTeX (sftx) is identified by
+ * the position in the memory object backing the address.
  */
-static rt_futex_t _pftx_get(void *uaddr, struct rt_lwp *lwp, int op,
-                            rt_err_t *rc)
+static rt_err_t _futex_key_get(void *uaddr, struct rt_lwp *lwp, int op_flags,
+                               struct futex_key *key)
 {
-    struct lwp_avl_struct *node = RT_NULL;
-    rt_futex_t futex = RT_NULL;
-    rt_err_t error = -1;
-
-    LWP_LOCK(lwp);
+    rt_err_t error = RT_EOK;
+    rt_varea_t varea;
 
-    /**
-     * Note: Critical Section
-     * protect lwp address_search_head (READ)
-     */
-    node = lwp_avl_find((avl_key_t)uaddr, lwp->address_search_head);
-    if (node)
+    if (op_flags & FUTEX_PRIVATE)
     {
-        futex = rt_container_of(node, struct rt_futex, node);
-        error = 0;
+        key->base = lwp->aspace;
+        key->offset = (rt_base_t)uaddr;
     }
     else
     {
-        /* create a futex according to this uaddr */
-        futex = _pftx_create_locked(uaddr, lwp);
-
-        if (!futex)
-            error = -ENOMEM;
+        RD_LOCK(lwp->aspace);
+        varea = rt_aspace_query(lwp->aspace, uaddr);
+        if (varea)
+        {
+            key->base = varea->mem_obj;
+            key->offset = ((varea->offset) << MM_PAGE_SHIFT) +
+                          ((char *)uaddr - (char *)varea->start);
+        }
         else
-            error = 0;
+        {
+            error = -EFAULT;
+        }
+        RD_UNLOCK(lwp->aspace);
     }
-    LWP_UNLOCK(lwp);
 
-    *rc = error;
-    return futex;
+    return error;
 }
 
-/**
- * Destroy a Shared FuTeX (pftx)
- * Note: must have futex address_search_head taken
- */
-static rt_err_t _sftx_destroy(void *data)
+static rt_futex_t _futex_create(struct futex_key *key, rt_bool_t shared)
 {
-    rt_err_t ret = -1;
-    rt_futex_t futex = (rt_futex_t)data;
+    rt_futex_t futex;
 
+    futex = (rt_futex_t)rt_calloc(1, sizeof(struct rt_futex));
     if (futex)
     {
-        /* delete it even it's not in the table */
-        futex_global_table_delete(&futex->entry.key);
-        if (futex->mutex)
-        {
-            rt_mutex_delete(futex->mutex);
-            futex->mutex = RT_NULL;
-        }
-        rt_free(futex);
-        ret = 0;
+        futex->key = *key;
+        futex->bucket = RT_NULL;
+        futex->mutex = RT_NULL;
+        futex->shared = shared;
+        futex->ref_count = 0;
+        rt_list_init(&futex->hash_node);
+        rt_list_init(&futex->lwp_node);
+        rt_list_init(&futex->waiting_thread);
     }
-    return ret;
+
+    return futex;
 }
 
 /**
- * Create a Shared FuTeX (sftx)
+ * Get the futex match the (lwp, uaddr, op), create one if it's not existed.
+ * A private futex is owned by the lwp and released on its exit, while a
+ * shared one is referenced until _futex_put() and released once unused.
  */
-static rt_futex_t _sftx_create(struct shared_futex_key *key, struct rt_lwp *lwp)
+static rt_futex_t _futex_get(void *uaddr, struct rt_lwp *lwp, int op_flags,
+                             rt_err_t *rc)
 {
+    struct futex_key key;
+    futex_hash_bucket_t bucket;
     rt_futex_t futex = RT_NULL;
-    struct rt_object *obj = RT_NULL;
+    rt_futex_t new_futex;
+    rt_mutex_t stale = RT_NULL;
+    rt_err_t error;
 
-    if (lwp)
+    error = _futex_key_get(uaddr, lwp, op_flags, &key);
+    if (!error)
     {
-        futex = (rt_futex_t)rt_calloc(1, sizeof(struct rt_futex));
+        bucket = futex_hash_bucket(&key);
+
+        rt_spin_lock(&bucket->lock);
+        futex = futex_hash_find_locked(bucket, &key);
         if (futex)
         {
-            /* create a Shared FuTeX (sftx) */
-            obj = rt_custom_object_create("sftx", (void *)futex, _sftx_destroy);
-            if (!obj)
+            stale = _futex_ref_locked(futex);
+        }
+        rt_spin_unlock(&bucket->lock);
+
+        if (!futex)
+        {
+            /* allocation can't be done with the bucket lock taken */
+            new_futex = _futex_create(&key, !(op_flags & FUTEX_PRIVATE));
+            if (!new_futex)
             {
-                rt_free(futex);
-                futex = RT_NULL;
+                error = -ENOMEM;
             }
             else
             {
-                if (futex_global_table_add(key, futex))
+                if (op_flags & FUTEX_PRIVATE)
                 {
-                    rt_object_delete(obj);
-                    rt_free(futex);
-                    futex = RT_NULL;
+                    LWP_LOCK(lwp);
                 }
-                else
+
+                /* someone may have created it while we were allocating */
+                rt_spin_lock(&bucket->lock);
+                futex = futex_hash_find_locked(bucket, &key);
+                if (!futex)
                 {
-                    futex->mutex = RT_NULL;
-                    rt_list_init(&(futex->waiting_thread));
-                    futex->custom_obj = obj;
+                    futex_hash_add_locked(bucket, new_futex);
+                    futex = new_futex;
+                    new_futex = RT_NULL;
+                }
+                stale = _futex_ref_locked(futex);
+                rt_spin_unlock(&bucket->lock);
+
+                if (op_flags & FUTEX_PRIVATE)
+                {
+                    if (!new_futex)
+                    {
+                        rt_list_insert_before(&lwp->futex_list,
+                                              &futex->lwp_node);
+                    }
+                    LWP_UNLOCK(lwp);
+                }
+
+                if (new_futex)
+                {
+                    rt_free(new_futex);
                 }
             }
         }
+
+        if (stale)
+        {
+            rt_mutex_delete(stale);
+        }
     }
+
+    *rc = error;
     return futex;
 }
 
 /**
- * Get a Shared FuTeX (sftx) match the (lwp, uaddr, op)
+ * Take the bucket locks and read the futex word. The locks disable the
+ * preemption so the word can't be faulted in with them taken. The frame is
+ * looked up under the aspace lock and pinned, then read through its kernel
+ * address, so the read is safe even if the user mapping goes away meanwhile.
+ * If the page is not present, fault it in out of the locks and retry.
+ *
+ * Return 0 with the bucket locks taken, or -EFAULT without them.
  */
-static rt_futex_t _sftx_get(void *uaddr, struct rt_lwp *lwp, int op,
-                            rt_err_t *rc)
+static int _futex_lock_and_get_word(struct rt_lwp *lwp, int *uaddr,
+                                    futex_hash_bucket_t bucket1,
+                                    futex_hash_bucket_t bucket2, int *word)
 {
-    rt_futex_t futex = RT_NULL;
-    struct shared_futex_key key;
-    rt_varea_t varea;
-    rt_err_t error = -1;
+    void *paddr;
+    char *page = RT_NULL;
 
-    RD_LOCK(lwp->aspace);
-    varea = rt_aspace_query(lwp->aspace, uaddr);
-    if (varea)
+    while (1)
     {
-        key.mobj = varea->mem_obj;
-        key.offset = ((varea->offset) << MM_PAGE_SHIFT) |
-                     ((long)uaddr & ((1 << MM_PAGE_SHIFT) - 1));
-        RD_UNLOCK(lwp->aspace);
-
-        /* query for the key */
-        _futex_lock(lwp, op & ~FUTEX_PRIVATE);
-        error = futex_global_table_find(&key, &futex);
-        if (error != RT_EOK)
+        RD_LOCK(lwp->aspace);
+        paddr = _lwp_v2p(lwp, uaddr);
+        if (paddr != ARCH_MAP_FAILED)
         {
-            /* not found, do allocation */
-            futex = _sftx_create(&key, lwp);
-            if (!futex)
-                error = -ENOMEM;
-            else
-                error = 0;
+            page = rt_kmem_p2v((void *)((rt_ubase_t)paddr & ~ARCH_PAGE_MASK));
+            if (page)
+            {
+                rt_page_ref_inc(page, 0);
+            }
         }
-        _futex_unlock(lwp, op & ~FUTEX_PRIVATE);
-    }
-    else
-    {
         RD_UNLOCK(lwp->aspace);
-    }
-
-    *rc = error;
-    return futex;
-}
 
-/* must have futex address_search_head taken */
-static rt_futex_t _futex_get(void *uaddr, struct rt_lwp *lwp, int op_flags,
-                             rt_err_t *rc)
-{
-    rt_futex_t futex = RT_NULL;
+        if (paddr != ARCH_MAP_FAILED)
+        {
+            break;
+        }
 
-    if (op_flags & FUTEX_PRIVATE)
-    {
-        futex = _pftx_get(uaddr, lwp, op_flags, rc);
+        if (lwp_get_from_user(word, uaddr, sizeof(*word)) != sizeof(*word))
+        {
+            return -EFAULT;
+        }
     }
-    else
+
+    /* not a frame of the page allocator */
+    if (!page)
     {
-        futex = _sftx_get(uaddr, lwp, op_flags, rc);
+        return -EFAULT;
     }
 
-    return futex;
+    _futex_bucket_lock2(bucket1, bucket2);
+    *word = *(volatile int *)(page + ((rt_ubase_t)paddr & ARCH_PAGE_MASK));
+    rt_pages_free(page, 0);
+
+    return 0;
 }
 
 static rt_err_t _suspend_thread_timeout_locked(rt_thread_t thread,
@@ -389,12 +416,71 @@ exit:
     return err;
 }
 
+/**
+ * Convert the timeout of wait to ticks. FUTEX_WAIT takes a relative timeout,
+ * while FUTEX_WAIT_BITSET takes an absolute one measured against the
+ * CLOCK_MONOTONIC, or the CLOCK_REALTIME if FUTEX_CLOCK_REALTIME is set.
+ */
+static rt_err_t _futex_timeout_to_tick(const struct timespec *timeout,
+                                       rt_bool_t absolute, int op_flags,
+                                       rt_tick_t *tick)
+{
+    struct timespec now;
+    rt_int64_t sec, nsec, to;
+
+    if (!timeout)
+    {
+        *tick = RT_WAITING_FOREVER;
+        return RT_EOK;
+    }
+
+    if (timeout->tv_sec < 0 || timeout->tv_nsec < 0 ||
+        timeout->tv_nsec >= NANOSECOND_PER_SECOND)
+    {
+        return -EINVAL;
+    }
+
+    sec = timeout->tv_sec;
+    nsec = timeout->tv_nsec;
+    if (absolute)
+    {
+        clock_gettime((op_flags & FUTEX_CLOCK_REALTIME) ? CLOCK_REALTIME
+                                                        : CLOCK_MONOTONIC,
+                      &now);
+        sec -= now.tv_sec;
+        nsec -= now.tv_nsec;
+        if (nsec < 0)
+        {
+            nsec += NANOSECOND_PER_SECOND;
+            sec--;
+        }
+        if (sec < 0)
+        {
+            return -ETIMEDOUT;
+        }
+    }
+
+    to = sec * RT_TICK_PER_SECOND + nsec * RT_TICK_PER_SECOND / NANOSECOND_PER_SECOND;
+    if (to >= RT_TICK_MAX / 2)
+    {
+        to = RT_TICK_MAX / 2 - 1;
+    }
+    *tick = (rt_tick_t)to;
+
+    return RT_EOK;
+}
+
 static int _futex_wait(rt_futex_t futex, struct rt_lwp *lwp, int *uaddr,
-                       int value, const struct timespec *timeout, int op_flags)
+                       int value, rt_tick_t timeout, rt_uint32_t bitset)
 {
-    rt_tick_t to;
     rt_thread_t thread;
-    rt_err_t rc = -RT_EINTR;
+    rt_err_t rc;
+    int word;
+
+    if (!bitset)
+    {
+        return -EINVAL;
+    }
 
     /**
      * Brief: Remove current thread from scheduler, besides appends it to
@@ -402,40 +488,30 @@ static int _futex_wait(rt_futex_t futex, struct rt_lwp *lwp, int *uaddr,
      * a timer will be setup for current thread
      *
      * Note: Critical Section
-     * - futex.waiting (RW; Protected by lwp_lock)
+     * - futex.waiting (RW; Protected by the bucket lock)
      * - the local cpu
      */
-    _futex_lock(lwp, op_flags);
-    if (*uaddr == value)
+    rc = _futex_lock_and_get_word(lwp, uaddr, futex->bucket, futex->bucket, &word);
+    if (rc)
+    {
+        rt_set_errno(EFAULT);
+        return rc;
+    }
+
+    if (word == value)
     {
         thread = rt_thread_self();
+        thread->futex_bitset = bitset;
 
-        if (timeout)
+        if (timeout != RT_WAITING_FOREVER)
         {
-            to = timeout->tv_sec * RT_TICK_PER_SECOND;
-            to +=
-                (timeout->tv_nsec * RT_TICK_PER_SECOND) / NANOSECOND_PER_SECOND;
-
-            if (to < 0)
-            {
-                rc = -EINVAL;
-                _futex_unlock(lwp, op_flags);
-            }
-            else
-            {
-                rt_enter_critical();
-                rc = _suspend_thread_timeout_locked(thread, futex, to);
-                _futex_unlock(lwp, op_flags);
-                rt_exit_critical();
-            }
+            rc = _suspend_thread_timeout_locked(thread, futex, timeout);
         }
         else
         {
-            rt_enter_critical();
             rc = _suspend_thread_locked(thread, futex);
-            _futex_unlock(lwp, op_flags);
-            rt_exit_critical();
         }
+        rt_spin_unlock(&futex->bucket->lock);
 
         if (rc == RT_EOK)
         {
@@ -448,7 +524,7 @@ static int _futex_wait(rt_futex_t futex, struct rt_lwp *lwp, int *uaddr,
     }
     else
     {
-        _futex_unlock(lwp, op_flags);
+        rt_spin_unlock(&futex->bucket->lock);
         rc = -EAGAIN;
         rt_set_errno(EAGAIN);
     }
@@ -456,33 +532,56 @@ static int _futex_wait(rt_futex_t futex, struct rt_lwp *lwp, int *uaddr,
     return rc;
 }
 
-static long _futex_wake(rt_futex_t futex, struct rt_lwp *lwp, int number,
-                        int op_flags)
+/**
+ * Wakeup at most number of threads waiting on the futex whose bitset
+ * intersects with the given one. The bucket lock must be taken.
+ */
+static long _futex_wake_locked(rt_futex_t futex, int number,
+                               rt_uint32_t bitset)
 {
     long woken_cnt = 0;
-    int is_empty = 0;
+    rt_list_t *node, *next;
+    rt_thread_t thread;
+    rt_sched_lock_level_t slvl;
 
     /**
-     * Brief: Wakeup a suspended thread on the futex waiting thread list
+     * Brief: Wakeup the suspended threads on the futex waiting thread list
      *
      * Note: Critical Section
      * - the futex waiting_thread list (RW)
      */
-    while (number && !is_empty)
+    rt_sched_lock(&slvl);
+    node = futex->waiting_thread.next;
+    while (number > 0 && node != &futex->waiting_thread)
     {
-        _futex_lock(lwp, op_flags);
-        if (rt_susp_list_dequeue(&futex->waiting_thread, RT_EOK))
+        next = node->next;
+        thread = RT_THREAD_LIST_NODE_ENTRY(node);
+        if ((thread->futex_bitset & bitset) &&
+            rt_sched_thread_ready(thread) == RT_EOK)
         {
+            thread->error = RT_EOK;
             number--;
             woken_cnt++;
-            is_empty = RT_FALSE;
-        }
-        else
-        {
-            is_empty = RT_TRUE;
         }
-        _futex_unlock(lwp, op_flags);
+        node = next;
     }
+    rt_sched_unlock(slvl);
+
+    return woken_cnt;
+}
+
+static long _futex_wake(rt_futex_t futex, int number, rt_uint32_t bitset)
+{
+    long woken_cnt;
+
+    if (!bitset)
+    {
+        return -EINVAL;
+    }
+
+    rt_spin_lock(&futex->bucket->lock);
+    woken_cnt = _futex_wake_locked(futex, number, bitset);
+    rt_spin_unlock(&futex->bucket->lock);
 
     /* do schedule */
     rt_schedule();
@@ -494,72 +593,175 @@ static long _futex_wake(rt_futex_t futex, struct rt_lwp *lwp, int number,
  *      If there are more waiters waiting on futex1 than nr_wake,
  *      insert the remaining at most nr_requeue waiters waiting
  *      on futex1 into the waiting queue of futex2.
+ *      The bucket locks of both futexes must be taken.
  */
-static long _futex_requeue(rt_futex_t futex1, rt_futex_t futex2,
-                           struct rt_lwp *lwp, int nr_wake, int nr_requeue,
-                           int opflags)
+static long _futex_requeue_locked(rt_futex_t futex1, rt_futex_t futex2,
+                                  int nr_wake, int nr_requeue)
 {
     long rtn;
-    long woken_cnt = 0;
-    int is_empty = 0;
     rt_thread_t thread;
+    rt_sched_lock_level_t slvl;
 
     if (futex1 == futex2)
     {
         return -EINVAL;
     }
 
+    rtn = _futex_wake_locked(futex1, nr_wake, FUTEX_BITSET_MATCH_ANY);
+
     /**
-     * Brief: Wakeup a suspended thread on the futex waiting thread list
+     * Brief: Requeue
      *
      * Note: Critical Section
      * - the futex waiting_thread list (RW)
      */
-    while (nr_wake && !is_empty)
+    rt_sched_lock(&slvl);
+    while (nr_requeue > 0 && !rt_list_isempty(&(futex1->waiting_thread)))
     {
-        if (rt_susp_list_dequeue(&futex1->waiting_thread, RT_EOK))
-        {
-            nr_wake--;
-            woken_cnt++;
-            is_empty = RT_FALSE;
-        }
-        else
-        {
-            is_empty = RT_TRUE;
-        }
+        /* moving from one susp list to another */
+        thread = RT_THREAD_LIST_NODE_ENTRY(futex1->waiting_thread.next);
+        rt_list_remove(&RT_THREAD_LIST_NODE(thread));
+        rt_list_insert_before(&(futex2->waiting_thread),
+                              &RT_THREAD_LIST_NODE(thread));
+        nr_requeue--;
+        rtn++;
     }
-    rtn = woken_cnt;
+    rt_sched_unlock(slvl);
 
-    /**
-     * Brief: Requeue
-     *
-     * Note: Critical Section
-     * - the futex waiting_thread list (RW)
-     */
-    while (!is_empty && nr_requeue)
+    return rtn;
+}
+
+/**
+ * Apply the operation encoded in FUTEX_WAKE_OP to the word at uaddr and
+ * return the result of comparing its old value, or a negative errno.
+ */
+static int _futex_atomic_op(int *uaddr, int encoded_op)
+{
+    int op = (encoded_op >> 28) & 7;
+    int cmp = (encoded_op >> 24) & 15;
+    int oparg = (int)((rt_uint32_t)encoded_op << 8) >> 20;
+    int cmparg = (int)((rt_uint32_t)encoded_op << 20) >> 20;
+    int oldval, newval;
+
+    if (encoded_op & (FUTEX_OP_OPARG_SHIFT << 28))
     {
-        rt_sched_lock_level_t slvl;
-        rt_sched_lock(&slvl);
+        oparg = 1 << (oparg & 31);
+    }
 
-        /* moving from one susp list to another */
-        is_empty = rt_list_isempty(&(futex1->waiting_thread));
+    if (!lwp_user_accessable((void *)uaddr, sizeof(*uaddr)))
+    {
+        return -EFAULT;
+    }
 
-        if (!is_empty)
+    oldval = *(volatile int *)uaddr;
+    do
+    {
+        switch (op)
         {
-            thread = RT_THREAD_LIST_NODE_ENTRY(futex1->waiting_thread.next);
-            rt_list_remove(&RT_THREAD_LIST_NODE(thread));
-            rt_list_insert_before(&(futex2->waiting_thread),
-                                  &RT_THREAD_LIST_NODE(thread));
-            nr_requeue--;
-            rtn++;
+            case FUTEX_OP_SET:
+                newval = oparg;
+                break;
+            case FUTEX_OP_ADD:
+                newval = oldval + oparg;
+                break;
+            case FUTEX_OP_OR:
+                newval = oldval | oparg;
+                break;
+            case FUTEX_OP_ANDN:
+                newval = oldval & ~oparg;
+                break;
+            case FUTEX_OP_XOR:
+                newval = oldval ^ oparg;
+                break;
+            default:
+                return -ENOSYS;
         }
-        rt_sched_unlock(slvl);
+    } while (!atomic_compare_exchange_strong(uaddr, &oldval, newval));
+
+    switch (cmp)
+    {
+        case FUTEX_OP_CMP_EQ:
+            return oldval == cmparg;
+        case FUTEX_OP_CMP_NE:
+            return oldval != cmparg;
+        case FUTEX_OP_CMP_LT:
+            return oldval < cmparg;
+        case FUTEX_OP_CMP_LE:
+            return oldval <= cmparg;
+        case FUTEX_OP_CMP_GT:
+            return oldval > cmparg;
+        case FUTEX_OP_CMP_GE:
+            return oldval >= cmparg;
+        default:
+            return -ENOSYS;
+    }
+}
+
+/**
+ *  Brief: Modify the word of futex2 and wake up to nr_wake futex1 threads,
+ *      besides up to nr_wake2 futex2 threads if the old value of the word
+ *      satisfies the condition encoded in the operation.
+ *
+ *  Note: the word is modified before taking the bucket locks, a waiter that
+ *      sampled the old value has been queued when the locks are taken.
+ */
+static long _futex_wake_op(rt_futex_t futex1, rt_futex_t futex2, int *uaddr2,
+                           int nr_wake, int nr_wake2, int encoded_op)
+{
+    long woken_cnt;
+    int cond;
+
+    cond = _futex_atomic_op(uaddr2, encoded_op);
+    if (cond < 0)
+    {
+        return cond;
     }
 
+    _futex_bucket_lock2(futex1->bucket, futex2->bucket);
+    woken_cnt = _futex_wake_locked(futex1, nr_wake, FUTEX_BITSET_MATCH_ANY);
+    if (cond)
+    {
+        woken_cnt += _futex_wake_locked(futex2, nr_wake2,
+                                        FUTEX_BITSET_MATCH_ANY);
+    }
+    _futex_bucket_unlock2(futex1->bucket, futex2->bucket);
+
     /* do schedule */
     rt_schedule();
+    return woken_cnt;
+}
 
-    return rtn;
+/**
+ * Create the pi mutex of futex which is owned by the given thread
+ */
+static rt_err_t _futex_pi_mutex_init(rt_futex_t futex, rt_thread_t owner)
+{
+    rt_mutex_t mutex;
+
+    /* creation can't be done with the bucket lock taken */
+    mutex = rt_mutex_create("futexpi", RT_IPC_FLAG_PRIO);
+    if (mutex == RT_NULL)
+    {
+        return -ENOMEM;
+    }
+
+    rt_spin_lock(&futex->bucket->lock);
+    if (futex->mutex == RT_NULL)
+    {
+        /* the owner has taken it in user space */
+        rt_mutex_set_owner(mutex, owner);
+
+        futex->mutex = mutex;
+        mutex = RT_NULL;
+    }
+    rt_spin_unlock(&futex->bucket->lock);
+
+    if (mutex)
+    {
+        rt_mutex_delete(mutex);
+    }
+
+    return RT_EOK;
 }
 
 /* timeout argument measured against the CLOCK_REALTIME clock. */
@@ -580,8 +782,10 @@ static long _futex_lock_pi(rt_futex_t futex, struct rt_lwp *lwp, int *uaddr,
 
     current_thread = rt_thread_self();
 
-    _futex_lock(lwp, op_flags);
-
+    /**
+     * Note: the word is only accessed by atomic operations, the bucket lock
+     * is not taken here since the access may fault
+     */
     lwp_get_from_user(&word, (void *)uaddr, sizeof(int));
     tid = word & FUTEX_TID_MASK;
     if (word == 0)
@@ -591,10 +795,8 @@ static long _futex_lock_pi(rt_futex_t futex, struct rt_lwp *lwp, int *uaddr,
         nword = current_thread->tid;
         if (_futex_cmpxchg_value(&cword, uaddr, word, nword))
         {
-            _futex_unlock(lwp, op_flags);
             return -EAGAIN;
         }
-        _futex_unlock(lwp, op_flags);
         return 0;
     }
     else
@@ -602,7 +804,6 @@ static long _futex_lock_pi(rt_futex_t futex, struct rt_lwp *lwp, int *uaddr,
         thread = lwp_tid_get_thread_and_inc_ref(tid);
         if (thread == RT_NULL)
         {
-            _futex_unlock(lwp, op_flags);
             return -ESRCH;
         }
         lwp_tid_dec_ref(thread);
@@ -611,7 +812,6 @@ static long _futex_lock_pi(rt_futex_t futex, struct rt_lwp *lwp, int *uaddr,
             word | FUTEX_WAITERS;
         if (_futex_cmpxchg_value(&cword, uaddr, word, nword))
         {
-            _futex_unlock(lwp, op_flags);
             return -EAGAIN;
         }
         word = nword;
@@ -619,18 +819,11 @@ static long _futex_lock_pi(rt_futex_t futex, struct rt_lwp *lwp, int *uaddr,
 
     if (futex->mutex == RT_NULL)
     {
-        futex->mutex = rt_mutex_create("futexpi", RT_IPC_FLAG_PRIO);
-        if (futex->mutex == RT_NULL)
+        err = _futex_pi_mutex_init(futex, thread);
+        if (err)
         {
-            _futex_unlock(lwp, op_flags);
-            return -ENOMEM;
+            return err;
         }
-
-        /* set mutex->owner */
-        rt_spin_lock(&(futex->mutex->spinlock));
-        futex->mutex->owner = thread;
-        futex->mutex->hold = 1;
-        rt_spin_unlock(&(futex->mutex->spinlock));
     }
     if (timeout)
     {
@@ -641,7 +834,6 @@ static long _futex_lock_pi(rt_futex_t futex, struct rt_lwp *lwp, int *uaddr,
     {
         to = RT_WAITING_NO;
     }
-    _futex_unlock(lwp, op_flags);
 
     err = rt_mutex_take_interruptible(futex->mutex, to);
     if (err == -RT_ETIMEOUT)
@@ -649,46 +841,54 @@ static long _futex_lock_pi(rt_futex_t futex, struct rt_lwp *lwp, int *uaddr,
         err = -EDEADLK;
     }
 
-    _futex_lock(lwp, op_flags);
     nword = current_thread->tid | FUTEX_WAITERS;
     if (_futex_cmpxchg_value(&cword, uaddr, word, nword))
     {
         err = -EAGAIN;
     }
-    _futex_unlock(lwp, op_flags);
 
     return err;
 }
 
 static long _futex_unlock_pi(rt_futex_t futex, struct rt_lwp *lwp, int op_flags)
 {
-    rt_err_t err = 0;
-    _futex_lock(lwp, op_flags);
-    if (!futex->mutex)
+    rt_mutex_t mutex;
+
+    rt_spin_lock(&futex->bucket->lock);
+    mutex = futex->mutex;
+    rt_spin_unlock(&futex->bucket->lock);
+
+    if (!mutex)
     {
-        _futex_unlock(lwp, op_flags);
         return -EPERM;
     }
-    _futex_unlock(lwp, op_flags);
 
-    err = rt_mutex_release(futex->mutex);
-    return err;
+    return rt_mutex_release(mutex);
 }
 
 #include <syscall_generic.h>
 
+#define FUTEX_FLAGS (FUTEX_PRIVATE | FUTEX_CLOCK_REALTIME)
+
 rt_inline rt_bool_t _timeout_ignored(int op)
 {
     /**
-     * if (op &
-     * (FUTEX_WAKE|FUTEX_FD|FUTEX_WAKE_BITSET|FUTEX_TRYLOCK_PI|FUTEX_UNLOCK_PI))
-     * was TRUE `timeout` should be ignored by implementation, according to
-     * POSIX futex(2) manual. since only FUTEX_WAKE is implemented in rt-smart,
-     * only FUTEX_WAKE was omitted currently
+     * `timeout` should be ignored by implementation for these ops, according
+     * to POSIX futex(2) manual. Some of them pass an integer by it instead.
      */
-    return ((op & (FUTEX_WAKE)) || (op & (FUTEX_REQUEUE)) ||
-            (op & (FUTEX_CMP_REQUEUE)) || (op & (FUTEX_UNLOCK_PI)) ||
-            (op & (FUTEX_TRYLOCK_PI)));
+    switch (op & ~FUTEX_FLAGS)
+    {
+        case FUTEX_WAKE:
+        case FUTEX_REQUEUE:
+        case FUTEX_CMP_REQUEUE:
+        case FUTEX_WAKE_OP:
+        case FUTEX_UNLOCK_PI:
+        case FUTEX_TRYLOCK_PI:
+        case FUTEX_WAKE_BITSET:
+            return RT_TRUE;
+        default:
+            return RT_FALSE;
+    }
 }
 
 sysret_t sys_futex(int *uaddr, int op, int val, const struct timespec *timeout,
@@ -715,12 +915,13 @@ sysret_t sys_futex(int *uaddr, int op, int val, const struct timespec *timeout,
     return ret;
 }
 
-#define FUTEX_FLAGS (FUTEX_PRIVATE | FUTEX_CLOCK_REALTIME)
 rt_err_t lwp_futex(struct rt_lwp *lwp, int *uaddr, int op, int val,
                    const struct timespec *timeout, int *uaddr2, int val3)
 {
-    rt_futex_t futex, futex2;
+    rt_futex_t futex, futex2 = RT_NULL;
     rt_err_t rc = 0;
+    rt_tick_t to;
+    int word;
     int op_type = op & ~FUTEX_FLAGS;
     int op_flags = op & FUTEX_FLAGS;
 
@@ -730,38 +931,68 @@ rt_err_t lwp_futex(struct rt_lwp *lwp, int *uaddr, int op, int val,
         switch (op_type)
         {
             case FUTEX_WAIT:
-                rc = _futex_wait(futex, lwp, uaddr, val, timeout, op_flags);
+                rc = _futex_timeout_to_tick(timeout, RT_FALSE, op_flags, &to);
+                if (!rc)
+                {
+                    rc = _futex_wait(futex, lwp, uaddr, val, to,
+                                     FUTEX_BITSET_MATCH_ANY);
+                }
+                break;
+            case FUTEX_WAIT_BITSET:
+                rc = _futex_timeout_to_tick(timeout, RT_TRUE, op_flags, &to);
+                if (!rc)
+                {
+                    rc = _futex_wait(futex, lwp, uaddr, val, to, val3);
+                }
                 break;
             case FUTEX_WAKE:
-                rc = _futex_wake(futex, lwp, val, op_flags);
+                rc = _futex_wake(futex, val, FUTEX_BITSET_MATCH_ANY);
                 break;
-            case FUTEX_REQUEUE:
+            case FUTEX_WAKE_BITSET:
+                rc = _futex_wake(futex, val, val3);
+                break;
+            case FUTEX_WAKE_OP:
                 futex2 = _futex_get(uaddr2, lwp, op_flags, &rc);
                 if (!rc)
                 {
-                    _futex_lock(lwp, op_flags);
-                    rc = _futex_requeue(futex, futex2, lwp, val, (long)timeout,
-                                        op_flags);
-                    _futex_unlock(lwp, op_flags);
+                    rc = _futex_wake_op(futex, futex2, uaddr2, val,
+                                        (long)timeout, val3);
                 }
                 break;
-            case FUTEX_CMP_REQUEUE:
+            case FUTEX_REQUEUE:
                 futex2 = _futex_get(uaddr2, lwp, op_flags, &rc);
-                _futex_lock(lwp, op_flags);
-                if (*uaddr == val3)
-                {
-                    rc = 0;
-                }
-                else
+                if (!rc)
                 {
-                    rc = -EAGAIN;
+                    _futex_bucket_lock2(futex->bucket, futex2->bucket);
+                    rc = _futex_requeue_locked(futex, futex2, val,
+                                               (long)timeout);
+                    _futex_bucket_unlock2(futex->bucket, futex2->bucket);
+                    rt_schedule();
                 }
-                if (rc == 0)
+                break;
+            case FUTEX_CMP_REQUEUE:
+                futex2 = _futex_get(uaddr2, lwp, op_flags, &rc);
+                if (!rc)
                 {
-                    rc = _futex_requeue(futex, futex2, lwp, val,
-                                        (long)timeout, op_flags);
+                    rc = _futex_lock_and_get_word(lwp, uaddr, futex->bucket,
+                                                  futex2->bucket, &word);
+                    if (rc)
+                    {
+                        break;
+                    }
+
+                    if (word == val3)
+                    {
+                        rc = _futex_requeue_locked(futex, futex2, val,
+                                                   (long)timeout);
+                    }
+                    else
+                    {
+                        rc = -EAGAIN;
+                    }
+                    _futex_bucket_unlock2(futex->bucket, futex2->bucket);
+                    rt_schedule();
                 }
-                _futex_unlock(lwp, op_flags);
                 break;
             case FUTEX_LOCK_PI:
                 rc = _futex_lock_pi(futex, lwp, uaddr, timeout, op_flags,
@@ -778,6 +1009,9 @@ rt_err_t lwp_futex(struct rt_lwp *lwp, int *uaddr, int op, int val,
                 rc = -ENOSYS;
                 break;
         }
+
+        _futex_put(futex2);
+        _futex_put(futex);
     }
 
     return rc;
@@ -832,9 +1066,12 @@ retry:
     }
 
     futex = _futex_get(uaddr, lwp, FUTEX_PRIVATE, &rc);
+    if (rc)
+        return -1;
+
     if (is_pending_op && !is_pi && !word)
     {
-        _futex_wake(futex, lwp, 1, FUTEX_PRIVATE);
+        _futex_wake(futex, 1, FUTEX_BITSET_MATCH_ANY);
         return 0;
     }
 
@@ -862,7 +1099,7 @@ retry:
         goto retry;
 
     if (!is_pi && (word & FUTEX_WAITERS))
-        _futex_wake(futex, lwp, 1, FUTEX_PRIVATE);
+        _futex_wake(futex, 1, FUTEX_BITSET_MATCH_ANY);
 
     return 0;
 }
@@ -14,7 +14,6 @@
 #define DBG_LVL DBG_INFO
 #include <rtdbg.h>
 
-#include "rt_uthash.h"
 #include "lwp_internal.h"
 #include "lwp_pid.h"
 
@@ -25,30 +24,58 @@
 #include <lwp_user_mm.h>
 #endif /* ARCH_MM_MMU */
 
-struct shared_futex_key
+#ifndef LWP_FUTEX_HASH_BITS
+#define LWP_FUTEX_HASH_BITS 6
+#endif /* LWP_FUTEX_HASH_BITS */
+
+#define FUTEX_HASH_SIZE (1ul << LWP_FUTEX_HASH_BITS)
+
+/**
+ * The key of a futex. A private futex is keyed by (aspace, uaddr), a shared
+ * one by (mem_obj, offset) so that every mapping of the same memory object
+ * hits the same futex.
+ */
+struct futex_key
 {
-    rt_mem_obj_t mobj;
+    void *base;
     rt_base_t offset;
 };
-DEFINE_RT_UTHASH_TYPE(shared_futex_entry, struct shared_futex_key, key);
+
+/**
+ * A bucket of the futex hash table. The lock protects the hash chain and
+ * serializes the check of the user word against the suspension of waiters
+ * on every futex in the bucket.
+ */
+struct futex_hash_bucket
+{
+    struct rt_spinlock lock;
+    rt_list_t chain;
+};
+typedef struct futex_hash_bucket *futex_hash_bucket_t;
 
 struct rt_futex
 {
-    union {
-        /* for private futex */
-        struct lwp_avl_struct node;
-        /* for shared futex */
-        struct shared_futex_entry entry;
-    };
+    rt_list_t hash_node;
+    struct futex_key key;
+    futex_hash_bucket_t bucket;
+
+    /* for private futex, node in the futex_list of owner lwp */
+    rt_list_t lwp_node;
+    /* for shared futex, number of ops using it, protected by the bucket lock */
+    rt_bool_t shared;
+    int ref_count;
 
     rt_list_t waiting_thread;
-    struct rt_object *custom_obj;
     rt_mutex_t mutex;
 };
 typedef struct rt_futex *rt_futex_t;
 
-rt_err_t futex_global_table_add(struct shared_futex_key *key, rt_futex_t futex);
-rt_err_t futex_global_table_find(struct shared_futex_key *key, rt_futex_t *futex);
-rt_err_t futex_global_table_delete(struct shared_futex_key *key);
+void futex_hash_init(void);
+futex_hash_bucket_t futex_hash_bucket(struct futex_key *key);
+rt_futex_t futex_hash_find_locked(futex_hash_bucket_t bucket,
+                                  struct futex_key *key);
+void futex_hash_add_locked(futex_hash_bucket_t bucket, rt_futex_t futex);
+void futex_hash_delete(rt_futex_t futex);
+void futex_hash_reap(rt_bool_t (*unused)(rt_futex_t futex), rt_list_t *reaped);
 
 #endif /* __LWP_FUTEX_INTERNAL_H__ */
@@ -10,56 +10,99 @@
 
 #include "lwp_futex_internal.h"
 
-static struct shared_futex_entry *_futex_hash_head;
+static struct futex_hash_bucket _futex_hash_table[FUTEX_HASH_SIZE];
 
-rt_err_t futex_global_table_add(struct shared_futex_key *key, rt_futex_t futex)
+void futex_hash_init(void)
 {
-    rt_err_t rc = 0;
-    struct shared_futex_entry *entry = &futex->entry;
-    futex->entry.key.mobj = key->mobj;
-    futex->entry.key.offset = key->offset;
+    rt_size_t i;
 
-    RT_UTHASH_ADD(_futex_hash_head, key, sizeof(struct shared_futex_key), entry);
-    return rc;
+    for (i = 0; i < FUTEX_HASH_SIZE; i++)
+    {
+        rt_spin_lock_init(&_futex_hash_table[i].lock);
+        rt_list_init(&_futex_hash_table[i].chain);
+    }
 }
 
-rt_err_t futex_global_table_find(struct shared_futex_key *key, rt_futex_t *futex)
+futex_hash_bucket_t futex_hash_bucket(struct futex_key *key)
 {
-    rt_err_t rc;
-    rt_futex_t found_futex;
-    struct shared_futex_entry *entry;
+    rt_ubase_t hash;
 
-    RT_UTHASH_FIND(_futex_hash_head, key, sizeof(struct shared_futex_key), entry);
-    if (entry)
-    {
-        rc = RT_EOK;
-        found_futex = rt_container_of(entry, struct rt_futex, entry);
-    }
-    else
+    /* futex words are 4-byte aligned, drop the bits that never change */
+    hash = ((rt_ubase_t)key->base >> 4) ^ ((rt_ubase_t)key->offset >> 2);
+#ifdef ARCH_CPU_64BIT
+    hash ^= hash >> 32;
+#endif /* ARCH_CPU_64BIT */
+    hash = (rt_uint32_t)hash * 0x9e3779b1u;
+    hash >>= 32 - LWP_FUTEX_HASH_BITS;
+
+    return &_futex_hash_table[hash & (FUTEX_HASH_SIZE - 1)];
+}
+
+/**
+ * Find the futex matching the key. The bucket lock must be taken.
+ */
+rt_futex_t futex_hash_find_locked(futex_hash_bucket_t bucket,
+                                  struct futex_key *key)
+{
+    rt_futex_t futex;
+
+    rt_list_for_each_entry(futex, &bucket->chain, hash_node)
     {
-        rc = -RT_ENOENT;
-        found_futex = RT_NULL;
+        if (futex->key.base == key->base && futex->key.offset == key->offset)
+        {
+            return futex;
+        }
     }
 
-    *futex = found_futex;
-    return rc;
+    return RT_NULL;
 }
 
-rt_err_t futex_global_table_delete(struct shared_futex_key *key)
+/**
+ * Add a futex whose key has been set up. The bucket lock must be taken.
+ */
+void futex_hash_add_locked(futex_hash_bucket_t bucket, rt_futex_t futex)
 {
-    rt_err_t rc;
-    struct shared_futex_entry *entry;
+    futex->bucket = bucket;
+    rt_list_insert_after(&bucket->chain, &futex->hash_node);
+}
 
-    RT_UTHASH_FIND(_futex_hash_head, key, sizeof(struct shared_futex_key), entry);
-    if (entry)
+/**
+ * Remove a futex from the table, it's fine if it was never added
+ */
+void futex_hash_delete(rt_futex_t futex)
+{
+    futex_hash_bucket_t bucket = futex->bucket;
+
+    if (bucket)
     {
-        RT_UTHASH_DELETE(_futex_hash_head, entry);
-        rc = RT_EOK;
+        rt_spin_lock(&bucket->lock);
+        rt_list_remove(&futex->hash_node);
+        futex->bucket = RT_NULL;
+        rt_spin_unlock(&bucket->lock);
     }
-    else
+}
+
+/**
+ * Move the futexes found unused out of the table onto the reaped list, linked
+ * by their lwp_node. The check is done with the bucket lock taken.
+ */
+void futex_hash_reap(rt_bool_t (*unused)(rt_futex_t futex), rt_list_t *reaped)
+{
+    rt_futex_t futex, next;
+    rt_size_t i;
+
+    for (i = 0; i < FUTEX_HASH_SIZE; i++)
     {
-        rc = -RT_ENOENT;
+        rt_spin_lock(&_futex_hash_table[i].lock);
+        rt_list_for_each_entry_safe(futex, next, &_futex_hash_table[i].chain, hash_node)
+        {
+            if (unused(futex))
+            {
+                rt_list_remove(&futex->hash_node);
+                futex->bucket = RT_NULL;
+                rt_list_insert_before(reaped, &futex->lwp_node);
+            }
+        }
+        rt_spin_unlock(&_futex_hash_table[i].lock);
     }
-
-    return rc;
 }
@@ -30,6 +30,13 @@
 #include <dfs_dentry.h>
 #endif
 
+#ifdef ARCH_MM_MMU
+#include <mm_aspace.h>
+#include <mm_memcg.h>
+#include <mm_page.h>
+#include <mmu.h>
+#endif /* ARCH_MM_MMU */
+
 /**
  * the IPC channel states
  */
@@ -40,6 +47,16 @@ enum
     RT_IPC_STAT_ACTIVE, /* suspended senders exist */
 };
 
+/**
+ * Page frames carried by a RT_CHANNEL_PAGES message. A NULL entry is a page
+ * never touched by the sender, the receiver gets a zero page on fault.
+ */
+struct rt_ipc_pages
+{
+    rt_size_t nr;
+    void *page[];
+};
+
 /**
  * IPC message structure.
  *
@@ -47,9 +64,10 @@ enum
  */
 struct rt_ipc_msg
 {
-    struct rt_channel_msg msg; /**< the payload of msg */
-    rt_list_t mlist;           /**< the msg list */
-    rt_uint8_t need_reply;     /**< whether msg wait reply*/
+    struct rt_channel_msg msg;  /**< the payload of msg */
+    rt_list_t mlist;            /**< the msg list */
+    rt_uint8_t need_reply;      /**< whether msg wait reply*/
+    struct rt_ipc_pages *pages; /**< the page frames of RT_CHANNEL_PAGES */
 };
 typedef struct rt_ipc_msg *rt_ipc_msg_t;
 
@@ -105,9 +123,221 @@ static void rt_ipc_msg_init(rt_ipc_msg_t msg, struct rt_channel_msg *data, rt_ui
     msg->need_reply = need_reply;
     msg->msg = *data;
     msg->msg.sender = (void *)rt_thread_self();
+    msg->pages = RT_NULL;
     rt_list_init(&msg->mlist);
 }
 
+#ifdef ARCH_MM_MMU
+static rt_atomic_t _ipc_pages_moved;  /* page frames transferred without copy */
+static rt_atomic_t _ipc_pages_copied; /* page frames shared with others, copied */
+
+static void _ipc_pages_release(struct rt_ipc_pages *pages)
+{
+    rt_size_t index;
+
+    for (index = 0; index < pages->nr; index++)
+    {
+        if (pages->page[index])
+        {
+            rt_pages_free(pages->page[index], 0);
+        }
+    }
+    rt_free(pages);
+}
+
+/**
+ * Take the pages of [addr, addr + length) out of the sender.
+ *
+ * Page frames of the anonymous memory owned by the sender only are moved: they
+ * are unmapped from the sender, whose range reads as zero afterwards, and
+ * the reference of the mapping is taken over by the message. Memory shared
+ * with a forked process or backed by a file is copied instead, and it stays
+ * mapped in the sender.
+ */
+static rt_err_t _ipc_pages_detach(struct rt_channel_msg *data,
+                                  struct rt_ipc_pages **ppages)
+{
+    struct rt_lwp *lwp = lwp_self();
+    struct rt_ipc_pages *pages;
+    rt_aspace_t aspace;
+    rt_varea_t varea;
+    rt_size_t index;
+    char *addr = data->u.p.addr;
+    rt_size_t length = data->u.p.length;
+    rt_bool_t shared;
+    void *page_pa;
+    void *page;
+    struct rt_mmu_gather tlb;
+
+    if (!lwp || !length || ((rt_ubase_t)addr & ARCH_PAGE_MASK) ||
+        (length & ARCH_PAGE_MASK) || !lwp_user_accessable(addr, length))
+    {
+        return -RT_EINVAL;
+    }
+
+    pages = rt_malloc(sizeof(*pages) + (length >> ARCH_PAGE_SHIFT) * sizeof(void *));
+    if (!pages)
+    {
+        return -RT_ENOMEM;
+    }
+    pages->nr = length >> ARCH_PAGE_SHIFT;
+    aspace = lwp->aspace;
+
+    /* copy the shared pages, which may fault, out of the write lock */
+    for (index = 0; index < pages->nr; index++)
+    {
+        RD_LOCK(aspace);
+        varea = rt_aspace_query(aspace, addr + (index << ARCH_PAGE_SHIFT));
+        shared = varea && varea->mem_obj != aspace->private_object;
+        RD_UNLOCK(aspace);
+
+        page = RT_NULL;
+        if (shared)
+        {
+            page = rt_pages_alloc_ext(0, PAGE_ANY_AVAILABLE);
+            if (page &&
+                rt_aspace_page_get(aspace, addr + (index << ARCH_PAGE_SHIFT), page) != RT_EOK)
+            {
+                rt_pages_free(page, 0);
+                page = RT_NULL;
+            }
+            if (!page)
+            {
+                pages->nr = index;
+                _ipc_pages_release(pages);
+                return -RT_ENOMEM;
+            }
+            rt_atomic_add(&_ipc_pages_copied, 1);
+        }
+        pages->page[index] = page;
+    }
+
+    WR_LOCK(aspace);
+    rt_mmu_gather_init(&tlb, aspace);
+    for (index = 0; index < pages->nr; index++, addr += ARCH_PAGE_SIZE)
+    {
+        varea = rt_aspace_query(aspace, addr);
+        if (pages->page[index] || !varea || varea->mem_obj != aspace->private_object)
+        {
+            continue;
+        }
+
+        page_pa = rt_hw_mmu_v2p(aspace, addr);
+        if (page_pa != ARCH_MAP_FAILED)
+        {
+            rt_hw_mmu_unmap(aspace, addr, ARCH_PAGE_SIZE);
+            /* a huge leaf failed to split is still mapped, leave it to the sender */
+            if (rt_hw_mmu_v2p(aspace, addr) != ARCH_MAP_FAILED)
+            {
+                continue;
+            }
+            pages->page[index] = rt_kmem_p2v(page_pa);
+            rt_mmu_gather_range(&tlb, addr, ARCH_PAGE_SIZE);
+            rt_memcg_uncharge(aspace->memcg, RT_MEMCG_ANON, 1);
+            rt_atomic_add(&_ipc_pages_moved, 1);
+        }
+    }
+    /* the frames are handed over, not freed; only the range is invalidated */
+    rt_mmu_gather_finish(&tlb);
+    WR_UNLOCK(aspace);
+
+    *ppages = pages;
+    return RT_EOK;
+}
+
+/**
+ * Map the pages into a new region of the receiver. The references of page
+ * frames held by the message are taken over by the mapping.
+ */
+static rt_err_t _ipc_pages_attach(struct rt_ipc_pages *pages,
+                                  struct rt_channel_msg *data)
+{
+    struct rt_lwp *lwp = lwp_self();
+    rt_varea_t varea = RT_NULL;
+    rt_size_t index;
+    char *addr;
+    rt_err_t rc = RT_EOK;
+
+    if (!lwp)
+    {
+        rc = -RT_EINVAL;
+    }
+    else
+    {
+        varea = lwp_map_user_varea(lwp, RT_NULL, pages->nr << ARCH_PAGE_SHIFT);
+        if (!varea)
+        {
+            rc = -RT_ENOMEM;
+        }
+    }
+
+    if (rc == RT_EOK)
+    {
+        addr = varea->start;
+        WR_LOCK(lwp->aspace);
+        for (index = 0; index < pages->nr; index++)
+        {
+            if (pages->page[index] &&
+                rt_varea_map_page(varea, addr + (index << ARCH_PAGE_SHIFT),
+                                  pages->page[index]) == RT_EOK)
+            {
+                pages->page[index] = RT_NULL;
+                rt_memcg_charge(lwp->aspace->memcg, RT_MEMCG_ANON, 1);
+            }
+        }
+        WR_UNLOCK(lwp->aspace);
+        rt_memcg_check(lwp->aspace->memcg);
+
+        data->u.p.addr = addr;
+        data->u.p.length = pages->nr << ARCH_PAGE_SHIFT;
+    }
+    else
+    {
+        data->u.p.addr = RT_NULL;
+        data->u.p.length = 0;
+    }
+
+    /* drop the frames failed to map */
+    _ipc_pages_release(pages);
+
+    return rc;
+}
+#else
+static void _ipc_pages_release(struct rt_ipc_pages *pages)
+{
+}
+
+static rt_err_t _ipc_pages_detach(struct rt_channel_msg *data,
+                                  struct rt_ipc_pages **ppages)
+{
+    return -RT_ENOSYS;
+}
+
+static rt_err_t _ipc_pages_attach(struct rt_ipc_pages *pages,
+                                  struct rt_channel_msg *data)
+{
+    return -RT_ENOSYS;
+}
+#endif /* ARCH_MM_MMU */
+
+/**
+ * Release the messages never received on a closing channel
+ */
+static void _ipc_msg_list_release(rt_list_t *list)
+{
+    rt_ipc_msg_t msg, next;
+
+    rt_list_for_each_entry_safe(msg, next, list, mlist)
+    {
+        rt_list_remove(&msg->mlist);
+        if (msg->pages)
+        {
+            _ipc_pages_release(msg->pages);
+        }
+        _ipc_msg_free(msg);
+    }
+}
+
 /**
  * Initialized the list of the waiting receivers on the IPC channel.
  */
@@ -302,7 +532,7 @@ rt_err_t rt_raw_channel_close(rt_channel_t ch)
                 _channel_list_resume_all_locked(&ch->wait_thread);
 
                 /* all ipc msg will lost */
-                rt_list_init(&ch->wait_msg);
+                _ipc_msg_list_release(&ch->wait_msg);
 
                 rt_object_delete(&ch->parent.parent); /* release the IPC channel structure */
             }
@@ -336,7 +566,7 @@ static rt_err_t wakeup_sender_wait_recv(void *object, struct rt_thread *thread)
             if (msg->need_reply && msg->msg.sender == thread)
             {
                 rt_list_remove(&msg->mlist); /* remove the msg from the channel */
-                _ipc_msg_free(msg);
+                thread->msg_ret = msg;       /* put back by the sender */
                 break;
             }
             l = l->next;
@@ -384,7 +614,7 @@ static void sender_timeout(void *parameter)
             if (msg->need_reply && msg->msg.sender == thread)
             {
                 rt_list_remove(&msg->mlist); /* remove the msg from the channel */
-                _ipc_msg_free(msg);
+                thread->msg_ret = msg;       /* put back by the sender */
                 break;
             }
             l = l->next;
@@ -518,6 +748,8 @@ static rt_err_t _do_send_recv_timeout(rt_channel_t ch, rt_channel_msg_t data, in
     rt_thread_t thread_send = 0;
     void (*old_timeout_func)(void *) = 0;
     rt_base_t level;
+    rt_ipc_msg_t msg_ret;
+    struct rt_ipc_pages *pages = RT_NULL;
 
     /* IPC message : file descriptor */
     if (data->type == RT_CHANNEL_FD)
@@ -527,10 +759,23 @@ static rt_err_t _do_send_recv_timeout(rt_channel_t ch, rt_channel_msg_t data, in
 
     rt_ipc_msg_init(msg, data, need_reply);
 
+    /* IPC message : page frames moved out of the sender */
+    if (data->type == RT_CHANNEL_PAGES)
+    {
+        rc = _ipc_pages_detach(data, &pages);
+        if (rc != RT_EOK)
+        {
+            _ipc_msg_free(msg);
+            return rc;
+        }
+        msg->pages = pages;
+    }
+
     if (need_reply)
     {
         thread_send = rt_thread_self();
         thread_send->error = RT_EOK;
+        thread_send->msg_ret = RT_NULL;
     }
 
     rc = RT_EOK;
@@ -651,21 +896,41 @@ static rt_err_t _do_send_recv_timeout(rt_channel_t ch, rt_channel_msg_t data, in
                                  old_timeout_func);
             }
             rc = thread_send->error;
+            msg_ret = (rt_ipc_msg_t)thread_send->msg_ret;
+            thread_send->msg_ret = RT_NULL;
 
             if (rc == RT_EOK)
             {
                 /* If the sender gets the chance to run, the requested reply must be valid. */
                 RT_ASSERT(data_ret != RT_NULL);
-                *data_ret = ((rt_ipc_msg_t)(thread_send->msg_ret))->msg; /* extract data */
-                _ipc_msg_free(thread_send->msg_ret);                     /* put back the message to kernel */
+                *data_ret = msg_ret->msg; /* extract data */
+                pages = msg_ret->pages;
+                _ipc_msg_free(msg_ret);   /* put back the message to kernel */
 
-                thread_send->msg_ret = RT_NULL;
+                if (pages)
+                {
+                    rc = _ipc_pages_attach(pages, data_ret);
+                }
+            }
+            else if (msg_ret)
+            {
+                /* the message is withdrawn before received, drop the pages */
+                if (msg_ret->pages)
+                {
+                    _ipc_pages_release(msg_ret->pages);
+                }
+                _ipc_msg_free(msg_ret);
             }
         }
     }
     else
     {
         rt_spin_unlock_irqrestore(&ch->slock, level);
+
+        if (pages)
+        {
+            _ipc_pages_release(pages);
+        }
     }
 
     return rc;
@@ -704,11 +969,17 @@ rt_err_t rt_raw_channel_reply(rt_channel_t ch, rt_channel_msg_t data)
     rt_ipc_msg_t msg;
     struct rt_thread *thread;
     rt_base_t level;
+    struct rt_ipc_pages *pages = RT_NULL;
 
     if (ch == RT_NULL)
     {
         rc = -RT_EIO;
     }
+    else if (data->type == RT_CHANNEL_PAGES &&
+             (rc = _ipc_pages_detach(data, &pages)) != RT_EOK)
+    {
+        /* IPC message : page frames moved out of the replier */
+    }
     else
     {
         level = rt_spin_lock_irqsave(&ch->slock);
@@ -736,6 +1007,8 @@ rt_err_t rt_raw_channel_reply(rt_channel_t ch, rt_channel_msg_t data)
             else
             {
                 rt_ipc_msg_init(msg, data, 0);
+                msg->pages = pages;
+                pages = RT_NULL;
 
                 thread = ch->reply;
                 thread->msg_ret = msg;    /* transfer the reply to the sender */
@@ -749,6 +1022,11 @@ rt_err_t rt_raw_channel_reply(rt_channel_t ch, rt_channel_msg_t data)
         }
         rt_spin_unlock_irqrestore(&ch->slock, level);
 
+        if (pages)
+        {
+            _ipc_pages_release(pages);
+        }
+
         rt_schedule();
     }
 
@@ -810,6 +1088,7 @@ static rt_err_t _rt_raw_channel_recv_timeout(rt_channel_t ch, rt_channel_msg_t d
     rt_ipc_msg_t msg_ret;
     void (*old_timeout_func)(void *) = 0;
     rt_base_t level;
+    struct rt_ipc_pages *pages = RT_NULL;
 
     RT_DEBUG_NOT_IN_INTERRUPT;
 
@@ -850,6 +1129,7 @@ static rt_err_t _rt_raw_channel_recv_timeout(rt_channel_t ch, rt_channel_msg_t d
             {
                 data->u.fd.fd = _ipc_msg_fd_new(data->u.fd.file);
             }
+            pages = msg_ret->pages; /* mapped out of the lock */
             _ipc_msg_free(msg_ret); /* put back the message to kernel */
             rc = RT_EOK;
         }
@@ -901,6 +1181,7 @@ static rt_err_t _rt_raw_channel_recv_timeout(rt_channel_t ch, rt_channel_msg_t d
                     {
                         data->u.fd.fd = _ipc_msg_fd_new(data->u.fd.file);
                     }
+                    pages = ((rt_ipc_msg_t)(thread->msg_ret))->pages;
                     _ipc_msg_free(thread->msg_ret); /* put back the message to kernel */
                     thread->msg_ret = RT_NULL;
                 }
@@ -911,6 +1192,12 @@ static rt_err_t _rt_raw_channel_recv_timeout(rt_channel_t ch, rt_channel_msg_t d
 
     rt_spin_unlock_irqrestore(&ch->slock, level);
 
+    /* IPC message : page frames moved into the receiver */
+    if (pages)
+    {
+        rc = _ipc_pages_attach(pages, data);
+    }
+
     LWP_RETURN(rc);
 }
 
@@ -1049,11 +1336,11 @@ static int channel_fops_close(struct dfs_file *file)
             _channel_list_resume_all_locked(&ch->parent.suspend_thread);
             _channel_list_resume_all_locked(&ch->wait_thread);
 
-            /* all ipc msg will lost */
-            rt_list_init(&ch->wait_msg);
-
             rt_spin_unlock_irqrestore(&ch->slock, level);
 
+            /* all ipc msg will lost */
+            _ipc_msg_list_release(&ch->wait_msg);
+
             rt_object_delete(&ch->parent.parent); /* release the IPC channel structure */
         }
         else
@@ -1321,6 +1608,12 @@ static int list_channel(void)
 
     rt_free(channels);
 
+#ifdef ARCH_MM_MMU
+    rt_kprintf("pages moved: %ld, pages copied: %ld\n",
+               (long)rt_atomic_load(&_ipc_pages_moved),
+               (long)rt_atomic_load(&_ipc_pages_copied));
+#endif /* ARCH_MM_MMU */
+
     return 0;
 }
 MSH_CMD_EXPORT(list_channel, list IPC channel information);
@@ -19,7 +19,8 @@ enum
 {
     RT_CHANNEL_RAW,
     RT_CHANNEL_BUFFER,
-    RT_CHANNEL_FD
+    RT_CHANNEL_FD,
+    RT_CHANNEL_PAGES
 };
 
 struct rt_channel_msg
@@ -38,6 +39,11 @@ struct rt_channel_msg
             void *file;
             int fd;
         } fd;
+        struct chpages
+        {
+            void *addr;     /* page aligned, moved out of the sender */
+            size_t length;  /* multiple of page size */
+        } p;
         void* d;
     } u;
 };
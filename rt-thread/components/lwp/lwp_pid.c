@@ -397,6 +397,7 @@ rt_lwp_t lwp_create(rt_base_t flags)
         rt_list_init(&new_lwp->t_grp);
         rt_list_init(&new_lwp->pgrp_node);
         rt_list_init(&new_lwp->timer);
+        rt_list_init(&new_lwp->futex_list);
         lwp_user_object_lock_init(new_lwp);
         rt_wqueue_init(&new_lwp->wait_queue);
         rt_wqueue_init(&new_lwp->waitpid_waiters);
@@ -483,6 +484,8 @@ void lwp_free(struct rt_lwp* lwp)
 
     lwp_user_object_clear(lwp);
     lwp_user_object_lock_destroy(lwp);
+    lwp_futex_private_clear(lwp);
+    lwp_futex_shared_reap();
 
     /* free data section */
     if (lwp->data_entry != RT_NULL)
@@ -788,10 +791,13 @@ rt_inline void _update_ru(struct rt_lwp *child, struct rt_lwp *self_lwp, struct
     struct rusage rt_rusage;
     if (uru != RT_NULL)
     {
+        rt_memset(&rt_rusage, 0, sizeof(rt_rusage));
         rt_rusage.ru_stime.tv_sec = child->rt_rusage.ru_stime.tv_sec;
         rt_rusage.ru_stime.tv_usec = child->rt_rusage.ru_stime.tv_usec;
         rt_rusage.ru_utime.tv_sec = child->rt_rusage.ru_utime.tv_sec;
         rt_rusage.ru_utime.tv_usec = child->rt_rusage.ru_utime.tv_usec;
+        rt_rusage.ru_minflt = child->rt_rusage.ru_minflt;
+        rt_rusage.ru_majflt = child->rt_rusage.ru_majflt;
         lwp_data_put(self_lwp, uru, &rt_rusage, sizeof(*uru));
     }
 }
@@ -1508,6 +1514,16 @@ static void _notify_parent(rt_lwp_t lwp)
 
 static void _resr_cleanup(struct rt_lwp *lwp)
 {
+#ifdef ARCH_MM_MMU
+    if (lwp->vfork_done)
+    {
+        /* give the aspace back to the vfork parent before it resumes */
+        lwp->aspace = RT_NULL;
+        lwp_aspace_switch(rt_thread_self());
+        lwp_vfork_done(lwp);
+    }
+#endif /* ARCH_MM_MMU */
+
     lwp_jobctrl_on_exit(lwp);
 
     LWP_LOCK(lwp);
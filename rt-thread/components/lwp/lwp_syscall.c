@@ -27,6 +27,7 @@
 
 #include <string.h>
 #include <stdint.h>
+#include <limits.h>
 
 #define DBG_TAG    "lwp.syscall"
 #define DBG_LVL    DBG_INFO
@@ -38,8 +39,10 @@
 #include "lwp_internal.h"
 #ifdef ARCH_MM_MMU
 #include <mm_aspace.h>
+#include <mm_memcg.h>
 #include <lwp_user_mm.h>
 #include <lwp_arch.h>
+#include <ipc/completion.h>
 #endif
 
 #include <fcntl.h>
@@ -53,6 +56,7 @@
 #include <dfs_file.h>
 #ifdef RT_USING_DFS_V2
 #include <dfs_dentry.h>
+#include <sys/uio.h> /* readv() */
 #endif
 #include <unistd.h>
 #include <stdio.h> /* rename() */
@@ -1990,7 +1994,7 @@ static void lwp_struct_copy(struct rt_lwp *dst, struct rt_lwp *src)
     rt_strcpy(dst->working_directory, src->working_directory);
 }
 
-static int lwp_copy_files(struct rt_lwp *dst, struct rt_lwp *src)
+int lwp_copy_files(struct rt_lwp *dst, struct rt_lwp *src)
 {
     struct dfs_fdtable *dst_fdt;
     struct dfs_fdtable *src_fdt;
@@ -2023,9 +2027,15 @@ static int lwp_copy_files(struct rt_lwp *dst, struct rt_lwp *src)
     return -RT_ERROR;
 }
 
-sysret_t _sys_fork(void)
+/**
+ * fork the current process. With is_vfork, the child shares the aspace of the
+ * parent instead of a COW copy, and the parent is suspended until the child
+ * calls execve() or exits.
+ */
+static sysret_t _lwp_fork(rt_bool_t is_vfork)
 {
     int tid = 0;
+    pid_t pid;
     sysret_t falival = 0;
     struct rt_lwp *lwp = RT_NULL;
     struct rt_lwp *self_lwp = RT_NULL;
@@ -2033,6 +2043,7 @@ sysret_t _sys_fork(void)
     rt_thread_t self_thread = RT_NULL;
     void *user_stack = RT_NULL;
     rt_processgroup_t group;
+    struct rt_completion vfork_done;
 
     /* new lwp */
     lwp = lwp_create(LWP_CREATE_FLAG_ALLOC_PID);
@@ -2049,20 +2060,30 @@ sysret_t _sys_fork(void)
         goto fail;
     }
 
-    /* user space init */
-    if (lwp_user_space_init(lwp, 1) != 0)
-    {
-        SET_ERRNO(ENOMEM);
-        goto fail;
-    }
-
     self_lwp = lwp_self();
 
-    /* copy address space of process from this proc to forked one */
-    if (lwp_fork_aspace(lwp, self_lwp) != 0)
+    if (is_vfork)
     {
-        SET_ERRNO(ENOMEM);
-        goto fail;
+        /* borrow the address space, it's given back on execve() or exit */
+        rt_completion_init(&vfork_done);
+        lwp->aspace = self_lwp->aspace;
+        lwp->vfork_done = &vfork_done;
+    }
+    else
+    {
+        /* user space init */
+        if (lwp_user_space_init(lwp, 1) != 0)
+        {
+            SET_ERRNO(ENOMEM);
+            goto fail;
+        }
+
+        /* copy address space of process from this proc to forked one */
+        if (lwp_fork_aspace(lwp, self_lwp) != 0)
+        {
+            SET_ERRNO(ENOMEM);
+            goto fail;
+        }
     }
 
     /* copy lwp struct data */
@@ -2096,7 +2117,8 @@ sysret_t _sys_fork(void)
     thread->user_stack_size = self_thread->user_stack_size;
     thread->signal.sigset_mask = self_thread->signal.sigset_mask;
     thread->thread_idr = self_thread->thread_idr;
-    thread->clear_child_tid = self_thread->clear_child_tid;
+    /* the vfork child must not write the tid word of the parent on exit */
+    thread->clear_child_tid = is_vfork ? RT_NULL : self_thread->clear_child_tid;
     thread->lwp = (void *)lwp;
     thread->tid = tid;
 
@@ -2130,8 +2152,16 @@ sysret_t _sys_fork(void)
             (void *)((char *)thread->stack_addr + thread->stack_size),
             user_stack, &thread->sp);
 
+    /* the child may be gone once the parent of vfork resumes */
+    pid = lwp_to_pid(lwp);
     rt_thread_startup(thread);
-    return lwp_to_pid(lwp);
+
+    if (is_vfork)
+    {
+        rt_completion_wait(&vfork_done, RT_WAITING_FOREVER);
+    }
+
+    return pid;
 fail:
     falival = GET_ERRNO();
 
@@ -2145,11 +2175,27 @@ fail:
     }
     if (lwp)
     {
+        if (is_vfork)
+        {
+            /* not ours to free */
+            lwp->aspace = RT_NULL;
+            lwp->vfork_done = RT_NULL;
+        }
         lwp_ref_dec(lwp);
     }
     return falival;
 }
 
+sysret_t _sys_fork(void)
+{
+    return _lwp_fork(RT_FALSE);
+}
+
+sysret_t _sys_vfork(void)
+{
+    return _lwp_fork(RT_TRUE);
+}
+
 /* arm needs to wrap fork/clone call to preserved lr & caller saved regs */
 
 rt_weak sysret_t sys_fork(void)
@@ -2159,7 +2205,7 @@ rt_weak sysret_t sys_fork(void)
 
 rt_weak sysret_t sys_vfork(void)
 {
-    return sys_fork();
+    return _sys_vfork();
 }
 
 struct process_aux *lwp_argscopy(struct rt_lwp *lwp, int argc, char **argv, char **envp);
@@ -2483,58 +2529,18 @@ quit:
     return (ret < 0 ? GET_ERRNO() : ret);
 }
 
-sysret_t sys_execve(const char *path, char *const argv[], char *const envp[])
+/* copy the argv and envp from user space into one kernel page */
+static void *_exec_args_get(char *const argv[], char *const envp[], struct lwp_args_info *args)
 {
-    int ret = -1;
     int argc = 0;
     int envc = 0;
-    void *page = NULL;
-    void *new_page;
+    void *page;
     int size = 0;
     size_t len;
     char **kargv;
     char **kenvp;
     char *p;
-    struct rt_lwp *new_lwp = NULL;
-    struct rt_lwp *lwp;
-    int uni_thread;
-    rt_thread_t thread;
-    struct process_aux *aux;
     int i;
-    struct lwp_args_info args_info;
-
-    if (access(path, X_OK) != 0)
-    {
-        return -EACCES;
-    }
-
-    lwp = lwp_self();
-    thread = rt_thread_self();
-    uni_thread = 1;
-
-    LWP_LOCK(lwp);
-    if (lwp->t_grp.prev != &thread->sibling)
-    {
-        uni_thread = 0;
-    }
-    if (lwp->t_grp.next != &thread->sibling)
-    {
-        uni_thread = 0;
-    }
-    LWP_UNLOCK(lwp);
-
-    if (!uni_thread)
-    {
-        SET_ERRNO(EINVAL);
-        goto quit;
-    }
-
-    len = lwp_user_strlen(path);
-    if (len <= 0)
-    {
-        SET_ERRNO(EFAULT);
-        goto quit;
-    }
 
     size += sizeof(char *);
     if (argv)
@@ -2544,7 +2550,7 @@ sysret_t sys_execve(const char *path, char *const argv[], char *const envp[])
             if (!lwp_user_accessable((void *)(argv + argc), sizeof(char *)))
             {
                 SET_ERRNO(EFAULT);
-                goto quit;
+                return RT_NULL;
             }
             if (!argv[argc])
             {
@@ -2554,7 +2560,7 @@ sysret_t sys_execve(const char *path, char *const argv[], char *const envp[])
             if (len < 0)
             {
                 SET_ERRNO(EFAULT);
-                goto quit;
+                return RT_NULL;
             }
             size += sizeof(char *) + len + 1;
             argc++;
@@ -2568,7 +2574,7 @@ sysret_t sys_execve(const char *path, char *const argv[], char *const envp[])
             if (!lwp_user_accessable((void *)(envp + envc), sizeof(char *)))
             {
                 SET_ERRNO(EFAULT);
-                goto quit;
+                return RT_NULL;
             }
             if (!envp[envc])
             {
@@ -2578,7 +2584,7 @@ sysret_t sys_execve(const char *path, char *const argv[], char *const envp[])
             if (len < 0)
             {
                 SET_ERRNO(EFAULT);
-                goto quit;
+                return RT_NULL;
             }
             size += sizeof(char *) + len + 1;
             envc++;
@@ -2587,13 +2593,13 @@ sysret_t sys_execve(const char *path, char *const argv[], char *const envp[])
     if (size > ARCH_PAGE_SIZE)
     {
         SET_ERRNO(EINVAL);
-        goto quit;
+        return RT_NULL;
     }
     page = rt_pages_alloc_ext(0, PAGE_ANY_AVAILABLE); /* 1 page */
     if (!page)
     {
         SET_ERRNO(ENOMEM);
-        goto quit;
+        return RT_NULL;
     }
 
     kargv = (char **)page;
@@ -2624,6 +2630,70 @@ sysret_t sys_execve(const char *path, char *const argv[], char *const envp[])
         kenvp[i] = NULL;
     }
 
+    kargv[argc] = NULL;
+    kenvp[envc] = NULL;
+
+    args->argc = argc;
+    args->argv = kargv;
+    args->envc = envc;
+    args->envp = kenvp;
+    args->size = size;
+
+    return page;
+}
+
+sysret_t sys_execve(const char *path, char *const argv[], char *const envp[])
+{
+    int ret = -1;
+    void *page = NULL;
+    void *new_page;
+    size_t len;
+    struct rt_lwp *new_lwp = NULL;
+    struct rt_lwp *lwp;
+    int uni_thread;
+    rt_thread_t thread;
+    struct process_aux *aux;
+    struct lwp_args_info args_info;
+
+    if (access(path, X_OK) != 0)
+    {
+        return -EACCES;
+    }
+
+    lwp = lwp_self();
+    thread = rt_thread_self();
+    uni_thread = 1;
+
+    LWP_LOCK(lwp);
+    if (lwp->t_grp.prev != &thread->sibling)
+    {
+        uni_thread = 0;
+    }
+    if (lwp->t_grp.next != &thread->sibling)
+    {
+        uni_thread = 0;
+    }
+    LWP_UNLOCK(lwp);
+
+    if (!uni_thread)
+    {
+        SET_ERRNO(EINVAL);
+        goto quit;
+    }
+
+    len = lwp_user_strlen(path);
+    if (len <= 0)
+    {
+        SET_ERRNO(EFAULT);
+        goto quit;
+    }
+
+    page = _exec_args_get(argv, envp, &args_info);
+    if (!page)
+    {
+        goto quit;
+    }
+
     /* alloc new lwp to operation */
     new_lwp = lwp_create(LWP_CREATE_FLAG_NONE);
     if (!new_lwp)
@@ -2639,11 +2709,6 @@ sysret_t sys_execve(const char *path, char *const argv[], char *const envp[])
         goto quit;
     }
     /* file is a script ? */
-    args_info.argc = argc;
-    args_info.argv = kargv;
-    args_info.envc = envc;
-    args_info.envp = kenvp;
-    args_info.size = size;
     while (1)
     {
         new_page = _load_script(path, page, &args_info);
@@ -2677,6 +2742,7 @@ sysret_t sys_execve(const char *path, char *const argv[], char *const envp[])
 
         /* clear all user objects */
         lwp_user_object_clear(lwp);
+        lwp_futex_private_clear(lwp);
 
         /* find last \ or / */
         while (1)
@@ -2700,7 +2766,7 @@ sysret_t sys_execve(const char *path, char *const argv[], char *const envp[])
          */
         RT_ASSERT(rt_list_entry(lwp->t_grp.prev, struct rt_thread, sibling) == thread);
 
-        strncpy(thread->parent.name, run_name + last_backslash, RT_NAME_MAX - 1);
+        rt_object_set_name(&thread->parent, run_name + last_backslash);
         strncpy(lwp->cmd, new_lwp->cmd, RT_NAME_MAX);
         rt_free(lwp->exe_file);
         lwp->exe_file = strndup(new_lwp->exe_file, DFS_PATH_MAX);
@@ -2709,6 +2775,17 @@ sysret_t sys_execve(const char *path, char *const argv[], char *const envp[])
 
 #ifdef ARCH_MM_MMU
         _swap_lwp_data(lwp, new_lwp, struct rt_aspace *, aspace);
+        if (lwp->vfork_done)
+        {
+            /* the old aspace belongs to the vfork parent */
+            new_lwp->aspace = RT_NULL;
+        }
+#ifdef RT_USING_MM_MEMCG
+        /* the new image is accounted to this process under the same limit */
+        rt_memcg_inherit(lwp->aspace->memcg,
+                         new_lwp->aspace ? new_lwp->aspace->memcg : RT_NULL,
+                         lwp->pid);
+#endif /* RT_USING_MM_MEMCG */
 
         _swap_lwp_data(lwp, new_lwp, size_t, end_heap);
 #endif
@@ -2729,6 +2806,7 @@ sysret_t sys_execve(const char *path, char *const argv[], char *const envp[])
         /* to do: clsoe files with flag CLOEXEC, recy sub-thread */
 
         lwp_aspace_switch(thread);
+        lwp_vfork_done(lwp);
 
         lwp_ref_dec(new_lwp);
         arch_start_umode(lwp->args,
@@ -2749,6 +2827,69 @@ quit:
     }
     return (ret < 0 ? GET_ERRNO() : ret);
 }
+
+/**
+ * posix_spawn(): run path in a new child process, which is built by the ELF
+ * loader directly instead of a fork() of the caller followed by execve(). The
+ * child inherits the files, working directory, process group and signal mask.
+ * The file actions and attributes of posix_spawn() are left to the C library.
+ */
+sysret_t sys_posix_spawn(const char *path, char *const argv[], char *const envp[])
+{
+    sysret_t ret;
+    int len;
+    void *page;
+    void *new_page;
+    char *kpath;
+    char *exec_path;
+    struct lwp_args_info args_info;
+
+    len = lwp_user_strlen(path);
+    if (len <= 0)
+    {
+        return -EFAULT;
+    }
+
+    kpath = (char *)kmem_get(len + 1);
+    if (!kpath)
+    {
+        return -ENOMEM;
+    }
+
+    if (lwp_get_from_user(kpath, (void *)path, len + 1) != (len + 1))
+    {
+        kmem_put(kpath);
+        return -EFAULT;
+    }
+
+    if (access(kpath, X_OK) != 0)
+    {
+        kmem_put(kpath);
+        return -EACCES;
+    }
+
+    page = _exec_args_get(argv, envp, &args_info);
+    if (!page)
+    {
+        kmem_put(kpath);
+        return GET_ERRNO();
+    }
+
+    /* file is a script ? */
+    exec_path = kpath;
+    while ((new_page = _load_script(exec_path, page, &args_info)) != RT_NULL)
+    {
+        page = new_page;
+        exec_path = args_info.argv[0];
+    }
+
+    ret = lwp_spawn(exec_path, args_info.argc, args_info.argv, args_info.envp);
+
+    rt_pages_free(page, 0);
+    kmem_put(kpath);
+
+    return ret;
+}
 #endif /* ARCH_MM_MMU */
 
 sysret_t sys_thread_delete(rt_thread_t thread)
@@ -6628,6 +6769,503 @@ ssize_t sys_pwrite64(int fd, void *buf, int size, size_t offset)
 }
 #endif
 
+#ifdef RT_USING_DFS_V2
+#ifndef IOV_MAX
+#define IOV_MAX 1024
+#endif
+
+/* bounce size between two files, no user buffer is involved */
+#define FILE_COPY_CHUNK 0x4000
+
+/* I/O at the offset, or at the file position if offset < 0 */
+static ssize_t _file_read(struct dfs_file *file, void *buf, size_t len, off_t offset)
+{
+    ssize_t ret;
+    off_t fpos;
+
+    if (offset < 0)
+    {
+        return dfs_file_read(file, buf, len);
+    }
+
+    /* fpos lock */
+    fpos = dfs_file_get_fpos(file);
+    ret = dfs_file_pread(file, buf, len, offset);
+    /* fpos unlock */
+    dfs_file_set_fpos(file, fpos);
+
+    return ret;
+}
+
+static ssize_t _file_write(struct dfs_file *file, const void *buf, size_t len, off_t offset)
+{
+    ssize_t ret;
+    off_t fpos;
+
+    if (offset < 0)
+    {
+        return dfs_file_write(file, buf, len);
+    }
+
+    /* fpos lock */
+    fpos = dfs_file_get_fpos(file);
+    ret = dfs_file_pwrite(file, buf, len, offset);
+    /* fpos unlock */
+    dfs_file_set_fpos(file, fpos);
+
+    return ret;
+}
+
+#ifdef ARCH_MM_MMU
+/* copy in the iovec array, the total length is done in one file I/O */
+static int _iov_from_user(const struct iovec *iov, int iovcnt, struct iovec **out_kiov, size_t *out_total)
+{
+    struct iovec *kiov;
+    size_t iovs_size, total = 0;
+
+    if (iovcnt < 0 || iovcnt > IOV_MAX)
+    {
+        return -EINVAL;
+    }
+
+    if (iovcnt == 0)
+    {
+        *out_kiov = RT_NULL;
+        *out_total = 0;
+        return 0;
+    }
+
+    iovs_size = sizeof(*iov) * iovcnt;
+    if (!lwp_user_accessable((void *)iov, iovs_size))
+    {
+        return -EFAULT;
+    }
+
+    kiov = kmem_get(iovs_size);
+    if (!kiov)
+    {
+        return -ENOMEM;
+    }
+    lwp_get_from_user(kiov, (void *)iov, iovs_size);
+
+    for (int i = 0; i < iovcnt; i++)
+    {
+        if (kiov[i].iov_len > SSIZE_MAX - total)
+        {
+            kmem_put(kiov);
+            return -EINVAL;
+        }
+        if (kiov[i].iov_len && !lwp_user_accessable(kiov[i].iov_base, kiov[i].iov_len))
+        {
+            kmem_put(kiov);
+            return -EFAULT;
+        }
+        total += kiov[i].iov_len;
+    }
+
+    *out_kiov = kiov;
+    *out_total = total;
+
+    return 0;
+}
+#endif /* ARCH_MM_MMU */
+
+static ssize_t _sys_readv(int fd, const struct iovec *iov, int iovcnt, off_t offset)
+{
+    struct dfs_file *file;
+    ssize_t ret = 0;
+#ifdef ARCH_MM_MMU
+    struct iovec *kiov;
+    size_t total, len;
+    char *kmem;
+
+    file = fd_get(fd);
+    if (!file)
+    {
+        return -EBADF;
+    }
+
+    ret = _iov_from_user(iov, iovcnt, &kiov, &total);
+    if (ret < 0 || total == 0)
+    {
+        if (ret == 0)
+        {
+            kmem_put(kiov);
+        }
+        return ret;
+    }
+
+    kmem = kmem_get(total);
+    if (!kmem)
+    {
+        kmem_put(kiov);
+        return -ENOMEM;
+    }
+
+    ret = _file_read(file, kmem, total, offset);
+    if (ret > 0)
+    {
+        total = 0;
+        for (int i = 0; i < iovcnt && total < (size_t)ret; i++)
+        {
+            len = kiov[i].iov_len < (size_t)ret - total ? kiov[i].iov_len : (size_t)ret - total;
+            if (lwp_put_to_user(kiov[i].iov_base, kmem + total, len) != len)
+            {
+                ret = -EFAULT;
+                break;
+            }
+            total += len;
+        }
+    }
+
+    kmem_put(kmem);
+    kmem_put(kiov);
+#else
+    ssize_t n;
+
+    file = fd_get(fd);
+    if (!file)
+    {
+        return -EBADF;
+    }
+    if (iovcnt < 0 || iovcnt > IOV_MAX)
+    {
+        return -EINVAL;
+    }
+
+    for (int i = 0; i < iovcnt; i++)
+    {
+        if (!lwp_user_accessable(iov[i].iov_base, iov[i].iov_len))
+        {
+            return ret ? ret : -EFAULT;
+        }
+
+        n = _file_read(file, iov[i].iov_base, iov[i].iov_len, offset < 0 ? offset : offset + ret);
+        if (n < 0)
+        {
+            return ret ? ret : n;
+        }
+        ret += n;
+        if ((size_t)n < iov[i].iov_len)
+        {
+            break;
+        }
+    }
+#endif /* ARCH_MM_MMU */
+
+    return ret;
+}
+
+static ssize_t _sys_writev(int fd, const struct iovec *iov, int iovcnt, off_t offset)
+{
+    struct dfs_file *file;
+    ssize_t ret = 0;
+#ifdef ARCH_MM_MMU
+    struct iovec *kiov;
+    size_t total;
+    char *kmem;
+
+    file = fd_get(fd);
+    if (!file)
+    {
+        return -EBADF;
+    }
+
+    ret = _iov_from_user(iov, iovcnt, &kiov, &total);
+    if (ret < 0 || total == 0)
+    {
+        if (ret == 0)
+        {
+            kmem_put(kiov);
+        }
+        return ret;
+    }
+
+    kmem = kmem_get(total);
+    if (!kmem)
+    {
+        kmem_put(kiov);
+        return -ENOMEM;
+    }
+
+    /* gathered, so that a socket sends it in one go */
+    total = 0;
+    for (int i = 0; i < iovcnt; i++)
+    {
+        lwp_get_from_user(kmem + total, kiov[i].iov_base, kiov[i].iov_len);
+        total += kiov[i].iov_len;
+    }
+
+    ret = _file_write(file, kmem, total, offset);
+
+    kmem_put(kmem);
+    kmem_put(kiov);
+#else
+    ssize_t n;
+
+    file = fd_get(fd);
+    if (!file)
+    {
+        return -EBADF;
+    }
+    if (iovcnt < 0 || iovcnt > IOV_MAX)
+    {
+        return -EINVAL;
+    }
+
+    for (int i = 0; i < iovcnt; i++)
+    {
+        if (!lwp_user_accessable(iov[i].iov_base, iov[i].iov_len))
+        {
+            return ret ? ret : -EFAULT;
+        }
+
+        n = _file_write(file, iov[i].iov_base, iov[i].iov_len, offset < 0 ? offset : offset + ret);
+        if (n < 0)
+        {
+            return ret ? ret : n;
+        }
+        ret += n;
+        if ((size_t)n < iov[i].iov_len)
+        {
+            break;
+        }
+    }
+#endif /* ARCH_MM_MMU */
+
+    return ret;
+}
+
+/**
+ * Copy between two files through a kernel buffer of FILE_COPY_CHUNK. Each
+ * chunk is copied once out of the page cache and once into the socket, but
+ * never through the user space. A position < 0 stands for the file position.
+ */
+static ssize_t _file_copy(struct dfs_file *in, off_t *in_pos, struct dfs_file *out, off_t *out_pos, size_t count)
+{
+    ssize_t ret = 0, n, w;
+    size_t done = 0, chunk;
+    char *buf;
+
+    chunk = count < FILE_COPY_CHUNK ? count : FILE_COPY_CHUNK;
+    if (chunk == 0)
+    {
+        return 0;
+    }
+
+    buf = rt_malloc(chunk);
+    if (!buf)
+    {
+        return -ENOMEM;
+    }
+
+    while (done < count)
+    {
+        n = _file_read(in, buf, count - done < chunk ? count - done : chunk, *in_pos);
+        if (n <= 0)
+        {
+            ret = n;
+            break;
+        }
+
+        for (w = 0; w < n; w += ret)
+        {
+            ret = _file_write(out, buf + w, n - w, *out_pos < 0 ? *out_pos : *out_pos + w);
+            if (ret <= 0)
+            {
+                break;
+            }
+        }
+
+        if (*out_pos >= 0)
+        {
+            *out_pos += w;
+        }
+        if (*in_pos >= 0)
+        {
+            *in_pos += w;
+        }
+        else if (w < n)
+        {
+            /* give back what was read but not written */
+            dfs_file_lseek(in, w - n, SEEK_CUR);
+        }
+        done += w;
+
+        if (w < n)
+        {
+            break;
+        }
+        ret = 0;
+    }
+
+    rt_free(buf);
+
+    return done ? (ssize_t)done : ret;
+}
+
+static int _pos_from_user(off_t *upos, off_t *kpos)
+{
+    if (!upos)
+    {
+        *kpos = -1;
+        return 0;
+    }
+
+    if (!lwp_user_accessable(upos, sizeof(*upos)))
+    {
+        return -EFAULT;
+    }
+    lwp_get_from_user(kpos, upos, sizeof(*kpos));
+
+    return *kpos < 0 ? -EINVAL : 0;
+}
+#endif /* RT_USING_DFS_V2 */
+
+ssize_t sys_readv(int fd, const struct iovec *iov, int iovcnt)
+{
+#ifdef RT_USING_DFS_V2
+    return _sys_readv(fd, iov, iovcnt, -1);
+#else
+    return -ENOSYS;
+#endif
+}
+
+ssize_t sys_writev(int fd, const struct iovec *iov, int iovcnt)
+{
+#ifdef RT_USING_DFS_V2
+    return _sys_writev(fd, iov, iovcnt, -1);
+#else
+    return -ENOSYS;
+#endif
+}
+
+ssize_t sys_preadv(int fd, const struct iovec *iov, int iovcnt, off_t offset)
+{
+#ifdef RT_USING_DFS_V2
+    if (offset < 0)
+    {
+        return -EINVAL;
+    }
+    return _sys_readv(fd, iov, iovcnt, offset);
+#else
+    return -ENOSYS;
+#endif
+}
+
+ssize_t sys_pwritev(int fd, const struct iovec *iov, int iovcnt, off_t offset)
+{
+#ifdef RT_USING_DFS_V2
+    if (offset < 0)
+    {
+        return -EINVAL;
+    }
+    return _sys_writev(fd, iov, iovcnt, offset);
+#else
+    return -ENOSYS;
+#endif
+}
+
+ssize_t sys_sendfile(int out_fd, int in_fd, off_t *offset, size_t count)
+{
+#ifdef RT_USING_DFS_V2
+    struct dfs_file *in, *out;
+    off_t in_pos, out_pos = -1;
+    ssize_t ret;
+
+    in = fd_get(in_fd);
+    out = fd_get(out_fd);
+    if (!in || !out)
+    {
+        return -EBADF;
+    }
+
+    ret = _pos_from_user(offset, &in_pos);
+    if (ret < 0)
+    {
+        return ret;
+    }
+
+    ret = _file_copy(in, &in_pos, out, &out_pos, count);
+
+    if (offset && ret > 0)
+    {
+        lwp_put_to_user(offset, &in_pos, sizeof(in_pos));
+    }
+
+    return ret;
+#else
+    return -ENOSYS;
+#endif
+}
+
+ssize_t sys_copy_file_range(int fd_in, off_t *off_in, int fd_out, off_t *off_out, size_t len, unsigned int flags)
+{
+#ifdef RT_USING_DFS_V2
+    struct dfs_file *in, *out;
+    off_t in_pos, out_pos;
+    ssize_t ret;
+
+    if (flags)
+    {
+        return -EINVAL;
+    }
+
+    in = fd_get(fd_in);
+    out = fd_get(fd_out);
+    if (!in || !out)
+    {
+        return -EBADF;
+    }
+    if (!in->vnode || !out->vnode ||
+        in->vnode->type != FT_REGULAR || out->vnode->type != FT_REGULAR)
+    {
+        return -EINVAL;
+    }
+
+    ret = _pos_from_user(off_in, &in_pos);
+    if (ret == 0)
+    {
+        ret = _pos_from_user(off_out, &out_pos);
+    }
+    if (ret < 0)
+    {
+        return ret;
+    }
+
+    /* the ranges in the same file must not overlap */
+    if (in->vnode == out->vnode)
+    {
+        off_t in_start = in_pos < 0 ? dfs_file_get_fpos(in) : in_pos;
+        off_t out_start = out_pos < 0 ? dfs_file_get_fpos(out) : out_pos;
+        off_t distance = in_start > out_start ? in_start - out_start : out_start - in_start;
+
+        if ((size_t)distance < len)
+        {
+            return -EINVAL;
+        }
+    }
+
+    ret = _file_copy(in, &in_pos, out, &out_pos, len);
+
+    if (ret > 0)
+    {
+        if (off_in)
+        {
+            lwp_put_to_user(off_in, &in_pos, sizeof(in_pos));
+        }
+        if (off_out)
+        {
+            lwp_put_to_user(off_out, &out_pos, sizeof(out_pos));
+        }
+    }
+
+    return ret;
+#else
+    return -ENOSYS;
+#endif
+}
+
 sysret_t sys_timerfd_create(int clockid, int flags)
 {
     int ret;
@@ -7082,6 +7720,13 @@ const static struct rt_syscall_def func_table[] =
     SYSCALL_SIGN(sys_getppid),
     SYSCALL_SIGN(sys_fchdir),
     SYSCALL_SIGN(sys_chown),
+    SYSCALL_USPACE(SYSCALL_SIGN(sys_posix_spawn)),          /* 215 */
+    SYSCALL_SIGN(sys_readv),
+    SYSCALL_SIGN(sys_writev),
+    SYSCALL_SIGN(sys_preadv),
+    SYSCALL_SIGN(sys_pwritev),
+    SYSCALL_SIGN(sys_sendfile),                         /* 220 */
+    SYSCALL_SIGN(sys_copy_file_range),
 };
 
 const void *lwp_get_sys_api(rt_uint32_t number)
@@ -62,6 +62,7 @@ sysret_t sys_nanosleep(const struct timespec *rqtp, struct timespec *rmtp);
 sysret_t sys_gettimeofday(struct timeval *tp, struct timezone *tzp);
 sysret_t sys_settimeofday(const struct timeval *tv, const struct timezone *tzp);
 sysret_t sys_exec(char *filename, int argc, char **argv, char **envp);
+sysret_t sys_posix_spawn(const char *path, char *const argv[], char *const envp[]);
 sysret_t sys_kill(int pid, int sig);
 sysret_t sys_getpid(void);
 sysret_t sys_getpriority(int which, id_t who);
@@ -28,9 +28,11 @@
 #include <mm_aspace.h>
 #include <mm_fault.h>
 #include <mm_flag.h>
+#include <mm_memcg.h>
 #include <mm_page.h>
 #include <mmu.h>
 #include <page.h>
+#include <ipc/completion.h>
 
 #ifdef RT_USING_MUSLLIBC
 #include "libc_musl.h"
@@ -121,6 +123,13 @@ int lwp_user_space_init(struct rt_lwp *lwp, rt_bool_t is_fork)
     err = arch_user_space_init(lwp);
     if (err == RT_EOK)
     {
+#ifdef RT_USING_MM_MEMCG
+        /* a forked process starts with the soft limit of its parent */
+        lwp->aspace->memcg = rt_memcg_create(lwp->pid);
+        if (is_fork && lwp_self() && lwp_self()->aspace)
+            rt_memcg_inherit(lwp->aspace->memcg, lwp_self()->aspace->memcg, lwp->pid);
+#endif /* RT_USING_MM_MEMCG */
+
         if (!is_fork)
         {
             stk_addr = (void *)USER_STACK_VSTART;
@@ -139,13 +148,14 @@ void lwp_aspace_switch(struct rt_thread *thread)
     rt_aspace_t aspace;
     void *from_tbl;
 
-    if (thread->lwp)
+    lwp = (struct rt_lwp *)thread->lwp;
+    if (lwp && lwp->aspace)
     {
-        lwp = (struct rt_lwp *)thread->lwp;
         aspace = lwp->aspace;
     }
     else
     {
+        /* kernel thread, or a vfork child which gave back the aspace */
         aspace = &rt_kernel_space;
     }
 
@@ -205,6 +215,25 @@ int lwp_fork_aspace(struct rt_lwp *dest_lwp, struct rt_lwp *src_lwp)
     return err;
 }
 
+/**
+ * wake up the vfork parent of lwp. The caller must have stopped using the
+ * borrowed aspace, either by replacing it in exec or by clearing it on exit.
+ */
+void lwp_vfork_done(struct rt_lwp *lwp)
+{
+    struct rt_completion *done;
+
+    LWP_LOCK(lwp);
+    done = lwp->vfork_done;
+    lwp->vfork_done = RT_NULL;
+    LWP_UNLOCK(lwp);
+
+    if (done)
+    {
+        rt_completion_done(done);
+    }
+}
+
 int lwp_unmap_user_phy(struct rt_lwp *lwp, void *va)
 {
     return lwp_unmap_user(lwp, va);
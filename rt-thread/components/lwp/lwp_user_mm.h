@@ -169,6 +169,7 @@ size_t lwp_user_strlen_ext(struct rt_lwp *lwp, const char *s);
 size_t lwp_strlen(struct rt_lwp *lwp, const char *s);
 
 int lwp_fork_aspace(struct rt_lwp *dest_lwp, struct rt_lwp *src_lwp);
+void lwp_vfork_done(struct rt_lwp *lwp);
 
 void lwp_data_cache_flush(struct rt_lwp *lwp, void *vaddr, size_t size);
 
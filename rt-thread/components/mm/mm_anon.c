@@ -113,21 +113,27 @@ void rt_varea_pgmgr_insert(rt_varea_t varea, void *page_addr)
 {
     /* each mapping of page frame in the varea is binding with a reference */
     rt_page_ref_inc(page_addr, 0);
+
+    rt_memcg_charge(varea->aspace->memcg, RT_MEMCG_ANON, 1);
+    rt_memcg_check(varea->aspace->memcg);
 }
 
 /**
- * Private unmapping of address space
+ * Private unmapping of address space. The TLB is invalidated once for the
+ * whole region and the page frames are freed after that.
  */
 static void _pgmgr_pop_all(rt_varea_t varea)
 {
     rt_aspace_t aspace = varea->aspace;
     char *iter = varea->start;
     char *end_addr = iter + varea->size;
+    struct rt_mmu_gather tlb;
 
     RT_ASSERT(iter < end_addr);
     RT_ASSERT(!((long)iter & ARCH_PAGE_MASK));
     RT_ASSERT(!((long)end_addr & ARCH_PAGE_MASK));
 
+    rt_mmu_gather_init(&tlb, aspace);
     for (; iter != end_addr; iter += ARCH_PAGE_SIZE)
     {
         void *page_pa = rt_hw_mmu_v2p(aspace, iter);
@@ -135,17 +141,26 @@ static void _pgmgr_pop_all(rt_varea_t varea)
         if (page_pa != ARCH_MAP_FAILED && page_va)
         {
             rt_hw_mmu_unmap(aspace, iter, ARCH_PAGE_SIZE);
-            rt_pages_free(page_va, 0);
+            /* a huge leaf failed to split is still mapped, keep its frames */
+            if (rt_hw_mmu_v2p(aspace, iter) != ARCH_MAP_FAILED)
+                continue;
+            rt_mmu_gather_range(&tlb, iter, ARCH_PAGE_SIZE);
+            rt_mmu_gather_page(&tlb, page_va);
+            rt_memcg_uncharge(aspace->memcg, RT_MEMCG_ANON, 1);
         }
     }
+    rt_mmu_gather_finish(&tlb);
 }
 
 static void _pgmgr_pop_range(rt_varea_t varea, void *rm_start, void *rm_end)
 {
     void *page_va;
+    struct rt_mmu_gather tlb;
 
     RT_ASSERT(!((rt_ubase_t)rm_start & ARCH_PAGE_MASK));
     RT_ASSERT(!((rt_ubase_t)rm_end & ARCH_PAGE_MASK));
+
+    rt_mmu_gather_init(&tlb, varea->aspace);
     while (rm_start != rm_end)
     {
         page_va = rt_hw_mmu_v2p(varea->aspace, rm_start);
@@ -154,11 +169,18 @@ static void _pgmgr_pop_range(rt_varea_t varea, void *rm_start, void *rm_end)
         {
             page_va -= PV_OFFSET;
             LOG_D("%s: free page %p", __func__, page_va);
-            rt_varea_unmap_page(varea, rm_start);
-            rt_pages_free(page_va, 0);
+            rt_hw_mmu_unmap(varea->aspace, rm_start, ARCH_PAGE_SIZE);
+            /* a huge leaf failed to split is still mapped, keep its frames */
+            if (rt_hw_mmu_v2p(varea->aspace, rm_start) == ARCH_MAP_FAILED)
+            {
+                rt_mmu_gather_range(&tlb, rm_start, ARCH_PAGE_SIZE);
+                rt_mmu_gather_page(&tlb, page_va);
+                rt_memcg_uncharge(varea->aspace->memcg, RT_MEMCG_ANON, 1);
+            }
         }
         rm_start += ARCH_PAGE_SIZE;
     }
+    rt_mmu_gather_finish(&tlb);
 }
 
 static const char *_anon_get_name(rt_varea_t varea)
@@ -305,6 +327,61 @@ static void *_get_page_from_backup(rt_aspace_t backup, rt_base_t offset_in_mobj)
     return rc;
 }
 
+#if defined(RT_USING_MM_HUGEPAGE) && defined(ARCH_HUGE_PAGE_SHIFT)
+#define HUGE_PAGE_SIZE  (1ul << ARCH_HUGE_PAGE_SHIFT)
+#define HUGE_PAGE_ORDER (ARCH_HUGE_PAGE_SHIFT - ARCH_PAGE_SHIFT)
+
+/**
+ * back the whole huge page around the fault if none of it is mapped yet. The
+ * page frames are managed as normal pages of the varea after the mapping.
+ */
+static rt_bool_t _map_huge_page(rt_varea_t varea, struct rt_aspace_fault_msg *msg)
+{
+    char *start = (char *)RT_ALIGN_DOWN((rt_ubase_t)msg->fault_vaddr, HUGE_PAGE_SIZE);
+    char *page;
+    rt_size_t off;
+
+    if (start < (char *)varea->start ||
+        start + HUGE_PAGE_SIZE > (char *)varea->start + varea->size)
+    {
+        return RT_FALSE;
+    }
+
+    for (off = 0; off < HUGE_PAGE_SIZE; off += ARCH_PAGE_SIZE)
+    {
+        if (rt_hw_mmu_v2p(varea->aspace, start + off) != ARCH_MAP_FAILED)
+            return RT_FALSE;
+    }
+
+    page = rt_pages_alloc_ext(HUGE_PAGE_ORDER, PAGE_ANY_AVAILABLE);
+    if (!page)
+    {
+        return RT_FALSE;
+    }
+
+    if (rt_varea_map_range(varea, start, rt_kmem_v2p(page), HUGE_PAGE_SIZE) != RT_EOK)
+    {
+        rt_pages_free(page, HUGE_PAGE_ORDER);
+        return RT_FALSE;
+    }
+
+    rt_pages_split(page, HUGE_PAGE_ORDER);
+    for (off = 0; off < HUGE_PAGE_SIZE; off += ARCH_PAGE_SIZE)
+    {
+        rt_varea_pgmgr_insert(varea, page + off);
+        rt_pages_free(page + off, 0);
+    }
+
+    msg->response.status = MM_FAULT_STATUS_OK_MAPPED;
+    return RT_TRUE;
+}
+#else
+rt_inline rt_bool_t _map_huge_page(rt_varea_t varea, struct rt_aspace_fault_msg *msg)
+{
+    return RT_FALSE;
+}
+#endif /* RT_USING_MM_HUGEPAGE && ARCH_HUGE_PAGE_SHIFT */
+
 /* get the backup page in kernel for the address in user space */
 static void _fetch_page_for_varea(struct rt_varea *varea, struct rt_aspace_fault_msg *msg, rt_bool_t need_map)
 {
@@ -313,7 +390,7 @@ static void _fetch_page_for_varea(struct rt_varea *varea, struct rt_aspace_fault
     rt_aspace_t curr_aspace = varea->aspace;
     rt_aspace_t backup = _anon_obj_get_backup(varea->mem_obj);
 
-    RDWR_LOCK(curr_aspace);
+    RDWR_LOCK(curr_aspace, msg->fault_vaddr);
 
     /**
      * if the page is already mapped(this may caused by data race while other
@@ -322,7 +399,11 @@ static void _fetch_page_for_varea(struct rt_varea *varea, struct rt_aspace_fault
     paddr = rt_hw_mmu_v2p(curr_aspace, msg->fault_vaddr);
     if (paddr == ARCH_MAP_FAILED)
     {
-        if (backup == curr_aspace)
+        if (backup == curr_aspace && need_map && _map_huge_page(varea, msg))
+        {
+            LOG_D("%s: huge page mapped at %p", __func__, msg->fault_vaddr);
+        }
+        else if (backup == curr_aspace)
         {
             rt_mm_dummy_mapper.on_page_fault(varea, msg);
             if (msg->response.status != MM_FAULT_STATUS_UNRECOVERABLE)
@@ -357,7 +438,7 @@ static void _fetch_page_for_varea(struct rt_varea *varea, struct rt_aspace_fault
     {
         msg->response.status = MM_FAULT_STATUS_OK_MAPPED;
     }
-    RDWR_UNLOCK(curr_aspace);
+    RDWR_UNLOCK(curr_aspace, msg->fault_vaddr);
 }
 
 static void _anon_page_fault(struct rt_varea *varea, struct rt_aspace_fault_msg *msg)
@@ -551,14 +632,13 @@ static int _override_map(rt_varea_t varea, rt_aspace_t aspace, void *fault_vaddr
  * replace an existing mapping to a private one, this is identical to:
  * => aspace_unmap(ex_varea, )
  * => aspace_map()
+ *
+ * The varea tree is modified, so the caller shall hold the write lock
  */
 int rt_varea_fix_private_locked(rt_varea_t ex_varea, void *pa,
                                 struct rt_aspace_fault_msg *msg,
                                 rt_bool_t dont_copy)
 {
-    /**
-     * todo: READ -> WRITE lock here
-     */
     void *page;
     void *fault_vaddr;
     rt_aspace_t aspace;
@@ -721,6 +801,14 @@ rt_err_t rt_aspace_fork(rt_aspace_t *psrc, rt_aspace_t *pdst)
                 {
                     _switch_aspace(psrc, &backup);
                     _convert_readonly(backup, base_reference);
+
+                    /**
+                     * the duplicate maps nothing and charges the group for
+                     * what it faults in. The backup keeps a reference of the
+                     * group, so the pages and page tables charged so far are
+                     * uncharged as the backup unmaps them.
+                     */
+                    (*psrc)->memcg = rt_memcg_get(backup->memcg);
                 }
             }
         }
@@ -39,15 +39,225 @@ static int _unmap_range_locked(rt_aspace_t aspace, void *addr, size_t length);
 
 struct rt_aspace rt_kernel_space;
 
+/* number of locks serializing the faults on the same page, power of 2 */
+#define MM_FAULT_LOCK_NR 16
+
+/* a fault may populate a whole huge page of anonymous memory */
+#if defined(RT_USING_MM_HUGEPAGE) && defined(ARCH_HUGE_PAGE_SHIFT)
+#define MM_FAULT_LOCK_SHIFT ARCH_HUGE_PAGE_SHIFT
+#else
+#define MM_FAULT_LOCK_SHIFT ARCH_PAGE_SHIFT
+#endif
+
+static struct rt_mutex _fault_lock[MM_FAULT_LOCK_NR];
+static rt_bool_t _fault_lock_inited;
+
 static int _init_lock(rt_aspace_t aspace)
 {
     int err;
+    int i;
+    rt_aspace_rwlock_t *rwlock = &aspace->bst_lock;
+
+    /* the first address space is the kernel space, set up before scheduling */
+    if (!_fault_lock_inited)
+    {
+        for (i = 0; i < MM_FAULT_LOCK_NR; i++)
+        {
+            rt_mutex_init(&_fault_lock[i], "mmfault", RT_IPC_FLAG_PRIO);
+        }
+        _fault_lock_inited = RT_TRUE;
+    }
+
     MM_PGTBL_LOCK_INIT(aspace);
-    err = rt_mutex_init(&aspace->bst_lock, "aspace", RT_IPC_FLAG_FIFO);
+
+    rt_spin_lock_init(&rwlock->spinlock);
+    rwlock->writer = RT_NULL;
+    rwlock->nested = 0;
+    rwlock->readers = 0;
+    rwlock->rd_waiting = 0;
+    rwlock->wr_waiting = RT_FALSE;
+    rt_sem_init(&rwlock->rd_sem, "aspace_r", 0, RT_IPC_FLAG_FIFO);
+    rt_sem_init(&rwlock->wr_sem, "aspace_w", 0, RT_IPC_FLAG_FIFO);
+    err = rt_mutex_init(&rwlock->wr_lock, "aspace", RT_IPC_FLAG_FIFO);
 
     return err;
 }
 
+static void _detach_lock(rt_aspace_t aspace)
+{
+    rt_aspace_rwlock_t *rwlock = &aspace->bst_lock;
+
+    rt_mutex_detach(&rwlock->wr_lock);
+    rt_sem_detach(&rwlock->rd_sem);
+    rt_sem_detach(&rwlock->wr_sem);
+}
+
+/**
+ * @brief Take the varea tree lock as a reader. New readers are admitted as
+ * long as no writer owns the lock, so a reader can safely fault again on
+ * the same address space while holding it.
+ */
+void rt_aspace_rd_lock(rt_aspace_t aspace)
+{
+    rt_base_t level;
+    rt_thread_t self = rt_thread_self();
+    rt_aspace_rwlock_t *rwlock = &aspace->bst_lock;
+
+    /* no concurrency before the scheduler is started */
+    if (!self)
+        return;
+
+    level = rt_spin_lock_irqsave(&rwlock->spinlock);
+    while (rwlock->writer && rwlock->writer != self)
+    {
+        rwlock->rd_waiting++;
+        rt_spin_unlock_irqrestore(&rwlock->spinlock, level);
+
+        rt_sem_take(&rwlock->rd_sem, RT_WAITING_FOREVER);
+
+        level = rt_spin_lock_irqsave(&rwlock->spinlock);
+    }
+
+    if (rwlock->writer == self)
+        rwlock->nested++;
+    else
+        rwlock->readers++;
+    rt_spin_unlock_irqrestore(&rwlock->spinlock, level);
+}
+
+void rt_aspace_rd_unlock(rt_aspace_t aspace)
+{
+    rt_base_t level;
+    rt_bool_t wakeup = RT_FALSE;
+    rt_thread_t self = rt_thread_self();
+    rt_aspace_rwlock_t *rwlock = &aspace->bst_lock;
+
+    if (!self)
+        return;
+
+    level = rt_spin_lock_irqsave(&rwlock->spinlock);
+    if (rwlock->writer == self)
+    {
+        RT_ASSERT(rwlock->nested > 1);
+        rwlock->nested--;
+    }
+    else
+    {
+        RT_ASSERT(rwlock->readers > 0);
+        rwlock->readers--;
+        if (rwlock->readers == 0 && rwlock->wr_waiting)
+        {
+            rwlock->wr_waiting = RT_FALSE;
+            wakeup = RT_TRUE;
+        }
+    }
+    rt_spin_unlock_irqrestore(&rwlock->spinlock, level);
+
+    if (wakeup)
+        rt_sem_release(&rwlock->wr_sem);
+}
+
+/**
+ * @brief Take the varea tree lock as a writer, waiting for all the readers
+ * to leave. The writers are serialized by a mutex with priority inheritance.
+ */
+void rt_aspace_wr_lock(rt_aspace_t aspace)
+{
+    rt_base_t level;
+    rt_thread_t self = rt_thread_self();
+    rt_aspace_rwlock_t *rwlock = &aspace->bst_lock;
+
+    if (!self)
+        return;
+
+    level = rt_spin_lock_irqsave(&rwlock->spinlock);
+    if (rwlock->writer == self)
+    {
+        rwlock->nested++;
+        rt_spin_unlock_irqrestore(&rwlock->spinlock, level);
+        return;
+    }
+    rt_spin_unlock_irqrestore(&rwlock->spinlock, level);
+
+    rt_mutex_take(&rwlock->wr_lock, RT_WAITING_FOREVER);
+
+    level = rt_spin_lock_irqsave(&rwlock->spinlock);
+    while (rwlock->readers)
+    {
+        rwlock->wr_waiting = RT_TRUE;
+        rt_spin_unlock_irqrestore(&rwlock->spinlock, level);
+
+        rt_sem_take(&rwlock->wr_sem, RT_WAITING_FOREVER);
+
+        level = rt_spin_lock_irqsave(&rwlock->spinlock);
+    }
+    rwlock->writer = self;
+    rwlock->nested = 1;
+    rt_spin_unlock_irqrestore(&rwlock->spinlock, level);
+}
+
+void rt_aspace_wr_unlock(rt_aspace_t aspace)
+{
+    rt_base_t level;
+    rt_uint32_t wakeup = 0;
+    rt_bool_t release;
+    rt_thread_t self = rt_thread_self();
+    rt_aspace_rwlock_t *rwlock = &aspace->bst_lock;
+
+    if (!self)
+        return;
+
+    level = rt_spin_lock_irqsave(&rwlock->spinlock);
+    RT_ASSERT(rwlock->writer == self);
+    release = (--rwlock->nested == 0);
+    if (release)
+    {
+        rwlock->writer = RT_NULL;
+        wakeup = rwlock->rd_waiting;
+        rwlock->rd_waiting = 0;
+    }
+    rt_spin_unlock_irqrestore(&rwlock->spinlock, level);
+
+    if (release)
+    {
+        while (wakeup--)
+        {
+            rt_sem_release(&rwlock->rd_sem);
+        }
+        rt_mutex_release(&rwlock->wr_lock);
+    }
+}
+
+rt_inline struct rt_mutex *_fault_lock_of(rt_aspace_t aspace, void *vaddr)
+{
+    rt_ubase_t key = ((rt_ubase_t)vaddr >> MM_FAULT_LOCK_SHIFT) ^ ((rt_ubase_t)aspace >> 4);
+    return &_fault_lock[key & (MM_FAULT_LOCK_NR - 1)];
+}
+
+/**
+ * @brief Serialize the fixing of faults on the same page, while the faults
+ * on other pages still run in parallel under the read lock
+ */
+void rt_aspace_fault_lock(rt_aspace_t aspace, void *vaddr)
+{
+    if (rt_thread_self())
+        rt_mutex_take(_fault_lock_of(aspace, vaddr), RT_WAITING_FOREVER);
+}
+
+/* take the fault lock only if it's free, for the pages fixed as a bonus */
+rt_bool_t rt_aspace_fault_trylock(rt_aspace_t aspace, void *vaddr)
+{
+    if (rt_thread_self())
+        return rt_mutex_take(_fault_lock_of(aspace, vaddr), RT_WAITING_NO) == RT_EOK;
+    return RT_TRUE;
+}
+
+void rt_aspace_fault_unlock(rt_aspace_t aspace, void *vaddr)
+{
+    if (rt_thread_self())
+        rt_mutex_release(_fault_lock_of(aspace, vaddr));
+}
+
 rt_err_t rt_aspace_init(rt_aspace_t aspace, void *start, rt_size_t length, void *pgtbl)
 {
     int err = RT_EOK;
@@ -123,7 +333,10 @@ void rt_aspace_detach(rt_aspace_t aspace)
 
     rt_aspace_anon_ref_dec(aspace->private_object);
 
-    rt_mutex_detach(&aspace->bst_lock);
+    rt_memcg_put(aspace->memcg);
+    aspace->memcg = RT_NULL;
+
+    _detach_lock(aspace);
 }
 
 void rt_aspace_delete(rt_aspace_t aspace)
@@ -1272,9 +1485,9 @@ int rt_aspace_load_page(rt_aspace_t aspace, void *addr, rt_size_t npage)
     rt_varea_t varea;
     char *end = (char *)addr + (npage << ARCH_PAGE_SHIFT);
 
-    WR_LOCK(aspace);
+    RD_LOCK(aspace);
     varea = _aspace_bst_search(aspace, addr);
-    WR_UNLOCK(aspace);
+    RD_UNLOCK(aspace);
 
     if (!varea)
     {
@@ -1398,6 +1611,86 @@ int rt_varea_unmap_range(rt_varea_t varea, void *vaddr, rt_size_t length)
     return err;
 }
 
+void rt_mmu_gather_init(struct rt_mmu_gather *tlb, rt_aspace_t aspace)
+{
+    tlb->aspace = aspace;
+    tlb->start = RT_NULL;
+    tlb->end = RT_NULL;
+    tlb->nr = 0;
+    tlb->max = RT_MMU_GATHER_LOCAL_NR;
+    tlb->pages = tlb->local;
+}
+
+void rt_mmu_gather_range(struct rt_mmu_gather *tlb, void *vaddr, rt_size_t size)
+{
+    char *start = vaddr;
+    char *end = start + size;
+
+    if (tlb->start == tlb->end)
+    {
+        tlb->start = start;
+        tlb->end = end;
+    }
+    else
+    {
+        if (start < tlb->start)
+            tlb->start = start;
+        if (end > tlb->end)
+            tlb->end = end;
+    }
+}
+
+void rt_mmu_gather_page(struct rt_mmu_gather *tlb, void *page_va)
+{
+    void **batch;
+
+    if (tlb->nr == tlb->max)
+    {
+        /* a page frame holds the batch if the local one is not enough */
+        if (tlb->pages == tlb->local &&
+            (batch = rt_pages_alloc_ext(0, PAGE_ANY_AVAILABLE)) != RT_NULL)
+        {
+            rt_memcpy(batch, tlb->local, tlb->nr * sizeof(void *));
+            tlb->pages = batch;
+            tlb->max = ARCH_PAGE_SIZE / sizeof(void *);
+        }
+        else
+        {
+            rt_mmu_gather_flush(tlb);
+        }
+    }
+
+    tlb->pages[tlb->nr++] = page_va;
+}
+
+void rt_mmu_gather_flush(struct rt_mmu_gather *tlb)
+{
+    rt_size_t i;
+
+    if (tlb->start != tlb->end)
+    {
+        rt_hw_tlb_invalidate_range(tlb->aspace, tlb->start,
+                                   tlb->end - tlb->start, ARCH_PAGE_SIZE);
+        tlb->start = tlb->end = RT_NULL;
+    }
+
+    for (i = 0; i < tlb->nr; i++)
+        rt_pages_free(tlb->pages[i], 0);
+    tlb->nr = 0;
+}
+
+void rt_mmu_gather_finish(struct rt_mmu_gather *tlb)
+{
+    rt_mmu_gather_flush(tlb);
+
+    if (tlb->pages != tlb->local)
+    {
+        rt_pages_free(tlb->pages, 0);
+        tlb->pages = tlb->local;
+        tlb->max = RT_MMU_GATHER_LOCAL_NR;
+    }
+}
+
 int rt_aspace_offload_page(rt_aspace_t aspace, void *addr, rt_size_t npage)
 {
     return -RT_ENOSYS;
@@ -1724,10 +2017,20 @@ rt_err_t rt_aspace_page_put(rt_aspace_t aspace, void *page_va, void *buffer)
 {
     rt_err_t rc = -RT_ERROR;
     rt_varea_t varea;
+    rt_bool_t writer = RT_FALSE;
 
     RT_ASSERT(aspace);
     RD_LOCK(aspace);
     varea = _aspace_bst_search(aspace, page_va);
+    if (varea && varea->mem_obj && rt_varea_is_private_locked(varea))
+    {
+        /* fixing the private varea modifies the varea tree, retry as a writer */
+        RD_UNLOCK(aspace);
+        WR_LOCK(aspace);
+        writer = RT_TRUE;
+        varea = _aspace_bst_search(aspace, page_va);
+    }
+
     if (varea && ALIGNED(page_va))
     {
         if (varea->mem_obj)
@@ -1736,14 +2039,12 @@ rt_err_t rt_aspace_page_put(rt_aspace_t aspace, void *page_va, void *buffer)
             {
                 if (rt_varea_is_private_locked(varea))
                 {
-                    RDWR_LOCK(aspace);
                     struct rt_aspace_fault_msg msg;
                     msg.fault_op = MM_FAULT_OP_WRITE;
                     msg.fault_type = MM_FAULT_TYPE_ACCESS_FAULT;
                     msg.fault_vaddr = page_va;
                     rc = rt_varea_fix_private_locked(varea, rt_hw_mmu_v2p(aspace, page_va),
                                                     &msg, RT_TRUE);
-                    RDWR_UNLOCK(aspace);
                     if (rc == MM_FAULT_FIXABLE_TRUE)
                     {
                         varea = _aspace_bst_search(aspace, page_va);
@@ -1768,7 +2069,11 @@ rt_err_t rt_aspace_page_put(rt_aspace_t aspace, void *page_va, void *buffer)
     }
     else
         rc = -RT_EINVAL;
-    RD_UNLOCK(aspace);
+
+    if (writer)
+        WR_UNLOCK(aspace);
+    else
+        RD_UNLOCK(aspace);
 
     return rc;
 }
@@ -34,9 +34,30 @@ typedef struct rt_spinlock mm_spinlock_t;
 struct rt_aspace;
 struct rt_varea;
 struct rt_mem_obj;
+struct rt_memcg;
 
 extern struct rt_aspace rt_kernel_space;
 
+/**
+ * Reader/writer lock of the varea tree. Readers (page fault, query) run in
+ * parallel, while writers (map, unmap, ...) are exclusive. The lock is
+ * recursive for the writer, and a writer can also take it as a reader.
+ * A reader shall never try to take it as a writer.
+ */
+typedef struct rt_aspace_rwlock
+{
+    struct rt_spinlock spinlock;
+    rt_thread_t writer;
+    rt_uint32_t nested;             /* recursion of the writer */
+    rt_uint32_t readers;
+    rt_uint32_t rd_waiting;
+    rt_bool_t wr_waiting;
+
+    struct rt_mutex wr_lock;        /* serialize the writers */
+    struct rt_semaphore rd_sem;     /* readers waiting for the writer */
+    struct rt_semaphore wr_sem;     /* writer waiting for the readers */
+} rt_aspace_rwlock_t;
+
 typedef struct rt_aspace
 {
     void *start;
@@ -46,10 +67,12 @@ typedef struct rt_aspace
     mm_spinlock_t pgtbl_lock;
 
     struct _aspace_tree tree;
-    struct rt_mutex bst_lock;
+    rt_aspace_rwlock_t bst_lock;
 
     struct rt_mem_obj *private_object;
     rt_uint64_t asid;
+    rt_ubase_t cpu_mask;            /* harts which have run the aspace */
+    struct rt_memcg *memcg;         /* memory group charged, with a reference */
 } *rt_aspace_t;
 
 typedef struct rt_varea
@@ -128,20 +151,29 @@ enum rt_mmu_cntl
     MMU_CNTL_DUMMY_END,
 };
 
+void rt_aspace_rd_lock(rt_aspace_t aspace);
+void rt_aspace_rd_unlock(rt_aspace_t aspace);
+void rt_aspace_wr_lock(rt_aspace_t aspace);
+void rt_aspace_wr_unlock(rt_aspace_t aspace);
+void rt_aspace_fault_lock(rt_aspace_t aspace, void *vaddr);
+rt_bool_t rt_aspace_fault_trylock(rt_aspace_t aspace, void *vaddr);
+void rt_aspace_fault_unlock(rt_aspace_t aspace, void *vaddr);
+
 /**
- * @brief Lock to access page table of address space
+ * @brief Lock to access the varea tree of address space
  */
-#define WR_LOCK(aspace)                                                        \
-    rt_thread_self() ? rt_mutex_take(&(aspace)->bst_lock, RT_WAITING_FOREVER)  \
-                     : 0
-#define WR_UNLOCK(aspace)                                                      \
-    rt_thread_self() ? rt_mutex_release(&(aspace)->bst_lock) : 0
-
-/* FIXME: fix rd_lock */
-#define RD_LOCK(aspace)   WR_LOCK(aspace)
-#define RD_UNLOCK(aspace) WR_UNLOCK(aspace)
-#define RDWR_LOCK(aspace)   ((void)aspace)
-#define RDWR_UNLOCK(aspace) ((void)aspace)
+#define WR_LOCK(aspace)     rt_aspace_wr_lock(aspace)
+#define WR_UNLOCK(aspace)   rt_aspace_wr_unlock(aspace)
+#define RD_LOCK(aspace)     rt_aspace_rd_lock(aspace)
+#define RD_UNLOCK(aspace)   rt_aspace_rd_unlock(aspace)
+
+/**
+ * @brief Lock to fix a page fault of a page under the read lock, so the
+ * concurrent faults on the same page are serialized. Lock order is
+ * aspace lock -> fault lock -> aspace lock of the backup aspace.
+ */
+#define RDWR_LOCK(aspace, vaddr)    rt_aspace_fault_lock(aspace, vaddr)
+#define RDWR_UNLOCK(aspace, vaddr)  rt_aspace_fault_unlock(aspace, vaddr)
 
 rt_aspace_t rt_aspace_create(void *start, rt_size_t length, void *pgtbl);
 
@@ -304,6 +336,66 @@ int rt_varea_unmap_range(rt_varea_t varea, void *vaddr, rt_size_t length);
  */
 void rt_varea_pgmgr_insert(rt_varea_t varea, void *page_addr);
 
+#define RT_MMU_GATHER_LOCAL_NR 8
+
+/**
+ * Gather of the page frames unmapped from an aspace. Invalidation of the
+ * unmapped range is deferred and the frames are freed only after it is done,
+ * so one flush covers a batch of pages and no stale translation can reach a
+ * frame that was reused.
+ */
+struct rt_mmu_gather
+{
+    rt_aspace_t aspace;
+    char *start;                    /* unmapped range not yet invalidated */
+    char *end;
+
+    rt_size_t nr;
+    rt_size_t max;
+    void **pages;                   /* frames waiting for the invalidation */
+    void *local[RT_MMU_GATHER_LOCAL_NR];
+};
+
+/**
+ * @brief Start a gather on the aspace
+ *
+ * @param tlb the gather
+ * @param aspace target aspace
+ */
+void rt_mmu_gather_init(struct rt_mmu_gather *tlb, rt_aspace_t aspace);
+
+/**
+ * @brief Record a range whose page table entries were cleared
+ *
+ * @param tlb the gather
+ * @param vaddr start of the range
+ * @param size bytes of the range
+ */
+void rt_mmu_gather_range(struct rt_mmu_gather *tlb, void *vaddr, rt_size_t size);
+
+/**
+ * @brief Queue a page frame to be freed after the invalidation. The page
+ * must be unmapped, and its range recorded, before calling this.
+ *
+ * @param tlb the gather
+ * @param page_va kernel address of the page frame
+ */
+void rt_mmu_gather_page(struct rt_mmu_gather *tlb, void *page_va);
+
+/**
+ * @brief Invalidate the recorded range and free the queued page frames
+ *
+ * @param tlb the gather
+ */
+void rt_mmu_gather_flush(struct rt_mmu_gather *tlb);
+
+/**
+ * @brief Flush the gather and release its resources
+ *
+ * @param tlb the gather
+ */
+void rt_mmu_gather_finish(struct rt_mmu_gather *tlb);
+
 rt_inline rt_mem_obj_t rt_mem_obj_create(rt_mem_obj_t source)
 {
     rt_mem_obj_t target;
@@ -54,7 +54,6 @@ static int _read_fault(rt_varea_t varea, void *pa, struct rt_aspace_fault_msg *m
 
 static int _write_fault(rt_varea_t varea, void *pa, struct rt_aspace_fault_msg *msg)
 {
-    rt_aspace_t aspace = varea->aspace;
     int err = MM_FAULT_FIXABLE_FALSE;
 
     if (rt_varea_is_private_locked(varea))
@@ -63,9 +62,8 @@ static int _write_fault(rt_varea_t varea, void *pa, struct rt_aspace_fault_msg *
             msg->fault_type == MM_FAULT_TYPE_ACCESS_FAULT ||
             msg->fault_type == MM_FAULT_TYPE_PAGE_FAULT))
         {
-            RDWR_LOCK(aspace);
+            /* the caller holds the write lock for this case */
             err = rt_varea_fix_private_locked(varea, pa, msg, RT_FALSE);
-            RDWR_UNLOCK(aspace);
             if (err == MM_FAULT_FIXABLE_FALSE)
                 LOG_I("%s: fix private failure", __func__);
         }
@@ -102,6 +100,20 @@ static int _exec_fault(rt_varea_t varea, void *pa, struct rt_aspace_fault_msg *m
     return err;
 }
 
+static void _fault_account(rt_aspace_t aspace, struct rt_aspace_fault_msg *msg)
+{
+    rt_lwp_t lwp = lwp_self();
+
+    /* statistics only, the racing updates from the sibling threads are tolerated */
+    if (lwp && lwp->aspace == aspace)
+    {
+        if (msg->response.major)
+            lwp->rt_rusage.ru_majflt++;
+        else
+            lwp->rt_rusage.ru_minflt++;
+    }
+}
+
 int rt_aspace_fault_try_fix(rt_aspace_t aspace, struct rt_aspace_fault_msg *msg)
 {
     int err = MM_FAULT_FIXABLE_FALSE;
@@ -115,12 +127,26 @@ int rt_aspace_fault_try_fix(rt_aspace_t aspace, struct rt_aspace_fault_msg *msg)
     if (aspace)
     {
         rt_varea_t varea;
+        rt_bool_t writer = RT_FALSE;
 
         RD_LOCK(aspace);
         varea = _aspace_bst_search(aspace, msg->fault_vaddr);
+        if (varea && msg->fault_op == MM_FAULT_OP_WRITE && rt_varea_is_private_locked(varea))
+        {
+            /* fixing the private varea modifies the varea tree, retry as a writer */
+            RD_UNLOCK(aspace);
+            WR_LOCK(aspace);
+            writer = RT_TRUE;
+            varea = _aspace_bst_search(aspace, msg->fault_vaddr);
+        }
+
         if (varea)
         {
-            void *pa = rt_hw_mmu_v2p(aspace, msg->fault_vaddr);
+            void *pa;
+
+            /* the faults on the same page are serialized from the check to the mapping */
+            RDWR_LOCK(aspace, msg->fault_vaddr);
+            pa = rt_hw_mmu_v2p(aspace, msg->fault_vaddr);
             if (pa != ARCH_MAP_FAILED && msg->fault_type == MM_FAULT_TYPE_PAGE_FAULT)
             {
                 LOG_D("%s(fault=%p) has already fixed", __func__, msg->fault_vaddr);
@@ -145,12 +171,20 @@ int rt_aspace_fault_try_fix(rt_aspace_t aspace, struct rt_aspace_fault_msg *msg)
                     break;
                 }
             }
+            RDWR_UNLOCK(aspace, msg->fault_vaddr);
         }
         else
         {
             LOG_I("%s: varea not found at 0x%lx", __func__, msg->fault_vaddr);
         }
-        RD_UNLOCK(aspace);
+
+        if (writer)
+            WR_UNLOCK(aspace);
+        else
+            RD_UNLOCK(aspace);
+
+        if (err == MM_FAULT_FIXABLE_TRUE)
+            _fault_account(aspace, msg);
     }
 
     return err;
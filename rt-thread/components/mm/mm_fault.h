@@ -67,6 +67,9 @@ struct rt_mm_fault_res
 
     /* hint for prefetch strategy */
     enum rt_mm_hint_prefetch hint;
+
+    /* the fault waits for the backing store, a major fault */
+    rt_bool_t major;
 };
 
 struct rt_aspace_fault_msg
@@ -96,6 +99,7 @@ rt_inline void rt_mm_fault_res_init(struct rt_mm_fault_res *res)
     res->vaddr = RT_NULL;
     res->size = 0;
     res->hint = MM_FAULT_HINT_PREFETCH_NONE;
+    res->major = RT_FALSE;
     res->status = MM_FAULT_STATUS_UNRECOVERABLE;
 }
 
@@ -0,0 +1,190 @@
+/*
+ * Copyright (c) 2006-2023, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2024-03-02     RTT          the first version
+ */
+#include <rtthread.h>
+
+#ifdef RT_USING_MM_MEMCG
+
+#define DBG_TAG "mm.memcg"
+#define DBG_LVL DBG_INFO
+#include <rtdbg.h>
+
+#include <stdlib.h>
+#include "mm_aspace.h"
+#include "mm_memcg.h"
+#include <mmu.h>
+
+#ifdef RT_USING_SMART
+#include <lwp.h>
+#endif
+
+#define PGNR2KB(nr) ((nr) << (ARCH_PAGE_SHIFT - 10))
+
+static rt_list_t _memcg_list = RT_LIST_OBJECT_INIT(_memcg_list);
+static struct rt_spinlock _memcg_lock = RT_SPINLOCK_INIT;
+static rt_memcg_reclaim_t _memcg_reclaim;
+
+rt_memcg_t rt_memcg_create(int id)
+{
+    rt_memcg_t memcg;
+    rt_base_t level;
+
+    memcg = rt_calloc(1, sizeof(*memcg));
+    if (memcg)
+    {
+        rt_atomic_store(&memcg->ref_count, 1);
+        memcg->id = id;
+
+        level = rt_spin_lock_irqsave(&_memcg_lock);
+        rt_list_insert_before(&_memcg_list, &memcg->node);
+        rt_spin_unlock_irqrestore(&_memcg_lock, level);
+    }
+
+    return memcg;
+}
+
+rt_memcg_t rt_memcg_get(rt_memcg_t memcg)
+{
+    if (memcg)
+        rt_atomic_add(&memcg->ref_count, 1);
+    return memcg;
+}
+
+void rt_memcg_put(rt_memcg_t memcg)
+{
+    rt_base_t level;
+    rt_bool_t last;
+
+    if (memcg)
+    {
+        /* the list walker can take a reference under the lock */
+        level = rt_spin_lock_irqsave(&_memcg_lock);
+        last = rt_atomic_sub(&memcg->ref_count, 1) == 1;
+        if (last)
+            rt_list_remove(&memcg->node);
+        rt_spin_unlock_irqrestore(&_memcg_lock, level);
+
+        if (last)
+            rt_free(memcg);
+    }
+}
+
+rt_memcg_t rt_memcg_current(void)
+{
+#ifdef RT_USING_SMART
+    rt_lwp_t lwp = lwp_self();
+
+    if (lwp && lwp->aspace)
+        return lwp->aspace->memcg;
+#endif /* RT_USING_SMART */
+
+    return RT_NULL;
+}
+
+rt_size_t rt_memcg_usage(rt_memcg_t memcg)
+{
+    rt_base_t usage = 0;
+    int i;
+
+    for (i = 0; i < RT_MEMCG_STAT_NR; i++)
+        usage += rt_atomic_load(&memcg->stat[i]);
+
+    return usage > 0 ? usage : 0;
+}
+
+void rt_memcg_check(rt_memcg_t memcg)
+{
+    rt_size_t usage;
+    rt_atomic_t idle = 0;
+
+    if (memcg && memcg->soft_limit && _memcg_reclaim)
+    {
+        usage = rt_memcg_usage(memcg);
+        if (usage > memcg->soft_limit &&
+            rt_atomic_compare_exchange_strong(&memcg->reclaiming, &idle, 1))
+        {
+            _memcg_reclaim(memcg, usage - memcg->soft_limit);
+        }
+    }
+}
+
+void rt_memcg_reclaim_done(rt_memcg_t memcg, rt_size_t nr)
+{
+    rt_atomic_add(&memcg->reclaimed, nr);
+    rt_atomic_store(&memcg->reclaiming, 0);
+}
+
+void rt_memcg_reclaimer_set(rt_memcg_reclaim_t reclaim)
+{
+    _memcg_reclaim = reclaim;
+}
+
+void rt_memcg_inherit(rt_memcg_t memcg, rt_memcg_t from, int id)
+{
+    if (memcg)
+    {
+        memcg->id = id;
+        if (from)
+            memcg->soft_limit = from->soft_limit;
+    }
+}
+
+static int memcg(int argc, char **argv)
+{
+    rt_memcg_t iter;
+    rt_memcg_t found = RT_NULL;
+    rt_base_t level;
+    int id;
+
+    if (argc == 3)
+    {
+        id = atoi(argv[1]);
+
+        level = rt_spin_lock_irqsave(&_memcg_lock);
+        rt_list_for_each_entry(iter, &_memcg_list, node)
+        {
+            if (iter->id == id)
+            {
+                iter->soft_limit = RT_ALIGN(atol(argv[2]) << 10, ARCH_PAGE_SIZE) >> ARCH_PAGE_SHIFT;
+                found = rt_memcg_get(iter);
+                break;
+            }
+        }
+        rt_spin_unlock_irqrestore(&_memcg_lock, level);
+
+        if (found)
+        {
+            rt_memcg_check(found);
+            rt_memcg_put(found);
+        }
+        else
+        {
+            rt_kprintf("no memory group of %d\n", id);
+        }
+        return 0;
+    }
+
+    rt_kprintf("  id     anon(KB)   pcache(KB)   kernel(KB)    limit(KB) reclaimed(KB)\n");
+    level = rt_spin_lock_irqsave(&_memcg_lock);
+    rt_list_for_each_entry(iter, &_memcg_list, node)
+    {
+        rt_kprintf("%4d %12ld %12ld %12ld %12ld %13ld\n", iter->id,
+                   (long)PGNR2KB(rt_atomic_load(&iter->stat[RT_MEMCG_ANON])),
+                   (long)PGNR2KB(rt_atomic_load(&iter->stat[RT_MEMCG_PCACHE])),
+                   (long)PGNR2KB(rt_atomic_load(&iter->stat[RT_MEMCG_KERNEL])),
+                   (long)PGNR2KB(iter->soft_limit),
+                   (long)PGNR2KB(rt_atomic_load(&iter->reclaimed)));
+    }
+    rt_spin_unlock_irqrestore(&_memcg_lock, level);
+
+    return 0;
+}
+MSH_CMD_EXPORT(memcg, list memory groups or set a soft limit: memcg [pid limit_kb]);
+
+#endif /* RT_USING_MM_MEMCG */
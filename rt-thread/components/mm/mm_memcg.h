@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) 2006-2023, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2024-03-02     RTT          the first version
+ */
+#ifndef __MM_MEMCG_H__
+#define __MM_MEMCG_H__
+
+#include <rtthread.h>
+
+enum rt_memcg_stat
+{
+    RT_MEMCG_ANON,                  /* anonymous pages mapped */
+    RT_MEMCG_PCACHE,                /* page cache pages loaded */
+    RT_MEMCG_KERNEL,                /* page tables */
+    RT_MEMCG_STAT_NR,
+};
+
+/**
+ * Memory group of a process. Pages are charged to the group while it is
+ * alive, and a page cache page keeps the group it's charged to until the
+ * page is freed. When the usage exceeds the soft limit, the page cache
+ * pages of the group are reclaimed in the background.
+ */
+typedef struct rt_memcg
+{
+    rt_list_t node;
+    rt_atomic_t ref_count;
+    int id;
+
+    rt_atomic_t stat[RT_MEMCG_STAT_NR];
+    rt_size_t soft_limit;           /* in pages, 0 for no limit */
+    rt_atomic_t reclaiming;
+    rt_atomic_t reclaimed;
+} *rt_memcg_t;
+
+/* reclaim nr pages of the group, rt_memcg_reclaim_done() shall follow */
+typedef void (*rt_memcg_reclaim_t)(rt_memcg_t memcg, rt_size_t nr);
+
+#ifdef RT_USING_MM_MEMCG
+
+rt_memcg_t rt_memcg_create(int id);
+rt_memcg_t rt_memcg_get(rt_memcg_t memcg);
+void rt_memcg_put(rt_memcg_t memcg);
+
+/**
+ * @brief Memory group of the current process
+ *
+ * @return rt_memcg_t the group, RT_NULL for kernel threads
+ */
+rt_memcg_t rt_memcg_current(void);
+
+rt_inline void rt_memcg_charge(rt_memcg_t memcg, enum rt_memcg_stat stat, long nr)
+{
+    if (memcg)
+        rt_atomic_add(&memcg->stat[stat], nr);
+}
+
+rt_inline void rt_memcg_uncharge(rt_memcg_t memcg, enum rt_memcg_stat stat, long nr)
+{
+    if (memcg)
+        rt_atomic_sub(&memcg->stat[stat], nr);
+}
+
+rt_size_t rt_memcg_usage(rt_memcg_t memcg);
+
+/**
+ * @brief Start the reclaim if the group is over its soft limit
+ *
+ * @note it never blocks, and the caller may hold the locks of mm
+ *
+ * @param memcg the group
+ */
+void rt_memcg_check(rt_memcg_t memcg);
+
+void rt_memcg_reclaim_done(rt_memcg_t memcg, rt_size_t nr);
+void rt_memcg_reclaimer_set(rt_memcg_reclaim_t reclaim);
+
+/**
+ * @brief Rebind the group to a new id, taking the limit of another group
+ *
+ * @param memcg the group
+ * @param from the group giving the soft limit, can be RT_NULL
+ * @param id the new id
+ */
+void rt_memcg_inherit(rt_memcg_t memcg, rt_memcg_t from, int id);
+
+#else
+
+#define rt_memcg_create(id)                     RT_NULL
+#define rt_memcg_get(memcg)                     (memcg)
+#define rt_memcg_put(memcg)
+#define rt_memcg_current()                      RT_NULL
+#define rt_memcg_charge(memcg, stat, nr)
+#define rt_memcg_uncharge(memcg, stat, nr)
+#define rt_memcg_check(memcg)
+#define rt_memcg_reclaim_done(memcg, nr)
+#define rt_memcg_reclaimer_set(reclaim)
+#define rt_memcg_inherit(memcg, from, id)
+
+#endif /* RT_USING_MM_MEMCG */
+
+#endif /* __MM_MEMCG_H__ */
@@ -43,8 +43,37 @@ static struct rt_varea mpr_varea;
 
 static struct rt_page *page_list_low[RT_PAGE_MAX_ORDER];
 static struct rt_page *page_list_high[RT_PAGE_MAX_ORDER];
+static rt_size_t page_free_nr_low[RT_PAGE_MAX_ORDER];
+static rt_size_t page_free_nr_high[RT_PAGE_MAX_ORDER];
 static RT_DEFINE_SPINLOCK(_spinlock);
 
+#ifdef RT_PAGE_USING_PCP
+#ifdef RT_USING_SMP
+#define PCP_CPUS RT_CPUS_NR
+#else
+#define PCP_CPUS 1
+#endif /* RT_USING_SMP */
+
+/* max cached blocks of an order, and the blocks moved per refill/drain */
+#define PCP_HIGH(order)     ((RT_PAGE_PCP_HIGH >> (order)) > 2 ? (RT_PAGE_PCP_HIGH >> (order)) : 2)
+#define PCP_BATCH(order)    (PCP_HIGH(order) / 2)
+
+/*
+ * per-CPU page frame cache of one order. Freed blocks are pushed to the hot
+ * end (head) and reused first, draining takes the cold end (tail). It's only
+ * touched by the owner cpu with local interrupt disabled.
+ */
+struct page_pcp
+{
+    struct rt_page *head;
+    struct rt_page *tail;
+    rt_size_t count;
+};
+
+/* [cpu][low/high page list][order] */
+static struct page_pcp _pcp[PCP_CPUS][2][RT_PAGE_PCP_ORDER_NR];
+#endif /* RT_PAGE_USING_PCP */
+
 #define page_start ((rt_page_t)rt_mpr_start)
 
 static rt_size_t page_nr;
@@ -270,6 +299,11 @@ static inline struct rt_page *_buddy_get(struct rt_page *p,
     return rt_page_addr2page((void *)addr);
 }
 
+rt_inline rt_size_t *_free_nr_get(rt_page_t page_list[])
+{
+    return page_list == page_list_high ? page_free_nr_high : page_free_nr_low;
+}
+
 static void _page_remove(rt_page_t page_list[], struct rt_page *p, rt_uint32_t size_bits)
 {
     if (p->pre)
@@ -287,6 +321,7 @@ static void _page_remove(rt_page_t page_list[], struct rt_page *p, rt_uint32_t s
     }
 
     p->size_bits = ARCH_ADDRESS_WIDTH_BITS;
+    _free_nr_get(page_list)[size_bits]--;
 }
 
 static void _page_insert(rt_page_t page_list[], struct rt_page *p, rt_uint32_t size_bits)
@@ -299,6 +334,7 @@ static void _page_insert(rt_page_t page_list[], struct rt_page *p, rt_uint32_t s
     p->pre = 0;
     page_list[size_bits] = p;
     p->size_bits = size_bits;
+    _free_nr_get(page_list)[size_bits]++;
 }
 
 static void _pages_ref_inc(struct rt_page *p, rt_uint32_t size_bits)
@@ -423,6 +459,7 @@ static void _early_page_remove(rt_page_t page_list[], rt_page_t page, rt_uint32_
     }
 
     page_cont->size_bits = ARCH_ADDRESS_WIDTH_BITS;
+    _free_nr_get(page_list)[size_bits]--;
 }
 
 static void _early_page_insert(rt_page_t page_list[], rt_page_t page, int size_bits)
@@ -440,6 +477,7 @@ static void _early_page_insert(rt_page_t page_list[], rt_page_t page, int size_b
     page_cont->pre = 0;
     page_list[size_bits] = page;
     page_cont->size_bits = size_bits;
+    _free_nr_get(page_list)[size_bits]++;
 }
 
 static struct rt_page *_early_pages_alloc(rt_page_t page_list[], rt_uint32_t size_bits)
@@ -540,25 +578,188 @@ static rt_page_t *_flag_to_page_list(size_t flags)
     return page_list;
 }
 
-rt_inline void *_do_pages_alloc(rt_uint32_t size_bits, size_t flags)
+#ifdef RT_PAGE_USING_PCP
+rt_inline rt_bool_t _pcp_usable(rt_uint32_t size_bits)
+{
+    /* the cache is bypassed until the early page allocator is retired */
+    return size_bits < RT_PAGE_PCP_ORDER_NR && pages_alloc_handler == _pages_alloc;
+}
+
+/* local interrupt must be disabled */
+rt_inline struct page_pcp *_pcp_get(rt_page_t page_list[], rt_uint32_t size_bits)
+{
+#ifdef RT_USING_SMP
+    int cpu = rt_hw_cpu_id();
+#else
+    int cpu = 0;
+#endif /* RT_USING_SMP */
+
+    return &_pcp[cpu][page_list == page_list_high][size_bits];
+}
+
+static void _pcp_push_head(struct page_pcp *pcp, struct rt_page *p)
+{
+    p->pre = RT_NULL;
+    p->next = pcp->head;
+    if (pcp->head)
+        pcp->head->pre = p;
+    else
+        pcp->tail = p;
+    pcp->head = p;
+    pcp->count++;
+}
+
+static struct rt_page *_pcp_pop_head(struct page_pcp *pcp)
+{
+    struct rt_page *p = pcp->head;
+
+    if (p)
+    {
+        pcp->head = p->next;
+        if (pcp->head)
+            pcp->head->pre = RT_NULL;
+        else
+            pcp->tail = RT_NULL;
+        pcp->count--;
+    }
+    return p;
+}
+
+static struct rt_page *_pcp_pop_tail(struct page_pcp *pcp)
+{
+    struct rt_page *p = pcp->tail;
+
+    if (p)
+    {
+        pcp->tail = p->pre;
+        if (pcp->tail)
+            pcp->tail->next = RT_NULL;
+        else
+            pcp->head = RT_NULL;
+        pcp->count--;
+    }
+    return p;
+}
+
+/* return cached blocks to the buddy lists, _spinlock must be held */
+static void _pcp_drain_locked(rt_page_t page_list[], struct page_pcp *pcp,
+                              rt_uint32_t size_bits, rt_size_t nr)
 {
-    void *alloc_buf = RT_NULL;
     struct rt_page *p;
+
+    while (nr-- && (p = _pcp_pop_tail(pcp)) != RT_NULL)
+    {
+        p->ref_cnt = 1;
+        _pages_free(page_list, p, size_bits);
+    }
+}
+
+static struct rt_page *_pcp_alloc(rt_page_t page_list[], rt_uint32_t size_bits)
+{
+    int i;
     rt_base_t level;
-    rt_page_t *page_list = _flag_to_page_list(flags);
+    struct page_pcp *pcp;
+    struct rt_page *p;
+
+    level = rt_hw_local_irq_disable();
+    pcp = _pcp_get(page_list, size_bits);
+    p = _pcp_pop_head(pcp);
+    if (!p)
+    {
+        /* refill a batch from the buddy lists */
+        rt_spin_lock(&_spinlock);
+        p = _pages_alloc(page_list, size_bits);
+        if (!p)
+        {
+            /* merge back whatever this cpu holds and retry */
+            for (i = 0; i < RT_PAGE_PCP_ORDER_NR; i++)
+            {
+                struct page_pcp *iter = _pcp_get(page_list, i);
+                _pcp_drain_locked(page_list, iter, i, iter->count);
+            }
+            p = _pages_alloc(page_list, size_bits);
+        }
+        for (i = 1; p && i < PCP_BATCH(size_bits); i++)
+        {
+            struct rt_page *q = _pages_alloc(page_list, size_bits);
+            if (!q)
+                break;
+            q->ref_cnt = 0;
+            _pcp_push_head(pcp, q);
+        }
+        rt_spin_unlock(&_spinlock);
+    }
+    rt_hw_local_irq_enable(level);
+
+    if (p)
+        p->ref_cnt = 1;
+    return p;
+}
+
+static void _pcp_free(rt_page_t page_list[], struct rt_page *p, rt_uint32_t size_bits)
+{
+    rt_base_t level;
+    struct page_pcp *pcp;
+
+    level = rt_hw_local_irq_disable();
+    pcp = _pcp_get(page_list, size_bits);
+    p->ref_cnt = 0;
+    _pcp_push_head(pcp, p);
+    if (pcp->count > PCP_HIGH(size_bits))
+    {
+        rt_spin_lock(&_spinlock);
+        _pcp_drain_locked(page_list, pcp, size_bits, PCP_BATCH(size_bits));
+        rt_spin_unlock(&_spinlock);
+    }
+    rt_hw_local_irq_enable(level);
+}
+
+static rt_size_t _pcp_count(rt_page_t page_list[], rt_uint32_t size_bits)
+{
+    int cpu;
+    rt_size_t count = 0;
+
+    if (size_bits >= RT_PAGE_PCP_ORDER_NR)
+        return 0;
+
+    for (cpu = 0; cpu < PCP_CPUS; cpu++)
+        count += _pcp[cpu][page_list == page_list_high][size_bits].count;
+    return count;
+}
+#else
+#define _pcp_count(page_list, size_bits) 0
+#endif /* RT_PAGE_USING_PCP */
+
+static struct rt_page *_do_alloc_from(rt_page_t page_list[], rt_uint32_t size_bits)
+{
+    struct rt_page *p;
+    rt_base_t level;
+
+#ifdef RT_PAGE_USING_PCP
+    if (_pcp_usable(size_bits))
+        return _pcp_alloc(page_list, size_bits);
+#endif /* RT_PAGE_USING_PCP */
 
     level = rt_spin_lock_irqsave(&_spinlock);
     p = pages_alloc_handler(page_list, size_bits);
     rt_spin_unlock_irqrestore(&_spinlock, level);
+    return p;
+}
+
+rt_inline void *_do_pages_alloc(rt_uint32_t size_bits, size_t flags)
+{
+    void *alloc_buf = RT_NULL;
+    struct rt_page *p;
+    rt_page_t *page_list = _flag_to_page_list(flags);
+
+    p = _do_alloc_from(page_list, size_bits);
 
     if (!p && page_list != page_list_low)
     {
         /* fall back */
         page_list = page_list_low;
 
-        level = rt_spin_lock_irqsave(&_spinlock);
-        p = pages_alloc_handler(page_list, size_bits);
-        rt_spin_unlock_irqrestore(&_spinlock, level);
+        p = _do_alloc_from(page_list, size_bits);
     }
 
     if (p)
@@ -566,6 +767,7 @@ rt_inline void *_do_pages_alloc(rt_uint32_t size_bits, size_t flags)
         alloc_buf = page_to_addr(p);
 
         #ifdef RT_DEBUGING_PAGE_LEAK
+            rt_base_t level;
             level = rt_spin_lock_irqsave(&_spinlock);
             TRACE_ALLOC(p, size_bits);
             rt_spin_unlock_irqrestore(&_spinlock, level);
@@ -594,6 +796,21 @@ int rt_pages_free(void *addr, rt_uint32_t size_bits)
     if (p)
     {
         rt_base_t level;
+
+#ifdef RT_PAGE_USING_PCP
+        /* the last reference is held by the caller, nobody else can race */
+        if (_pcp_usable(size_bits) && p->ref_cnt == 1)
+        {
+            _pcp_free(page_list, p, size_bits);
+            #ifdef RT_DEBUGING_PAGE_LEAK
+                level = rt_spin_lock_irqsave(&_spinlock);
+                TRACE_FREE(p, size_bits);
+                rt_spin_unlock_irqrestore(&_spinlock, level);
+            #endif
+            return 1;
+        }
+#endif /* RT_PAGE_USING_PCP */
+
         level = rt_spin_lock_irqsave(&_spinlock);
         real_free = _pages_free(page_list, p, size_bits);
         if (real_free)
@@ -604,6 +821,36 @@ int rt_pages_free(void *addr, rt_uint32_t size_bits)
     return real_free;
 }
 
+/**
+ * @brief Split an allocated page group into single pages, each one holding
+ * a reference, so they can be freed one by one later.
+ *
+ * @param addr head of the page group, which shall be held by the caller only
+ * @param size_bits order of the page group
+ */
+void rt_pages_split(void *addr, rt_uint32_t size_bits)
+{
+    struct rt_page *p;
+    rt_base_t level;
+    rt_size_t i;
+
+    p = rt_page_addr2page(addr);
+    RT_ASSERT(p);
+
+    level = rt_spin_lock_irqsave(&_spinlock);
+    RT_ASSERT(p->ref_cnt == 1);
+    RT_ASSERT(p->size_bits == ARCH_ADDRESS_WIDTH_BITS);
+
+    TRACE_FREE(p, size_bits);
+    for (i = 0; i < (1ul << size_bits); i++)
+    {
+        p[i].size_bits = ARCH_ADDRESS_WIDTH_BITS;
+        p[i].ref_cnt = 1;
+        TRACE_ALLOC(&p[i], 0);
+    }
+    rt_spin_unlock_irqrestore(&_spinlock, level);
+}
+
 void rt_page_list(void) __attribute__((alias("list_page")));
 
 #define PGNR2SIZE(nr) ((nr) * ARCH_PAGE_SIZE / 1024)
@@ -641,6 +888,15 @@ void list_page(void)
 
     rt_spin_unlock_irqrestore(&_spinlock, level);
     rt_kprintf("-------------------------------\n");
+    rt_kprintf("order  free(low)  free(high) cached\n");
+    for (i = 0; i < RT_PAGE_MAX_ORDER; i++)
+    {
+        rt_size_t cached = _pcp_count(page_list_low, i) + _pcp_count(page_list_high, i);
+
+        rt_kprintf("%5d %10ld %10ld %6ld\n", i, page_free_nr_low[i], page_free_nr_high[i], cached);
+        free += cached << i;
+    }
+    rt_kprintf("-------------------------------\n");
     rt_kprintf("Page Summary:\n => free/installed: 0x%lx/0x%lx (%ld/%ld KB)\n", free, installed, PGNR2SIZE(free), PGNR2SIZE(installed));
     rt_kprintf("-------------------------------\n");
 }
@@ -655,23 +911,8 @@ void rt_page_get_info(rt_size_t *total_nr, rt_size_t *free_nr)
     level = rt_spin_lock_irqsave(&_spinlock);
     for (i = 0; i < RT_PAGE_MAX_ORDER; i++)
     {
-        struct rt_page *p = page_list_low[i];
-
-        while (p)
-        {
-            total_free += (1UL << i);
-            p = p->next;
-        }
-    }
-    for (i = 0; i < RT_PAGE_MAX_ORDER; i++)
-    {
-        struct rt_page *p = page_list_high[i];
-
-        while (p)
-        {
-            total_free += (1UL << i);
-            p = p->next;
-        }
+        total_free += (page_free_nr_low[i] + page_free_nr_high[i] +
+                       _pcp_count(page_list_low, i) + _pcp_count(page_list_high, i)) << i;
     }
     rt_spin_unlock_irqrestore(&_spinlock, level);
     *total_nr = page_nr;
@@ -687,13 +928,7 @@ void rt_page_high_get_info(rt_size_t *total_nr, rt_size_t *free_nr)
     level = rt_spin_lock_irqsave(&_spinlock);
     for (i = 0; i < RT_PAGE_MAX_ORDER; i++)
     {
-        struct rt_page *p = page_list_high[i];
-
-        while (p)
-        {
-            total_free += (1UL << i);
-            p = p->next;
-        }
+        total_free += (page_free_nr_high[i] + _pcp_count(page_list_high, i)) << i;
     }
     rt_spin_unlock_irqrestore(&_spinlock, level);
     *total_nr = _high_pages_nr;
@@ -787,6 +1022,8 @@ void rt_page_init(rt_region_t reg)
     {
         page_list_low[i] = 0;
         page_list_high[i] = 0;
+        page_free_nr_low[i] = 0;
+        page_free_nr_high[i] = 0;
     }
 
     /* map MPR area */
@@ -83,6 +83,8 @@ int rt_page_ref_get(void *addr, rt_uint32_t size_bits);
 
 int rt_pages_free(void *addr, rt_uint32_t size_bits);
 
+void rt_pages_split(void *addr, rt_uint32_t size_bits);
+
 void rt_page_list(void);
 
 rt_size_t rt_page_bits(rt_size_t size);
@@ -13,6 +13,7 @@
 #include "mm_aspace.h"
 #include "mm_fault.h"
 #include "mm_flag.h"
+#include "mm_memcg.h"
 #include "mm_page.h"
 
 #include <rtdef.h>
@@ -0,0 +1,461 @@
+/*
+ * Copyright (c) 2006-2026, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-17     agent        first version
+ */
+
+#include <rthw.h>
+#include <rtthread.h>
+#include <ktrace.h>
+
+#ifdef RT_USING_CPUTIME
+#include <drivers/cputime.h>
+#endif /* RT_USING_CPUTIME */
+
+#ifdef RT_USING_DFS
+#include <fcntl.h>
+#include <unistd.h>
+#endif /* RT_USING_DFS */
+
+#define DBG_TAG           "utilities.ktrace"
+#define DBG_LVL           DBG_INFO
+#include <rtdbg.h>
+
+#if (RT_KTRACE_RECORDS & (RT_KTRACE_RECORDS - 1)) != 0
+#error "RT_KTRACE_RECORDS must be a power of 2"
+#endif
+
+#ifdef RT_USING_SMP
+#define KTRACE_CPUS             RT_CPUS_NR
+#else
+#define KTRACE_CPUS             1
+#endif /* RT_USING_SMP */
+
+/* the ring of one cpu, only written by that cpu with local irq disabled */
+struct ktrace_ring
+{
+    rt_uint32_t head;                           /* number of records written */
+    struct ktrace_record records[RT_KTRACE_RECORDS];
+};
+
+/* thread name snapshot for the dump */
+struct ktrace_name
+{
+    rt_ubase_t thread;
+    char name[RT_NAME_MAX];
+};
+
+static struct ktrace_ring _ktrace_ring[KTRACE_CPUS];
+static volatile rt_bool_t _ktrace_enabled = RT_FALSE;
+
+rt_inline rt_uint64_t _ktrace_timestamp(void)
+{
+#ifdef RT_USING_CPUTIME
+    return clock_cpu_gettime();
+#else
+    return rt_tick_get();
+#endif /* RT_USING_CPUTIME */
+}
+
+static rt_uint64_t _ktrace_resolution(void)
+{
+#ifdef RT_USING_CPUTIME
+    return clock_cpu_getres();
+#else
+    return (1000ULL * 1000 * 1000 / RT_TICK_PER_SECOND) * (1000ULL * 1000);
+#endif /* RT_USING_CPUTIME */
+}
+
+/**
+ * @brief Record one event into the ring of the current cpu. The oldest record
+ *        is overwritten when the ring is full.
+ *
+ * @note  This function is lock-free and can be called in any context.
+ */
+void ktrace_record(rt_uint16_t event, rt_ubase_t arg0, rt_ubase_t arg1, rt_uint8_t prio)
+{
+    rt_base_t level;
+    rt_uint32_t cpu;
+    struct ktrace_ring *ring;
+    struct ktrace_record *record;
+
+    if (!_ktrace_enabled)
+        return;
+
+    level = rt_hw_local_irq_disable();
+
+#ifdef RT_USING_SMP
+    cpu = rt_hw_cpu_id();
+#else
+    cpu = 0;
+#endif /* RT_USING_SMP */
+
+    ring = &_ktrace_ring[cpu];
+    record = &ring->records[ring->head & (RT_KTRACE_RECORDS - 1)];
+
+    record->timestamp = _ktrace_timestamp();
+    record->arg0 = arg0;
+    record->arg1 = arg1;
+    record->event = event;
+    record->cpu = (rt_uint8_t)cpu;
+    record->prio = prio;
+    record->seq = ring->head;
+
+    ring->head ++;
+
+    rt_hw_local_irq_enable(level);
+}
+
+static void _ktrace_switch_hook(struct rt_thread *from, struct rt_thread *to)
+{
+    ktrace_record(KTRACE_EVENT_SWITCH, (rt_ubase_t)from, (rt_ubase_t)to,
+                  RT_SCHED_PRIV(to).current_priority);
+}
+
+static void _ktrace_irq_enter_hook(void)
+{
+    ktrace_record(KTRACE_EVENT_IRQ_ENTER, rt_interrupt_get_nest(), 0, 0);
+}
+
+static void _ktrace_irq_leave_hook(void)
+{
+    ktrace_record(KTRACE_EVENT_IRQ_LEAVE, rt_interrupt_get_nest(), 0, 0);
+}
+
+static void _ktrace_suspend_hook(rt_thread_t thread)
+{
+    ktrace_record(KTRACE_EVENT_SUSPEND, (rt_ubase_t)thread, 0,
+                  RT_SCHED_PRIV(thread).current_priority);
+}
+
+static void _ktrace_wakeup_hook(struct rt_thread *thread)
+{
+    rt_ubase_t waker;
+
+    /* the waker is the interrupted thread in irq context, record nothing */
+    waker = rt_interrupt_get_nest() ? 0 : (rt_ubase_t)rt_thread_self();
+
+    ktrace_record(KTRACE_EVENT_WAKEUP, (rt_ubase_t)thread, waker,
+                  RT_SCHED_PRIV(thread).current_priority);
+}
+
+#ifdef RT_KTRACE_USING_IPC
+static void _ktrace_trytake_hook(struct rt_object *object)
+{
+    ktrace_record(KTRACE_EVENT_OBJ_TRYTAKE, (rt_ubase_t)object, rt_object_get_type(object), 0);
+}
+
+static void _ktrace_take_hook(struct rt_object *object)
+{
+    ktrace_record(KTRACE_EVENT_OBJ_TAKE, (rt_ubase_t)object, rt_object_get_type(object), 0);
+}
+
+static void _ktrace_put_hook(struct rt_object *object)
+{
+    ktrace_record(KTRACE_EVENT_OBJ_PUT, (rt_ubase_t)object, rt_object_get_type(object), 0);
+}
+#endif /* RT_KTRACE_USING_IPC */
+
+/**
+ * @brief Install the kernel hooks and start recording.
+ *
+ * @note  The hooks used by the tracer replace any other hooks set before.
+ */
+void ktrace_start(void)
+{
+    rt_scheduler_sethook(_ktrace_switch_hook);
+    rt_interrupt_enter_sethook(_ktrace_irq_enter_hook);
+    rt_interrupt_leave_sethook(_ktrace_irq_leave_hook);
+    rt_thread_suspend_sethook(_ktrace_suspend_hook);
+    rt_scheduler_wakeup_sethook(_ktrace_wakeup_hook);
+#ifdef RT_KTRACE_USING_IPC
+    rt_object_trytake_sethook(_ktrace_trytake_hook);
+    rt_object_take_sethook(_ktrace_take_hook);
+    rt_object_put_sethook(_ktrace_put_hook);
+#endif /* RT_KTRACE_USING_IPC */
+
+    _ktrace_enabled = RT_TRUE;
+}
+
+/**
+ * @brief Stop recording and remove the kernel hooks.
+ */
+void ktrace_stop(void)
+{
+    _ktrace_enabled = RT_FALSE;
+
+    rt_scheduler_sethook(RT_NULL);
+    rt_interrupt_enter_sethook(RT_NULL);
+    rt_interrupt_leave_sethook(RT_NULL);
+    rt_thread_suspend_sethook(RT_NULL);
+    rt_scheduler_wakeup_sethook(RT_NULL);
+#ifdef RT_KTRACE_USING_IPC
+    rt_object_trytake_sethook(RT_NULL);
+    rt_object_take_sethook(RT_NULL);
+    rt_object_put_sethook(RT_NULL);
+#endif /* RT_KTRACE_USING_IPC */
+}
+
+/**
+ * @brief Drop all the records. The tracer shall be stopped.
+ */
+void ktrace_clear(void)
+{
+    int cpu;
+
+    RT_ASSERT(!_ktrace_enabled);
+
+    for (cpu = 0; cpu < KTRACE_CPUS; cpu ++)
+    {
+        _ktrace_ring[cpu].head = 0;
+    }
+}
+
+rt_bool_t ktrace_is_enabled(void)
+{
+    return _ktrace_enabled;
+}
+
+/* the index of the oldest record and the number of records in a ring */
+static rt_uint32_t _ktrace_ring_range(struct ktrace_ring *ring, rt_uint32_t *first)
+{
+    if (ring->head > RT_KTRACE_RECORDS)
+    {
+        *first = ring->head & (RT_KTRACE_RECORDS - 1);
+        return RT_KTRACE_RECORDS;
+    }
+
+    *first = 0;
+    return ring->head;
+}
+
+/* copy the names of all threads, so they can be printed without the lock */
+static struct ktrace_name *_ktrace_snapshot_names(int *count)
+{
+    struct rt_object_information *information;
+    struct ktrace_name *names;
+    struct rt_list_node *node;
+    struct rt_object *object;
+    rt_base_t level;
+    int capacity, index = 0;
+
+    information = rt_object_get_information(RT_Object_Class_Thread);
+    /* leave room for the threads created meanwhile */
+    capacity = rt_object_get_length(RT_Object_Class_Thread) + 8;
+
+    names = (struct ktrace_name *)rt_malloc(capacity * sizeof(struct ktrace_name));
+    if (names == RT_NULL)
+    {
+        *count = 0;
+        return RT_NULL;
+    }
+
+    level = rt_spin_lock_irqsave(&(information->spinlock));
+    rt_list_for_each(node, &(information->object_list))
+    {
+        if (index >= capacity) break;
+
+        object = rt_list_entry(node, struct rt_object, list);
+        names[index].thread = (rt_ubase_t)object;
+        rt_strncpy(names[index].name, object->name, RT_NAME_MAX);
+        index ++;
+    }
+    rt_spin_unlock_irqrestore(&(information->spinlock), level);
+
+    *count = index;
+    return names;
+}
+
+/* 64 bits values are printed in hex, as rt_kprintf may not support long long */
+#define KTRACE_U64_FMT          "%x%08x"
+#define KTRACE_U64_ARG(v)       (rt_uint32_t)((v) >> 32), (rt_uint32_t)(v)
+
+static void _ktrace_dump_console(void)
+{
+    struct ktrace_ring *ring;
+    struct ktrace_record *record;
+    struct ktrace_name *names;
+    rt_uint32_t first, count, index;
+    rt_uint64_t resolution;
+    int cpu, nr, i;
+
+    resolution = _ktrace_resolution();
+    rt_kprintf("KH %d %d " KTRACE_U64_FMT "\n", KTRACE_VERSION, KTRACE_CPUS,
+               KTRACE_U64_ARG(resolution));
+
+    for (cpu = 0; cpu < KTRACE_CPUS; cpu ++)
+    {
+        ring = &_ktrace_ring[cpu];
+        count = _ktrace_ring_range(ring, &first);
+
+        for (index = 0; index < count; index ++)
+        {
+            record = &ring->records[(first + index) & (RT_KTRACE_RECORDS - 1)];
+            rt_kprintf("KT %d %u " KTRACE_U64_FMT " %d %p %p %d\n", record->cpu, record->seq,
+                       KTRACE_U64_ARG(record->timestamp), record->event,
+                       (void *)record->arg0, (void *)record->arg1, record->prio);
+        }
+    }
+
+    names = _ktrace_snapshot_names(&nr);
+    for (i = 0; i < nr; i ++)
+    {
+        rt_kprintf("KN %p %.*s\n", (void *)names[i].thread, RT_NAME_MAX, names[i].name);
+    }
+    rt_free(names);
+}
+
+#ifdef RT_USING_DFS
+static int _ktrace_write(int fd, const void *buffer, rt_size_t size)
+{
+    return write(fd, buffer, size) == (ssize_t)size ? 0 : -1;
+}
+
+/**
+ * @brief Write all the records into a binary file, which can be decoded by
+ *        tools/ktrace.py. The tracer shall be stopped.
+ *
+ * @param path is the path of the file.
+ *
+ * @return 0 on success, otherwise -1.
+ */
+int ktrace_dump_file(const char *path)
+{
+    struct ktrace_dump_header header;
+    struct ktrace_ring *ring;
+    struct ktrace_name *names;
+    rt_uint32_t first, count, value;
+    int fd, cpu, nr = 0, result = 0;
+
+    fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+    {
+        LOG_E("open %s failed", path);
+        return -1;
+    }
+
+    header.magic = KTRACE_MAGIC;
+    header.version = KTRACE_VERSION;
+    header.cpus = KTRACE_CPUS;
+    header.record_size = sizeof(struct ktrace_record);
+    header.ptr_size = sizeof(rt_ubase_t);
+    header.name_size = RT_NAME_MAX;
+    header.reserved = 0;
+    header.resolution = _ktrace_resolution();
+    result |= _ktrace_write(fd, &header, sizeof(header));
+
+    /* each cpu: cpu id, number of records, then the records from the oldest */
+    for (cpu = 0; cpu < KTRACE_CPUS && result == 0; cpu ++)
+    {
+        ring = &_ktrace_ring[cpu];
+        count = _ktrace_ring_range(ring, &first);
+
+        value = cpu;
+        result |= _ktrace_write(fd, &value, sizeof(value));
+        result |= _ktrace_write(fd, &count, sizeof(count));
+
+        if (first + count > RT_KTRACE_RECORDS)
+        {
+            result |= _ktrace_write(fd, &ring->records[first],
+                                    (RT_KTRACE_RECORDS - first) * sizeof(struct ktrace_record));
+            result |= _ktrace_write(fd, &ring->records[0],
+                                    (first + count - RT_KTRACE_RECORDS) * sizeof(struct ktrace_record));
+        }
+        else
+        {
+            result |= _ktrace_write(fd, &ring->records[first], count * sizeof(struct ktrace_record));
+        }
+    }
+
+    /* the thread names: number of names, then pairs of thread and name */
+    names = _ktrace_snapshot_names(&nr);
+    value = nr;
+    result |= _ktrace_write(fd, &value, sizeof(value));
+    if (nr > 0)
+    {
+        result |= _ktrace_write(fd, names, nr * sizeof(struct ktrace_name));
+    }
+    rt_free(names);
+
+    close(fd);
+
+    if (result != 0)
+    {
+        LOG_E("write %s failed", path);
+    }
+
+    return result;
+}
+#endif /* RT_USING_DFS */
+
+#ifdef RT_USING_FINSH
+static void _ktrace_status(void)
+{
+    rt_uint32_t first, count;
+    int cpu;
+
+    rt_kprintf("ktrace: %s, %d records per cpu\n",
+               _ktrace_enabled ? "running" : "stopped", RT_KTRACE_RECORDS);
+    for (cpu = 0; cpu < KTRACE_CPUS; cpu ++)
+    {
+        count = _ktrace_ring_range(&_ktrace_ring[cpu], &first);
+        rt_kprintf("cpu%d: %u recorded, %u kept\n", cpu, _ktrace_ring[cpu].head, count);
+    }
+}
+
+static int ktrace(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        goto _usage;
+    }
+
+    if (rt_strcmp(argv[1], "start") == 0)
+    {
+        ktrace_start();
+    }
+    else if (rt_strcmp(argv[1], "stop") == 0)
+    {
+        ktrace_stop();
+    }
+    else if (rt_strcmp(argv[1], "clear") == 0)
+    {
+        ktrace_stop();
+        ktrace_clear();
+    }
+    else if (rt_strcmp(argv[1], "status") == 0)
+    {
+        _ktrace_status();
+    }
+    else if (rt_strcmp(argv[1], "dump") == 0)
+    {
+        ktrace_stop();
+
+        if (argc > 2)
+        {
+#ifdef RT_USING_DFS
+            return ktrace_dump_file(argv[2]);
+#else
+            rt_kprintf("dump to file needs RT_USING_DFS\n");
+            return -1;
+#endif /* RT_USING_DFS */
+        }
+        _ktrace_dump_console();
+    }
+    else
+    {
+        goto _usage;
+    }
+
+    return 0;
+
+_usage:
+    rt_kprintf("Usage: ktrace start|stop|clear|status|dump [file]\n");
+    return -1;
+}
+MSH_CMD_EXPORT(ktrace, scheduler and irq trace: start|stop|clear|status|dump [file]);
+#endif /* RT_USING_FINSH */
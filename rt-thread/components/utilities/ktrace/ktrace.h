@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) 2006-2026, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-17     agent        first version
+ */
+
+#ifndef __KTRACE_H__
+#define __KTRACE_H__
+
+#include <rtthread.h>
+
+#define KTRACE_MAGIC            0x4352544b      /* "KTRC" */
+#define KTRACE_VERSION          1
+
+/* trace events */
+enum ktrace_event
+{
+    KTRACE_EVENT_SWITCH = 1,                    /* arg0: from thread, arg1: to thread, prio: of to thread */
+    KTRACE_EVENT_IRQ_ENTER,                     /* arg0: irq nest */
+    KTRACE_EVENT_IRQ_LEAVE,                     /* arg0: irq nest */
+    KTRACE_EVENT_SUSPEND,                       /* arg0: thread */
+    KTRACE_EVENT_WAKEUP,                        /* arg0: thread, arg1: waker thread, prio: of thread */
+    KTRACE_EVENT_OBJ_TRYTAKE,                   /* arg0: object, arg1: object type */
+    KTRACE_EVENT_OBJ_TAKE,                      /* arg0: object, arg1: object type */
+    KTRACE_EVENT_OBJ_PUT,                       /* arg0: object, arg1: object type */
+};
+
+/* one trace record, written by its own cpu only */
+struct ktrace_record
+{
+    rt_uint64_t timestamp;                      /* cpu time or os tick */
+    rt_ubase_t  arg0;
+    rt_ubase_t  arg1;
+    rt_uint16_t event;
+    rt_uint8_t  cpu;
+    rt_uint8_t  prio;
+    rt_uint32_t seq;                            /* per cpu sequence number */
+};
+
+/* the header of a binary dump, followed by the records and the thread names */
+struct ktrace_dump_header
+{
+    rt_uint32_t magic;
+    rt_uint16_t version;
+    rt_uint16_t cpus;                           /* number of cpu sections */
+    rt_uint16_t record_size;
+    rt_uint16_t ptr_size;                       /* size of arg0/arg1 */
+    rt_uint16_t name_size;                      /* RT_NAME_MAX */
+    rt_uint16_t reserved;
+    rt_uint64_t resolution;                     /* nanoseconds per timestamp unit, x (1000 * 1000) */
+};
+
+void ktrace_start(void);
+void ktrace_stop(void);
+void ktrace_clear(void);
+rt_bool_t ktrace_is_enabled(void);
+void ktrace_record(rt_uint16_t event, rt_ubase_t arg0, rt_ubase_t arg1, rt_uint8_t prio);
+#ifdef RT_USING_DFS
+int ktrace_dump_file(const char *path);
+#endif /* RT_USING_DFS */
+
+#endif /* __KTRACE_H__ */
@@ -351,6 +351,10 @@ struct rt_object
 #endif /* RT_USING_SMART */
 
     rt_list_t   list;                                    /**< list node of kernel object */
+
+#ifdef RT_USING_OBJECT_HASH
+    struct rt_object *hash_next;                         /**< next object in the same name hash bucket */
+#endif /* RT_USING_OBJECT_HASH */
 };
 typedef struct rt_object *rt_object_t;                   /**< Type for kernel objects. */
 
@@ -397,13 +401,34 @@ enum rt_object_class_type
 /**
  * The information of the kernel object
  */
+#ifdef RT_USING_OBJECT_HASH
+#define RT_OBJECT_HASH_SIZE             (1 << RT_OBJECT_HASH_BITS)
+#endif /* RT_USING_OBJECT_HASH */
+
 struct rt_object_information
 {
     enum rt_object_class_type type;                     /**< object class type */
     rt_list_t                 object_list;              /**< object list */
     rt_size_t                 object_size;              /**< object size */
     struct rt_spinlock        spinlock;
+#ifdef RT_USING_OBJECT_HASH
+    rt_uint32_t               generation;               /**< changed on each insertion, removal or rename */
+    struct rt_object         *name_hash[RT_OBJECT_HASH_SIZE]; /**< objects indexed by name */
+#endif /* RT_USING_OBJECT_HASH */
+};
+
+#ifdef RT_USING_OBJECT_HASH
+/**
+ * The iterator to walk an object container in batches
+ */
+struct rt_object_iter
+{
+    struct rt_object_information *information;          /**< container being walked */
+    rt_list_t                    *node;                 /**< last object returned, RT_NULL before the first batch */
+    rt_uint32_t                   bucket;               /**< name hash bucket of the last object */
+    rt_uint32_t                   generation;           /**< container generation of the last batch */
 };
+#endif /* RT_USING_OBJECT_HASH */
 
 /**
  * The hook function call macro
@@ -603,6 +628,10 @@ struct rt_object_information
  */
 typedef void (*rt_timer_func_t)(void *parameter);
 
+#ifdef RT_TIMER_USING_WHEEL
+struct rt_timer_wheel;
+#endif /* RT_TIMER_USING_WHEEL */
+
 /**
  * timer structure
  */
@@ -611,6 +640,9 @@ struct rt_timer
     struct rt_object parent;                            /**< inherit from rt_object */
 
     rt_list_t        row[RT_TIMER_SKIP_LIST_LEVEL];
+#ifdef RT_TIMER_USING_WHEEL
+    struct rt_timer_wheel *wheel;                       /**< timing wheel the timer belongs to */
+#endif /* RT_TIMER_USING_WHEEL */
 
     rt_timer_func_t  timeout_func;                      /**< timeout function */
     void             *parameter;                        /**< timeout function's parameter */
@@ -741,6 +773,9 @@ struct rt_cpu
     #else
         rt_uint32_t             priority_group;
     #endif /* RT_THREAD_PRIORITY_MAX > 32 */
+    #ifdef RT_SCHED_USING_PCPU_QUEUE
+        rt_uint32_t             stealable_nr;   /**< unbound threads in ready queue */
+    #endif /* RT_SCHED_USING_PCPU_QUEUE */
 
         rt_atomic_t             tick;   /**< Passing tickes on this core */
     );
@@ -925,6 +960,7 @@ struct rt_thread
     int                         tid_ref_count;          /**< reference of tid */
     void                        *susp_recycler;         /**< suspended recycler on this thread */
     void                        *robust_list;           /**< pi lock, very carefully, it's a userspace list!*/
+    rt_uint32_t                 futex_bitset;           /**< bitset of the futex the thread is waiting on */
 
     rt_uint64_t                 user_time;
     rt_uint64_t                 system_time;
@@ -1021,6 +1057,9 @@ struct rt_mutex
     struct rt_thread    *owner;                         /**< current owner of mutex */
     rt_list_t            taken_list;                    /**< the object list taken by thread */
     struct rt_spinlock   spinlock;
+#ifdef RT_USING_MUTEX_FASTPATH
+    rt_atomic_t          state;                         /**< 0: unlocked, 1: locked, 2: locked with waiters */
+#endif /* RT_USING_MUTEX_FASTPATH */
 };
 typedef struct rt_mutex *rt_mutex_t;
 #endif /* RT_USING_MUTEX */
@@ -155,6 +155,15 @@ void rt_hw_interrupt_enable(rt_base_t level);
 #endif /*RT_USING_SMP*/
 rt_bool_t rt_hw_interrupt_is_disabled(void);
 
+#ifdef RT_USING_TICKLESS
+/**
+ * Stop the periodic tick of local cpu and wait for interrupt, with the tick
+ * timer programmed to fire `tick` ticks later. The local irq is masked by
+ * caller, and the ticks passed meanwhile are accounted by the tick ISR.
+ */
+void rt_hw_tick_nohz_idle(rt_tick_t tick);
+#endif /* RT_USING_TICKLESS */
+
 /*
  * Context interfaces
  */
@@ -59,6 +59,9 @@ struct rt_sched_thread_ctx
 #ifdef RT_USING_SMP
     rt_uint8_t                  bind_cpu;               /**< thread is bind to cpu */
     rt_uint8_t                  oncpu;                  /**< process on cpu */
+#ifdef RT_SCHED_USING_PCPU_QUEUE
+    rt_uint8_t                  queue_cpu;              /**< cpu whose ready queue holds thread */
+#endif /* RT_SCHED_USING_PCPU_QUEUE */
 
     rt_base_t                   critical_lock_nest;     /**< critical lock count */
 #endif
@@ -171,6 +174,11 @@ rt_err_t rt_sched_thread_timer_start(struct rt_thread *thread);
 void rt_sched_insert_thread(struct rt_thread *thread);
 void rt_sched_remove_thread(struct rt_thread *thread);
 
+#if defined(RT_USING_HOOK) && defined(RT_HOOK_USING_FUNC_PTR)
+/* called when a suspended thread is made ready, see rt_scheduler_wakeup_sethook() */
+extern void (*rt_scheduler_wakeup_hook)(struct rt_thread *thread);
+#endif /* defined(RT_USING_HOOK) && defined(RT_HOOK_USING_FUNC_PTR) */
+
 #endif /* defined(__RT_KERNEL_SOURCE__) || defined(__RT_IPC_SOURCE__) */
 
 #ifdef __cplusplus
@@ -77,6 +77,11 @@ rt_bool_t rt_object_is_systemobject(rt_object_t object);
 rt_uint8_t rt_object_get_type(rt_object_t object);
 rt_object_t rt_object_find(const char *name, rt_uint8_t type);
 rt_err_t rt_object_get_name(rt_object_t object, char *name, rt_uint8_t name_size);
+void rt_object_set_name(rt_object_t object, const char *name);
+#ifdef RT_USING_OBJECT_HASH
+rt_err_t rt_object_iter_init(struct rt_object_iter *iter, enum rt_object_class_type type);
+int rt_object_iter_next(struct rt_object_iter *iter, rt_object_t *pointers, int maxlen);
+#endif /* RT_USING_OBJECT_HASH */
 
 #ifdef RT_USING_HOOK
 void rt_object_attach_sethook(void (*hook)(struct rt_object *object));
@@ -99,6 +104,7 @@ void rt_object_put_sethook(void (*hook)(struct rt_object *object));
 rt_tick_t rt_tick_get(void);
 void rt_tick_set(rt_tick_t tick);
 void rt_tick_increase(void);
+void rt_tick_increase_tick(rt_tick_t tick);
 rt_tick_t  rt_tick_from_millisecond(rt_int32_t ms);
 rt_tick_t rt_tick_get_millisecond(void);
 #ifdef RT_USING_HOOK
@@ -234,6 +240,7 @@ rt_uint16_t rt_critical_level(void);
 #ifdef RT_USING_HOOK
 void rt_scheduler_sethook(void (*hook)(rt_thread_t from, rt_thread_t to));
 void rt_scheduler_switch_sethook(void (*hook)(struct rt_thread *tid));
+void rt_scheduler_wakeup_sethook(void (*hook)(struct rt_thread *thread));
 #endif /* RT_USING_HOOK */
 
 #ifdef RT_USING_SMP
@@ -371,6 +378,12 @@ void rt_slab_page_free(rt_slab_t m, void *addr, rt_size_t npages);
 void *rt_slab_alloc(rt_slab_t m, rt_size_t size);
 void *rt_slab_realloc(rt_slab_t m, void *ptr, rt_size_t size);
 void rt_slab_free(rt_slab_t m, void *ptr);
+#ifdef RT_SLAB_USING_MAGAZINE
+void *rt_slab_magazine_alloc(rt_slab_t m, rt_size_t size);
+rt_err_t rt_slab_magazine_free(rt_slab_t m, void *ptr);
+void *rt_slab_magazine_refill(rt_slab_t m, rt_size_t size);
+void rt_slab_magazine_drain(rt_slab_t m, void *ptr);
+#endif /* RT_SLAB_USING_MAGAZINE */
 #endif /* RT_USING_SLAB */
 
 /**@}*/
@@ -433,6 +446,7 @@ rt_mutex_t rt_mutex_create(const char *name, rt_uint8_t flag);
 rt_err_t rt_mutex_delete(rt_mutex_t mutex);
 #endif /* RT_USING_HEAP */
 void rt_mutex_drop_thread(rt_mutex_t mutex, rt_thread_t thread);
+void rt_mutex_set_owner(rt_mutex_t mutex, rt_thread_t owner);
 rt_uint8_t rt_mutex_setprioceiling(rt_mutex_t mutex, rt_uint8_t priority);
 rt_uint8_t rt_mutex_getprioceiling(rt_mutex_t mutex);
 
@@ -515,6 +529,14 @@ rt_err_t rt_mb_urgent(rt_mailbox_t mb, rt_ubase_t value);
 rt_err_t rt_mb_recv(rt_mailbox_t mb, rt_ubase_t *value, rt_int32_t timeout);
 rt_err_t rt_mb_recv_interruptible(rt_mailbox_t mb, rt_ubase_t *value, rt_int32_t timeout);
 rt_err_t rt_mb_recv_killable(rt_mailbox_t mb, rt_ubase_t *value, rt_int32_t timeout);
+rt_ssize_t rt_mb_send_batch(rt_mailbox_t mb,
+                            const rt_ubase_t *values,
+                            rt_size_t count,
+                            rt_int32_t timeout);
+rt_ssize_t rt_mb_recv_batch(rt_mailbox_t mb,
+                            rt_ubase_t *values,
+                            rt_size_t count,
+                            rt_int32_t timeout);
 rt_err_t rt_mb_control(rt_mailbox_t mb, int cmd, void *arg);
 #endif /* RT_USING_MAILBOX */
 
@@ -578,6 +600,17 @@ rt_ssize_t rt_mq_recv_killable(rt_mq_t    mq,
                     void      *buffer,
                     rt_size_t  size,
                     rt_int32_t timeout);
+rt_ssize_t rt_mq_send_batch(rt_mq_t mq,
+                            const void *buffer,
+                            rt_size_t size,
+                            rt_size_t count,
+                            rt_int32_t timeout);
+rt_ssize_t rt_mq_recv_batch(rt_mq_t mq,
+                            void *buffer,
+                            rt_size_t size,
+                            rt_size_t *lengths,
+                            rt_size_t count,
+                            rt_int32_t timeout);
 rt_err_t rt_mq_control(rt_mq_t mq, int cmd, void *arg);
 
 #ifdef RT_USING_MESSAGEQUEUE_PRIORITY
@@ -594,6 +627,14 @@ rt_ssize_t rt_mq_recv_prio(rt_mq_t mq,
                            rt_int32_t timeout,
                            int suspend_flag);
 #endif /* RT_USING_MESSAGEQUEUE_PRIORITY */
+
+#ifdef RT_USING_MESSAGEQUEUE_ZEROCOPY
+void *rt_mq_reserve(rt_mq_t mq, rt_int32_t timeout);
+rt_err_t rt_mq_commit(rt_mq_t mq, void *buffer, rt_size_t size);
+rt_err_t rt_mq_commit_urgent(rt_mq_t mq, void *buffer, rt_size_t size);
+rt_ssize_t rt_mq_borrow(rt_mq_t mq, void **buffer, rt_int32_t timeout);
+rt_err_t rt_mq_release(rt_mq_t mq, void *buffer);
+#endif /* RT_USING_MESSAGEQUEUE_ZEROCOPY */
 #endif /* RT_USING_MESSAGEQUEUE */
 
 /* defunct */
@@ -21,8 +21,10 @@
 #include <board.h>
 #include <cache.h>
 #include <mm_aspace.h>
+#include <mm_memcg.h>
 #include <mm_page.h>
 #include <mmu.h>
+#include <riscv_io.h>
 #include <riscv_mmu.h>
 #include <tlb.h>
 
@@ -36,21 +38,185 @@
 #define USER_VADDR_START 0
 #endif
 
-static size_t _unmap_area(struct rt_aspace *aspace, void *v_addr, size_t size);
+/* a huge leaf is split down to the last level with one table per level */
+#define SPLIT_TABLE_NR 2
+
+static size_t _unmap_one(struct rt_aspace *aspace, void *v_addr, size_t size,
+                         rt_size_t *tables[]);
+static void _free_tables(rt_size_t *tables[]);
+static inline uintptr_t _get_level_size(int level);
 
 static void *current_mmu_table = RT_NULL;
 
 volatile __attribute__((aligned(4 * 1024)))
 rt_ubase_t MMUTable[__SIZE(VPN2_BIT)];
 
+/**
+ * ASID of an aspace is (generation << SATP_ASID_BITS | index). Index 0 is
+ * reserved for the kernel space. Indexes are not freed in a generation; when
+ * they run out a new generation starts, and each hart flushes its TLB before
+ * it switches to an ASID of the new generation. The ASIDs running on the
+ * harts at the rollover are carried to the new generation.
+ */
+#define ASID_MAX_BITS           12
+#define ASID_FIRST_GENERATION   (1ul << SATP_ASID_BITS)
+#define ASID_IS_CURRENT(asid)   (!(((asid) ^ _asid_generation) >> SATP_ASID_BITS))
+#define ASID_MAP_WORD_BITS      (sizeof(rt_ubase_t) * 8)
+
+#ifdef RT_USING_SMP
+#define ASID_CPUS               RT_CPUS_NR
+#define ASID_CPU_ID()           rt_hw_cpu_id()
+#else
+#define ASID_CPUS               1
+#define ASID_CPU_ID()           0
+#endif /* RT_USING_SMP */
+
+static rt_uint32_t _asid_nr;
+static rt_uint32_t _asid_next = 1;
+static rt_uint64_t _asid_generation = ASID_FIRST_GENERATION;
+static rt_ubase_t _asid_map[(1ul << ASID_MAX_BITS) / ASID_MAP_WORD_BITS] = {1};
+static rt_uint64_t _asid_active[ASID_CPUS];
+static rt_uint64_t _asid_reserved[ASID_CPUS];
+static rt_ubase_t _asid_flush_pending;
+static struct rt_spinlock _asid_lock;
+
+static void _asid_init(void)
+{
+    rt_ubase_t satp_v = read_csr(satp);
+    rt_ubase_t asid_bits;
+    int bits = 0;
+
+    rt_spin_lock_init(&_asid_lock);
+
+    /* ASIDLEN is probed by writing ones to the field */
+    write_csr(satp, satp_v | (SATP_ASID_MASK << SATP_ASID_OFFSET));
+    asid_bits = (read_csr(satp) >> SATP_ASID_OFFSET) & SATP_ASID_MASK;
+    write_csr(satp, satp_v);
+    rt_hw_tlb_invalidate_all_local();
+
+    while (asid_bits & 0x1)
+    {
+        asid_bits >>= 1;
+        bits++;
+    }
+    if (bits > ASID_MAX_BITS)
+        bits = ASID_MAX_BITS;
+
+    _asid_nr = bits ? (1ul << bits) : 0;
+    LOG_D("%s: %d ASIDs", __func__, _asid_nr);
+}
+
+rt_inline rt_bool_t _asid_map_test_and_set(rt_uint32_t index)
+{
+    rt_ubase_t bit = 1ul << (index % ASID_MAP_WORD_BITS);
+    rt_ubase_t *word = &_asid_map[index / ASID_MAP_WORD_BITS];
+    rt_bool_t used = !!(*word & bit);
+
+    *word |= bit;
+    return used;
+}
+
+static void _asid_rollover(void)
+{
+    int cpu;
+
+    rt_memset(_asid_map, 0, sizeof(_asid_map));
+    _asid_map_test_and_set(0);
+
+    for (cpu = 0; cpu < ASID_CPUS; cpu++)
+    {
+        /* a cpu not switched since the last rollover keeps its reservation */
+        if (_asid_active[cpu])
+            _asid_reserved[cpu] = _asid_active[cpu];
+        _asid_active[cpu] = 0;
+
+        if (_asid_reserved[cpu])
+            _asid_map_test_and_set(_asid_reserved[cpu] & SATP_ASID_MASK);
+    }
+
+    _asid_generation += ASID_FIRST_GENERATION;
+    _asid_next = 1;
+    _asid_flush_pending = (1ul << ASID_CPUS) - 1;
+}
+
+static rt_uint64_t _asid_new(rt_aspace_t aspace)
+{
+    rt_uint64_t asid = aspace->asid;
+    rt_uint32_t index = asid & SATP_ASID_MASK;
+    rt_bool_t reserved = RT_FALSE;
+    int cpu;
+
+    if (index)
+    {
+        /* the ASID was running at the rollover, keep it in this generation */
+        for (cpu = 0; cpu < ASID_CPUS; cpu++)
+        {
+            if (_asid_reserved[cpu] == asid)
+            {
+                _asid_reserved[cpu] = _asid_generation | index;
+                reserved = RT_TRUE;
+            }
+        }
+        if (reserved || !_asid_map_test_and_set(index))
+            return _asid_generation | index;
+    }
+
+    while (1)
+    {
+        for (index = _asid_next; index < _asid_nr; index++)
+        {
+            if (!_asid_map_test_and_set(index))
+            {
+                _asid_next = index + 1;
+                return _asid_generation | index;
+            }
+        }
+        _asid_rollover();
+    }
+}
+
 void rt_hw_aspace_switch(rt_aspace_t aspace)
 {
     uintptr_t page_table = (uintptr_t)rt_kmem_v2p(aspace->page_table);
+    rt_uint64_t asid = 0;
+    rt_bool_t flush = RT_TRUE;
+    rt_base_t level;
+    int cpu;
+
     current_mmu_table = aspace->page_table;
 
+    if (!_asid_nr)
+    {
+        /* no ASID, all the address spaces share ASID 0 */
+        aspace->cpu_mask |= 1ul << __raw_hartid();
+    }
+    else if (aspace != &rt_kernel_space)
+    {
+        level = rt_spin_lock_irqsave(&_asid_lock);
+        cpu = ASID_CPU_ID();
+
+        if (!ASID_IS_CURRENT(aspace->asid))
+            aspace->asid = _asid_new(aspace);
+        asid = aspace->asid;
+
+        _asid_active[cpu] = asid;
+        flush = !!(_asid_flush_pending & (1ul << cpu));
+        _asid_flush_pending &= ~(1ul << cpu);
+        aspace->cpu_mask |= 1ul << __raw_hartid();
+
+        rt_spin_unlock_irqrestore(&_asid_lock, level);
+    }
+    else
+    {
+        /* the kernel mappings are global, keep the TLB of the other ASIDs */
+        flush = RT_FALSE;
+    }
+
     write_csr(satp, (((size_t)SATP_MODE) << SATP_MODE_OFFSET) |
+                        ((asid & SATP_ASID_MASK) << SATP_ASID_OFFSET) |
                         ((rt_ubase_t)page_table >> PAGE_OFFSET_BIT));
-    rt_hw_tlb_invalidate_all_local();
+    if (flush)
+        rt_hw_tlb_invalidate_all_local();
 }
 
 void *rt_hw_mmu_tbl_get()
@@ -58,11 +224,16 @@ void *rt_hw_mmu_tbl_get()
     return current_mmu_table;
 }
 
+/**
+ * Map a leaf at level 1 (1 GiB), 2 (2 MiB) or 3 (4 KiB). A huge leaf is
+ * only installed on an unused entry, otherwise -RT_EBUSY is returned.
+ */
 static int _map_one_page(struct rt_aspace *aspace, void *va, void *pa,
-                         size_t attr)
+                         size_t attr, int level)
 {
     rt_size_t l1_off, l2_off, l3_off;
     rt_size_t *mmu_l1, *mmu_l2, *mmu_l3;
+    rt_size_t next_attr;
 
     l1_off = GET_L1((size_t)va);
     l2_off = GET_L2((size_t)va);
@@ -70,8 +241,22 @@ static int _map_one_page(struct rt_aspace *aspace, void *va, void *pa,
 
     mmu_l1 = ((rt_size_t *)aspace->page_table) + l1_off;
 
+    /* a global next level entry makes all the entries under it global */
+    next_attr = (PAGE_DEFAULT_ATTR_NEXT & ~PTE_G) | (attr & PTE_G);
+
+    if (level == 1)
+    {
+        if (PTE_USED(*mmu_l1))
+            return -RT_EBUSY;
+
+        *mmu_l1 = COMBINEPTE((rt_size_t)pa, attr);
+        rt_hw_cpu_dcache_clean(mmu_l1, sizeof(*mmu_l1));
+        return 0;
+    }
+
     if (PTE_USED(*mmu_l1))
     {
+        RT_ASSERT(!PAGE_IS_LEAF(*mmu_l1));
         mmu_l2 = (rt_size_t *)PPN_TO_VPN(GET_PADDR(*mmu_l1), PV_OFFSET);
     }
     else
@@ -83,8 +268,9 @@ static int _map_one_page(struct rt_aspace *aspace, void *va, void *pa,
             rt_memset(mmu_l2, 0, PAGE_SIZE);
             rt_hw_cpu_dcache_clean(mmu_l2, PAGE_SIZE);
             *mmu_l1 = COMBINEPTE((rt_size_t)VPN_TO_PPN(mmu_l2, PV_OFFSET),
-                                 PAGE_DEFAULT_ATTR_NEXT);
+                                 next_attr);
             rt_hw_cpu_dcache_clean(mmu_l1, sizeof(*mmu_l1));
+            rt_memcg_charge(aspace->memcg, RT_MEMCG_KERNEL, 1);
         }
         else
         {
@@ -92,6 +278,18 @@ static int _map_one_page(struct rt_aspace *aspace, void *va, void *pa,
         }
     }
 
+    if (level == 2)
+    {
+        if (PTE_USED(*(mmu_l2 + l2_off)))
+            return -RT_EBUSY;
+
+        // declares a reference to parent page table
+        rt_page_ref_inc((void *)mmu_l2, 0);
+        *(mmu_l2 + l2_off) = COMBINEPTE((rt_size_t)pa, attr);
+        rt_hw_cpu_dcache_clean(mmu_l2 + l2_off, sizeof(*(mmu_l2 + l2_off)));
+        return 0;
+    }
+
     if (PTE_USED(*(mmu_l2 + l2_off)))
     {
         RT_ASSERT(!PAGE_IS_LEAF(*(mmu_l2 + l2_off)));
@@ -108,10 +306,11 @@ static int _map_one_page(struct rt_aspace *aspace, void *va, void *pa,
             rt_hw_cpu_dcache_clean(mmu_l3, PAGE_SIZE);
             *(mmu_l2 + l2_off) =
                 COMBINEPTE((rt_size_t)VPN_TO_PPN(mmu_l3, PV_OFFSET),
-                           PAGE_DEFAULT_ATTR_NEXT);
+                           next_attr);
             rt_hw_cpu_dcache_clean(mmu_l2, sizeof(*mmu_l2));
             // declares a reference to parent page table
             rt_page_ref_inc((void *)mmu_l2, 0);
+            rt_memcg_charge(aspace->memcg, RT_MEMCG_KERNEL, 1);
         }
         else
         {
@@ -127,34 +326,58 @@ static int _map_one_page(struct rt_aspace *aspace, void *va, void *pa,
     return 0;
 }
 
-/** rt_hw_mmu_map will never override existed page table entry */
+/* the largest leaf level allowed by the alignment and the size */
+static int _map_level(void *v_addr, void *p_addr, size_t size)
+{
+    rt_size_t align = (rt_size_t)v_addr | (rt_size_t)p_addr;
+
+    if (!(align & (L1_PAGE_SIZE - 1)) && size >= L1_PAGE_SIZE)
+        return 1;
+    if (!(align & (L2_PAGE_SIZE - 1)) && size >= L2_PAGE_SIZE)
+        return 2;
+    return 3;
+}
+
+/**
+ * rt_hw_mmu_map will never override existed page table entry. Huge leaves
+ * are used where the alignment of both addresses and the size allow.
+ */
 void *rt_hw_mmu_map(struct rt_aspace *aspace, void *v_addr, void *p_addr,
                     size_t size, size_t attr)
 {
     int ret = -1;
+    int level;
     void *unmap_va = v_addr;
-    size_t npages = size >> ARCH_PAGE_SHIFT;
 
-    // TODO trying with HUGEPAGE here
-    while (npages--)
+    size &= ~ARCH_PAGE_MASK;
+    while (size)
     {
+        level = _map_level(v_addr, p_addr, size);
+
         MM_PGTBL_LOCK(aspace);
-        ret = _map_one_page(aspace, v_addr, p_addr, attr);
+        while ((ret = _map_one_page(aspace, v_addr, p_addr, attr, level)) == -RT_EBUSY)
+            level++;
         MM_PGTBL_UNLOCK(aspace);
         if (ret != 0)
         {
+            rt_size_t *tables[SPLIT_TABLE_NR] = {0};
+
             /* error, undo map */
-            while (unmap_va != v_addr)
+            while (unmap_va < v_addr)
             {
-                MM_PGTBL_LOCK(aspace);
-                _unmap_area(aspace, unmap_va, ARCH_PAGE_SIZE);
-                MM_PGTBL_UNLOCK(aspace);
-                unmap_va += ARCH_PAGE_SIZE;
+                size_t unmapped;
+
+                unmapped = _unmap_one(aspace, unmap_va, v_addr - unmap_va, tables);
+
+                /* a huge leaf failed to split is left mapped, go on with the rest */
+                unmap_va += unmapped ? unmapped : ARCH_PAGE_SIZE;
             }
+            _free_tables(tables);
             break;
         }
-        v_addr += ARCH_PAGE_SIZE;
-        p_addr += ARCH_PAGE_SIZE;
+        v_addr += _get_level_size(level);
+        p_addr += _get_level_size(level);
+        size -= _get_level_size(level);
     }
 
     if (ret == 0)
@@ -165,7 +388,8 @@ void *rt_hw_mmu_map(struct rt_aspace *aspace, void *v_addr, void *p_addr,
     return NULL;
 }
 
-static void _unmap_pte(rt_size_t *pentry, rt_size_t *lvl_entry[], int level)
+static void _unmap_pte(struct rt_aspace *aspace, rt_size_t *pentry,
+                       rt_size_t *lvl_entry[], int level)
 {
     int loop_flag = 1;
     while (loop_flag)
@@ -186,6 +410,7 @@ static void _unmap_pte(rt_size_t *pentry, rt_size_t *lvl_entry[], int level)
             if (free == 1)
             {
                 rt_pages_free(page, 0);
+                rt_memcg_uncharge(aspace->memcg, RT_MEMCG_KERNEL, 1);
                 pentry = lvl_entry[--level];
                 loop_flag = 1;
             }
@@ -193,7 +418,43 @@ static void _unmap_pte(rt_size_t *pentry, rt_size_t *lvl_entry[], int level)
     }
 }
 
-static size_t _unmap_area(struct rt_aspace *aspace, void *v_addr, size_t size)
+/**
+ * replace a huge leaf by a next level table with the same mappings. The table
+ * is taken from *ptable since nothing can be allocated under the pgtbl lock.
+ */
+static int _split_leaf(struct rt_aspace *aspace, rt_size_t *pentry,
+                       rt_size_t leaf_size, rt_size_t **ptable)
+{
+    rt_size_t *table = *ptable;
+    rt_size_t pa = GET_PADDR(*pentry);
+    rt_size_t attr = *pentry - COMBINEPTE(pa, 0);
+    rt_size_t stride = leaf_size >> ARCH_INDEX_WIDTH;
+    int i;
+
+    if (!table)
+    {
+        return -1;
+    }
+    *ptable = RT_NULL;
+    rt_memcg_charge(aspace->memcg, RT_MEMCG_KERNEL, 1);
+
+    for (i = 0; i < ARCH_INDEX_SIZE; i++)
+    {
+        table[i] = COMBINEPTE(pa + i * stride, attr);
+        // declares a reference to parent page table
+        rt_page_ref_inc((void *)table, 0);
+    }
+    rt_hw_cpu_dcache_clean(table, ARCH_PAGE_SIZE);
+
+    *pentry = COMBINEPTE((rt_size_t)VPN_TO_PPN(table, PV_OFFSET),
+                         (PAGE_DEFAULT_ATTR_NEXT & ~PTE_G) | (attr & PTE_G));
+    rt_hw_cpu_dcache_clean(pentry, sizeof(*pentry));
+    return 0;
+}
+
+/* return 0 if a huge leaf is to be split but no table is prepared for it */
+static size_t _unmap_area(struct rt_aspace *aspace, void *v_addr, size_t size,
+                          rt_size_t *tables[])
 {
     rt_size_t loop_va = __UMASKVALUE((rt_size_t)v_addr, PAGE_OFFSET_MASK);
     size_t unmapped = 0;
@@ -220,18 +481,89 @@ static size_t _unmap_area(struct rt_aspace *aspace, void *v_addr, size_t size)
         unmapped >>= ARCH_INDEX_WIDTH;
     }
 
+    // split the huge leaf which is partially unmapped
+    while (PTE_USED(*pentry) && i < 2 &&
+           ((loop_va & (unmapped - 1)) || size < unmapped))
+    {
+        if (_split_leaf(aspace, pentry, unmapped, &tables[i]) != 0)
+        {
+            return 0;
+        }
+
+        i += 1;
+        lvl_entry[i] = ((rt_size_t *)PPN_TO_VPN(GET_PADDR(*pentry), PV_OFFSET) +
+                        lvl_off[i]);
+        pentry = lvl_entry[i];
+        unmapped >>= ARCH_INDEX_WIDTH;
+    }
+
     // clear PTE & setup its
     if (PTE_USED(*pentry))
     {
-        _unmap_pte(pentry, lvl_entry, i);
+        _unmap_pte(aspace, pentry, lvl_entry, i);
+    }
+
+    return unmapped;
+}
+
+static void _free_tables(rt_size_t *tables[])
+{
+    int i;
+
+    for (i = 0; i < SPLIT_TABLE_NR; i++)
+    {
+        if (tables[i])
+        {
+            rt_pages_free(tables[i], 0);
+            tables[i] = RT_NULL;
+        }
+    }
+}
+
+/**
+ * unmap the leaf at v_addr. If a partially unmapped huge leaf is to be split,
+ * the tables are allocated out of the pgtbl lock and the walk is retried.
+ * Return 0 and leave the leaf mapped if they can not be allocated.
+ */
+static size_t _unmap_one(struct rt_aspace *aspace, void *v_addr, size_t size,
+                         rt_size_t *tables[])
+{
+    size_t unmapped;
+    int i;
+
+    MM_PGTBL_LOCK(aspace);
+    unmapped = _unmap_area(aspace, v_addr, size, tables);
+    MM_PGTBL_UNLOCK(aspace);
+
+    if (!unmapped)
+    {
+        for (i = 0; i < SPLIT_TABLE_NR; i++)
+        {
+            if (!tables[i] && !(tables[i] = (rt_size_t *)rt_pages_alloc(0)))
+            {
+                LOG_W("%s: failed to split huge page at %p", __func__, v_addr);
+                return 0;
+            }
+        }
+
+        /* a table for each level, the split can not fail this time */
+        MM_PGTBL_LOCK(aspace);
+        unmapped = _unmap_area(aspace, v_addr, size, tables);
+        MM_PGTBL_UNLOCK(aspace);
     }
 
     return unmapped;
 }
 
-/** unmap is different from map that it can handle multiple pages */
+/**
+ * unmap is different from map that it can handle multiple pages. A huge leaf
+ * which can not be split for lack of memory is left mapped, so the caller
+ * must check with rt_hw_mmu_v2p() before it frees the frames.
+ */
 void rt_hw_mmu_unmap(struct rt_aspace *aspace, void *v_addr, size_t size)
 {
+    rt_size_t *tables[SPLIT_TABLE_NR] = {0};
+
     // caller guarantee that v_addr & size are page aligned
     if (!aspace->page_table)
     {
@@ -241,17 +573,17 @@ void rt_hw_mmu_unmap(struct rt_aspace *aspace, void *v_addr, size_t size)
 
     while (size > 0)
     {
-        MM_PGTBL_LOCK(aspace);
-        unmapped = _unmap_area(aspace, v_addr, size);
-        MM_PGTBL_UNLOCK(aspace);
+        unmapped = _unmap_one(aspace, v_addr, size, tables);
 
-        // when unmapped == 0, region not exist in pgtbl
+        // when unmapped == 0, the huge leaf is not split
         if (!unmapped || unmapped > size)
             break;
 
         size -= unmapped;
         v_addr += unmapped;
     }
+
+    _free_tables(tables);
 }
 
 #ifdef RT_USING_SMART
@@ -489,6 +821,7 @@ void rt_hw_mmu_setup(rt_aspace_t aspace, struct mem_desc *mdesc, int desc_nr)
     }
 
     rt_hw_aspace_switch(&rt_kernel_space);
+    _asid_init();
     rt_page_cleanup();
 }
 
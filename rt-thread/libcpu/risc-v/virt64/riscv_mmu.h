@@ -72,6 +72,10 @@
 #define ARCH_VADDR_WIDTH        39
 #define SATP_MODE               SATP_MODE_SV39
 
+#define SATP_ASID_OFFSET        44
+#define SATP_ASID_BITS          16
+#define SATP_ASID_MASK          ((1ul << SATP_ASID_BITS) - 1)
+
 #define MMU_MAP_K_DEVICE        (PTE_G | PTE_W | PTE_R | PTE_V)
 #define MMU_MAP_K_RWCB          (PTE_G | PTE_X | PTE_W | PTE_R | PTE_V)
 #define MMU_MAP_K_RW            (PTE_G | PTE_X | PTE_W | PTE_R | PTE_V)
@@ -84,6 +88,7 @@
 #define ARCH_PAGE_SIZE          PAGE_SIZE
 #define ARCH_PAGE_MASK          (ARCH_PAGE_SIZE - 1)
 #define ARCH_PAGE_SHIFT         PAGE_OFFSET_BIT
+#define ARCH_HUGE_PAGE_SHIFT    (PAGE_OFFSET_BIT + VPN0_BIT)
 #define ARCH_INDEX_WIDTH        9
 #define ARCH_INDEX_SIZE         (1ul << ARCH_INDEX_WIDTH)
 #define ARCH_INDEX_MASK         (ARCH_INDEX_SIZE - 1)
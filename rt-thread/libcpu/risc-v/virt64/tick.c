@@ -20,6 +20,18 @@
 
 static volatile uint64_t time_elapsed = 0;
 static volatile unsigned long tick_cycles = 0;
+#ifdef RT_USING_TICKLESS
+#ifdef RT_USING_SMP
+#define TICK_CPUS               RT_CPUS_NR
+#define TICK_CPU_ID()           rt_hw_cpu_id()
+#else
+#define TICK_CPUS               1
+#define TICK_CPU_ID()           0
+#endif /* RT_USING_SMP */
+
+/* timer count of the last tick accounted, each hart has its own timer */
+static uint64_t tick_last[TICK_CPUS];
+#endif
 
 static uint64_t get_ticks()
 {
@@ -31,14 +43,45 @@ static uint64_t get_ticks()
 
 int tick_isr(void)
 {
+#ifdef RT_USING_TICKLESS
+    rt_tick_t tick;
+    uint64_t *last = &tick_last[TICK_CPU_ID()];
+
+    /* more than one tick is passed if the tick was stopped on idle */
+    tick = (get_ticks() - *last) / tick_cycles;
+    *last += (uint64_t)tick * tick_cycles;
+
+    rt_tick_increase_tick(tick);
+    sbi_set_timer(*last + tick_cycles);
+#else
     // uint64_t core_id = current_coreid();
     // clint->mtimecmp[core_id] += tick_cycles;
     rt_tick_increase();
     sbi_set_timer(get_ticks() + tick_cycles);
+#endif
 
     return 0;
 }
 
+#ifdef RT_USING_TICKLESS
+void rt_hw_tick_nohz_idle(rt_tick_t tick)
+{
+    uint64_t last = tick_last[TICK_CPU_ID()];
+
+    /* fire on the tick boundary of the next timeout */
+    sbi_set_timer(last + (uint64_t)tick * tick_cycles);
+
+    /* wakeup on pending interrupt even though SIE is cleared */
+    __asm__ __volatile__("wfi");
+
+    /**
+     * Restart the periodic tick on the next tick boundary, which fires at once
+     * if it's passed already. The ticks lost are accounted by tick_isr.
+     */
+    sbi_set_timer(last + tick_cycles);
+}
+#endif
+
 /* Sets and enable the timer interrupt */
 int rt_hw_tick_init(void)
 {
@@ -51,7 +94,12 @@ int rt_hw_tick_init(void)
     /* calculate the tick cycles */
     tick_cycles = CPUTIME_TIMER_FREQ / RT_TICK_PER_SECOND;
     /* Set timer */
+#ifdef RT_USING_TICKLESS
+    tick_last[TICK_CPU_ID()] = get_ticks();
+    sbi_set_timer(tick_last[TICK_CPU_ID()] + tick_cycles);
+#else
     sbi_set_timer(get_ticks() + tick_cycles);
+#endif
 
 #ifdef RT_USING_KTIME
     rt_ktime_cputimer_init();
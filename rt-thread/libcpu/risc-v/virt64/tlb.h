@@ -16,6 +16,7 @@
 #include <rtthread.h>
 #include <mm_aspace.h>
 #include "sbi.h"
+#include "riscv_io.h"
 #include "riscv_mmu.h"
 
 #define HANDLE_FAULT(ret)                                                      \
@@ -33,17 +34,50 @@ static inline void rt_hw_tlb_invalidate_all_local(void)
     __asm__ volatile("sfence.vma" ::: "memory");
 }
 
+/**
+ * Flush the TLB entries of a user aspace on the harts which have run it.
+ * It's done locally when no other hart has run the aspace.
+ */
+static inline void _tlb_invalidate_asid(rt_aspace_t aspace, unsigned long start,
+                                        unsigned long size)
+{
+    unsigned long asid = aspace->asid & SATP_ASID_MASK;
+    unsigned long self = 1ul << __raw_hartid();
+    unsigned long mask = aspace->cpu_mask;
+
+    if (mask & ~self)
+    {
+        sbi_remote_sfence_vma_asid(&mask, start, size, asid);
+    }
+    else if (mask)
+    {
+        if (size == -1ul)
+            __asm__ volatile("sfence.vma zero, %0" ::"r"(asid) : "memory");
+        else
+            for (; size; start += ARCH_PAGE_SIZE, size -= ARCH_PAGE_SIZE)
+                __asm__ volatile("sfence.vma %0, %1" ::"r"(start), "r"(asid) : "memory");
+    }
+}
+
 static inline void rt_hw_tlb_invalidate_aspace(rt_aspace_t aspace)
 {
-    // TODO ASID
-    rt_hw_tlb_invalidate_all_local();
+    if (aspace == &rt_kernel_space)
+        rt_hw_tlb_invalidate_all_local();
+    else
+        _tlb_invalidate_asid(aspace, 0, -1ul);
 }
 
 static inline void rt_hw_tlb_invalidate_page(rt_aspace_t aspace, void *start)
 {
-    __asm__ volatile("sfence.vma %0, zero" ::"r"(start) : "memory");
+    if (aspace == &rt_kernel_space)
+        __asm__ volatile("sfence.vma %0, zero" ::"r"(start) : "memory");
+    else
+        _tlb_invalidate_asid(aspace, (unsigned long)start, ARCH_PAGE_SIZE);
 }
 
+/* a range of more pages than this is cheaper to invalidate as a whole */
+#define TLB_RANGE_FLUSH_MAX_PAGES 32
+
 static inline void rt_hw_tlb_invalidate_range(rt_aspace_t aspace, void *start,
                                               size_t size, size_t stride)
 {
@@ -52,6 +86,21 @@ static inline void rt_hw_tlb_invalidate_range(rt_aspace_t aspace, void *start,
     {
         rt_hw_tlb_invalidate_page(aspace, start);
     }
+    else if (size <= TLB_RANGE_FLUSH_MAX_PAGES * ARCH_PAGE_SIZE)
+    {
+        uintptr_t va = (uintptr_t)start & ~(ARCH_PAGE_SIZE - 1);
+        size = RT_ALIGN((uintptr_t)start + size, ARCH_PAGE_SIZE) - va;
+
+        if (aspace == &rt_kernel_space)
+        {
+            for (; size; va += ARCH_PAGE_SIZE, size -= ARCH_PAGE_SIZE)
+                __asm__ volatile("sfence.vma %0, zero" ::"r"(va) : "memory");
+        }
+        else
+        {
+            _tlb_invalidate_asid(aspace, va, size);
+        }
+    }
     else
     {
         rt_hw_tlb_invalidate_aspace(aspace);
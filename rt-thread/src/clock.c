@@ -99,8 +99,46 @@ void rt_tick_increase(void)
     /* check time slice */
     rt_sched_tick_increase();
 
-    /* check timer */
+    /* check timer, each cpu checks its own timing wheel */
+#if defined(RT_USING_SMP) && !defined(RT_TIMER_USING_WHEEL)
+    if (rt_hw_cpu_id() != 0)
+    {
+        return;
+    }
+#endif
+    rt_timer_check();
+}
+
+/**
+ * @brief    This function will notify kernel there are some ticks passed at once,
+ *           e.g. when the periodic tick was stopped on a tickless idle cpu.
+ *           Normally, this function is invoked by clock ISR.
+ *
+ * @param    tick is the number of ticks passed.
+ */
+void rt_tick_increase_tick(rt_tick_t tick)
+{
+    RT_ASSERT(rt_interrupt_get_nest() > 0);
+
+    if (tick == 0)
+    {
+        return;
+    }
+
+    RT_OBJECT_HOOK_CALL(rt_tick_hook, ());
+    /* increase the global tick */
 #ifdef RT_USING_SMP
+    /* get percpu and increase the tick */
+    rt_atomic_add(&(rt_cpu_self()->tick), tick);
+#else
+    rt_atomic_add(&(rt_tick), tick);
+#endif /* RT_USING_SMP */
+
+    /* check time slice, only idle thread is running during the ticks skipped */
+    rt_sched_tick_increase();
+
+    /* check timer, each cpu checks its own timing wheel */
+#if defined(RT_USING_SMP) && !defined(RT_TIMER_USING_WHEEL)
     if (rt_hw_cpu_id() != 0)
     {
         return;
@@ -257,6 +257,82 @@ static void rt_defunct_execute(void)
     }
 }
 
+#ifdef RT_USING_TICKLESS
+#ifndef RT_TICKLESS_THRESHOLD
+#define RT_TICKLESS_THRESHOLD   2
+#endif /* RT_TICKLESS_THRESHOLD */
+
+#ifdef RT_USING_SMP
+/* cpus with the periodic tick stopped */
+static rt_atomic_t _nohz_cpus;
+#endif /* RT_USING_SMP */
+
+/**
+ * @brief Stop the periodic tick till the next timer timeout, if it's far
+ *        enough away.
+ *
+ * @return RT_TRUE if cpu was waiting for interrupt with the tick stopped.
+ */
+static rt_bool_t _idle_tickless(void)
+{
+    rt_base_t level;
+    rt_tick_t next_timeout;
+    rt_tick_t timeout;
+    rt_bool_t stopped = RT_FALSE;
+
+    level = rt_hw_local_irq_disable();
+
+    next_timeout = rt_timer_next_timeout_tick();
+    if (next_timeout == RT_TICK_MAX)
+    {
+        /* no timer at all, wake up once in a while anyway */
+        timeout = RT_TICK_MAX / 2 - 1;
+    }
+    else
+    {
+        timeout = next_timeout - rt_tick_get();
+        if (timeout >= RT_TICK_MAX / 2)
+        {
+            /* timeout already */
+            timeout = 0;
+        }
+    }
+
+    if (timeout >= RT_TICKLESS_THRESHOLD)
+    {
+#ifdef RT_USING_SMP
+        int cpu_id = rt_hw_cpu_id();
+
+        /**
+         * The global tick is counted by cpu 0, so it's stopped only if all
+         * the other cpus stopped their ticks too. Flag is set before checking
+         * others, which pairs with the wakeup of cpu 0 below.
+         */
+        rt_atomic_or(&_nohz_cpus, 1UL << cpu_id);
+        if (cpu_id != 0 || rt_atomic_load(&_nohz_cpus) == RT_CPU_MASK)
+        {
+            rt_hw_tick_nohz_idle(timeout);
+            stopped = RT_TRUE;
+        }
+        rt_atomic_and(&_nohz_cpus, ~(1UL << cpu_id));
+
+        /* restart the global tick before running anything */
+        if (cpu_id != 0 && (rt_atomic_load(&_nohz_cpus) & 1))
+        {
+            rt_hw_ipi_send(RT_SCHEDULE_IPI, 1);
+        }
+#else
+        rt_hw_tick_nohz_idle(timeout);
+        stopped = RT_TRUE;
+#endif /* RT_USING_SMP */
+    }
+
+    rt_hw_local_irq_enable(level);
+
+    return stopped;
+}
+#endif /* RT_USING_TICKLESS */
+
 static void idle_thread_entry(void *parameter)
 {
     RT_UNUSED(parameter);
@@ -265,6 +341,12 @@ static void idle_thread_entry(void *parameter)
     {
         while (1)
         {
+#ifdef RT_USING_TICKLESS
+            if (_idle_tickless())
+            {
+                continue;
+            }
+#endif /* RT_USING_TICKLESS */
             rt_hw_secondary_cpu_idle_exec();
         }
     }
@@ -294,6 +376,10 @@ static void idle_thread_entry(void *parameter)
         void rt_system_power_manager(void);
         rt_system_power_manager();
 #endif /* RT_USING_PM */
+
+#ifdef RT_USING_TICKLESS
+        _idle_tickless();
+#endif /* RT_USING_TICKLESS */
     }
 }
 
@@ -228,6 +228,34 @@ rt_err_t rt_susp_list_resume_all_irq(rt_list_t *susp_list,
     return RT_EOK;
 }
 
+/**
+ * @brief   Resume at most n threads from the suspend list with RT_EOK, used
+ *          by the batched IPC operations which make n items available at once.
+ *
+ * @note    The caller holds the IPC object lock and calls rt_schedule() once
+ *          after releasing it if this function returns RT_TRUE.
+ *
+ * @param   susp_list the list threads dequeued from.
+ * @param   n the maximum number of threads to be resumed.
+ *
+ * @return  RT_TRUE if any thread is resumed.
+ */
+rt_inline rt_bool_t _ipc_list_resume_n(rt_list_t *susp_list, rt_size_t n)
+{
+    rt_bool_t resumed = RT_FALSE;
+
+    while (n > 0 && !rt_list_isempty(susp_list))
+    {
+        if (rt_susp_list_dequeue(susp_list, RT_EOK) == RT_NULL)
+            break;
+
+        resumed = RT_TRUE;
+        n --;
+    }
+
+    return resumed;
+}
+
 /**
  * @brief   Add a thread to the suspend list
  *
@@ -973,6 +1001,130 @@ static void _mutex_before_delete_detach(rt_mutex_t mutex)
     rt_spin_unlock(&(mutex->spinlock));
 }
 
+#ifdef RT_USING_MUTEX_FASTPATH
+#define MUTEX_UNLOCKED      0
+#define MUTEX_LOCKED        1
+#define MUTEX_CONTENDED     2
+
+/**
+ * Take the mutex state from unlocked to locked. The owner is published under
+ * the mutex spinlock, so whoever holds that lock never sees a locked mutex
+ * without its owner.
+ */
+static rt_bool_t _mutex_fast_take(rt_mutex_t mutex, struct rt_thread *thread)
+{
+    rt_atomic_t expected = MUTEX_UNLOCKED;
+    rt_bool_t taken = RT_FALSE;
+
+    /* priority ceiling is handled in the slow path */
+    if (mutex->ceiling_priority != 0xFF ||
+        rt_atomic_load(&mutex->state) != MUTEX_UNLOCKED)
+        return RT_FALSE;
+
+    rt_spin_lock(&(mutex->spinlock));
+    if (rt_atomic_compare_exchange_strong(&mutex->state, &expected, MUTEX_LOCKED))
+    {
+        mutex->owner = thread;
+        mutex->hold  = 1;
+        rt_list_insert_after(&thread->taken_object_list, &mutex->taken_list);
+        taken = RT_TRUE;
+    }
+    rt_spin_unlock(&(mutex->spinlock));
+
+    return taken;
+}
+
+/**
+ * Release a mutex which nobody has waited on since it was taken. The owner
+ * priority is never boosted in that case, so there is nothing to restore and
+ * the scheduler lock is not needed.
+ */
+static rt_bool_t _mutex_fast_release(rt_mutex_t mutex, struct rt_thread *thread)
+{
+    rt_atomic_t expected = MUTEX_LOCKED;
+    rt_bool_t released = RT_FALSE;
+
+    rt_spin_lock(&(mutex->spinlock));
+    if (mutex->owner == thread && mutex->hold == 1 &&
+        mutex->ceiling_priority == 0xFF && mutex->priority == 0xFF &&
+        rt_atomic_compare_exchange_strong(&mutex->state, &expected, MUTEX_UNLOCKED))
+    {
+        rt_list_remove(&mutex->taken_list);
+        mutex->hold  = 0;
+        mutex->owner = RT_NULL;
+        released = RT_TRUE;
+    }
+    rt_spin_unlock(&(mutex->spinlock));
+
+    return released;
+}
+
+/* take an unlocked mutex in the slow path, mutex->spinlock must be held */
+rt_inline rt_bool_t _mutex_try_acquire(rt_mutex_t mutex)
+{
+    rt_atomic_t expected = MUTEX_UNLOCKED;
+
+    return rt_atomic_compare_exchange_strong(&mutex->state, &expected, MUTEX_LOCKED) ? RT_TRUE : RT_FALSE;
+}
+
+/**
+ * Mark the mutex as contended so that the owner releases it in the slow path.
+ * Return RT_TRUE if the mutex was released meanwhile and is taken by caller.
+ */
+rt_inline rt_bool_t _mutex_mark_contended(rt_mutex_t mutex)
+{
+    return rt_atomic_exchange(&mutex->state, MUTEX_CONTENDED) == MUTEX_UNLOCKED;
+}
+
+#define _mutex_set_state(mutex, value)  rt_atomic_store(&(mutex)->state, (value))
+
+#if defined(RT_USING_SMP) && RT_MUTEX_SPIN_COUNT > 0
+/**
+ * Spin while the owner is running on another cpu, as it is likely to release
+ * the mutex soon. Stop once a waiter is queued since the mutex will be handed
+ * over to it directly.
+ */
+static rt_bool_t _mutex_spin_on_owner(rt_mutex_t mutex, struct rt_thread *thread)
+{
+    int spin;
+    struct rt_thread *owner;
+
+    for (spin = 0; spin < RT_MUTEX_SPIN_COUNT; spin++)
+    {
+        switch (rt_atomic_load(&mutex->state))
+        {
+        case MUTEX_UNLOCKED:
+            if (_mutex_fast_take(mutex, thread))
+                return RT_TRUE;
+            break;
+        case MUTEX_LOCKED:
+            /**
+             * the owner releases its taken mutexes before it exits, so it is
+             * still alive while it is read back as the owner
+             */
+            owner = ((volatile struct rt_mutex *)mutex)->owner;
+            if (owner == thread ||
+                (owner && RT_SCHED_CTX(owner).oncpu == RT_CPU_DETACHED))
+                return RT_FALSE;
+            break;
+        default:
+            return RT_FALSE;
+        }
+        rt_hw_dmb();
+    }
+
+    return RT_FALSE;
+}
+#else
+#define _mutex_spin_on_owner(mutex, thread) RT_FALSE
+#endif /* defined(RT_USING_SMP) && RT_MUTEX_SPIN_COUNT > 0 */
+
+#else
+#define _mutex_try_acquire(mutex)           ((mutex)->owner == RT_NULL)
+#define _mutex_mark_contended(mutex)        RT_FALSE
+#define _mutex_set_state(mutex, value)
+#endif /* RT_USING_MUTEX_FASTPATH */
+
 /**
  * @addtogroup mutex
  * @{
@@ -1021,6 +1173,7 @@ rt_err_t rt_mutex_init(rt_mutex_t mutex, const char *name, rt_uint8_t flag)
     mutex->hold     = 0;
     mutex->ceiling_priority = 0xFF;
     rt_list_init(&(mutex->taken_list));
+    _mutex_set_state(mutex, MUTEX_UNLOCKED);
 
     /* flag can only be RT_IPC_FLAG_PRIO. RT_IPC_FLAG_FIFO cannot solve the unbounded priority inversion problem */
     mutex->parent.parent.flag = RT_IPC_FLAG_PRIO;
@@ -1065,6 +1218,28 @@ rt_err_t rt_mutex_detach(rt_mutex_t mutex)
 }
 RTM_EXPORT(rt_mutex_detach);
 
+/**
+ * @brief Make the thread the owner of a mutex nobody holds, as if the thread
+ *        had taken it. It's for a lock taken out of the kernel, e.g. by the
+ *        user space fast path of a pi futex.
+ *
+ * @param mutex is a pointer to a mutex object.
+ * @param owner is the thread holding the lock.
+ */
+void rt_mutex_set_owner(rt_mutex_t mutex, rt_thread_t owner)
+{
+    RT_ASSERT(mutex != RT_NULL);
+    RT_ASSERT(owner != RT_NULL);
+
+    rt_spin_lock(&(mutex->spinlock));
+    RT_ASSERT(mutex->owner == RT_NULL);
+
+    mutex->owner = owner;
+    mutex->hold  = 1;
+    _mutex_set_state(mutex, MUTEX_LOCKED);
+    rt_spin_unlock(&(mutex->spinlock));
+}
+
 /* drop a thread from the suspend list of mutex */
 
 /**
@@ -1250,6 +1425,7 @@ rt_mutex_t rt_mutex_create(const char *name, rt_uint8_t flag)
     mutex->hold     = 0;
     mutex->ceiling_priority = 0xFF;
     rt_list_init(&(mutex->taken_list));
+    _mutex_set_state(mutex, MUTEX_UNLOCKED);
 
     /* flag can only be RT_IPC_FLAG_PRIO. RT_IPC_FLAG_FIFO cannot solve the unbounded priority inversion problem */
     mutex->parent.parent.flag = RT_IPC_FLAG_PRIO;
@@ -1337,6 +1513,17 @@ static rt_err_t _rt_mutex_take(rt_mutex_t mutex, rt_int32_t timeout, int suspend
     /* get current thread */
     thread = rt_thread_self();
 
+#ifdef RT_USING_MUTEX_FASTPATH
+    if (_mutex_fast_take(mutex, thread) ||
+        (timeout != 0 && _mutex_spin_on_owner(mutex, thread)))
+    {
+        RT_OBJECT_HOOK_CALL(rt_object_trytake_hook, (&(mutex->parent.parent)));
+        thread->error = RT_EOK;
+        RT_OBJECT_HOOK_CALL(rt_object_take_hook, (&(mutex->parent.parent)));
+        return RT_EOK;
+    }
+#endif /* RT_USING_MUTEX_FASTPATH */
+
     rt_spin_lock(&(mutex->spinlock));
 
     RT_OBJECT_HOOK_CALL(rt_object_trytake_hook, (&(mutex->parent.parent)));
@@ -1363,7 +1550,8 @@ static rt_err_t _rt_mutex_take(rt_mutex_t mutex, rt_int32_t timeout, int suspend
     else
     {
         /* whether the mutex has owner thread. */
-        if (mutex->owner == RT_NULL)
+        if (_mutex_try_acquire(mutex) ||
+            (timeout != 0 && _mutex_mark_contended(mutex)))
         {
             /* set mutex owner and original priority */
             mutex->owner    = thread;
@@ -1596,6 +1784,14 @@ rt_err_t rt_mutex_release(rt_mutex_t mutex)
     /* get current thread */
     thread = rt_thread_self();
 
+#ifdef RT_USING_MUTEX_FASTPATH
+    if (_mutex_fast_release(mutex, thread))
+    {
+        RT_OBJECT_HOOK_CALL(rt_object_put_hook, (&(mutex->parent.parent)));
+        return RT_EOK;
+    }
+#endif /* RT_USING_MUTEX_FASTPATH */
+
     rt_spin_lock(&(mutex->spinlock));
 
     LOG_D("mutex_release:current thread %s, hold: %d",
@@ -1670,10 +1866,13 @@ rt_err_t rt_mutex_release(rt_mutex_t mutex)
 
                     th = RT_THREAD_LIST_NODE_ENTRY(mutex->parent.suspend_thread.next);
                     mutex->priority = rt_sched_thread_get_curr_prio(th);
+                    _mutex_set_state(mutex, MUTEX_CONTENDED);
                 }
                 else
                 {
                     mutex->priority = 0xff;
+                    /* let the new owner release it in fast path */
+                    _mutex_set_state(mutex, MUTEX_LOCKED);
                 }
 
                 need_schedule = RT_TRUE;
@@ -1681,8 +1880,9 @@ rt_err_t rt_mutex_release(rt_mutex_t mutex)
             else
             {
                 /* no waiting thread is woke up, clear owner */
-                mutex->owner = RT_NULL;
                 mutex->priority = 0xff;
+                mutex->owner = RT_NULL;
+                _mutex_set_state(mutex, MUTEX_UNLOCKED);
             }
 
             rt_sched_unlock(slvl);
@@ -1692,8 +1892,9 @@ rt_err_t rt_mutex_release(rt_mutex_t mutex)
             rt_sched_unlock(slvl);
 
             /* clear owner */
-            mutex->owner    = RT_NULL;
             mutex->priority = 0xff;
+            mutex->owner    = RT_NULL;
+            _mutex_set_state(mutex, MUTEX_UNLOCKED);
         }
     }
 
@@ -2530,59 +2731,40 @@ RTM_EXPORT(rt_mb_delete);
 
 
 /**
- * @brief    This function will send an mail to the mailbox object. If there is a thread suspended on the mailbox,
- *           the thread will be resumed.
- *
- * @note     When using this function to send a mail, if the mailbox if fully used, the current thread will
- *           wait for a timeout. If the set timeout time is reached and there is still no space available,
- *           the sending thread will be resumed and an error code will be returned.
- *           By contrast, the rt_mb_send() function will return an error code immediately without waiting time
- *           when the mailbox if fully used.
+ * @brief    Wait until the mailbox has a free slot.
  *
- * @see      rt_mb_send()
+ * @note     The caller must hold the mailbox spinlock. On success, the lock
+ *           is still held when this function returns. On failure, the lock
+ *           has been released.
  *
- * @param    mb is a pointer to the mailbox object to be sent.
+ * @param    mb is a pointer to the mailbox object.
  *
- * @param    value is a value to the content of the mail you want to send.
+ * @param    level is the interrupt level saved when taking the spinlock.
  *
  * @param    timeout is a timeout period (unit: an OS tick).
  *
- * @return   Return the operation status. When the return value is RT_EOK, the operation is successful.
- *           If the return value is any other values, it means that the mailbox detach failed.
+ * @param    suspend_flag status flag of the thread to be suspended.
  *
- * @warning  This function can be called in interrupt context and thread context.
+ * @return   Return the operation status. RT_EOK means there is a free slot.
  */
-static rt_err_t _rt_mb_send_wait(rt_mailbox_t mb,
-                         rt_ubase_t   value,
-                         rt_int32_t   timeout,
-                         int suspend_flag)
+static rt_err_t _mb_wait_space(rt_mailbox_t mb,
+                               rt_base_t *level,
+                               rt_int32_t timeout,
+                               int suspend_flag)
 {
     struct rt_thread *thread;
-    rt_base_t level;
     rt_uint32_t tick_delta;
     rt_err_t ret;
 
-    /* parameter check */
-    RT_ASSERT(mb != RT_NULL);
-    RT_ASSERT(rt_object_get_type(&mb->parent.parent) == RT_Object_Class_MailBox);
-
-    /* current context checking */
-    RT_DEBUG_SCHEDULER_AVAILABLE(timeout != 0);
-
     /* initialize delta tick */
     tick_delta = 0;
     /* get current thread */
     thread = rt_thread_self();
 
-    RT_OBJECT_HOOK_CALL(rt_object_put_hook, (&(mb->parent.parent)));
-
-    /* disable interrupt */
-    level = rt_spin_lock_irqsave(&(mb->spinlock));
-
     /* for non-blocking call */
     if (mb->entry == mb->size && timeout == 0)
     {
-        rt_spin_unlock_irqrestore(&(mb->spinlock), level);
+        rt_spin_unlock_irqrestore(&(mb->spinlock), *level);
         return -RT_EFULL;
     }
 
@@ -2595,7 +2777,7 @@ static rt_err_t _rt_mb_send_wait(rt_mailbox_t mb,
         /* no waiting, return timeout */
         if (timeout == 0)
         {
-            rt_spin_unlock_irqrestore(&(mb->spinlock), level);
+            rt_spin_unlock_irqrestore(&(mb->spinlock), *level);
 
             return -RT_EFULL;
         }
@@ -2606,7 +2788,7 @@ static rt_err_t _rt_mb_send_wait(rt_mailbox_t mb,
 
         if (ret != RT_EOK)
         {
-            rt_spin_unlock_irqrestore(&(mb->spinlock), level);
+            rt_spin_unlock_irqrestore(&(mb->spinlock), *level);
             return ret;
         }
 
@@ -2625,7 +2807,7 @@ static rt_err_t _rt_mb_send_wait(rt_mailbox_t mb,
                              &timeout);
             rt_timer_start(&(thread->thread_timer));
         }
-        rt_spin_unlock_irqrestore(&(mb->spinlock), level);
+        rt_spin_unlock_irqrestore(&(mb->spinlock), *level);
 
         /* re-schedule */
         rt_schedule();
@@ -2637,7 +2819,7 @@ static rt_err_t _rt_mb_send_wait(rt_mailbox_t mb,
             return thread->error;
         }
 
-        level = rt_spin_lock_irqsave(&(mb->spinlock));
+        *level = rt_spin_lock_irqsave(&(mb->spinlock));
 
         /* if it's not waiting forever and then re-calculate timeout tick */
         if (timeout > 0)
@@ -2649,224 +2831,50 @@ static rt_err_t _rt_mb_send_wait(rt_mailbox_t mb,
         }
     }
 
-    /* set ptr */
-    mb->msg_pool[mb->in_offset] = value;
-    /* increase input offset */
-    ++ mb->in_offset;
-    if (mb->in_offset >= mb->size)
-        mb->in_offset = 0;
-
-    if(mb->entry < RT_MB_ENTRY_MAX)
-    {
-        /* increase message entry */
-        mb->entry ++;
-    }
-    else
-    {
-        rt_spin_unlock_irqrestore(&(mb->spinlock), level);
-        return -RT_EFULL; /* value overflowed */
-    }
-
-    /* resume suspended thread */
-    if (!rt_list_isempty(&mb->parent.suspend_thread))
-    {
-        rt_susp_list_dequeue(&(mb->parent.suspend_thread), RT_EOK);
-
-        rt_spin_unlock_irqrestore(&(mb->spinlock), level);
-
-        rt_schedule();
-
-        return RT_EOK;
-    }
-    rt_spin_unlock_irqrestore(&(mb->spinlock), level);
-
     return RT_EOK;
 }
 
-rt_err_t rt_mb_send_wait(rt_mailbox_t mb,
-                         rt_ubase_t   value,
-                         rt_int32_t   timeout)
-{
-    return _rt_mb_send_wait(mb, value, timeout, RT_UNINTERRUPTIBLE);
-}
-RTM_EXPORT(rt_mb_send_wait);
-
-rt_err_t rt_mb_send_wait_interruptible(rt_mailbox_t mb,
-                         rt_ubase_t   value,
-                         rt_int32_t   timeout)
-{
-    return _rt_mb_send_wait(mb, value, timeout, RT_INTERRUPTIBLE);
-}
-RTM_EXPORT(rt_mb_send_wait_interruptible);
-
-rt_err_t rt_mb_send_wait_killable(rt_mailbox_t mb,
-                         rt_ubase_t   value,
-                         rt_int32_t   timeout)
-{
-    return _rt_mb_send_wait(mb, value, timeout, RT_KILLABLE);
-}
-RTM_EXPORT(rt_mb_send_wait_killable);
 /**
- * @brief    This function will send an mail to the mailbox object. If there is a thread suspended on the mailbox,
- *           the thread will be resumed.
- *
- * @note     When using this function to send a mail, if the mailbox is fully used, this function will return an error
- *           code immediately without waiting time.
- *           By contrast, the rt_mb_send_wait() function is set a timeout to wait for the mail to be sent.
- *
- * @see      rt_mb_send_wait()
- *
- * @param    mb is a pointer to the mailbox object to be sent.
- *
- * @param    value is a value to the content of the mail you want to send.
+ * @brief    Wait until there is mail in the mailbox.
  *
- * @return   Return the operation status. When the return value is RT_EOK, the operation is successful.
- *           If the return value is any other values, it means that the mailbox detach failed.
- */
-rt_err_t rt_mb_send(rt_mailbox_t mb, rt_ubase_t value)
-{
-    return rt_mb_send_wait(mb, value, 0);
-}
-RTM_EXPORT(rt_mb_send);
-
-rt_err_t rt_mb_send_interruptible(rt_mailbox_t mb, rt_ubase_t value)
-{
-    return rt_mb_send_wait_interruptible(mb, value, 0);
-}
-RTM_EXPORT(rt_mb_send_interruptible);
-
-rt_err_t rt_mb_send_killable(rt_mailbox_t mb, rt_ubase_t value)
-{
-    return rt_mb_send_wait_killable(mb, value, 0);
-}
-RTM_EXPORT(rt_mb_send_killable);
-
-/**
- * @brief    This function will send an urgent mail to the mailbox object.
+ * @note     The caller must hold the mailbox spinlock. On success, the lock
+ *           is still held when this function returns. On failure, the lock
+ *           has been released.
  *
- * @note     This function is almost the same as the rt_mb_send() function. The only difference is that
- *           when sending an urgent mail, the mail will be placed at the head of the mail queue so that
- *           the recipient can receive the urgent mail first.
+ * @param    mb is a pointer to the mailbox object.
  *
- * @see      rt_mb_send()
+ * @param    level is the interrupt level saved when taking the spinlock.
  *
- * @param    mb is a pointer to the mailbox object to be sent.
+ * @param    timeout is a timeout period (unit: an OS tick).
  *
- * @param    value is the content of the mail you want to send.
+ * @param    suspend_flag status flag of the thread to be suspended.
  *
- * @return   Return the operation status. When the return value is RT_EOK, the operation is successful.
- *           If the return value is any other values, it means that the mailbox detach failed.
+ * @return   Return the operation status. RT_EOK means there is mail available.
  */
-rt_err_t rt_mb_urgent(rt_mailbox_t mb, rt_ubase_t value)
+static rt_err_t _mb_wait_mail(rt_mailbox_t mb,
+                              rt_base_t *level,
+                              rt_int32_t timeout,
+                              int suspend_flag)
 {
-    rt_base_t level;
-
-    /* parameter check */
-    RT_ASSERT(mb != RT_NULL);
-    RT_ASSERT(rt_object_get_type(&mb->parent.parent) == RT_Object_Class_MailBox);
-
-    RT_OBJECT_HOOK_CALL(rt_object_put_hook, (&(mb->parent.parent)));
+    struct rt_thread *thread;
+    rt_uint32_t tick_delta;
+    rt_err_t ret;
 
-    level = rt_spin_lock_irqsave(&(mb->spinlock));
+    /* initialize delta tick */
+    tick_delta = 0;
+    /* get current thread */
+    thread = rt_thread_self();
 
-    if (mb->entry == mb->size)
+    /* for non-blocking call */
+    if (mb->entry == 0 && timeout == 0)
     {
-        rt_spin_unlock_irqrestore(&(mb->spinlock), level);
-        return -RT_EFULL;
+        rt_spin_unlock_irqrestore(&(mb->spinlock), *level);
+
+        return -RT_ETIMEOUT;
     }
 
-    /* rewind to the previous position */
-    if (mb->out_offset > 0)
-    {
-        mb->out_offset --;
-    }
-    else
-    {
-        mb->out_offset = mb->size - 1;
-    }
-
-    /* set ptr */
-    mb->msg_pool[mb->out_offset] = value;
-
-    /* increase message entry */
-    mb->entry ++;
-
-    /* resume suspended thread */
-    if (!rt_list_isempty(&mb->parent.suspend_thread))
-    {
-        rt_susp_list_dequeue(&(mb->parent.suspend_thread), RT_EOK);
-
-        rt_spin_unlock_irqrestore(&(mb->spinlock), level);
-
-        rt_schedule();
-
-        return RT_EOK;
-    }
-    rt_spin_unlock_irqrestore(&(mb->spinlock), level);
-
-    return RT_EOK;
-}
-RTM_EXPORT(rt_mb_urgent);
-
-
-/**
- * @brief    This function will receive a mail from mailbox object, if there is no mail in mailbox object,
- *           the thread shall wait for a specified time.
- *
- * @note     Only when there is mail in the mailbox, the receiving thread can get the mail immediately and
- *           return RT_EOK, otherwise the receiving thread will be suspended until the set timeout. If the mail
- *           is still not received within the specified time, it will return-RT_ETIMEOUT.
- *
- * @param    mb is a pointer to the mailbox object to be received.
- *
- * @param    value is a flag that you will set for this mailbox's flag.
- *           You can set an mailbox flag, or you can set multiple flags through OR logic operations.
- *
- * @param    timeout is a timeout period (unit: an OS tick). If the mailbox object is not avaliable in the queue,
- *           the thread will wait for the object in the queue up to the amount of time specified by this parameter.
- *
- *           NOTE:
- *           If use Macro RT_WAITING_FOREVER to set this parameter, which means that when the
- *           mailbox object is unavailable in the queue, the thread will be waiting forever.
- *           If use macro RT_WAITING_NO to set this parameter, which means that this
- *           function is non-blocking and will return immediately.
- *
- * @return   Return the operation status. When the return value is RT_EOK, the operation is successful.
- *           If the return value is any other values, it means that the mailbox release failed.
- */
-static rt_err_t _rt_mb_recv(rt_mailbox_t mb, rt_ubase_t *value, rt_int32_t timeout, int suspend_flag)
-{
-    struct rt_thread *thread;
-    rt_base_t level;
-    rt_uint32_t tick_delta;
-    rt_err_t ret;
-
-    /* parameter check */
-    RT_ASSERT(mb != RT_NULL);
-    RT_ASSERT(rt_object_get_type(&mb->parent.parent) == RT_Object_Class_MailBox);
-
-    /* current context checking */
-    RT_DEBUG_SCHEDULER_AVAILABLE(timeout != 0);
-
-    /* initialize delta tick */
-    tick_delta = 0;
-    /* get current thread */
-    thread = rt_thread_self();
-
-    RT_OBJECT_HOOK_CALL(rt_object_trytake_hook, (&(mb->parent.parent)));
-
-    level = rt_spin_lock_irqsave(&(mb->spinlock));
-
-    /* for non-blocking call */
-    if (mb->entry == 0 && timeout == 0)
-    {
-        rt_spin_unlock_irqrestore(&(mb->spinlock), level);
-
-        return -RT_ETIMEOUT;
-    }
-
-    /* mailbox is empty */
-    while (mb->entry == 0)
+    /* mailbox is empty */
+    while (mb->entry == 0)
     {
         /* reset error number in thread */
         thread->error = -RT_EINTR;
@@ -2874,7 +2882,7 @@ static rt_err_t _rt_mb_recv(rt_mailbox_t mb, rt_ubase_t *value, rt_int32_t timeo
         /* no waiting, return timeout */
         if (timeout == 0)
         {
-            rt_spin_unlock_irqrestore(&(mb->spinlock), level);
+            rt_spin_unlock_irqrestore(&(mb->spinlock), *level);
 
             thread->error = -RT_ETIMEOUT;
 
@@ -2886,7 +2894,7 @@ static rt_err_t _rt_mb_recv(rt_mailbox_t mb, rt_ubase_t *value, rt_int32_t timeo
                                         mb->parent.parent.flag, suspend_flag);
         if (ret != RT_EOK)
         {
-            rt_spin_unlock_irqrestore(&(mb->spinlock), level);
+            rt_spin_unlock_irqrestore(&(mb->spinlock), *level);
             return ret;
         }
 
@@ -2906,7 +2914,7 @@ static rt_err_t _rt_mb_recv(rt_mailbox_t mb, rt_ubase_t *value, rt_int32_t timeo
             rt_timer_start(&(thread->thread_timer));
         }
 
-        rt_spin_unlock_irqrestore(&(mb->spinlock), level);
+        rt_spin_unlock_irqrestore(&(mb->spinlock), *level);
 
         /* re-schedule */
         rt_schedule();
@@ -2917,7 +2925,7 @@ static rt_err_t _rt_mb_recv(rt_mailbox_t mb, rt_ubase_t *value, rt_int32_t timeo
             /* return error */
             return thread->error;
         }
-        level = rt_spin_lock_irqsave(&(mb->spinlock));
+        *level = rt_spin_lock_irqsave(&(mb->spinlock));
 
         /* if it's not waiting forever and then re-calculate timeout tick */
         if (timeout > 0)
@@ -2929,94 +2937,496 @@ static rt_err_t _rt_mb_recv(rt_mailbox_t mb, rt_ubase_t *value, rt_int32_t timeo
         }
     }
 
-    /* fill ptr */
-    *value = mb->msg_pool[mb->out_offset];
+    return RT_EOK;
+}
 
-    /* increase output offset */
-    ++ mb->out_offset;
-    if (mb->out_offset >= mb->size)
-        mb->out_offset = 0;
+/**
+ * @brief    This function will send an mail to the mailbox object. If there is a thread suspended on the mailbox,
+ *           the thread will be resumed.
+ *
+ * @note     When using this function to send a mail, if the mailbox if fully used, the current thread will
+ *           wait for a timeout. If the set timeout time is reached and there is still no space available,
+ *           the sending thread will be resumed and an error code will be returned.
+ *           By contrast, the rt_mb_send() function will return an error code immediately without waiting time
+ *           when the mailbox if fully used.
+ *
+ * @see      rt_mb_send()
+ *
+ * @param    mb is a pointer to the mailbox object to be sent.
+ *
+ * @param    value is a value to the content of the mail you want to send.
+ *
+ * @param    timeout is a timeout period (unit: an OS tick).
+ *
+ * @return   Return the operation status. When the return value is RT_EOK, the operation is successful.
+ *           If the return value is any other values, it means that the mailbox detach failed.
+ *
+ * @warning  This function can be called in interrupt context and thread context.
+ */
+static rt_err_t _rt_mb_send_wait(rt_mailbox_t mb,
+                         rt_ubase_t   value,
+                         rt_int32_t   timeout,
+                         int suspend_flag)
+{
+    rt_base_t level;
+    rt_err_t ret;
 
-    /* decrease message entry */
-    if(mb->entry > 0)
+    /* parameter check */
+    RT_ASSERT(mb != RT_NULL);
+    RT_ASSERT(rt_object_get_type(&mb->parent.parent) == RT_Object_Class_MailBox);
+
+    /* current context checking */
+    RT_DEBUG_SCHEDULER_AVAILABLE(timeout != 0);
+
+    RT_OBJECT_HOOK_CALL(rt_object_put_hook, (&(mb->parent.parent)));
+
+    /* disable interrupt */
+    level = rt_spin_lock_irqsave(&(mb->spinlock));
+
+    ret = _mb_wait_space(mb, &level, timeout, suspend_flag);
+    if (ret != RT_EOK)
+        return ret;
+
+    /* set ptr */
+    mb->msg_pool[mb->in_offset] = value;
+    /* increase input offset */
+    ++ mb->in_offset;
+    if (mb->in_offset >= mb->size)
+        mb->in_offset = 0;
+
+    if(mb->entry < RT_MB_ENTRY_MAX)
     {
-        mb->entry --;
+        /* increase message entry */
+        mb->entry ++;
+    }
+    else
+    {
+        rt_spin_unlock_irqrestore(&(mb->spinlock), level);
+        return -RT_EFULL; /* value overflowed */
     }
 
     /* resume suspended thread */
-    if (!rt_list_isempty(&(mb->suspend_sender_thread)))
+    if (!rt_list_isempty(&mb->parent.suspend_thread))
     {
-        rt_susp_list_dequeue(&(mb->suspend_sender_thread), RT_EOK);
+        rt_susp_list_dequeue(&(mb->parent.suspend_thread), RT_EOK);
 
         rt_spin_unlock_irqrestore(&(mb->spinlock), level);
 
-        RT_OBJECT_HOOK_CALL(rt_object_take_hook, (&(mb->parent.parent)));
-
         rt_schedule();
 
         return RT_EOK;
     }
     rt_spin_unlock_irqrestore(&(mb->spinlock), level);
 
-    RT_OBJECT_HOOK_CALL(rt_object_take_hook, (&(mb->parent.parent)));
-
     return RT_EOK;
 }
 
-rt_err_t rt_mb_recv(rt_mailbox_t mb, rt_ubase_t *value, rt_int32_t timeout)
+rt_err_t rt_mb_send_wait(rt_mailbox_t mb,
+                         rt_ubase_t   value,
+                         rt_int32_t   timeout)
 {
-    return _rt_mb_recv(mb, value, timeout, RT_UNINTERRUPTIBLE);
+    return _rt_mb_send_wait(mb, value, timeout, RT_UNINTERRUPTIBLE);
 }
-RTM_EXPORT(rt_mb_recv);
+RTM_EXPORT(rt_mb_send_wait);
 
-rt_err_t rt_mb_recv_interruptible(rt_mailbox_t mb, rt_ubase_t *value, rt_int32_t timeout)
+rt_err_t rt_mb_send_wait_interruptible(rt_mailbox_t mb,
+                         rt_ubase_t   value,
+                         rt_int32_t   timeout)
 {
-    return _rt_mb_recv(mb, value, timeout, RT_INTERRUPTIBLE);
+    return _rt_mb_send_wait(mb, value, timeout, RT_INTERRUPTIBLE);
 }
-RTM_EXPORT(rt_mb_recv_interruptible);
+RTM_EXPORT(rt_mb_send_wait_interruptible);
 
-rt_err_t rt_mb_recv_killable(rt_mailbox_t mb, rt_ubase_t *value, rt_int32_t timeout)
+rt_err_t rt_mb_send_wait_killable(rt_mailbox_t mb,
+                         rt_ubase_t   value,
+                         rt_int32_t   timeout)
 {
-    return _rt_mb_recv(mb, value, timeout, RT_KILLABLE);
+    return _rt_mb_send_wait(mb, value, timeout, RT_KILLABLE);
 }
-RTM_EXPORT(rt_mb_recv_killable);
+RTM_EXPORT(rt_mb_send_wait_killable);
+/**
+ * @brief    This function will send an mail to the mailbox object. If there is a thread suspended on the mailbox,
+ *           the thread will be resumed.
+ *
+ * @note     When using this function to send a mail, if the mailbox is fully used, this function will return an error
+ *           code immediately without waiting time.
+ *           By contrast, the rt_mb_send_wait() function is set a timeout to wait for the mail to be sent.
+ *
+ * @see      rt_mb_send_wait()
+ *
+ * @param    mb is a pointer to the mailbox object to be sent.
+ *
+ * @param    value is a value to the content of the mail you want to send.
+ *
+ * @return   Return the operation status. When the return value is RT_EOK, the operation is successful.
+ *           If the return value is any other values, it means that the mailbox detach failed.
+ */
+rt_err_t rt_mb_send(rt_mailbox_t mb, rt_ubase_t value)
+{
+    return rt_mb_send_wait(mb, value, 0);
+}
+RTM_EXPORT(rt_mb_send);
+
+rt_err_t rt_mb_send_interruptible(rt_mailbox_t mb, rt_ubase_t value)
+{
+    return rt_mb_send_wait_interruptible(mb, value, 0);
+}
+RTM_EXPORT(rt_mb_send_interruptible);
+
+rt_err_t rt_mb_send_killable(rt_mailbox_t mb, rt_ubase_t value)
+{
+    return rt_mb_send_wait_killable(mb, value, 0);
+}
+RTM_EXPORT(rt_mb_send_killable);
 
 /**
- * @brief    This function will set some extra attributions of a mailbox object.
+ * @brief    This function will send an urgent mail to the mailbox object.
  *
- * @note     Currently this function only supports the RT_IPC_CMD_RESET command to reset the mailbox.
+ * @note     This function is almost the same as the rt_mb_send() function. The only difference is that
+ *           when sending an urgent mail, the mail will be placed at the head of the mail queue so that
+ *           the recipient can receive the urgent mail first.
  *
- * @param    mb is a pointer to a mailbox object.
+ * @see      rt_mb_send()
  *
- * @param    cmd is a command used to configure some attributions of the mailbox.
+ * @param    mb is a pointer to the mailbox object to be sent.
  *
- * @param    arg is the argument of the function to execute the command.
+ * @param    value is the content of the mail you want to send.
  *
  * @return   Return the operation status. When the return value is RT_EOK, the operation is successful.
- *           If the return value is any other values, it means that this function failed to execute.
+ *           If the return value is any other values, it means that the mailbox detach failed.
  */
-rt_err_t rt_mb_control(rt_mailbox_t mb, int cmd, void *arg)
+rt_err_t rt_mb_urgent(rt_mailbox_t mb, rt_ubase_t value)
 {
     rt_base_t level;
 
-    RT_UNUSED(arg);
-
     /* parameter check */
     RT_ASSERT(mb != RT_NULL);
     RT_ASSERT(rt_object_get_type(&mb->parent.parent) == RT_Object_Class_MailBox);
 
-    if (cmd == RT_IPC_CMD_RESET)
-    {
-        level = rt_spin_lock_irqsave(&(mb->spinlock));
+    RT_OBJECT_HOOK_CALL(rt_object_put_hook, (&(mb->parent.parent)));
 
-        /* resume all waiting thread */
-        rt_susp_list_resume_all(&(mb->parent.suspend_thread), RT_ERROR);
-        /* also resume all mailbox private suspended thread */
-        rt_susp_list_resume_all(&(mb->suspend_sender_thread), RT_ERROR);
+    level = rt_spin_lock_irqsave(&(mb->spinlock));
 
-        /* re-init mailbox */
-        mb->entry      = 0;
-        mb->in_offset  = 0;
+    if (mb->entry == mb->size)
+    {
+        rt_spin_unlock_irqrestore(&(mb->spinlock), level);
+        return -RT_EFULL;
+    }
+
+    /* rewind to the previous position */
+    if (mb->out_offset > 0)
+    {
+        mb->out_offset --;
+    }
+    else
+    {
+        mb->out_offset = mb->size - 1;
+    }
+
+    /* set ptr */
+    mb->msg_pool[mb->out_offset] = value;
+
+    /* increase message entry */
+    mb->entry ++;
+
+    /* resume suspended thread */
+    if (!rt_list_isempty(&mb->parent.suspend_thread))
+    {
+        rt_susp_list_dequeue(&(mb->parent.suspend_thread), RT_EOK);
+
+        rt_spin_unlock_irqrestore(&(mb->spinlock), level);
+
+        rt_schedule();
+
+        return RT_EOK;
+    }
+    rt_spin_unlock_irqrestore(&(mb->spinlock), level);
+
+    return RT_EOK;
+}
+RTM_EXPORT(rt_mb_urgent);
+
+
+/**
+ * @brief    This function will receive a mail from mailbox object, if there is no mail in mailbox object,
+ *           the thread shall wait for a specified time.
+ *
+ * @note     Only when there is mail in the mailbox, the receiving thread can get the mail immediately and
+ *           return RT_EOK, otherwise the receiving thread will be suspended until the set timeout. If the mail
+ *           is still not received within the specified time, it will return-RT_ETIMEOUT.
+ *
+ * @param    mb is a pointer to the mailbox object to be received.
+ *
+ * @param    value is a flag that you will set for this mailbox's flag.
+ *           You can set an mailbox flag, or you can set multiple flags through OR logic operations.
+ *
+ * @param    timeout is a timeout period (unit: an OS tick). If the mailbox object is not avaliable in the queue,
+ *           the thread will wait for the object in the queue up to the amount of time specified by this parameter.
+ *
+ *           NOTE:
+ *           If use Macro RT_WAITING_FOREVER to set this parameter, which means that when the
+ *           mailbox object is unavailable in the queue, the thread will be waiting forever.
+ *           If use macro RT_WAITING_NO to set this parameter, which means that this
+ *           function is non-blocking and will return immediately.
+ *
+ * @return   Return the operation status. When the return value is RT_EOK, the operation is successful.
+ *           If the return value is any other values, it means that the mailbox release failed.
+ */
+static rt_err_t _rt_mb_recv(rt_mailbox_t mb, rt_ubase_t *value, rt_int32_t timeout, int suspend_flag)
+{
+    rt_base_t level;
+    rt_err_t ret;
+
+    /* parameter check */
+    RT_ASSERT(mb != RT_NULL);
+    RT_ASSERT(rt_object_get_type(&mb->parent.parent) == RT_Object_Class_MailBox);
+
+    /* current context checking */
+    RT_DEBUG_SCHEDULER_AVAILABLE(timeout != 0);
+
+    RT_OBJECT_HOOK_CALL(rt_object_trytake_hook, (&(mb->parent.parent)));
+
+    level = rt_spin_lock_irqsave(&(mb->spinlock));
+
+    ret = _mb_wait_mail(mb, &level, timeout, suspend_flag);
+    if (ret != RT_EOK)
+        return ret;
+
+    /* fill ptr */
+    *value = mb->msg_pool[mb->out_offset];
+
+    /* increase output offset */
+    ++ mb->out_offset;
+    if (mb->out_offset >= mb->size)
+        mb->out_offset = 0;
+
+    /* decrease message entry */
+    if(mb->entry > 0)
+    {
+        mb->entry --;
+    }
+
+    /* resume suspended thread */
+    if (!rt_list_isempty(&(mb->suspend_sender_thread)))
+    {
+        rt_susp_list_dequeue(&(mb->suspend_sender_thread), RT_EOK);
+
+        rt_spin_unlock_irqrestore(&(mb->spinlock), level);
+
+        RT_OBJECT_HOOK_CALL(rt_object_take_hook, (&(mb->parent.parent)));
+
+        rt_schedule();
+
+        return RT_EOK;
+    }
+    rt_spin_unlock_irqrestore(&(mb->spinlock), level);
+
+    RT_OBJECT_HOOK_CALL(rt_object_take_hook, (&(mb->parent.parent)));
+
+    return RT_EOK;
+}
+
+rt_err_t rt_mb_recv(rt_mailbox_t mb, rt_ubase_t *value, rt_int32_t timeout)
+{
+    return _rt_mb_recv(mb, value, timeout, RT_UNINTERRUPTIBLE);
+}
+RTM_EXPORT(rt_mb_recv);
+
+rt_err_t rt_mb_recv_interruptible(rt_mailbox_t mb, rt_ubase_t *value, rt_int32_t timeout)
+{
+    return _rt_mb_recv(mb, value, timeout, RT_INTERRUPTIBLE);
+}
+RTM_EXPORT(rt_mb_recv_interruptible);
+
+rt_err_t rt_mb_recv_killable(rt_mailbox_t mb, rt_ubase_t *value, rt_int32_t timeout)
+{
+    return _rt_mb_recv(mb, value, timeout, RT_KILLABLE);
+}
+RTM_EXPORT(rt_mb_recv_killable);
+
+/**
+ * @brief    This function will send a batch of mails to the mailbox object under
+ *           one lock acquisition. The threads suspended on the mailbox are resumed
+ *           at most once per mail and the scheduler is invoked only once.
+ *
+ * @note     If the mailbox is fully used, the current thread will wait for a free
+ *           slot up to timeout, then as many mails as there are free slots are sent.
+ *           A short count is not an error.
+ *
+ * @param    mb is a pointer to the mailbox object to be sent.
+ *
+ * @param    values is the array of mails to be sent.
+ *
+ * @param    count is the number of mails in values.
+ *
+ * @param    timeout is a timeout period (unit: an OS tick).
+ *
+ * @return   Return the number of mails sent, or a negative error code if nothing
+ *           was sent.
+ *
+ * @warning  This function can be called in interrupt context only with RT_WAITING_NO.
+ */
+rt_ssize_t rt_mb_send_batch(rt_mailbox_t mb,
+                            const rt_ubase_t *values,
+                            rt_size_t count,
+                            rt_int32_t timeout)
+{
+    rt_base_t level;
+    rt_size_t n, i;
+    rt_bool_t need_schedule;
+    rt_err_t ret;
+
+    /* parameter check */
+    RT_ASSERT(mb != RT_NULL);
+    RT_ASSERT(rt_object_get_type(&mb->parent.parent) == RT_Object_Class_MailBox);
+    RT_ASSERT(values != RT_NULL);
+    RT_ASSERT(count != 0);
+
+    /* current context checking */
+    RT_DEBUG_SCHEDULER_AVAILABLE(timeout != 0);
+
+    RT_OBJECT_HOOK_CALL(rt_object_put_hook, (&(mb->parent.parent)));
+
+    level = rt_spin_lock_irqsave(&(mb->spinlock));
+
+    ret = _mb_wait_space(mb, &level, timeout, RT_UNINTERRUPTIBLE);
+    if (ret != RT_EOK)
+        return ret;
+
+    n = mb->size - mb->entry;
+    if (n > count)
+        n = count;
+
+    for (i = 0; i < n; i ++)
+    {
+        mb->msg_pool[mb->in_offset] = values[i];
+        ++ mb->in_offset;
+        if (mb->in_offset >= mb->size)
+            mb->in_offset = 0;
+    }
+    mb->entry += n;
+
+    /* resume one receiver for each mail */
+    need_schedule = _ipc_list_resume_n(&(mb->parent.suspend_thread), n);
+
+    rt_spin_unlock_irqrestore(&(mb->spinlock), level);
+
+    if (need_schedule)
+        rt_schedule();
+
+    return n;
+}
+RTM_EXPORT(rt_mb_send_batch);
+
+/**
+ * @brief    This function will receive a batch of mails from the mailbox object
+ *           under one lock acquisition. The threads waiting for a free slot are
+ *           resumed at most once per mail and the scheduler is invoked only once.
+ *
+ * @note     If the mailbox is empty, the current thread will wait for a mail up to
+ *           timeout, then all available mails, up to count, are received.
+ *
+ * @param    mb is a pointer to the mailbox object to be received.
+ *
+ * @param    values is the array to store the received mails.
+ *
+ * @param    count is the capacity of values.
+ *
+ * @param    timeout is a timeout period (unit: an OS tick).
+ *
+ * @return   Return the number of mails received, or a negative error code if
+ *           nothing was received.
+ */
+rt_ssize_t rt_mb_recv_batch(rt_mailbox_t mb,
+                            rt_ubase_t *values,
+                            rt_size_t count,
+                            rt_int32_t timeout)
+{
+    rt_base_t level;
+    rt_size_t n, i;
+    rt_bool_t need_schedule;
+    rt_err_t ret;
+
+    /* parameter check */
+    RT_ASSERT(mb != RT_NULL);
+    RT_ASSERT(rt_object_get_type(&mb->parent.parent) == RT_Object_Class_MailBox);
+    RT_ASSERT(values != RT_NULL);
+    RT_ASSERT(count != 0);
+
+    /* current context checking */
+    RT_DEBUG_SCHEDULER_AVAILABLE(timeout != 0);
+
+    RT_OBJECT_HOOK_CALL(rt_object_trytake_hook, (&(mb->parent.parent)));
+
+    level = rt_spin_lock_irqsave(&(mb->spinlock));
+
+    ret = _mb_wait_mail(mb, &level, timeout, RT_UNINTERRUPTIBLE);
+    if (ret != RT_EOK)
+        return ret;
+
+    n = mb->entry;
+    if (n > count)
+        n = count;
+
+    for (i = 0; i < n; i ++)
+    {
+        values[i] = mb->msg_pool[mb->out_offset];
+        ++ mb->out_offset;
+        if (mb->out_offset >= mb->size)
+            mb->out_offset = 0;
+    }
+    mb->entry -= n;
+
+    /* resume one sender for each free slot */
+    need_schedule = _ipc_list_resume_n(&(mb->suspend_sender_thread), n);
+
+    rt_spin_unlock_irqrestore(&(mb->spinlock), level);
+
+    RT_OBJECT_HOOK_CALL(rt_object_take_hook, (&(mb->parent.parent)));
+
+    if (need_schedule)
+        rt_schedule();
+
+    return n;
+}
+RTM_EXPORT(rt_mb_recv_batch);
+
+/**
+ * @brief    This function will set some extra attributions of a mailbox object.
+ *
+ * @note     Currently this function only supports the RT_IPC_CMD_RESET command to reset the mailbox.
+ *
+ * @param    mb is a pointer to a mailbox object.
+ *
+ * @param    cmd is a command used to configure some attributions of the mailbox.
+ *
+ * @param    arg is the argument of the function to execute the command.
+ *
+ * @return   Return the operation status. When the return value is RT_EOK, the operation is successful.
+ *           If the return value is any other values, it means that this function failed to execute.
+ */
+rt_err_t rt_mb_control(rt_mailbox_t mb, int cmd, void *arg)
+{
+    rt_base_t level;
+
+    RT_UNUSED(arg);
+
+    /* parameter check */
+    RT_ASSERT(mb != RT_NULL);
+    RT_ASSERT(rt_object_get_type(&mb->parent.parent) == RT_Object_Class_MailBox);
+
+    if (cmd == RT_IPC_CMD_RESET)
+    {
+        level = rt_spin_lock_irqsave(&(mb->spinlock));
+
+        /* resume all waiting thread */
+        rt_susp_list_resume_all(&(mb->parent.suspend_thread), RT_ERROR);
+        /* also resume all mailbox private suspended thread */
+        rt_susp_list_resume_all(&(mb->suspend_sender_thread), RT_ERROR);
+
+        /* re-init mailbox */
+        mb->entry      = 0;
+        mb->in_offset  = 0;
         mb->out_offset = 0;
 
         rt_spin_unlock_irqrestore(&(mb->spinlock), level);
@@ -3333,73 +3743,41 @@ RTM_EXPORT(rt_mq_delete);
 #endif /* RT_USING_HEAP */
 
 /**
- * @brief    This function will send a message to the messagequeue object. If
- *           there is a thread suspended on the messagequeue, the thread will be
- *           resumed.
+ * @brief    Get free message nodes from the messagequeue, wait for one if the
+ *           messagequeue is fully used.
  *
- * @note     When using this function to send a message, if the messagequeue is
- *           fully used, the current thread will wait for a timeout. If reaching
- *           the timeout and there is still no space available, the sending
- *           thread will be resumed and an error code will be returned. By
- *           contrast, the _rt_mq_send_wait() function will return an error code
- *           immediately without waiting when the messagequeue if fully used.
- *
- * @see      _rt_mq_send_wait()
- *
- * @param    mq is a pointer to the messagequeue object to be sent.
- *
- * @param    buffer is the content of the message.
+ * @param    mq is a pointer to the messagequeue object.
  *
- * @param    size is the length of the message(Unit: Byte).
- *
- * @param    prio is message priority, A larger value indicates a higher priority
+ * @param    count is the maximum number of nodes wanted. On success, it is set
+ *           to the number of nodes got, which is at least one.
  *
  * @param    timeout is a timeout period (unit: an OS tick).
  *
  * @param    suspend_flag status flag of the thread to be suspended.
  *
- * @return   Return the operation status. When the return value is RT_EOK, the
- *           operation is successful. If the return value is any other values,
- *           it means that the messagequeue detach failed.
+ * @param    err is a pointer to return the error code on failure.
  *
- * @warning  This function can be called in interrupt context and thread
- * context.
+ * @return   Return the chain of message nodes detached from the free list, or
+ *           RT_NULL on failure.
  */
-static rt_err_t _rt_mq_send_wait(rt_mq_t mq,
-                                 const void *buffer,
-                                 rt_size_t size,
-                                 rt_int32_t prio,
-                                 rt_int32_t timeout,
-                                 int suspend_flag)
+static struct rt_mq_message *_mq_get_free_msg(rt_mq_t mq,
+                                              rt_size_t *count,
+                                              rt_int32_t timeout,
+                                              int suspend_flag,
+                                              rt_err_t *err)
 {
     rt_base_t level;
-    struct rt_mq_message *msg;
+    struct rt_mq_message *msg, *head;
     rt_uint32_t tick_delta;
     struct rt_thread *thread;
     rt_err_t ret;
-
-    RT_UNUSED(prio);
-
-    /* parameter check */
-    RT_ASSERT(mq != RT_NULL);
-    RT_ASSERT(rt_object_get_type(&mq->parent.parent) == RT_Object_Class_MessageQueue);
-    RT_ASSERT(buffer != RT_NULL);
-    RT_ASSERT(size != 0);
-
-    /* current context checking */
-    RT_DEBUG_SCHEDULER_AVAILABLE(timeout != 0);
-
-    /* greater than one message size */
-    if (size > mq->msg_size)
-        return -RT_ERROR;
+    rt_size_t n;
 
     /* initialize delta tick */
     tick_delta = 0;
     /* get current thread */
     thread = rt_thread_self();
 
-    RT_OBJECT_HOOK_CALL(rt_object_put_hook, (&(mq->parent.parent)));
-
     level = rt_spin_lock_irqsave(&(mq->spinlock));
 
     /* get a free list, there must be an empty item */
@@ -3409,7 +3787,8 @@ static rt_err_t _rt_mq_send_wait(rt_mq_t mq,
     {
         rt_spin_unlock_irqrestore(&(mq->spinlock), level);
 
-        return -RT_EFULL;
+        *err = -RT_EFULL;
+        return RT_NULL;
     }
 
     /* message queue is full */
@@ -3423,7 +3802,8 @@ static rt_err_t _rt_mq_send_wait(rt_mq_t mq,
         {
             rt_spin_unlock_irqrestore(&(mq->spinlock), level);
 
-            return -RT_EFULL;
+            *err = -RT_EFULL;
+            return RT_NULL;
         }
 
         /* suspend current thread */
@@ -3432,7 +3812,8 @@ static rt_err_t _rt_mq_send_wait(rt_mq_t mq,
         if (ret != RT_EOK)
         {
             rt_spin_unlock_irqrestore(&(mq->spinlock), level);
-            return ret;
+            *err = ret;
+            return RT_NULL;
         }
 
         /* has waiting time, start thread timer */
@@ -3460,7 +3841,8 @@ static rt_err_t _rt_mq_send_wait(rt_mq_t mq,
         if (thread->error != RT_EOK)
         {
             /* return error */
-            return thread->error;
+            *err = thread->error;
+            return RT_NULL;
         }
         level = rt_spin_lock_irqsave(&(mq->spinlock));
 
@@ -3474,66 +3856,125 @@ static rt_err_t _rt_mq_send_wait(rt_mq_t mq,
         }
     }
 
+    /* detach up to count nodes from the free list */
+    head = msg;
+    for (n = 1; n < *count && msg->next != RT_NULL; n ++)
+        msg = msg->next;
+
     /* move free list pointer */
     mq->msg_queue_free = msg->next;
+    msg->next = RT_NULL;
 
     rt_spin_unlock_irqrestore(&(mq->spinlock), level);
 
-    /* the msg is the new tailer of list, the next shall be NULL */
-    msg->next = RT_NULL;
+    *count = n;
+    return head;
+}
 
-    /* add the length */
-    ((struct rt_mq_message *)msg)->length = size;
-    /* copy buffer */
-    rt_memcpy(GET_MESSAGEBYTE_ADDR(msg), buffer, size);
+/**
+ * @brief    Link filled message nodes into the messagequeue and resume the
+ *           receiving threads if any.
+ *
+ * @param    mq is a pointer to the messagequeue object.
+ *
+ * @param    msg is the chain of message nodes got by _mq_get_free_msg().
+ *
+ * @param    count is the number of nodes in the chain.
+ *
+ * @param    size is the length of each message(Unit: Byte).
+ *
+ * @param    prio is message priority, A larger value indicates a higher priority
+ *
+ * @param    urgent is whether to place the message at the head of the messagequeue.
+ *
+ * @return   Return the operation status.
+ */
+static rt_err_t _mq_enqueue_msg(rt_mq_t mq,
+                                struct rt_mq_message *msg,
+                                rt_size_t count,
+                                rt_size_t size,
+                                rt_int32_t prio,
+                                rt_bool_t urgent)
+{
+    rt_base_t level;
+    struct rt_mq_message *next;
+    rt_bool_t need_schedule;
+
+    RT_UNUSED(prio);
+    RT_ASSERT(!urgent || count == 1);
 
     /* disable interrupt */
     level = rt_spin_lock_irqsave(&(mq->spinlock));
-#ifdef RT_USING_MESSAGEQUEUE_PRIORITY
-    msg->prio = prio;
-    if (mq->msg_queue_head == RT_NULL)
-        mq->msg_queue_head = msg;
 
-    struct rt_mq_message *node, *prev_node = RT_NULL;
-    for (node = mq->msg_queue_head; node != RT_NULL; node = node->next)
+    for (; msg != RT_NULL; msg = next)
     {
-        if (node->prio < msg->prio)
+        next = msg->next;
+
+        /* the msg is the new tailer of list, the next shall be NULL */
+        msg->next = RT_NULL;
+
+        /* add the length */
+        msg->length = size;
+
+        if (urgent)
         {
-            if (prev_node == RT_NULL)
-                mq->msg_queue_head = msg;
-            else
-                prev_node->next = msg;
-            msg->next = node;
-            break;
+            /* link msg to the beginning of message queue */
+            msg->next = (struct rt_mq_message *)mq->msg_queue_head;
+            mq->msg_queue_head = msg;
+
+            /* if there is no tail */
+            if (mq->msg_queue_tail == RT_NULL)
+                mq->msg_queue_tail = msg;
         }
-        if (node->next == RT_NULL)
+        else
         {
-            if (node != msg)
-                node->next = msg;
-            mq->msg_queue_tail = msg;
-            break;
-        }
-        prev_node = node;
-    }
+#ifdef RT_USING_MESSAGEQUEUE_PRIORITY
+            msg->prio = prio;
+            if (mq->msg_queue_head == RT_NULL)
+                mq->msg_queue_head = msg;
+
+            struct rt_mq_message *node, *prev_node = RT_NULL;
+            for (node = mq->msg_queue_head; node != RT_NULL; node = node->next)
+            {
+                if (node->prio < msg->prio)
+                {
+                    if (prev_node == RT_NULL)
+                        mq->msg_queue_head = msg;
+                    else
+                        prev_node->next = msg;
+                    msg->next = node;
+                    break;
+                }
+                if (node->next == RT_NULL)
+                {
+                    if (node != msg)
+                        node->next = msg;
+                    mq->msg_queue_tail = msg;
+                    break;
+                }
+                prev_node = node;
+            }
 #else
-    /* link msg to message queue */
-    if (mq->msg_queue_tail != RT_NULL)
-    {
-        /* if the tail exists, */
-        ((struct rt_mq_message *)mq->msg_queue_tail)->next = msg;
-    }
+            /* link msg to message queue */
+            if (mq->msg_queue_tail != RT_NULL)
+            {
+                /* if the tail exists, */
+                ((struct rt_mq_message *)mq->msg_queue_tail)->next = msg;
+            }
 
-    /* set new tail */
-    mq->msg_queue_tail = msg;
-    /* if the head is empty, set head */
-    if (mq->msg_queue_head == RT_NULL)
-        mq->msg_queue_head = msg;
+            /* set new tail */
+            mq->msg_queue_tail = msg;
+            /* if the head is empty, set head */
+            if (mq->msg_queue_head == RT_NULL)
+                mq->msg_queue_head = msg;
 #endif
+        }
+    }
 
-    if(mq->entry < RT_MQ_ENTRY_MAX)
+    if(mq->entry <= RT_MQ_ENTRY_MAX - count)
     {
         /* increase message entry */
-        mq->entry ++;
+        mq->entry += count;
     }
     else
     {
@@ -3541,227 +3982,231 @@ static rt_err_t _rt_mq_send_wait(rt_mq_t mq,
         return -RT_EFULL; /* value overflowed */
     }
 
-    /* resume suspended thread */
-    if (!rt_list_isempty(&mq->parent.suspend_thread))
-    {
-        rt_susp_list_dequeue(&(mq->parent.suspend_thread), RT_EOK);
+    /* resume one suspended thread for each message */
+    need_schedule = _ipc_list_resume_n(&(mq->parent.suspend_thread), count);
 
-        rt_spin_unlock_irqrestore(&(mq->spinlock), level);
+    rt_spin_unlock_irqrestore(&(mq->spinlock), level);
 
+    if (need_schedule)
         rt_schedule();
 
-        return RT_EOK;
-    }
-    rt_spin_unlock_irqrestore(&(mq->spinlock), level);
-
     return RT_EOK;
 }
 
-rt_err_t rt_mq_send_wait(rt_mq_t     mq,
-                         const void *buffer,
-                         rt_size_t   size,
-                         rt_int32_t  timeout)
-{
-    return _rt_mq_send_wait(mq, buffer, size, 0, timeout, RT_UNINTERRUPTIBLE);
-}
-RTM_EXPORT(rt_mq_send_wait);
-
-rt_err_t rt_mq_send_wait_interruptible(rt_mq_t     mq,
-                         const void *buffer,
-                         rt_size_t   size,
-                         rt_int32_t  timeout)
-{
-    return _rt_mq_send_wait(mq, buffer, size, 0, timeout, RT_INTERRUPTIBLE);
-}
-RTM_EXPORT(rt_mq_send_wait_interruptible);
-
-rt_err_t rt_mq_send_wait_killable(rt_mq_t     mq,
-                         const void *buffer,
-                         rt_size_t   size,
-                         rt_int32_t  timeout)
-{
-    return _rt_mq_send_wait(mq, buffer, size, 0, timeout, RT_KILLABLE);
-}
-RTM_EXPORT(rt_mq_send_wait_killable);
-/**
- * @brief    This function will send a message to the messagequeue object.
- *           If there is a thread suspended on the messagequeue, the thread will be resumed.
- *
- * @note     When using this function to send a message, if the messagequeue is fully used,
- *           the current thread will wait for a timeout.
- *           By contrast, when the messagequeue is fully used, the rt_mq_send_wait() function will
- *           return an error code immediately without waiting.
- *
- * @see      rt_mq_send_wait()
- *
- * @param    mq is a pointer to the messagequeue object to be sent.
- *
- * @param    buffer is the content of the message.
- *
- * @param    size is the length of the message(Unit: Byte).
- *
- * @return   Return the operation status. When the return value is RT_EOK, the operation is successful.
- *           If the return value is any other values, it means that the messagequeue detach failed.
- *
- * @warning  This function can be called in interrupt context and thread context.
- */
-rt_err_t rt_mq_send(rt_mq_t mq, const void *buffer, rt_size_t size)
-{
-    return rt_mq_send_wait(mq, buffer, size, 0);
-}
-RTM_EXPORT(rt_mq_send);
-
-rt_err_t rt_mq_send_interruptible(rt_mq_t mq, const void *buffer, rt_size_t size)
-{
-    return rt_mq_send_wait_interruptible(mq, buffer, size, 0);
-}
-RTM_EXPORT(rt_mq_send_interruptible);
-
-rt_err_t rt_mq_send_killable(rt_mq_t mq, const void *buffer, rt_size_t size)
-{
-    return rt_mq_send_wait_killable(mq, buffer, size, 0);
-}
-RTM_EXPORT(rt_mq_send_killable);
 /**
- * @brief    This function will send an urgent message to the messagequeue object.
+ * @brief    Get the message nodes at the head of the messagequeue, wait for one
+ *           if the messagequeue is empty.
  *
- * @note     This function is almost the same as the rt_mq_send() function. The only difference is that
- *           when sending an urgent message, the message is placed at the head of the messagequeue so that
- *           the recipient can receive the urgent message first.
+ * @param    mq is a pointer to the messagequeue object.
  *
- * @see      rt_mq_send()
+ * @param    count is the maximum number of nodes wanted. On success, it is set
+ *           to the number of nodes got, which is at least one.
  *
- * @param    mq is a pointer to the messagequeue object to be sent.
+ * @param    timeout is a timeout period (unit: an OS tick).
  *
- * @param    buffer is the content of the message.
+ * @param    suspend_flag status flag of the thread to be suspended.
  *
- * @param    size is the length of the message(Unit: Byte).
+ * @param    err is a pointer to return the error code on failure.
  *
- * @return   Return the operation status. When the return value is RT_EOK, the operation is successful.
- *           If the return value is any other values, it means that the mailbox detach failed.
+ * @return   Return the chain of message nodes detached from the messagequeue, in
+ *           queue order, or RT_NULL on failure.
  */
-rt_err_t rt_mq_urgent(rt_mq_t mq, const void *buffer, rt_size_t size)
+static struct rt_mq_message *_mq_dequeue_msg(rt_mq_t mq,
+                                             rt_size_t *count,
+                                             rt_int32_t timeout,
+                                             int suspend_flag,
+                                             rt_err_t *err)
 {
+    struct rt_thread *thread;
     rt_base_t level;
-    struct rt_mq_message *msg;
-
-    /* parameter check */
-    RT_ASSERT(mq != RT_NULL);
-    RT_ASSERT(rt_object_get_type(&mq->parent.parent) == RT_Object_Class_MessageQueue);
-    RT_ASSERT(buffer != RT_NULL);
-    RT_ASSERT(size != 0);
-
-    /* greater than one message size */
-    if (size > mq->msg_size)
-        return -RT_ERROR;
+    struct rt_mq_message *msg, *head;
+    rt_uint32_t tick_delta;
+    rt_err_t ret;
+    rt_size_t n;
 
-    RT_OBJECT_HOOK_CALL(rt_object_put_hook, (&(mq->parent.parent)));
+    /* initialize delta tick */
+    tick_delta = 0;
+    /* get current thread */
+    thread = rt_thread_self();
 
     level = rt_spin_lock_irqsave(&(mq->spinlock));
 
-    /* get a free list, there must be an empty item */
-    msg = (struct rt_mq_message *)mq->msg_queue_free;
-    /* message queue is full */
-    if (msg == RT_NULL)
+    /* for non-blocking call */
+    if (mq->entry == 0 && timeout == 0)
     {
         rt_spin_unlock_irqrestore(&(mq->spinlock), level);
 
-        return -RT_EFULL;
+        *err = -RT_ETIMEOUT;
+        return RT_NULL;
     }
-    /* move free list pointer */
-    mq->msg_queue_free = msg->next;
-
-    rt_spin_unlock_irqrestore(&(mq->spinlock), level);
 
-    /* add the length */
-    ((struct rt_mq_message *)msg)->length = size;
-    /* copy buffer */
-    rt_memcpy(GET_MESSAGEBYTE_ADDR(msg), buffer, size);
+    /* message queue is empty */
+    while (mq->entry == 0)
+    {
+        /* reset error number in thread */
+        thread->error = -RT_EINTR;
 
-    level = rt_spin_lock_irqsave(&(mq->spinlock));
+        /* no waiting, return timeout */
+        if (timeout == 0)
+        {
+            /* enable interrupt */
+            rt_spin_unlock_irqrestore(&(mq->spinlock), level);
 
-    /* link msg to the beginning of message queue */
-    msg->next = (struct rt_mq_message *)mq->msg_queue_head;
-    mq->msg_queue_head = msg;
+            thread->error = -RT_ETIMEOUT;
 
-    /* if there is no tail */
-    if (mq->msg_queue_tail == RT_NULL)
-        mq->msg_queue_tail = msg;
+            *err = -RT_ETIMEOUT;
+            return RT_NULL;
+        }
 
-    if(mq->entry < RT_MQ_ENTRY_MAX)
-    {
-        /* increase message entry */
-        mq->entry ++;
-    }
-    else
-    {
-        rt_spin_unlock_irqrestore(&(mq->spinlock), level);
-        return -RT_EFULL; /* value overflowed */
-    }
+        /* suspend current thread */
+        ret = rt_thread_suspend_to_list(thread, &(mq->parent.suspend_thread),
+                                        mq->parent.parent.flag, suspend_flag);
+        if (ret != RT_EOK)
+        {
+            rt_spin_unlock_irqrestore(&(mq->spinlock), level);
+            *err = ret;
+            return RT_NULL;
+        }
 
-    /* resume suspended thread */
-    if (!rt_list_isempty(&mq->parent.suspend_thread))
-    {
-        rt_susp_list_dequeue(&(mq->parent.suspend_thread), RT_EOK);
+        /* has waiting time, start thread timer */
+        if (timeout > 0)
+        {
+            /* get the start tick of timer */
+            tick_delta = rt_tick_get();
 
-        rt_spin_unlock_irqrestore(&(mq->spinlock), level);
+            LOG_D("set thread:%s to timer list",
+                  thread->parent.name);
 
+            /* reset the timeout of thread timer and start it */
+            rt_timer_control(&(thread->thread_timer),
+                             RT_TIMER_CTRL_SET_TIME,
+                             &timeout);
+            rt_timer_start(&(thread->thread_timer));
+        }
+
+        rt_spin_unlock_irqrestore(&(mq->spinlock), level);
+
+        /* re-schedule */
         rt_schedule();
 
-        return RT_EOK;
+        /* recv message */
+        if (thread->error != RT_EOK)
+        {
+            /* return error */
+            *err = thread->error;
+            return RT_NULL;
+        }
+
+        level = rt_spin_lock_irqsave(&(mq->spinlock));
+
+        /* if it's not waiting forever and then re-calculate timeout tick */
+        if (timeout > 0)
+        {
+            tick_delta = rt_tick_get() - tick_delta;
+            timeout -= tick_delta;
+            if (timeout < 0)
+                timeout = 0;
+        }
     }
 
+    /* get messages from queue */
+    head = (struct rt_mq_message *)mq->msg_queue_head;
+    msg = head;
+    for (n = 1; n < *count && n < mq->entry; n ++)
+        msg = msg->next;
+
+    /* move message queue head */
+    mq->msg_queue_head = msg->next;
+    /* reach queue tail, set to NULL */
+    if (mq->msg_queue_tail == msg)
+        mq->msg_queue_tail = RT_NULL;
+    msg->next = RT_NULL;
+
+    /* decrease message entry */
+    mq->entry -= n;
+
     rt_spin_unlock_irqrestore(&(mq->spinlock), level);
 
-    return RT_EOK;
+    *count = n;
+    return head;
 }
-RTM_EXPORT(rt_mq_urgent);
 
 /**
- * @brief    This function will receive a message from message queue object,
- *           if there is no message in messagequeue object, the thread shall wait for a specified time.
+ * @brief    Put message nodes back to the free list of the messagequeue and
+ *           resume the sending threads if any.
  *
- * @note     Only when there is mail in the mailbox, the receiving thread can get the mail immediately and return RT_EOK,
- *           otherwise the receiving thread will be suspended until timeout.
- *           If the mail is not received within the specified time, it will return -RT_ETIMEOUT.
+ * @param    mq is a pointer to the messagequeue object.
  *
- * @param    mq is a pointer to the messagequeue object to be received.
+ * @param    msg is the chain of message nodes to be freed.
  *
- * @param    buffer is the content of the message.
+ * @param    count is the number of nodes in the chain.
  *
- * @param    prio is message priority, A larger value indicates a higher priority
+ * @return   Return RT_TRUE if a sending thread is resumed and a schedule is required.
+ */
+static rt_bool_t _mq_put_free_msg(rt_mq_t mq, struct rt_mq_message *msg, rt_size_t count)
+{
+    rt_base_t level;
+    rt_bool_t need_schedule;
+    struct rt_mq_message *tail;
+
+    for (tail = msg; tail->next != RT_NULL; tail = tail->next);
+
+    level = rt_spin_lock_irqsave(&(mq->spinlock));
+    /* put messages to free list */
+    tail->next = (struct rt_mq_message *)mq->msg_queue_free;
+    mq->msg_queue_free = msg;
+
+    /* resume one suspended thread for each free node */
+    need_schedule = _ipc_list_resume_n(&(mq->suspend_sender_thread), count);
+
+    rt_spin_unlock_irqrestore(&(mq->spinlock), level);
+
+    return need_schedule;
+}
+
+/**
+ * @brief    This function will send a message to the messagequeue object. If
+ *           there is a thread suspended on the messagequeue, the thread will be
+ *           resumed.
+ *
+ * @note     When using this function to send a message, if the messagequeue is
+ *           fully used, the current thread will wait for a timeout. If reaching
+ *           the timeout and there is still no space available, the sending
+ *           thread will be resumed and an error code will be returned. By
+ *           contrast, the _rt_mq_send_wait() function will return an error code
+ *           immediately without waiting when the messagequeue if fully used.
+ *
+ * @see      _rt_mq_send_wait()
+ *
+ * @param    mq is a pointer to the messagequeue object to be sent.
+ *
+ * @param    buffer is the content of the message.
  *
  * @param    size is the length of the message(Unit: Byte).
  *
- * @param    timeout is a timeout period (unit: an OS tick). If the message is unavailable, the thread will wait for
- *           the message in the queue up to the amount of time specified by this parameter.
+ * @param    prio is message priority, A larger value indicates a higher priority
+ *
+ * @param    timeout is a timeout period (unit: an OS tick).
  *
  * @param    suspend_flag status flag of the thread to be suspended.
  *
- *           NOTE:
- *           If use Macro RT_WAITING_FOREVER to set this parameter, which means that when the
- *           message is unavailable in the queue, the thread will be waiting forever.
- *           If use macro RT_WAITING_NO to set this parameter, which means that this
- *           function is non-blocking and will return immediately.
+ * @return   Return the operation status. When the return value is RT_EOK, the
+ *           operation is successful. If the return value is any other values,
+ *           it means that the messagequeue detach failed.
  *
- * @return   Return the real length of the message. When the return value is larger than zero, the operation is successful.
- *           If the return value is any other values, it means that the mailbox release failed.
+ * @warning  This function can be called in interrupt context and thread
+ * context.
  */
-static rt_ssize_t _rt_mq_recv(rt_mq_t mq,
-                              void *buffer,
-                              rt_size_t size,
-                              rt_int32_t *prio,
-                              rt_int32_t timeout,
-                              int suspend_flag)
+static rt_err_t _rt_mq_send_wait(rt_mq_t mq,
+                                 const void *buffer,
+                                 rt_size_t size,
+                                 rt_int32_t prio,
+                                 rt_int32_t timeout,
+                                 int suspend_flag)
 {
-    struct rt_thread *thread;
-    rt_base_t level;
     struct rt_mq_message *msg;
-    rt_uint32_t tick_delta;
     rt_err_t ret;
-    rt_size_t len;
-
-    RT_UNUSED(prio);
+    rt_size_t count = 1;
 
     /* parameter check */
     RT_ASSERT(mq != RT_NULL);
@@ -3772,104 +4217,194 @@ static rt_ssize_t _rt_mq_recv(rt_mq_t mq,
     /* current context checking */
     RT_DEBUG_SCHEDULER_AVAILABLE(timeout != 0);
 
-    /* initialize delta tick */
-    tick_delta = 0;
-    /* get current thread */
-    thread = rt_thread_self();
-    RT_OBJECT_HOOK_CALL(rt_object_trytake_hook, (&(mq->parent.parent)));
+    /* greater than one message size */
+    if (size > mq->msg_size)
+        return -RT_ERROR;
 
-    level = rt_spin_lock_irqsave(&(mq->spinlock));
+    RT_OBJECT_HOOK_CALL(rt_object_put_hook, (&(mq->parent.parent)));
 
-    /* for non-blocking call */
-    if (mq->entry == 0 && timeout == 0)
-    {
-        rt_spin_unlock_irqrestore(&(mq->spinlock), level);
+    msg = _mq_get_free_msg(mq, &count, timeout, suspend_flag, &ret);
+    if (msg == RT_NULL)
+        return ret;
 
-        return -RT_ETIMEOUT;
-    }
+    /* copy buffer */
+    rt_memcpy(GET_MESSAGEBYTE_ADDR(msg), buffer, size);
 
-    /* message queue is empty */
-    while (mq->entry == 0)
-    {
-        /* reset error number in thread */
-        thread->error = -RT_EINTR;
+    return _mq_enqueue_msg(mq, msg, 1, size, prio, RT_FALSE);
+}
 
-        /* no waiting, return timeout */
-        if (timeout == 0)
-        {
-            /* enable interrupt */
-            rt_spin_unlock_irqrestore(&(mq->spinlock), level);
+rt_err_t rt_mq_send_wait(rt_mq_t     mq,
+                         const void *buffer,
+                         rt_size_t   size,
+                         rt_int32_t  timeout)
+{
+    return _rt_mq_send_wait(mq, buffer, size, 0, timeout, RT_UNINTERRUPTIBLE);
+}
+RTM_EXPORT(rt_mq_send_wait);
 
-            thread->error = -RT_ETIMEOUT;
+rt_err_t rt_mq_send_wait_interruptible(rt_mq_t     mq,
+                         const void *buffer,
+                         rt_size_t   size,
+                         rt_int32_t  timeout)
+{
+    return _rt_mq_send_wait(mq, buffer, size, 0, timeout, RT_INTERRUPTIBLE);
+}
+RTM_EXPORT(rt_mq_send_wait_interruptible);
 
-            return -RT_ETIMEOUT;
-        }
+rt_err_t rt_mq_send_wait_killable(rt_mq_t     mq,
+                         const void *buffer,
+                         rt_size_t   size,
+                         rt_int32_t  timeout)
+{
+    return _rt_mq_send_wait(mq, buffer, size, 0, timeout, RT_KILLABLE);
+}
+RTM_EXPORT(rt_mq_send_wait_killable);
+/**
+ * @brief    This function will send a message to the messagequeue object.
+ *           If there is a thread suspended on the messagequeue, the thread will be resumed.
+ *
+ * @note     When using this function to send a message, if the messagequeue is fully used,
+ *           the current thread will wait for a timeout.
+ *           By contrast, when the messagequeue is fully used, the rt_mq_send_wait() function will
+ *           return an error code immediately without waiting.
+ *
+ * @see      rt_mq_send_wait()
+ *
+ * @param    mq is a pointer to the messagequeue object to be sent.
+ *
+ * @param    buffer is the content of the message.
+ *
+ * @param    size is the length of the message(Unit: Byte).
+ *
+ * @return   Return the operation status. When the return value is RT_EOK, the operation is successful.
+ *           If the return value is any other values, it means that the messagequeue detach failed.
+ *
+ * @warning  This function can be called in interrupt context and thread context.
+ */
+rt_err_t rt_mq_send(rt_mq_t mq, const void *buffer, rt_size_t size)
+{
+    return rt_mq_send_wait(mq, buffer, size, 0);
+}
+RTM_EXPORT(rt_mq_send);
 
-        /* suspend current thread */
-        ret = rt_thread_suspend_to_list(thread, &(mq->parent.suspend_thread),
-                                        mq->parent.parent.flag, suspend_flag);
-        if (ret != RT_EOK)
-        {
-            rt_spin_unlock_irqrestore(&(mq->spinlock), level);
-            return ret;
-        }
+rt_err_t rt_mq_send_interruptible(rt_mq_t mq, const void *buffer, rt_size_t size)
+{
+    return rt_mq_send_wait_interruptible(mq, buffer, size, 0);
+}
+RTM_EXPORT(rt_mq_send_interruptible);
 
-        /* has waiting time, start thread timer */
-        if (timeout > 0)
-        {
-            /* get the start tick of timer */
-            tick_delta = rt_tick_get();
+rt_err_t rt_mq_send_killable(rt_mq_t mq, const void *buffer, rt_size_t size)
+{
+    return rt_mq_send_wait_killable(mq, buffer, size, 0);
+}
+RTM_EXPORT(rt_mq_send_killable);
+/**
+ * @brief    This function will send an urgent message to the messagequeue object.
+ *
+ * @note     This function is almost the same as the rt_mq_send() function. The only difference is that
+ *           when sending an urgent message, the message is placed at the head of the messagequeue so that
+ *           the recipient can receive the urgent message first.
+ *
+ * @see      rt_mq_send()
+ *
+ * @param    mq is a pointer to the messagequeue object to be sent.
+ *
+ * @param    buffer is the content of the message.
+ *
+ * @param    size is the length of the message(Unit: Byte).
+ *
+ * @return   Return the operation status. When the return value is RT_EOK, the operation is successful.
+ *           If the return value is any other values, it means that the mailbox detach failed.
+ */
+rt_err_t rt_mq_urgent(rt_mq_t mq, const void *buffer, rt_size_t size)
+{
+    struct rt_mq_message *msg;
+    rt_err_t ret;
+    rt_size_t count = 1;
 
-            LOG_D("set thread:%s to timer list",
-                  thread->parent.name);
+    /* parameter check */
+    RT_ASSERT(mq != RT_NULL);
+    RT_ASSERT(rt_object_get_type(&mq->parent.parent) == RT_Object_Class_MessageQueue);
+    RT_ASSERT(buffer != RT_NULL);
+    RT_ASSERT(size != 0);
 
-            /* reset the timeout of thread timer and start it */
-            rt_timer_control(&(thread->thread_timer),
-                             RT_TIMER_CTRL_SET_TIME,
-                             &timeout);
-            rt_timer_start(&(thread->thread_timer));
-        }
+    /* greater than one message size */
+    if (size > mq->msg_size)
+        return -RT_ERROR;
 
-        rt_spin_unlock_irqrestore(&(mq->spinlock), level);
+    RT_OBJECT_HOOK_CALL(rt_object_put_hook, (&(mq->parent.parent)));
 
-        /* re-schedule */
-        rt_schedule();
+    /* urgent message never waits for a free slot */
+    msg = _mq_get_free_msg(mq, &count, RT_WAITING_NO, RT_UNINTERRUPTIBLE, &ret);
+    if (msg == RT_NULL)
+        return ret;
 
-        /* recv message */
-        if (thread->error != RT_EOK)
-        {
-            /* return error */
-            return thread->error;
-        }
+    /* copy buffer */
+    rt_memcpy(GET_MESSAGEBYTE_ADDR(msg), buffer, size);
 
-        level = rt_spin_lock_irqsave(&(mq->spinlock));
+    return _mq_enqueue_msg(mq, msg, 1, size, 0, RT_TRUE);
+}
+RTM_EXPORT(rt_mq_urgent);
+
+/**
+ * @brief    This function will receive a message from message queue object,
+ *           if there is no message in messagequeue object, the thread shall wait for a specified time.
+ *
+ * @note     Only when there is mail in the mailbox, the receiving thread can get the mail immediately and return RT_EOK,
+ *           otherwise the receiving thread will be suspended until timeout.
+ *           If the mail is not received within the specified time, it will return -RT_ETIMEOUT.
+ *
+ * @param    mq is a pointer to the messagequeue object to be received.
+ *
+ * @param    buffer is the content of the message.
+ *
+ * @param    prio is message priority, A larger value indicates a higher priority
+ *
+ * @param    size is the length of the message(Unit: Byte).
+ *
+ * @param    timeout is a timeout period (unit: an OS tick). If the message is unavailable, the thread will wait for
+ *           the message in the queue up to the amount of time specified by this parameter.
+ *
+ * @param    suspend_flag status flag of the thread to be suspended.
+ *
+ *           NOTE:
+ *           If use Macro RT_WAITING_FOREVER to set this parameter, which means that when the
+ *           message is unavailable in the queue, the thread will be waiting forever.
+ *           If use macro RT_WAITING_NO to set this parameter, which means that this
+ *           function is non-blocking and will return immediately.
+ *
+ * @return   Return the real length of the message. When the return value is larger than zero, the operation is successful.
+ *           If the return value is any other values, it means that the mailbox release failed.
+ */
+static rt_ssize_t _rt_mq_recv(rt_mq_t mq,
+                              void *buffer,
+                              rt_size_t size,
+                              rt_int32_t *prio,
+                              rt_int32_t timeout,
+                              int suspend_flag)
+{
+    struct rt_mq_message *msg;
+    rt_err_t ret;
+    rt_size_t count = 1;
+    rt_size_t len;
+    rt_bool_t need_schedule;
 
-        /* if it's not waiting forever and then re-calculate timeout tick */
-        if (timeout > 0)
-        {
-            tick_delta = rt_tick_get() - tick_delta;
-            timeout -= tick_delta;
-            if (timeout < 0)
-                timeout = 0;
-        }
-    }
+    RT_UNUSED(prio);
 
-    /* get message from queue */
-    msg = (struct rt_mq_message *)mq->msg_queue_head;
+    /* parameter check */
+    RT_ASSERT(mq != RT_NULL);
+    RT_ASSERT(rt_object_get_type(&mq->parent.parent) == RT_Object_Class_MessageQueue);
+    RT_ASSERT(buffer != RT_NULL);
+    RT_ASSERT(size != 0);
 
-    /* move message queue head */
-    mq->msg_queue_head = msg->next;
-    /* reach queue tail, set to NULL */
-    if (mq->msg_queue_tail == msg)
-        mq->msg_queue_tail = RT_NULL;
+    /* current context checking */
+    RT_DEBUG_SCHEDULER_AVAILABLE(timeout != 0);
 
-    /* decrease message entry */
-    if(mq->entry > 0)
-    {
-        mq->entry --;
-    }
+    RT_OBJECT_HOOK_CALL(rt_object_trytake_hook, (&(mq->parent.parent)));
 
-    rt_spin_unlock_irqrestore(&(mq->spinlock), level);
+    msg = _mq_dequeue_msg(mq, &count, timeout, suspend_flag, &ret);
+    if (msg == RT_NULL)
+        return ret;
 
     /* get real message length */
     len = ((struct rt_mq_message *)msg)->length;
@@ -3883,29 +4418,13 @@ static rt_ssize_t _rt_mq_recv(rt_mq_t mq,
     if (prio != RT_NULL)
         *prio = msg->prio;
 #endif
-    level = rt_spin_lock_irqsave(&(mq->spinlock));
-    /* put message to free list */
-    msg->next = (struct rt_mq_message *)mq->msg_queue_free;
-    mq->msg_queue_free = msg;
-
-    /* resume suspended thread */
-    if (!rt_list_isempty(&(mq->suspend_sender_thread)))
-    {
-        rt_susp_list_dequeue(&(mq->suspend_sender_thread), RT_EOK);
-
-        rt_spin_unlock_irqrestore(&(mq->spinlock), level);
+    need_schedule = _mq_put_free_msg(mq, msg, 1);
 
-        RT_OBJECT_HOOK_CALL(rt_object_take_hook, (&(mq->parent.parent)));
+    RT_OBJECT_HOOK_CALL(rt_object_take_hook, (&(mq->parent.parent)));
 
+    if (need_schedule)
         rt_schedule();
 
-        return len;
-    }
-
-    rt_spin_unlock_irqrestore(&(mq->spinlock), level);
-
-    RT_OBJECT_HOOK_CALL(rt_object_take_hook, (&(mq->parent.parent)));
-
     return len;
 }
 
@@ -3955,6 +4474,343 @@ rt_ssize_t rt_mq_recv_prio(rt_mq_t mq,
 }
 #endif
 RTM_EXPORT(rt_mq_recv_killable);
+
+/**
+ * @brief    This function will send a batch of messages to the messagequeue object.
+ *           The free slots are taken and the messages are linked under one lock
+ *           acquisition each, and the scheduler is invoked only once.
+ *
+ * @note     If the messagequeue is fully used, the current thread will wait for a
+ *           free slot up to timeout, then as many messages as there are free slots
+ *           are sent. A short count is not an error.
+ *
+ * @param    mq is a pointer to the messagequeue object to be sent.
+ *
+ * @param    buffer is the content of the messages, stored back to back.
+ *
+ * @param    size is the length of each message(Unit: Byte).
+ *
+ * @param    count is the number of messages in buffer.
+ *
+ * @param    timeout is a timeout period (unit: an OS tick).
+ *
+ * @return   Return the number of messages sent, or a negative error code if
+ *           nothing was sent.
+ *
+ * @warning  This function can be called in interrupt context only with RT_WAITING_NO.
+ */
+rt_ssize_t rt_mq_send_batch(rt_mq_t mq,
+                            const void *buffer,
+                            rt_size_t size,
+                            rt_size_t count,
+                            rt_int32_t timeout)
+{
+    struct rt_mq_message *head, *msg;
+    const rt_uint8_t *ptr;
+    rt_err_t ret;
+
+    /* parameter check */
+    RT_ASSERT(mq != RT_NULL);
+    RT_ASSERT(rt_object_get_type(&mq->parent.parent) == RT_Object_Class_MessageQueue);
+    RT_ASSERT(buffer != RT_NULL);
+    RT_ASSERT(size != 0);
+    RT_ASSERT(count != 0);
+
+    /* current context checking */
+    RT_DEBUG_SCHEDULER_AVAILABLE(timeout != 0);
+
+    /* greater than one message size */
+    if (size > mq->msg_size)
+        return -RT_ERROR;
+
+    RT_OBJECT_HOOK_CALL(rt_object_put_hook, (&(mq->parent.parent)));
+
+    head = _mq_get_free_msg(mq, &count, timeout, RT_UNINTERRUPTIBLE, &ret);
+    if (head == RT_NULL)
+        return ret;
+
+    /* copy buffers */
+    ptr = (const rt_uint8_t *)buffer;
+    for (msg = head; msg != RT_NULL; msg = msg->next)
+    {
+        rt_memcpy(GET_MESSAGEBYTE_ADDR(msg), ptr, size);
+        ptr += size;
+    }
+
+    ret = _mq_enqueue_msg(mq, head, count, size, 0, RT_FALSE);
+    if (ret != RT_EOK)
+        return ret;
+
+    return count;
+}
+RTM_EXPORT(rt_mq_send_batch);
+
+/**
+ * @brief    This function will receive a batch of messages from the messagequeue
+ *           object. The messages are taken and their slots are freed under one lock
+ *           acquisition each, and the scheduler is invoked only once.
+ *
+ * @note     If the messagequeue is empty, the current thread will wait for a message
+ *           up to timeout, then all available messages, up to count, are received.
+ *
+ * @param    mq is a pointer to the messagequeue object to be received.
+ *
+ * @param    buffer is the buffer to store the messages, each one in a size bytes slot.
+ *
+ * @param    size is the size of each slot in buffer(Unit: Byte). Longer messages are
+ *           truncated.
+ *
+ * @param    lengths is the array to store the length of each message. It can be RT_NULL.
+ *
+ * @param    count is the number of slots in buffer.
+ *
+ * @param    timeout is a timeout period (unit: an OS tick).
+ *
+ * @return   Return the number of messages received, or a negative error code if
+ *           nothing was received.
+ */
+rt_ssize_t rt_mq_recv_batch(rt_mq_t mq,
+                            void *buffer,
+                            rt_size_t size,
+                            rt_size_t *lengths,
+                            rt_size_t count,
+                            rt_int32_t timeout)
+{
+    struct rt_mq_message *head, *msg;
+    rt_uint8_t *ptr;
+    rt_size_t len;
+    rt_bool_t need_schedule;
+    rt_err_t ret;
+
+    /* parameter check */
+    RT_ASSERT(mq != RT_NULL);
+    RT_ASSERT(rt_object_get_type(&mq->parent.parent) == RT_Object_Class_MessageQueue);
+    RT_ASSERT(buffer != RT_NULL);
+    RT_ASSERT(size != 0);
+    RT_ASSERT(count != 0);
+
+    /* current context checking */
+    RT_DEBUG_SCHEDULER_AVAILABLE(timeout != 0);
+
+    RT_OBJECT_HOOK_CALL(rt_object_trytake_hook, (&(mq->parent.parent)));
+
+    head = _mq_dequeue_msg(mq, &count, timeout, RT_UNINTERRUPTIBLE, &ret);
+    if (head == RT_NULL)
+        return ret;
+
+    /* copy messages */
+    ptr = (rt_uint8_t *)buffer;
+    for (msg = head; msg != RT_NULL; msg = msg->next)
+    {
+        len = msg->length;
+        if (len > size)
+            len = size;
+        rt_memcpy(ptr, GET_MESSAGEBYTE_ADDR(msg), len);
+        ptr += size;
+
+        if (lengths != RT_NULL)
+            *lengths ++ = len;
+    }
+
+    need_schedule = _mq_put_free_msg(mq, head, count);
+
+    RT_OBJECT_HOOK_CALL(rt_object_take_hook, (&(mq->parent.parent)));
+
+    if (need_schedule)
+        rt_schedule();
+
+    return count;
+}
+RTM_EXPORT(rt_mq_recv_batch);
+#ifdef RT_USING_MESSAGEQUEUE_ZEROCOPY
+/**
+ * @brief    Get the message node owning a payload buffer handed out by
+ *           rt_mq_reserve() or rt_mq_borrow().
+ */
+rt_inline struct rt_mq_message *_mq_buffer_to_msg(rt_mq_t mq, void *buffer)
+{
+    struct rt_mq_message *msg;
+    rt_size_t slot_size;
+
+    msg = (struct rt_mq_message *)buffer - 1;
+    slot_size = RT_ALIGN(mq->msg_size, RT_ALIGN_SIZE) + sizeof(struct rt_mq_message);
+
+    /* the buffer must be the payload of one slot in the message pool */
+    RT_ASSERT((rt_uint8_t *)msg >= (rt_uint8_t *)mq->msg_pool);
+    RT_ASSERT((rt_uint8_t *)msg < (rt_uint8_t *)mq->msg_pool + slot_size * mq->max_msgs);
+    RT_ASSERT(((rt_uint8_t *)msg - (rt_uint8_t *)mq->msg_pool) % slot_size == 0);
+    RT_UNUSED(slot_size);
+
+    /* a slot lent out is always a single node */
+    msg->next = RT_NULL;
+
+    return msg;
+}
+
+/**
+ * @brief    This function will reserve a free message slot in the messagequeue
+ *           object, so that the sender can build the message in place.
+ *
+ * @note     The slot returned must be handed back either by rt_mq_commit() or
+ *           rt_mq_commit_urgent() to send it, or by rt_mq_release() to cancel it.
+ *           The size of the slot is the msg_size of the messagequeue.
+ *
+ * @param    mq is a pointer to the messagequeue object to be sent.
+ *
+ * @param    timeout is a timeout period (unit: an OS tick). If the messagequeue is
+ *           fully used, the thread will wait for a free slot up to the amount of
+ *           time specified by this parameter.
+ *
+ * @return   Return the payload address of the reserved slot. RT_NULL means the
+ *           reservation failed.
+ *
+ * @warning  This function can be called in interrupt context only with RT_WAITING_NO.
+ */
+void *rt_mq_reserve(rt_mq_t mq, rt_int32_t timeout)
+{
+    struct rt_mq_message *msg;
+    rt_err_t ret;
+    rt_size_t count = 1;
+
+    /* parameter check */
+    RT_ASSERT(mq != RT_NULL);
+    RT_ASSERT(rt_object_get_type(&mq->parent.parent) == RT_Object_Class_MessageQueue);
+
+    /* current context checking */
+    RT_DEBUG_SCHEDULER_AVAILABLE(timeout != 0);
+
+    RT_OBJECT_HOOK_CALL(rt_object_put_hook, (&(mq->parent.parent)));
+
+    msg = _mq_get_free_msg(mq, &count, timeout, RT_UNINTERRUPTIBLE, &ret);
+    if (msg == RT_NULL)
+        return RT_NULL;
+
+    return GET_MESSAGEBYTE_ADDR(msg);
+}
+RTM_EXPORT(rt_mq_reserve);
+
+/**
+ * @brief    This function will send a message slot reserved by rt_mq_reserve()
+ *           to the messagequeue object without copying it.
+ *
+ * @param    mq is a pointer to the messagequeue object to be sent.
+ *
+ * @param    buffer is the slot returned by rt_mq_reserve().
+ *
+ * @param    size is the length of the message(Unit: Byte).
+ *
+ * @return   Return the operation status. When the return value is RT_EOK, the operation is successful.
+ *           If the return value is any other values, it means that the message was not sent and
+ *           the slot is still owned by the caller.
+ */
+rt_err_t rt_mq_commit(rt_mq_t mq, void *buffer, rt_size_t size)
+{
+    /* parameter check */
+    RT_ASSERT(mq != RT_NULL);
+    RT_ASSERT(rt_object_get_type(&mq->parent.parent) == RT_Object_Class_MessageQueue);
+    RT_ASSERT(buffer != RT_NULL);
+    RT_ASSERT(size != 0);
+
+    /* greater than one message size */
+    if (size > mq->msg_size)
+        return -RT_ERROR;
+
+    return _mq_enqueue_msg(mq, _mq_buffer_to_msg(mq, buffer), 1, size, 0, RT_FALSE);
+}
+RTM_EXPORT(rt_mq_commit);
+
+/**
+ * @brief    This function will send a message slot reserved by rt_mq_reserve()
+ *           to the head of the messagequeue object, as rt_mq_urgent() does.
+ *
+ * @see      rt_mq_commit()
+ */
+rt_err_t rt_mq_commit_urgent(rt_mq_t mq, void *buffer, rt_size_t size)
+{
+    /* parameter check */
+    RT_ASSERT(mq != RT_NULL);
+    RT_ASSERT(rt_object_get_type(&mq->parent.parent) == RT_Object_Class_MessageQueue);
+    RT_ASSERT(buffer != RT_NULL);
+    RT_ASSERT(size != 0);
+
+    /* greater than one message size */
+    if (size > mq->msg_size)
+        return -RT_ERROR;
+
+    return _mq_enqueue_msg(mq, _mq_buffer_to_msg(mq, buffer), 1, size, 0, RT_TRUE);
+}
+RTM_EXPORT(rt_mq_commit_urgent);
+
+/**
+ * @brief    This function will take the message at the head of the messagequeue
+ *           object and lend its slot to the caller without copying it.
+ *
+ * @note     The slot stays out of the messagequeue until it is given back by
+ *           rt_mq_release(). Senders waiting for a free slot are not resumed
+ *           before that.
+ *
+ * @param    mq is a pointer to the messagequeue object to be received.
+ *
+ * @param    buffer is a pointer to store the payload address of the message.
+ *
+ * @param    timeout is a timeout period (unit: an OS tick).
+ *
+ * @return   Return the real length of the message. When the return value is larger than zero,
+ *           the operation is successful. Otherwise it is a negative error code.
+ */
+rt_ssize_t rt_mq_borrow(rt_mq_t mq, void **buffer, rt_int32_t timeout)
+{
+    struct rt_mq_message *msg;
+    rt_err_t ret;
+    rt_size_t count = 1;
+
+    /* parameter check */
+    RT_ASSERT(mq != RT_NULL);
+    RT_ASSERT(rt_object_get_type(&mq->parent.parent) == RT_Object_Class_MessageQueue);
+    RT_ASSERT(buffer != RT_NULL);
+
+    /* current context checking */
+    RT_DEBUG_SCHEDULER_AVAILABLE(timeout != 0);
+
+    RT_OBJECT_HOOK_CALL(rt_object_trytake_hook, (&(mq->parent.parent)));
+
+    msg = _mq_dequeue_msg(mq, &count, timeout, RT_UNINTERRUPTIBLE, &ret);
+    if (msg == RT_NULL)
+        return ret;
+
+    *buffer = GET_MESSAGEBYTE_ADDR(msg);
+
+    RT_OBJECT_HOOK_CALL(rt_object_take_hook, (&(mq->parent.parent)));
+
+    return msg->length;
+}
+RTM_EXPORT(rt_mq_borrow);
+
+/**
+ * @brief    This function will give a slot got by rt_mq_borrow() or
+ *           rt_mq_reserve() back to the messagequeue object. If there is a
+ *           thread waiting for a free slot, the thread will be resumed.
+ *
+ * @param    mq is a pointer to the messagequeue object.
+ *
+ * @param    buffer is the slot to be released.
+ *
+ * @return   Return the operation status. When the return value is RT_EOK, the operation is successful.
+ */
+rt_err_t rt_mq_release(rt_mq_t mq, void *buffer)
+{
+    /* parameter check */
+    RT_ASSERT(mq != RT_NULL);
+    RT_ASSERT(rt_object_get_type(&mq->parent.parent) == RT_Object_Class_MessageQueue);
+    RT_ASSERT(buffer != RT_NULL);
+
+    if (_mq_put_free_msg(mq, _mq_buffer_to_msg(mq, buffer), 1))
+        rt_schedule();
+
+    return RT_EOK;
+}
+RTM_EXPORT(rt_mq_release);
+#endif /* RT_USING_MESSAGEQUEUE_ZEROCOPY */
 /**
  * @brief    This function will set some extra attributions of a messagequeue object.
  *
@@ -758,12 +758,23 @@ rt_inline void _slab_info(rt_size_t *total,
 }
 #define _MEM_INIT(_name, _start, _size) \
     system_heap = rt_slab_init(_name, _start, _size)
+#ifdef RT_SLAB_USING_MAGAZINE
+#define _MEM_CACHE_MALLOC(_size)    \
+    rt_slab_magazine_alloc(system_heap, _size)
+#define _MEM_CACHE_FREE(_ptr)   \
+    rt_slab_magazine_free(system_heap, _ptr)
+#define _MEM_MALLOC(_size)  \
+    rt_slab_magazine_refill(system_heap, _size)
+#define _MEM_FREE(_ptr) \
+    rt_slab_magazine_drain(system_heap, _ptr)
+#else
 #define _MEM_MALLOC(_size)  \
     rt_slab_alloc(system_heap, _size)
-#define _MEM_REALLOC(_ptr, _newsize)    \
-    rt_slab_realloc(system_heap, _ptr, _newsize)
 #define _MEM_FREE(_ptr) \
     rt_slab_free(system_heap, _ptr)
+#endif /* RT_SLAB_USING_MAGAZINE */
+#define _MEM_REALLOC(_ptr, _newsize)    \
+    rt_slab_realloc(system_heap, _ptr, _newsize)
 #define _MEM_INFO       _slab_info
 #else
 #define _MEM_INIT(...)
@@ -773,6 +784,12 @@ rt_inline void _slab_info(rt_size_t *total,
 #define _MEM_INFO(...)
 #endif
 
+/* lock-free per-CPU cache tried before taking the heap lock */
+#ifndef _MEM_CACHE_MALLOC
+#define _MEM_CACHE_MALLOC(...)  RT_NULL
+#define _MEM_CACHE_FREE(...)    (-RT_EFULL)
+#endif /* _MEM_CACHE_MALLOC */
+
 static void _rt_system_heap_init(void *begin_addr, void *end_addr)
 {
     rt_ubase_t begin_align = RT_ALIGN((rt_ubase_t)begin_addr, RT_ALIGN_SIZE);
@@ -810,12 +827,16 @@ rt_weak void *rt_malloc(rt_size_t size)
     rt_base_t level;
     void *ptr;
 
-    /* Enter critical zone */
-    level = _heap_lock();
-    /* allocate memory block from system heap */
-    ptr = _MEM_MALLOC(size);
-    /* Exit critical zone */
-    _heap_unlock(level);
+    ptr = _MEM_CACHE_MALLOC(size);
+    if (ptr == RT_NULL)
+    {
+        /* Enter critical zone */
+        level = _heap_lock();
+        /* allocate memory block from system heap */
+        ptr = _MEM_MALLOC(size);
+        /* Exit critical zone */
+        _heap_unlock(level);
+    }
     /* call 'rt_malloc' hook */
     RT_OBJECT_HOOK_CALL(rt_malloc_hook, (&ptr, size));
     return ptr;
@@ -892,6 +913,7 @@ rt_weak void rt_free(void *ptr)
     RT_OBJECT_HOOK_CALL(rt_free_hook, (&ptr));
     /* NULL check */
     if (ptr == RT_NULL) return;
+    if (_MEM_CACHE_FREE(ptr) == RT_EOK) return;
     /* Enter critical zone */
     level = _heap_lock();
     _MEM_FREE(ptr);
@@ -144,6 +144,54 @@ static struct rt_object_information _object_container[RT_Object_Info_Unknown] =
 #endif
 };
 
+#ifdef RT_USING_OBJECT_HASH
+/* the bucket of a name, only the first RT_NAME_MAX characters are significant */
+rt_inline rt_uint32_t _object_name_hash(const char *name)
+{
+    rt_uint32_t hash = 0;
+    int index;
+
+    for (index = 0; index < RT_NAME_MAX && name[index] != '\0'; index ++)
+    {
+        hash = hash * 31 + (rt_uint8_t)name[index];
+    }
+
+    return hash & (RT_OBJECT_HASH_SIZE - 1);
+}
+
+/* the caller shall hold the spinlock of the container */
+static void _object_hash_insert(struct rt_object_information *information, struct rt_object *object)
+{
+    rt_uint32_t bucket = _object_name_hash(object->name);
+
+    object->hash_next = information->name_hash[bucket];
+    information->name_hash[bucket] = object;
+    information->generation ++;
+}
+
+/* the caller shall hold the spinlock of the container */
+static rt_bool_t _object_hash_remove(struct rt_object_information *information, struct rt_object *object)
+{
+    struct rt_object **pprev;
+
+    pprev = &(information->name_hash[_object_name_hash(object->name)]);
+    for (; *pprev != RT_NULL; pprev = &((*pprev)->hash_next))
+    {
+        if (*pprev == object)
+        {
+            *pprev = object->hash_next;
+            object->hash_next = RT_NULL;
+            information->generation ++;
+
+            return RT_TRUE;
+        }
+    }
+
+    /* the object of a module is not in the container */
+    return RT_FALSE;
+}
+#endif /* RT_USING_OBJECT_HASH */
+
 #if defined(RT_USING_HOOK) && defined(RT_HOOK_USING_FUNC_PTR)
 static void (*rt_object_attach_hook)(struct rt_object *object);
 static void (*rt_object_detach_hook)(struct rt_object *object);
@@ -401,6 +449,9 @@ void rt_object_init(struct rt_object         *object,
     {
         /* insert object into information object list */
         rt_list_insert_after(&(information->object_list), &(object->list));
+#ifdef RT_USING_OBJECT_HASH
+        _object_hash_insert(information, object);
+#endif /* RT_USING_OBJECT_HASH */
     }
     rt_spin_unlock_irqrestore(&(information->spinlock), level);
 }
@@ -427,6 +478,9 @@ void rt_object_detach(rt_object_t object)
     level = rt_spin_lock_irqsave(&(information->spinlock));
     /* remove from old list */
     rt_list_remove(&(object->list));
+#ifdef RT_USING_OBJECT_HASH
+    _object_hash_remove(information, object);
+#endif /* RT_USING_OBJECT_HASH */
     rt_spin_unlock_irqrestore(&(information->spinlock), level);
 
     object->type = 0;
@@ -496,6 +550,9 @@ rt_object_t rt_object_allocate(enum rt_object_class_type type, const char *name)
     {
         /* insert object into information object list */
         rt_list_insert_after(&(information->object_list), &(object->list));
+#ifdef RT_USING_OBJECT_HASH
+        _object_hash_insert(information, object);
+#endif /* RT_USING_OBJECT_HASH */
     }
     rt_spin_unlock_irqrestore(&(information->spinlock), level);
 
@@ -526,6 +583,9 @@ void rt_object_delete(rt_object_t object)
 
     /* remove from old list */
     rt_list_remove(&(object->list));
+#ifdef RT_USING_OBJECT_HASH
+    _object_hash_remove(information, object);
+#endif /* RT_USING_OBJECT_HASH */
 
     rt_spin_unlock_irqrestore(&(information->spinlock), level);
 
@@ -605,6 +665,22 @@ rt_object_t rt_object_find(const char *name, rt_uint8_t type)
     /* enter critical */
     level = rt_spin_lock_irqsave(&(information->spinlock));
 
+#ifdef RT_USING_OBJECT_HASH
+    RT_UNUSED(node);
+
+    /* only walk the objects with the same name hash */
+    for (object = information->name_hash[_object_name_hash(name)];
+         object != RT_NULL;
+         object = object->hash_next)
+    {
+        if (rt_strncmp(object->name, name, RT_NAME_MAX) == 0)
+        {
+            rt_spin_unlock_irqrestore(&(information->spinlock), level);
+
+            return object;
+        }
+    }
+#else
     /* try to find object */
     rt_list_for_each(node, &(information->object_list))
     {
@@ -616,6 +692,7 @@ rt_object_t rt_object_find(const char *name, rt_uint8_t type)
             return object;
         }
     }
+#endif /* RT_USING_OBJECT_HASH */
 
     rt_spin_unlock_irqrestore(&(information->spinlock), level);
 
@@ -646,6 +723,155 @@ rt_err_t rt_object_get_name(rt_object_t object, char *name, rt_uint8_t name_size
     return result;
 }
 
+/**
+ * @brief This function will change the name of an object. The name of an
+ *        object in object container shall only be changed by this function,
+ *        so it can still be found by rt_object_find().
+ *
+ * @param object    the specified object to be renamed
+ * @param name      the new name of the object
+ */
+void rt_object_set_name(rt_object_t object, const char *name)
+{
+    struct rt_object_information *information;
+    rt_base_t level;
+#ifdef RT_USING_OBJECT_HASH
+    rt_bool_t hashed;
+#endif /* RT_USING_OBJECT_HASH */
+
+    /* parameter check */
+    RT_ASSERT(object != RT_NULL);
+    RT_ASSERT(name != RT_NULL);
+
+    information = rt_object_get_information((enum rt_object_class_type)object->type);
+    RT_ASSERT(information != RT_NULL);
+
+    level = rt_spin_lock_irqsave(&(information->spinlock));
+#ifdef RT_USING_OBJECT_HASH
+    hashed = _object_hash_remove(information, object);
+#endif /* RT_USING_OBJECT_HASH */
+
+#if RT_NAME_MAX > 0
+    rt_strncpy(object->name, name, RT_NAME_MAX - 1);
+    object->name[RT_NAME_MAX - 1] = '\0';
+#else
+    object->name = name;
+#endif /* RT_NAME_MAX > 0 */
+
+#ifdef RT_USING_OBJECT_HASH
+    if (hashed)
+        _object_hash_insert(information, object);
+#endif /* RT_USING_OBJECT_HASH */
+    rt_spin_unlock_irqrestore(&(information->spinlock), level);
+}
+
+#ifdef RT_USING_OBJECT_HASH
+/**
+ * @brief This function will initialize an iterator to walk the object
+ *        container of the specified type with rt_object_iter_next().
+ *
+ * @param iter is the iterator to be initialized.
+ *
+ * @param type is the type of object, which can be
+ *             RT_Object_Class_Thread/Semaphore/Mutex... etc
+ *
+ * @return -RT_EINVAL if the type is unknown, otherwise RT_EOK.
+ */
+rt_err_t rt_object_iter_init(struct rt_object_iter *iter, enum rt_object_class_type type)
+{
+    RT_ASSERT(iter != RT_NULL);
+
+    iter->information = rt_object_get_information(type);
+    iter->node = RT_NULL;
+    iter->bucket = 0;
+    iter->generation = 0;
+
+    return iter->information ? RT_EOK : -RT_EINVAL;
+}
+RTM_EXPORT(rt_object_iter_init);
+
+/**
+ * @brief This function will copy the next batch of object pointers of the
+ *        container walked by the iterator. The spinlock of the container is
+ *        only held while copying one batch.
+ *
+ * @note  If the container has changed since the last batch, the walk goes on
+ *        after the last object returned as long as it is still in the
+ *        container. Otherwise the iterator is rewound and -RT_EBUSY is
+ *        returned, so the caller can restart its walk.
+ *
+ * @param iter is the iterator initialized by rt_object_iter_init().
+ *
+ * @param pointers is the pointer will be saved to.
+ *
+ * @param maxlen is the maximum number of pointers can be saved.
+ *
+ * @return the copied number of object pointers, 0 at the end of the container,
+ *         or -RT_EBUSY if the walk shall be restarted.
+ */
+int rt_object_iter_next(struct rt_object_iter *iter, rt_object_t *pointers, int maxlen)
+{
+    int index = 0;
+    rt_base_t level;
+    struct rt_object *object;
+    struct rt_list_node *node;
+    struct rt_object_information *information;
+
+    RT_ASSERT(iter != RT_NULL);
+
+    information = iter->information;
+    if ((information == RT_NULL) || (maxlen <= 0)) return 0;
+
+    level = rt_spin_lock_irqsave(&(information->spinlock));
+
+    if (iter->node == RT_NULL)
+    {
+        node = information->object_list.next;
+    }
+    else
+    {
+        if (iter->generation != information->generation)
+        {
+            /* the last object is still in the container if it is in its bucket */
+            for (object = information->name_hash[iter->bucket];
+                 object != RT_NULL;
+                 object = object->hash_next)
+            {
+                if (&(object->list) == iter->node) break;
+            }
+
+            if (object == RT_NULL)
+            {
+                rt_spin_unlock_irqrestore(&(information->spinlock), level);
+
+                iter->node = RT_NULL;
+                return -RT_EBUSY;
+            }
+        }
+
+        node = iter->node->next;
+    }
+
+    /* retrieve pointer of object */
+    for (; (node != &(information->object_list)) && (index < maxlen); node = node->next)
+    {
+        object = rt_list_entry(node, struct rt_object, list);
+
+        pointers[index] = object;
+        index ++;
+
+        iter->node = node;
+        iter->bucket = _object_name_hash(object->name);
+    }
+    iter->generation = information->generation;
+
+    rt_spin_unlock_irqrestore(&(information->spinlock), level);
+
+    return index;
+}
+RTM_EXPORT(rt_object_iter_next);
+#endif /* RT_USING_OBJECT_HASH */
+
 #ifdef RT_USING_HEAP
 /**
  * This function will create a custom object
@@ -16,6 +16,24 @@
 
 #include <rtthread.h>
 
+#if defined(RT_USING_HOOK) && defined(RT_HOOK_USING_FUNC_PTR)
+void (*rt_scheduler_wakeup_hook)(struct rt_thread *thread);
+
+/**
+ * @brief This function will set a hook function, which will be invoked when a
+ *        suspended thread is made ready, either resumed or timed out.
+ *
+ * @note  The hook function is called with the scheduler lock held. It must be
+ *        simple and never be blocked or suspend.
+ *
+ * @param hook is the hook function.
+ */
+void rt_scheduler_wakeup_sethook(void (*hook)(struct rt_thread *thread))
+{
+    rt_scheduler_wakeup_hook = hook;
+}
+#endif /* RT_USING_HOOK */
+
 void rt_sched_thread_init_ctx(struct rt_thread *thread, rt_uint32_t tick, rt_uint8_t priority)
 {
     /* setup thread status */
@@ -138,6 +156,8 @@ rt_err_t rt_sched_thread_ready(struct rt_thread *thread)
 
             /* insert to schedule ready list and remove from susp list */
             rt_sched_insert_thread(thread);
+
+            RT_OBJECT_HOOK_CALL(rt_scheduler_wakeup_hook, (thread));
         }
     }
 
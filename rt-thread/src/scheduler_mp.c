@@ -42,7 +42,9 @@
 #define DBG_LVL           DBG_INFO
 #include <rtdbg.h>
 
+#ifndef RT_SCHED_USING_PCPU_QUEUE
 rt_list_t rt_thread_priority_table[RT_THREAD_PRIORITY_MAX];
+#endif /* RT_SCHED_USING_PCPU_QUEUE */
 static struct rt_spinlock _mp_scheduler_lock;
 
 #define SCHEDULER_LOCK_FLAG(percpu) ((percpu)->sched_lock_flag)
@@ -99,11 +101,13 @@ static struct rt_spinlock _mp_scheduler_lock;
         rt_hw_local_irq_enable(level);     \
     } while (0)
 
+#ifndef RT_SCHED_USING_PCPU_QUEUE
 static rt_uint32_t rt_thread_ready_priority_group;
 #if RT_THREAD_PRIORITY_MAX > 32
 /* Maximum priority level, 256 */
 static rt_uint8_t rt_thread_ready_table[32];
 #endif /* RT_THREAD_PRIORITY_MAX > 32 */
+#endif /* RT_SCHED_USING_PCPU_QUEUE */
 
 /**
  * Used only on scheduler for optimization of control flows, where the critical
@@ -164,6 +168,7 @@ void rt_scheduler_switch_sethook(void (*hook)(struct rt_thread *tid))
 
 #if RT_THREAD_PRIORITY_MAX > 32
 
+#ifndef RT_SCHED_USING_PCPU_QUEUE
 rt_inline rt_base_t _get_global_highest_ready_prio(void)
 {
     rt_ubase_t number;
@@ -180,6 +185,7 @@ rt_inline rt_base_t _get_global_highest_ready_prio(void)
     }
     return highest_ready_priority;
 }
+#endif /* RT_SCHED_USING_PCPU_QUEUE */
 
 rt_inline rt_base_t _get_local_highest_ready_prio(struct rt_cpu* pcpu)
 {
@@ -200,10 +206,12 @@ rt_inline rt_base_t _get_local_highest_ready_prio(struct rt_cpu* pcpu)
 
 #else /* if RT_THREAD_PRIORITY_MAX <= 32 */
 
+#ifndef RT_SCHED_USING_PCPU_QUEUE
 rt_inline rt_base_t _get_global_highest_ready_prio(void)
 {
     return __rt_ffs(rt_thread_ready_priority_group) - 1;
 }
+#endif /* RT_SCHED_USING_PCPU_QUEUE */
 
 rt_inline rt_base_t _get_local_highest_ready_prio(struct rt_cpu* pcpu)
 {
@@ -212,6 +220,293 @@ rt_inline rt_base_t _get_local_highest_ready_prio(struct rt_cpu* pcpu)
 
 #endif /* RT_THREAD_PRIORITY_MAX > 32 */
 
+#ifdef RT_SCHED_USING_PCPU_QUEUE
+
+/**
+ * Priority of the work running on pcpu. A core whose current thread is no
+ * longer RUNNING is about to reschedule, so it's taken as free.
+ */
+rt_inline rt_base_t _get_running_prio(struct rt_cpu *pcpu)
+{
+    struct rt_thread *current_thread = pcpu->current_thread;
+
+    if (current_thread &&
+        (RT_SCHED_CTX(current_thread).stat & RT_THREAD_STAT_MASK) == RT_THREAD_RUNNING)
+    {
+        return RT_SCHED_PRIV(current_thread).current_priority;
+    }
+    return RT_THREAD_PRIORITY_MAX;
+}
+
+/* the highest priority pcpu is going to run, RT_THREAD_PRIORITY_MAX for none */
+rt_inline rt_base_t _get_top_prio(struct rt_cpu *pcpu)
+{
+    rt_base_t running_priority = _get_running_prio(pcpu);
+    rt_base_t ready_priority = _get_local_highest_ready_prio(pcpu);
+
+    if (ready_priority != -1 && ready_priority < running_priority)
+    {
+        return ready_priority;
+    }
+    return running_priority;
+}
+
+/*
+ * get the highest priority thread in ready queue
+ */
+static struct rt_thread* _scheduler_get_highest_priority_thread(rt_ubase_t *highest_prio)
+{
+    struct rt_thread *highest_priority_thread;
+    rt_base_t local_highest_ready_priority;
+    struct rt_cpu* pcpu = rt_cpu_self();
+
+    local_highest_ready_priority = _get_local_highest_ready_prio(pcpu);
+
+    *highest_prio = local_highest_ready_priority;
+    if (local_highest_ready_priority != -1)
+    {
+        highest_priority_thread = RT_THREAD_LIST_NODE_ENTRY(
+            pcpu->priority_table[local_highest_ready_priority].next);
+    }
+    else
+    {
+        highest_priority_thread = RT_NULL;
+    }
+
+    RT_ASSERT(!highest_priority_thread ||
+              rt_object_get_type(&highest_priority_thread->parent) == RT_Object_Class_Thread);
+    return highest_priority_thread;
+}
+
+static void _pcpu_enqueue_locked(int cpu, struct rt_thread *thread)
+{
+    struct rt_cpu *pcpu = rt_cpu_index(cpu);
+
+#if RT_THREAD_PRIORITY_MAX > 32
+    pcpu->ready_table[RT_SCHED_PRIV(thread).number] |= RT_SCHED_PRIV(thread).high_mask;
+#endif /* RT_THREAD_PRIORITY_MAX > 32 */
+    pcpu->priority_group |= RT_SCHED_PRIV(thread).number_mask;
+
+    /* there is no time slices left(YIELD), inserting thread before ready list*/
+    if((RT_SCHED_CTX(thread).stat & RT_THREAD_STAT_YIELD_MASK) != 0)
+    {
+        rt_list_insert_before(&(pcpu->priority_table[RT_SCHED_PRIV(thread).current_priority]),
+                              &RT_THREAD_LIST_NODE(thread));
+    }
+    /* there are some time slices left, inserting thread after ready list to schedule it firstly at next time*/
+    else
+    {
+        rt_list_insert_after(&(pcpu->priority_table[RT_SCHED_PRIV(thread).current_priority]),
+                             &RT_THREAD_LIST_NODE(thread));
+    }
+
+    RT_SCHED_CTX(thread).queue_cpu = cpu;
+    if (RT_SCHED_CTX(thread).bind_cpu == RT_CPUS_NR)
+    {
+        pcpu->stealable_nr++;
+    }
+}
+
+static void _pcpu_dequeue_locked(struct rt_thread *thread)
+{
+    struct rt_cpu *pcpu = rt_cpu_index(RT_SCHED_CTX(thread).queue_cpu);
+
+    rt_list_remove(&RT_THREAD_LIST_NODE(thread));
+
+    if (rt_list_isempty(&(pcpu->priority_table[RT_SCHED_PRIV(thread).current_priority])))
+    {
+#if RT_THREAD_PRIORITY_MAX > 32
+        pcpu->ready_table[RT_SCHED_PRIV(thread).number] &= ~RT_SCHED_PRIV(thread).high_mask;
+        if (pcpu->ready_table[RT_SCHED_PRIV(thread).number] == 0)
+        {
+            pcpu->priority_group &= ~RT_SCHED_PRIV(thread).number_mask;
+        }
+#else
+        pcpu->priority_group &= ~RT_SCHED_PRIV(thread).number_mask;
+#endif /* RT_THREAD_PRIORITY_MAX > 32 */
+    }
+
+    if (RT_SCHED_CTX(thread).bind_cpu == RT_CPUS_NR)
+    {
+        RT_ASSERT(pcpu->stealable_nr > 0);
+        pcpu->stealable_nr--;
+    }
+}
+
+/**
+ * Pick a core for an unbound thread. The core it was queued on last time is
+ * preferred if the thread can run there at once, since its cache is still
+ * warm. Otherwise the core running the least important work is chosen.
+ */
+static int _pcpu_select_cpu_locked(struct rt_thread *thread, int cpu_id)
+{
+    int cpu;
+    int target;
+    rt_base_t top_priority, lowest_priority;
+
+    target = RT_SCHED_CTX(thread).queue_cpu;
+    if (target >= RT_CPUS_NR)
+    {
+        target = cpu_id;
+    }
+
+    lowest_priority = _get_top_prio(rt_cpu_index(target));
+    if (RT_SCHED_PRIV(thread).current_priority < lowest_priority)
+    {
+        return target;
+    }
+
+    for (cpu = 0; cpu < RT_CPUS_NR; cpu++)
+    {
+        top_priority = _get_top_prio(rt_cpu_index(cpu));
+        if (top_priority > lowest_priority)
+        {
+            lowest_priority = top_priority;
+            target = cpu;
+        }
+    }
+
+    return target;
+}
+
+/**
+ * @brief   set READY and insert thread to ready queue
+ *
+ * @note    caller must holding the `_mp_scheduler_lock` lock
+ */
+static void _sched_insert_thread_locked(struct rt_thread *thread)
+{
+    int cpu_id;
+    int target_cpu;
+    rt_base_t top_priority;
+
+    if ((RT_SCHED_CTX(thread).stat & RT_THREAD_STAT_MASK) == RT_THREAD_READY)
+    {
+        /* already in ready queue */
+        return ;
+    }
+    else if (RT_SCHED_CTX(thread).oncpu != RT_CPU_DETACHED)
+    {
+        /**
+         * only YIELD -> READY, SUSPEND -> READY is allowed by this API. However,
+         * this is a RUNNING thread. So here we reset it's status and let it go.
+         */
+        RT_SCHED_CTX(thread).stat = RT_THREAD_RUNNING | (RT_SCHED_CTX(thread).stat & ~RT_THREAD_STAT_MASK);
+        return ;
+    }
+
+    /* READY thread, insert to ready queue */
+    RT_SCHED_CTX(thread).stat = RT_THREAD_READY | (RT_SCHED_CTX(thread).stat & ~RT_THREAD_STAT_MASK);
+
+    cpu_id = rt_hw_cpu_id();
+    if (RT_SCHED_CTX(thread).bind_cpu == RT_CPUS_NR)
+    {
+        target_cpu = _pcpu_select_cpu_locked(thread, cpu_id);
+    }
+    else
+    {
+        target_cpu = RT_SCHED_CTX(thread).bind_cpu;
+    }
+
+    top_priority = _get_top_prio(rt_cpu_index(target_cpu));
+    _pcpu_enqueue_locked(target_cpu, thread);
+
+    /* only bother the remote core if its highest priority is changed */
+    if (target_cpu != cpu_id && RT_SCHED_PRIV(thread).current_priority < top_priority)
+    {
+        rt_hw_ipi_send(RT_SCHEDULE_IPI, 1U << target_cpu);
+    }
+
+    LOG_D("insert thread[%.*s] to cpu#%d, the priority: %d",
+          RT_NAME_MAX, thread->parent.name, target_cpu,
+          RT_SCHED_PRIV(thread).current_priority);
+}
+
+/* remove thread from ready queue */
+static void _sched_remove_thread_locked(struct rt_thread *thread)
+{
+    LOG_D("%s [%.*s], the priority: %d", __func__,
+          RT_NAME_MAX, thread->parent.name,
+          RT_SCHED_PRIV(thread).current_priority);
+
+    /* only a READY thread is in a ready queue, a picked one was dequeued already */
+    if ((RT_SCHED_CTX(thread).stat & RT_THREAD_STAT_MASK) == RT_THREAD_READY)
+    {
+        _pcpu_dequeue_locked(thread);
+    }
+    else
+    {
+        rt_list_remove(&RT_THREAD_LIST_NODE(thread));
+    }
+}
+
+/**
+ * Whether nothing but the idle thread is left to run on this core. A user
+ * thread running on the lowest priority is not taken as idle.
+ */
+rt_inline rt_bool_t _pcpu_is_idle_locked(struct rt_cpu *pcpu, struct rt_thread *current_thread)
+{
+    rt_base_t ready_priority = _get_local_highest_ready_prio(pcpu);
+
+    if (ready_priority != -1 && ready_priority < RT_THREAD_PRIORITY_MAX - 1)
+    {
+        return RT_FALSE;
+    }
+
+    return current_thread == pcpu->idle_thread ||
+           _get_running_prio(pcpu) == RT_THREAD_PRIORITY_MAX;
+}
+
+/**
+ * Pull the highest priority unbound thread from the ready queue of the busiest
+ * peer to the local ready queue.
+ */
+static void _pcpu_steal_locked(int cpu_id)
+{
+    int cpu;
+    int busiest = -1;
+    rt_uint32_t nr = 0;
+    rt_base_t priority;
+    rt_list_t *node;
+    struct rt_cpu *victim;
+    struct rt_thread *thread;
+
+    for (cpu = 0; cpu < RT_CPUS_NR; cpu++)
+    {
+        if (cpu != cpu_id && rt_cpu_index(cpu)->stealable_nr > nr)
+        {
+            nr = rt_cpu_index(cpu)->stealable_nr;
+            busiest = cpu;
+        }
+    }
+
+    if (busiest == -1)
+    {
+        return ;
+    }
+
+    victim = rt_cpu_index(busiest);
+    for (priority = _get_local_highest_ready_prio(victim);
+         priority < RT_THREAD_PRIORITY_MAX; priority++)
+    {
+        rt_list_for_each(node, &victim->priority_table[priority])
+        {
+            thread = RT_THREAD_LIST_NODE_ENTRY(node);
+            if (RT_SCHED_CTX(thread).bind_cpu == RT_CPUS_NR)
+            {
+                LOG_D("cpu#%d steal thread[%.*s] from cpu#%d", cpu_id,
+                      RT_NAME_MAX, thread->parent.name, busiest);
+
+                _pcpu_dequeue_locked(thread);
+                _pcpu_enqueue_locked(cpu_id, thread);
+                return ;
+            }
+        }
+    }
+}
+
+#else /* !RT_SCHED_USING_PCPU_QUEUE */
+
 /*
  * get the highest priority thread in ready queue
  */
@@ -384,6 +679,8 @@ static void _sched_remove_thread_locked(struct rt_thread *thread)
     }
 }
 
+#endif /* RT_SCHED_USING_PCPU_QUEUE */
+
 /**
  * @brief This function will initialize the system scheduler.
  */
@@ -397,10 +694,12 @@ void rt_system_scheduler_init(void)
 
     rt_spin_lock_init(&_mp_scheduler_lock);
 
+#ifndef RT_SCHED_USING_PCPU_QUEUE
     for (offset = 0; offset < RT_THREAD_PRIORITY_MAX; offset ++)
     {
         rt_list_init(&rt_thread_priority_table[offset]);
     }
+#endif /* RT_SCHED_USING_PCPU_QUEUE */
 
     for (cpu = 0; cpu < RT_CPUS_NR; cpu++)
     {
@@ -419,11 +718,16 @@ void rt_system_scheduler_init(void)
         rt_memset(pcpu->ready_table, 0, sizeof(pcpu->ready_table));
 #endif /* RT_THREAD_PRIORITY_MAX > 32 */
 
+#ifdef RT_SCHED_USING_PCPU_QUEUE
+        pcpu->stealable_nr = 0;
+#endif /* RT_SCHED_USING_PCPU_QUEUE */
+
 #ifdef RT_USING_SMART
         rt_spin_lock_init(&(pcpu->spinlock));
 #endif
     }
 
+#ifndef RT_SCHED_USING_PCPU_QUEUE
     /* initialize ready priority group */
     rt_thread_ready_priority_group = 0;
 
@@ -431,6 +735,7 @@ void rt_system_scheduler_init(void)
     /* initialize ready table */
     rt_memset(rt_thread_ready_table, 0, sizeof(rt_thread_ready_table));
 #endif /* RT_THREAD_PRIORITY_MAX > 32 */
+#endif /* RT_SCHED_USING_PCPU_QUEUE */
 }
 
 /**
@@ -565,8 +870,19 @@ static rt_thread_t _prepare_context_switch_locked(int cpu_id,
     rt_thread_t to_thread = RT_NULL;
     rt_ubase_t highest_ready_priority;
 
+#ifdef RT_SCHED_USING_PCPU_QUEUE
+    /* nothing but idle is left to run here, pull work from the busiest peer */
+    if (_pcpu_is_idle_locked(pcpu, current_thread))
+    {
+        _pcpu_steal_locked(cpu_id);
+    }
+
+    /* quickly check if any other ready threads queuing */
+    if (pcpu->priority_group != 0)
+#else
     /* quickly check if any other ready threads queuing */
     if (rt_thread_ready_priority_group != 0 || pcpu->priority_group != 0)
+#endif /* RT_SCHED_USING_PCPU_QUEUE */
     {
         /* pick the highest ready thread */
         to_thread = _scheduler_get_highest_priority_thread(&highest_ready_priority);
@@ -1015,6 +1331,11 @@ void rt_sched_thread_init_priv(struct rt_thread *thread, rt_uint32_t tick, rt_ui
     RT_SCHED_CTX(thread).critical_lock_nest = 0;
 #endif /* RT_USING_SMP */
 
+#ifdef RT_SCHED_USING_PCPU_QUEUE
+    /* never queued on any cpu */
+    RT_SCHED_CTX(thread).queue_cpu = RT_CPUS_NR;
+#endif /* RT_SCHED_USING_PCPU_QUEUE */
+
 }
 
 /* Normally, there isn't anyone racing with us so this operation is lockless */
@@ -1227,6 +1548,7 @@ rt_err_t rt_sched_thread_bind_cpu(struct rt_thread *thread, int cpu)
         rt_sched_remove_thread(thread);
         /* change thread bind cpu */
         RT_SCHED_CTX(thread).bind_cpu = cpu;
+        RT_SCHED_CTX(thread).stat = RT_THREAD_INIT;
         /* add to new ready queue */
         rt_sched_insert_thread(thread);
 
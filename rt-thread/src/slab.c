@@ -188,6 +188,30 @@ struct rt_slab_page
 
 #define RT_SLAB_NZONES                  72              /* number of zones */
 
+#ifdef RT_SLAB_USING_MAGAZINE
+#ifdef RT_USING_SMP
+#define SLAB_MAGAZINE_CPUS              RT_CPUS_NR
+#else
+#define SLAB_MAGAZINE_CPUS              1
+#endif /* RT_USING_SMP */
+
+#define SLAB_MAGAZINE_BATCH             (RT_SLAB_MAGAZINE_SIZE / 2)
+
+/*
+ * per-CPU object cache of one zone. It's only touched by the owner cpu with
+ * local interrupt disabled, so no lock is required.
+ */
+struct rt_slab_magazine
+{
+    rt_uint32_t                 rounds;                         /**< number of cached objects */
+    rt_uint32_t                 alloc_hit;
+    rt_uint32_t                 alloc_miss;
+    rt_uint32_t                 free_hit;
+    rt_uint32_t                 free_miss;
+    void                       *objs[RT_SLAB_MAGAZINE_SIZE];
+};
+#endif /* RT_SLAB_USING_MAGAZINE */
+
 /*
  * slab object
  */
@@ -204,6 +228,9 @@ struct rt_slab
     rt_uint32_t                 zone_limit;
     rt_uint32_t                 zone_page_cnt;
     struct rt_slab_page        *page_list;
+#ifdef RT_SLAB_USING_MAGAZINE
+    struct rt_slab_magazine     magazine[SLAB_MAGAZINE_CPUS][RT_SLAB_MAGAZINE_NZONES];
+#endif /* RT_SLAB_USING_MAGAZINE */
 };
 
 /**
@@ -853,4 +880,278 @@ void rt_slab_free(rt_slab_t m, void *ptr)
 }
 RTM_EXPORT(rt_slab_free);
 
+#ifdef RT_SLAB_USING_MAGAZINE
+/*
+ * Get the magazine of zone on current cpu, local interrupt must be disabled.
+ */
+rt_inline struct rt_slab_magazine *_slab_magazine(struct rt_slab *slab, int zi)
+{
+#ifdef RT_USING_SMP
+    return &slab->magazine[rt_hw_cpu_id()][zi];
+#else
+    return &slab->magazine[0][zi];
+#endif /* RT_USING_SMP */
+}
+
+/*
+ * Get the zone index of an allocation size, or -1 if it has no magazine.
+ */
+rt_inline int _slab_magazine_zi_size(struct rt_slab *slab, rt_size_t size)
+{
+    int zi;
+
+    if (size == 0 || size >= slab->zone_limit)
+        return -1;
+
+    zi = zoneindex(&size);
+    return zi < RT_SLAB_MAGAZINE_NZONES ? zi : -1;
+}
+
+/*
+ * Get the zone index of an allocated block, or -1 if it has no magazine.
+ * The zone header is stable because the block is still allocated.
+ */
+rt_inline int _slab_magazine_zi_ptr(struct rt_slab *slab, void *ptr)
+{
+    struct rt_slab_zone *z;
+    struct rt_slab_memusage *kup;
+
+    if ((rt_ubase_t)ptr < slab->heap_start || (rt_ubase_t)ptr >= slab->heap_end)
+        return -1;
+
+    kup = btokup((rt_ubase_t)ptr & ~RT_MM_PAGE_MASK);
+    if (kup->type != PAGE_TYPE_SMALL)
+        return -1;
+
+    z = (struct rt_slab_zone *)(((rt_ubase_t)ptr & ~RT_MM_PAGE_MASK) -
+                      kup->size * RT_MM_PAGE_SIZE);
+    RT_ASSERT(z->z_magic == ZALLOC_SLAB_MAGIC);
+
+    return z->z_zoneindex < RT_SLAB_MAGAZINE_NZONES ? (int)z->z_zoneindex : -1;
+}
+
+/**
+ * @brief This function will allocate a block from the magazine of current cpu.
+ *        It doesn't require the lock of slab object.
+ *
+ * @param m the slab memory management object.
+ *
+ * @param size is the size of memory to be allocated.
+ *
+ * @return the allocated memory, RT_NULL if the magazine is empty or the size
+ *         is not cached. Then rt_slab_magazine_refill() should be called with
+ *         the lock of slab object held.
+ */
+void *rt_slab_magazine_alloc(rt_slab_t m, rt_size_t size)
+{
+    int zi;
+    void *ptr = RT_NULL;
+    rt_base_t level;
+    struct rt_slab_magazine *mag;
+    struct rt_slab *slab = (struct rt_slab *)m;
+
+    zi = _slab_magazine_zi_size(slab, size);
+    if (zi < 0)
+        return RT_NULL;
+
+    level = rt_hw_local_irq_disable();
+    mag = _slab_magazine(slab, zi);
+    if (mag->rounds > 0)
+    {
+        ptr = mag->objs[--mag->rounds];
+        mag->alloc_hit++;
+    }
+    rt_hw_local_irq_enable(level);
+
+    return ptr;
+}
+RTM_EXPORT(rt_slab_magazine_alloc);
+
+/**
+ * @brief This function will release a block to the magazine of current cpu.
+ *        It doesn't require the lock of slab object.
+ *
+ * @param m the slab memory management object.
+ *
+ * @param ptr is the address of memory which will be released.
+ *
+ * @return RT_EOK on success, -RT_EFULL if the magazine is full or the block
+ *         is not cached. Then rt_slab_magazine_drain() should be called with
+ *         the lock of slab object held.
+ */
+rt_err_t rt_slab_magazine_free(rt_slab_t m, void *ptr)
+{
+    int zi;
+    rt_err_t err = -RT_EFULL;
+    rt_base_t level;
+    struct rt_slab_magazine *mag;
+    struct rt_slab *slab = (struct rt_slab *)m;
+
+    zi = _slab_magazine_zi_ptr(slab, ptr);
+    if (zi < 0)
+        return -RT_EFULL;
+
+    level = rt_hw_local_irq_disable();
+    mag = _slab_magazine(slab, zi);
+    if (mag->rounds < RT_SLAB_MAGAZINE_SIZE)
+    {
+        mag->objs[mag->rounds++] = ptr;
+        mag->free_hit++;
+        err = RT_EOK;
+    }
+    rt_hw_local_irq_enable(level);
+
+    return err;
+}
+RTM_EXPORT(rt_slab_magazine_free);
+
+/**
+ * @brief This function will allocate a block from slab object, and refill the
+ *        magazine of current cpu with a batch of blocks of the same zone.
+ *
+ * @note The lock of slab object must be held by the caller.
+ *
+ * @param m the slab memory management object.
+ *
+ * @param size is the size of memory to be allocated.
+ *
+ * @return the allocated memory.
+ */
+void *rt_slab_magazine_refill(rt_slab_t m, rt_size_t size)
+{
+    int zi, n;
+    void *ptr;
+    void *batch[SLAB_MAGAZINE_BATCH];
+    rt_base_t level;
+    struct rt_slab_magazine *mag;
+    struct rt_slab *slab = (struct rt_slab *)m;
+
+    ptr = rt_slab_alloc(m, size);
+    zi = _slab_magazine_zi_size(slab, size);
+    if (ptr == RT_NULL || zi < 0)
+        return ptr;
+
+    for (n = 0; n < SLAB_MAGAZINE_BATCH; n++)
+    {
+        batch[n] = rt_slab_alloc(m, size);
+        if (batch[n] == RT_NULL)
+            break;
+    }
+
+    level = rt_hw_local_irq_disable();
+    mag = _slab_magazine(slab, zi);
+    mag->alloc_miss++;
+    while (n > 0 && mag->rounds < RT_SLAB_MAGAZINE_SIZE)
+        mag->objs[mag->rounds++] = batch[--n];
+    rt_hw_local_irq_enable(level);
+
+    /* the thread may have been migrated to a cpu with a fuller magazine */
+    while (n > 0)
+        rt_slab_free(m, batch[--n]);
+
+    return ptr;
+}
+RTM_EXPORT(rt_slab_magazine_refill);
+
+/**
+ * @brief This function will release a block to slab object, and drain half of
+ *        the magazine of current cpu back to the zone.
+ *
+ * @note The lock of slab object must be held by the caller.
+ *
+ * @param m the slab memory management object.
+ *
+ * @param ptr is the address of memory which will be released.
+ */
+void rt_slab_magazine_drain(rt_slab_t m, void *ptr)
+{
+    int zi, n = 0;
+    void *batch[SLAB_MAGAZINE_BATCH];
+    rt_base_t level;
+    struct rt_slab_magazine *mag;
+    struct rt_slab *slab = (struct rt_slab *)m;
+
+    zi = _slab_magazine_zi_ptr(slab, ptr);
+    if (zi >= 0)
+    {
+        level = rt_hw_local_irq_disable();
+        mag = _slab_magazine(slab, zi);
+        mag->free_miss++;
+        while (mag->rounds > RT_SLAB_MAGAZINE_SIZE - SLAB_MAGAZINE_BATCH)
+            batch[n++] = mag->objs[--mag->rounds];
+        mag->objs[mag->rounds++] = ptr;
+        rt_hw_local_irq_enable(level);
+
+        ptr = RT_NULL;
+    }
+
+    while (n > 0)
+        rt_slab_free(m, batch[--n]);
+    rt_slab_free(m, ptr);
+}
+RTM_EXPORT(rt_slab_magazine_drain);
+
+#ifdef RT_USING_FINSH
+/*
+ * Get the chunk size of a zone, the reverse of zoneindex().
+ */
+static rt_size_t _zone_chunksize(int zi)
+{
+    int group;
+
+    if (zi < 15)
+        return (zi + 1) * 8;
+
+    group = (zi - 15) / 8;
+    return (16 << group) * (zi - 7 - 8 * group);
+}
+
+static int list_slab_magazine(int argc, char **argv)
+{
+    int zi, cpu;
+    struct rt_object_information *info;
+    struct rt_list_node *node;
+    struct rt_slab *slab;
+
+    info = rt_object_get_information(RT_Object_Class_Memory);
+    for (node = info->object_list.next; node != &info->object_list; node = node->next)
+    {
+        slab = (struct rt_slab *)rt_list_entry(node, struct rt_object, list);
+        if (rt_strcmp(slab->parent.algorithm, "slab") != 0)
+            continue;
+
+        rt_kprintf("slab %.*s magazine:\n", RT_NAME_MAX, slab->parent.parent.name);
+        rt_kprintf("zone chunk  cached alloc hit  alloc miss free hit   free miss\n");
+        rt_kprintf("---- ----- ------ ---------- ---------- ---------- ----------\n");
+        for (zi = 0; zi < RT_SLAB_MAGAZINE_NZONES; zi++)
+        {
+            rt_uint32_t rounds = 0, alloc_hit = 0, alloc_miss = 0;
+            rt_uint32_t free_hit = 0, free_miss = 0;
+
+            for (cpu = 0; cpu < SLAB_MAGAZINE_CPUS; cpu++)
+            {
+                struct rt_slab_magazine *mag = &slab->magazine[cpu][zi];
+
+                rounds     += mag->rounds;
+                alloc_hit  += mag->alloc_hit;
+                alloc_miss += mag->alloc_miss;
+                free_hit   += mag->free_hit;
+                free_miss  += mag->free_miss;
+            }
+
+            if (alloc_hit + alloc_miss + free_hit + free_miss == 0)
+                continue;
+
+            rt_kprintf("%4d %5d %6d %10u %10u %10u %10u\n", zi, (int)_zone_chunksize(zi),
+                       (int)rounds, alloc_hit, alloc_miss, free_hit, free_miss);
+        }
+    }
+
+    return 0;
+}
+#include <finsh.h>
+MSH_CMD_EXPORT(list_slab_magazine, list per-zone hit and miss of slab magazines);
+#endif /* RT_USING_FINSH */
+#endif /* RT_SLAB_USING_MAGAZINE */
+
 #endif /* RT_USING_SLAB */
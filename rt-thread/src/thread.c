@@ -140,6 +140,9 @@ static void _thread_timeout(void *parameter)
     rt_list_remove(&RT_THREAD_LIST_NODE(thread));
     /* insert to schedule ready list */
     rt_sched_insert_thread(thread);
+
+    RT_OBJECT_HOOK_CALL(rt_scheduler_wakeup_hook, (thread));
+
     /* do schedule and release the scheduler lock */
     rt_sched_unlock_n_resched(slvl);
 }
@@ -30,9 +30,50 @@
 #define DBG_LVL           DBG_INFO
 #include <rtdbg.h>
 
+#ifdef RT_TIMER_USING_WHEEL
+
+#ifdef RT_USING_SMP
+#define _TIMER_WHEEL_NR         RT_CPUS_NR
+#define _TIMER_WHEEL_CPU_ID()   rt_hw_cpu_id()
+#ifdef RT_USING_TICKLESS
+/* the cpu of a wheel may be idle with its tick stopped till the earliest timer */
+#define _TIMER_WHEEL_KICK_REMOTE
+#endif /* RT_USING_TICKLESS */
+#else
+#define _TIMER_WHEEL_NR         1
+#define _TIMER_WHEEL_CPU_ID()   0
+#endif /* RT_USING_SMP */
+
+/* 32 slots in each level, so the slot bitmap of one level fits in a word */
+#define RT_TIMER_WHEEL_BITS     5
+#define RT_TIMER_WHEEL_SIZE     (1U << RT_TIMER_WHEEL_BITS)
+#define RT_TIMER_WHEEL_MASK     (RT_TIMER_WHEEL_SIZE - 1)
+/* enough levels to cover the whole range of rt_tick_t */
+#define RT_TIMER_WHEEL_LEVEL    ((sizeof(rt_tick_t) * 8 + RT_TIMER_WHEEL_BITS - 1) / RT_TIMER_WHEEL_BITS)
+
+/**
+ * Hashed hierarchical timing wheel. A timer is hashed to the slot of level 0
+ * when it expires within 32 ticks, to the slot of level 1 within 1024 ticks
+ * and so on. The slot of an upper level is cascaded to the lower levels when
+ * all the lower levels wrap around.
+ */
+struct rt_timer_wheel
+{
+    struct rt_spinlock  lock;
+    rt_tick_t           clk;                            /**< next tick to be processed */
+    rt_uint32_t         bitmap[RT_TIMER_WHEEL_LEVEL];   /**< slots that may be non-empty */
+    rt_list_t           slot[RT_TIMER_WHEEL_LEVEL][RT_TIMER_WHEEL_SIZE];
+};
+
+/* hard timer wheel of each cpu */
+static struct rt_timer_wheel _timer_wheel[_TIMER_WHEEL_NR];
+
+#else
+
 /* hard timer list */
 static rt_list_t _timer_list[RT_TIMER_SKIP_LIST_LEVEL];
 static struct rt_spinlock _htimer_lock;
+#endif /* RT_TIMER_USING_WHEEL */
 
 #ifdef RT_USING_TIMER_SOFT
 
@@ -44,9 +85,14 @@ static struct rt_spinlock _htimer_lock;
 #define RT_TIMER_THREAD_PRIO           0
 #endif /* RT_TIMER_THREAD_PRIO */
 
+#ifdef RT_TIMER_USING_WHEEL
+/* soft timer wheel */
+static struct rt_timer_wheel _soft_timer_wheel;
+#else
 /* soft timer list */
 static rt_list_t _soft_timer_list[RT_TIMER_SKIP_LIST_LEVEL];
 static struct rt_spinlock _stimer_lock;
+#endif /* RT_TIMER_USING_WHEEL */
 static struct rt_thread _timer_thread;
 static struct rt_semaphore _soft_timer_sem;
 rt_align(RT_ALIGN_SIZE)
@@ -92,6 +138,9 @@ void rt_timer_exit_sethook(void (*hook)(struct rt_timer *timer))
 
 rt_inline struct rt_spinlock* _timerlock_idx(struct rt_timer *timer)
 {
+#ifdef RT_TIMER_USING_WHEEL
+    return &timer->wheel->lock;
+#else
 #ifdef RT_USING_TIMER_SOFT
     if (timer->parent.flag & RT_TIMER_FLAG_SOFT_TIMER)
     {
@@ -102,8 +151,204 @@ rt_inline struct rt_spinlock* _timerlock_idx(struct rt_timer *timer)
     {
         return &_htimer_lock;
     }
+#endif /* RT_TIMER_USING_WHEEL */
+}
+
+#ifdef RT_TIMER_USING_WHEEL
+static void _timer_wheel_init(struct rt_timer_wheel *wheel)
+{
+    rt_size_t lvl, idx;
+
+    rt_spin_lock_init(&wheel->lock);
+    wheel->clk = rt_tick_get();
+
+    for (lvl = 0; lvl < RT_TIMER_WHEEL_LEVEL; lvl++)
+    {
+        wheel->bitmap[lvl] = 0;
+        for (idx = 0; idx < RT_TIMER_WHEEL_SIZE; idx++)
+        {
+            rt_list_init(&wheel->slot[lvl][idx]);
+        }
+    }
+}
+
+/**
+ * @brief Hash the timer to a slot of wheel according to its timeout tick
+ *
+ * @note caller must hold the lock of wheel
+ */
+static void _timer_wheel_add(struct rt_timer_wheel *wheel, rt_timer_t timer)
+{
+    unsigned int lvl;
+    unsigned int idx;
+    rt_tick_t expires = timer->timeout_tick;
+    rt_tick_t delta = expires - wheel->clk;
+
+    /* timeout already, let it go on the next tick processed */
+    if (delta >= RT_TICK_MAX / 2)
+    {
+        expires = wheel->clk;
+        delta = 0;
+    }
+
+    for (lvl = 0; lvl < RT_TIMER_WHEEL_LEVEL - 1; lvl++)
+    {
+        if ((delta >> ((lvl + 1) * RT_TIMER_WHEEL_BITS)) == 0)
+            break;
+    }
+
+    idx = (expires >> (lvl * RT_TIMER_WHEEL_BITS)) & RT_TIMER_WHEEL_MASK;
+
+    /* insert to the tail, so timers with the same timeout are called in order */
+    rt_list_insert_before(&wheel->slot[lvl][idx], &(timer->row[0]));
+    wheel->bitmap[lvl] |= 1U << idx;
+}
+
+/**
+ * @brief Remove the timer from wheel, and clear the bit of slot if it's the
+ *        last one there. Timers on the temporary lists of checking routine are
+ *        never hashed, so the slot is found by address.
+ */
+static void _timer_wheel_remove(rt_timer_t timer)
+{
+    rt_list_t *head = timer->row[0].next;
+    struct rt_timer_wheel *wheel = timer->wheel;
+
+    if (head == timer->row[0].prev && head != &(timer->row[0]) &&
+        head >= &wheel->slot[0][0] &&
+        head < &wheel->slot[0][0] + RT_TIMER_WHEEL_LEVEL * RT_TIMER_WHEEL_SIZE)
+    {
+        rt_size_t offset = head - &wheel->slot[0][0];
+
+        wheel->bitmap[offset / RT_TIMER_WHEEL_SIZE] &= ~(1U << (offset % RT_TIMER_WHEEL_SIZE));
+    }
+
+    rt_list_remove(&(timer->row[0]));
 }
 
+/**
+ * @brief Find the next tick when anything happens on wheel, which is either
+ *        the timeout of a timer on level 0, or the cascading of a slot on
+ *        upper levels. So the result is never later than the real timeout.
+ *
+ * @note caller must hold the lock of wheel
+ *
+ * @return RT_EOK if any timer is on wheel, otherwise -RT_ERROR
+ */
+static rt_err_t _timer_wheel_next_timeout(struct rt_timer_wheel *wheel, rt_tick_t *timeout_tick)
+{
+    unsigned int lvl;
+    unsigned int idx;
+    unsigned int shift;
+    rt_uint32_t bits;
+    rt_tick_t base, next;
+    rt_err_t err = -RT_ERROR;
+
+    for (lvl = 0; lvl < RT_TIMER_WHEEL_LEVEL; lvl++)
+    {
+        bits = wheel->bitmap[lvl];
+        if (bits == 0)
+            continue;
+
+        shift = lvl * RT_TIMER_WHEEL_BITS;
+
+        /* the first tick to visit this level, where all lower levels wrap */
+        base = (wheel->clk + (1U << shift) - 1) & ~((1U << shift) - 1);
+        idx = (base >> shift) & RT_TIMER_WHEEL_MASK;
+
+        /* rotate the bitmap, so bit 0 stands for the slot visited on base */
+        if (idx)
+            bits = (bits >> idx) | (bits << (RT_TIMER_WHEEL_SIZE - idx));
+
+        next = base + ((rt_tick_t)(__rt_ffs(bits) - 1) << shift);
+        if (err != RT_EOK || (next - wheel->clk) < (*timeout_tick - wheel->clk))
+        {
+            *timeout_tick = next;
+            err = RT_EOK;
+        }
+    }
+
+    return err;
+}
+
+#ifdef _TIMER_WHEEL_KICK_REMOTE
+/**
+ * @brief Get the cpu of a hard timer wheel other than the one of current cpu.
+ *
+ * @return the cpu id, or -1 if it's the wheel of current cpu or the soft one
+ */
+static int _timer_wheel_remote_cpu(struct rt_timer_wheel *wheel)
+{
+    int cpu;
+
+    if ((rt_ubase_t)wheel < (rt_ubase_t)&_timer_wheel[0] ||
+        (rt_ubase_t)wheel >= (rt_ubase_t)&_timer_wheel[_TIMER_WHEEL_NR])
+    {
+        return -1;
+    }
+
+    cpu = wheel - &_timer_wheel[0];
+    return cpu == _TIMER_WHEEL_CPU_ID() ? -1 : cpu;
+}
+#endif /* _TIMER_WHEEL_KICK_REMOTE */
+
+/**
+ * @brief Process the next tick on wheel which is not later than current_tick,
+ *        and move the timeout timers to the pending list. The ticks when nothing
+ *        happens are skipped.
+ *
+ * @note caller must hold the lock of wheel
+ */
+static void _timer_wheel_advance(struct rt_timer_wheel *wheel, rt_tick_t current_tick, rt_list_t *pending)
+{
+    unsigned int lvl;
+    unsigned int idx;
+    rt_list_t *head;
+    struct rt_timer *t;
+    rt_tick_t next;
+
+    if (_timer_wheel_next_timeout(wheel, &next) != RT_EOK ||
+        (current_tick - next) >= RT_TICK_MAX / 2)
+    {
+        /* nothing happens till current_tick */
+        wheel->clk = current_tick + 1;
+        return;
+    }
+    wheel->clk = next;
+
+    /* cascade the upper levels if all the lower levels wrap */
+    for (lvl = 1; lvl < RT_TIMER_WHEEL_LEVEL; lvl++)
+    {
+        if ((wheel->clk >> ((lvl - 1) * RT_TIMER_WHEEL_BITS)) & RT_TIMER_WHEEL_MASK)
+            break;
+
+        idx = (wheel->clk >> (lvl * RT_TIMER_WHEEL_BITS)) & RT_TIMER_WHEEL_MASK;
+        head = &wheel->slot[lvl][idx];
+        wheel->bitmap[lvl] &= ~(1U << idx);
+
+        while (!rt_list_isempty(head))
+        {
+            t = rt_list_entry(head->next, struct rt_timer, row[0]);
+            rt_list_remove(&(t->row[0]));
+            _timer_wheel_add(wheel, t);
+        }
+    }
+
+    idx = wheel->clk & RT_TIMER_WHEEL_MASK;
+    head = &wheel->slot[0][idx];
+    wheel->bitmap[0] &= ~(1U << idx);
+
+    while (!rt_list_isempty(head))
+    {
+        t = rt_list_entry(head->next, struct rt_timer, row[0]);
+        rt_list_remove(&(t->row[0]));
+        rt_list_insert_before(pending, &(t->row[0]));
+    }
+
+    wheel->clk++;
+}
+#endif /* RT_TIMER_USING_WHEEL */
+
 /**
  * @brief [internal] The init funtion of timer
  *
@@ -146,6 +391,20 @@ static void _timer_init(rt_timer_t timer,
     {
         rt_list_init(&(timer->row[i]));
     }
+
+#ifdef RT_TIMER_USING_WHEEL
+#ifdef RT_USING_TIMER_SOFT
+    if (flag & RT_TIMER_FLAG_SOFT_TIMER)
+    {
+        timer->wheel = &_soft_timer_wheel;
+    }
+    else
+#endif /* RT_USING_TIMER_SOFT */
+    {
+        /* hard timer is always checked on the cpu it's initialized */
+        timer->wheel = &_timer_wheel[_TIMER_WHEEL_CPU_ID()];
+    }
+#endif /* RT_TIMER_USING_WHEEL */
 }
 
 /**
@@ -158,6 +417,7 @@ static void _timer_init(rt_timer_t timer,
  * @return  Return the operation status. If the return value is RT_EOK, the function is successfully executed.
  *          If the return value is any other values, it means this operation failed.
  */
+#ifndef RT_TIMER_USING_WHEEL
 static rt_err_t _timer_list_next_timeout(rt_list_t timer_list[], rt_tick_t *timeout_tick)
 {
     struct rt_timer *timer;
@@ -171,6 +431,7 @@ static rt_err_t _timer_list_next_timeout(rt_list_t timer_list[], rt_tick_t *time
     }
     return -RT_ERROR;
 }
+#endif /* RT_TIMER_USING_WHEEL */
 
 /**
  * @brief Remove the timer
@@ -179,12 +440,16 @@ static rt_err_t _timer_list_next_timeout(rt_list_t timer_list[], rt_tick_t *time
  */
 rt_inline void _timer_remove(rt_timer_t timer)
 {
+#ifdef RT_TIMER_USING_WHEEL
+    _timer_wheel_remove(timer);
+#else
     int i;
 
     for (i = 0; i < RT_TIMER_SKIP_LIST_LEVEL; i++)
     {
         rt_list_remove(&timer->row[i]);
     }
+#endif /* RT_TIMER_USING_WHEEL */
 }
 
 #if (DBG_LVL == DBG_LOG)
@@ -388,6 +653,40 @@ rt_err_t rt_timer_delete(rt_timer_t timer)
 RTM_EXPORT(rt_timer_delete);
 #endif /* RT_USING_HEAP */
 
+#ifdef RT_TIMER_USING_WHEEL
+/**
+ * @brief This function will start the timer
+ *
+ * @param wheel the timing wheel of timer
+ *
+ * @param timer the timer to be started
+ *
+ * @return the operation status, RT_EOK on OK, -RT_ERROR on error
+ */
+static rt_err_t _timer_start(struct rt_timer_wheel *wheel, rt_timer_t timer)
+{
+    if (timer->parent.flag & RT_TIMER_FLAG_PROCESSING)
+    {
+        return -RT_ERROR;
+    }
+
+    /* remove timer from wheel */
+    _timer_remove(timer);
+    /* change status of timer */
+    timer->parent.flag &= ~RT_TIMER_FLAG_ACTIVATED;
+
+    RT_OBJECT_HOOK_CALL(rt_object_take_hook, (&(timer->parent)));
+
+    timer->timeout_tick = rt_tick_get() + timer->init_tick;
+    _timer_wheel_add(wheel, timer);
+
+    timer->parent.flag |= RT_TIMER_FLAG_ACTIVATED;
+
+    return RT_EOK;
+}
+
+#else
+
 /**
  * @brief This function will start the timer
  *
@@ -471,6 +770,7 @@ static rt_err_t _timer_start(rt_list_t *timer_list, rt_timer_t timer)
 
     return RT_EOK;
 }
+#endif /* RT_TIMER_USING_WHEEL */
 
 /**
  * @brief This function will start the timer
@@ -484,7 +784,17 @@ rt_err_t rt_timer_start(rt_timer_t timer)
     rt_sched_lock_level_t slvl;
     int is_thread_timer = 0;
     struct rt_spinlock *spinlock;
+#ifdef RT_TIMER_USING_WHEEL
+    struct rt_timer_wheel *timer_list;
+#else
     rt_list_t *timer_list;
+#endif /* RT_TIMER_USING_WHEEL */
+#ifdef _TIMER_WHEEL_KICK_REMOTE
+    int remote_cpu;
+    rt_bool_t kick = RT_FALSE;
+    rt_tick_t next_before, next_after;
+    rt_err_t has_timer;
+#endif /* _TIMER_WHEEL_KICK_REMOTE */
     rt_base_t level;
     rt_err_t err;
 
@@ -492,6 +802,10 @@ rt_err_t rt_timer_start(rt_timer_t timer)
     RT_ASSERT(timer != RT_NULL);
     RT_ASSERT(rt_object_get_type(&timer->parent) == RT_Object_Class_Timer);
 
+#ifdef RT_TIMER_USING_WHEEL
+    timer_list = timer->wheel;
+    spinlock = &timer->wheel->lock;
+#else
 #ifdef RT_USING_TIMER_SOFT
     if (timer->parent.flag & RT_TIMER_FLAG_SOFT_TIMER)
     {
@@ -504,6 +818,7 @@ rt_err_t rt_timer_start(rt_timer_t timer)
         timer_list = _timer_list;
         spinlock = &_htimer_lock;
     }
+#endif /* RT_TIMER_USING_WHEEL */
 
     if (timer->parent.flag & RT_TIMER_FLAG_THREAD_TIMER)
     {
@@ -518,8 +833,25 @@ rt_err_t rt_timer_start(rt_timer_t timer)
 
     level = rt_spin_lock_irqsave(spinlock);
 
+#ifdef _TIMER_WHEEL_KICK_REMOTE
+    remote_cpu = _timer_wheel_remote_cpu(timer_list);
+    if (remote_cpu >= 0)
+    {
+        has_timer = _timer_wheel_next_timeout(timer_list, &next_before);
+    }
+#endif /* _TIMER_WHEEL_KICK_REMOTE */
+
     err = _timer_start(timer_list, timer);
 
+#ifdef _TIMER_WHEEL_KICK_REMOTE
+    /* the remote cpu has to re-arm its tick if the earliest timeout changed */
+    if (err == RT_EOK && remote_cpu >= 0)
+    {
+        _timer_wheel_next_timeout(timer_list, &next_after);
+        kick = has_timer != RT_EOK || next_after != next_before;
+    }
+#endif /* _TIMER_WHEEL_KICK_REMOTE */
+
 #ifdef RT_USING_TIMER_SOFT
     if (err == RT_EOK && (timer->parent.flag & RT_TIMER_FLAG_SOFT_TIMER))
     {
@@ -529,6 +861,13 @@ rt_err_t rt_timer_start(rt_timer_t timer)
 
     rt_spin_unlock_irqrestore(spinlock, level);
 
+#ifdef _TIMER_WHEEL_KICK_REMOTE
+    if (kick)
+    {
+        rt_hw_ipi_send(RT_SCHEDULE_IPI, 1U << remote_cpu);
+    }
+#endif /* _TIMER_WHEEL_KICK_REMOTE */
+
     if (is_thread_timer)
     {
         rt_sched_unlock(slvl);
@@ -661,6 +1000,118 @@ rt_err_t rt_timer_control(rt_timer_t timer, int cmd, void *arg)
 }
 RTM_EXPORT(rt_timer_control);
 
+#ifdef RT_TIMER_USING_WHEEL
+/**
+ * @brief Process all the ticks on wheel till now, and invoke the timeout
+ *        function of timers expired.
+ *
+ * @param wheel the timing wheel to be checked
+ */
+static void _timer_wheel_check(struct rt_timer_wheel *wheel)
+{
+    struct rt_timer *t;
+    rt_tick_t current_tick;
+    rt_base_t level;
+    rt_list_t pending;
+    rt_list_t list;
+
+    rt_list_init(&pending);
+    rt_list_init(&list);
+
+    level = rt_spin_lock_irqsave(&wheel->lock);
+
+    current_tick = rt_tick_get();
+
+    while ((current_tick - wheel->clk) < RT_TICK_MAX / 2)
+    {
+        _timer_wheel_advance(wheel, current_tick, &pending);
+
+        while (!rt_list_isempty(&pending))
+        {
+            t = rt_list_entry(pending.next, struct rt_timer, row[0]);
+
+            RT_OBJECT_HOOK_CALL(rt_timer_enter_hook, (t));
+
+            /* remove timer from pending list firstly */
+            _timer_remove(t);
+            if (!(t->parent.flag & RT_TIMER_FLAG_PERIODIC))
+            {
+                t->parent.flag &= ~RT_TIMER_FLAG_ACTIVATED;
+            }
+
+            t->parent.flag |= RT_TIMER_FLAG_PROCESSING;
+            /* add timer to temporary list  */
+            rt_list_insert_after(&list, &(t->row[0]));
+            rt_spin_unlock_irqrestore(&wheel->lock, level);
+            /* call timeout function */
+            t->timeout_func(t->parameter);
+
+            RT_OBJECT_HOOK_CALL(rt_timer_exit_hook, (t));
+            level = rt_spin_lock_irqsave(&wheel->lock);
+
+            t->parent.flag &= ~RT_TIMER_FLAG_PROCESSING;
+
+            /* Check whether the timer object is detached or started again */
+            if (rt_list_isempty(&list))
+            {
+                continue;
+            }
+            rt_list_remove(&(t->row[0]));
+            if ((t->parent.flag & RT_TIMER_FLAG_PERIODIC) &&
+                (t->parent.flag & RT_TIMER_FLAG_ACTIVATED))
+            {
+                /* start it */
+                t->parent.flag &= ~RT_TIMER_FLAG_ACTIVATED;
+                _timer_start(wheel, t);
+            }
+        }
+
+        /* re-get tick */
+        current_tick = rt_tick_get();
+    }
+
+    rt_spin_unlock_irqrestore(&wheel->lock, level);
+}
+
+/**
+ * @brief This function will check timer wheel of current cpu, if a timeout
+ *        event happens, the corresponding timeout function will be invoked.
+ *
+ * @note This function shall be invoked in operating system timer interrupt.
+ */
+void rt_timer_check(void)
+{
+    RT_ASSERT(rt_interrupt_get_nest() > 0);
+
+    LOG_D("timer check enter");
+    _timer_wheel_check(&_timer_wheel[_TIMER_WHEEL_CPU_ID()]);
+    LOG_D("timer check leave");
+}
+
+/**
+ * @brief This function will return the next timeout tick of current cpu. The
+ *        tick returned is never later than the real timeout.
+ *
+ * @return the next timeout tick in the system
+ */
+rt_tick_t rt_timer_next_timeout_tick(void)
+{
+    rt_base_t level;
+    rt_tick_t next_timeout = RT_TICK_MAX;
+    struct rt_timer_wheel *wheel;
+
+    level = rt_hw_local_irq_disable();
+    wheel = &_timer_wheel[_TIMER_WHEEL_CPU_ID()];
+    rt_spin_lock(&wheel->lock);
+    _timer_wheel_next_timeout(wheel, &next_timeout);
+    rt_spin_unlock(&wheel->lock);
+    rt_hw_local_irq_enable(level);
+
+    return next_timeout;
+}
+
+#else
+
 /**
  * @brief This function will check timer list, if a timeout event happens,
  *        the corresponding timeout function will be invoked.
@@ -765,6 +1216,7 @@ rt_tick_t rt_timer_next_timeout_tick(void)
 
     return next_timeout;
 }
+#endif /* RT_TIMER_USING_WHEEL */
 
 #ifdef RT_USING_TIMER_SOFT
 /**
@@ -773,6 +1225,11 @@ rt_tick_t rt_timer_next_timeout_tick(void)
  */
 static void _soft_timer_check(void)
 {
+#ifdef RT_TIMER_USING_WHEEL
+    LOG_D("software timer check enter");
+    _timer_wheel_check(&_soft_timer_wheel);
+    LOG_D("software timer check leave");
+#else
     rt_tick_t current_tick;
     struct rt_timer *t;
     rt_base_t level;
@@ -840,6 +1297,7 @@ static void _soft_timer_check(void)
     rt_spin_unlock_irqrestore(&_stimer_lock, level);
 
     LOG_D("software timer check leave");
+#endif /* RT_TIMER_USING_WHEEL */
 }
 
 /**
@@ -860,9 +1318,15 @@ static void _timer_thread_entry(void *parameter)
     while (1)
     {
         /* get the next timeout tick */
+#ifdef RT_TIMER_USING_WHEEL
+        level = rt_spin_lock_irqsave(&_soft_timer_wheel.lock);
+        ret = _timer_wheel_next_timeout(&_soft_timer_wheel, &next_timeout);
+        rt_spin_unlock_irqrestore(&_soft_timer_wheel.lock, level);
+#else
         level = rt_spin_lock_irqsave(&_stimer_lock);
         ret = _timer_list_next_timeout(_soft_timer_list, &next_timeout);
         rt_spin_unlock_irqrestore(&_stimer_lock, level);
+#endif /* RT_TIMER_USING_WHEEL */
 
         if (ret != RT_EOK)
         {
@@ -898,11 +1362,18 @@ void rt_system_timer_init(void)
 {
     rt_size_t i;
 
+#ifdef RT_TIMER_USING_WHEEL
+    for (i = 0; i < _TIMER_WHEEL_NR; i++)
+    {
+        _timer_wheel_init(&_timer_wheel[i]);
+    }
+#else
     for (i = 0; i < sizeof(_timer_list) / sizeof(_timer_list[0]); i++)
     {
         rt_list_init(_timer_list + i);
     }
     rt_spin_lock_init(&_htimer_lock);
+#endif /* RT_TIMER_USING_WHEEL */
 }
 
 /**
@@ -913,6 +1384,9 @@ void rt_system_timer_init(void)
 void rt_system_timer_thread_init(void)
 {
 #ifdef RT_USING_TIMER_SOFT
+#ifdef RT_TIMER_USING_WHEEL
+    _timer_wheel_init(&_soft_timer_wheel);
+#else
     int i;
 
     for (i = 0;
@@ -922,6 +1396,7 @@ void rt_system_timer_thread_init(void)
         rt_list_init(_soft_timer_list + i);
     }
     rt_spin_lock_init(&_stimer_lock);
+#endif /* RT_TIMER_USING_WHEEL */
     rt_sem_init(&_soft_timer_sem, "stimer", 0, RT_IPC_FLAG_PRIO);
     /* start software timer thread */
     rt_thread_init(&_timer_thread,
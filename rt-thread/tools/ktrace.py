@@ -0,0 +1,241 @@
+#!/usr/bin/env python
+#
+# Copyright (c) 2006-2026, RT-Thread Development Team
+#
+# SPDX-License-Identifier: Apache-2.0
+#
+# Change Logs:
+# Date           Author       Notes
+# 2026-10-17     agent        first version
+#
+# Decode the dumps of components/utilities/ktrace, either the binary file
+# written by 'ktrace dump <file>' or the console output of 'ktrace dump',
+# into Chrome/Perfetto trace JSON and wakeup latency histograms.
+
+import sys
+import json
+import struct
+import argparse
+
+KTRACE_MAGIC = 0x4352544b
+
+EVENT_SWITCH = 1
+EVENT_IRQ_ENTER = 2
+EVENT_IRQ_LEAVE = 3
+EVENT_SUSPEND = 4
+EVENT_WAKEUP = 5
+EVENT_OBJ_TRYTAKE = 6
+EVENT_OBJ_TAKE = 7
+EVENT_OBJ_PUT = 8
+
+OBJ_EVENT_NAMES = {
+    EVENT_OBJ_TRYTAKE: 'trytake',
+    EVENT_OBJ_TAKE: 'take',
+    EVENT_OBJ_PUT: 'put',
+}
+
+class Record(object):
+    __slots__ = ('cpu', 'seq', 'ts', 'event', 'arg0', 'arg1', 'prio')
+
+    def __init__(self, cpu, seq, ts, event, arg0, arg1, prio):
+        self.cpu = cpu
+        self.seq = seq
+        self.ts = ts
+        self.event = event
+        self.arg0 = arg0
+        self.arg1 = arg1
+        self.prio = prio
+
+class Trace(object):
+    def __init__(self):
+        self.resolution = 0     # nanoseconds per timestamp unit, x 1000000
+        self.records = []
+        self.names = {}
+
+    def to_us(self, ts):
+        return ts * self.resolution / 1000000.0 / 1000.0
+
+    def thread_name(self, thread):
+        if thread == 0:
+            return 'irq'
+        return self.names.get(thread, '%#x' % thread)
+
+def load_binary(data):
+    trace = Trace()
+    endian = '<'
+    magic, = struct.unpack_from('<I', data, 0)
+    if magic != KTRACE_MAGIC:
+        endian = '>'
+        magic, = struct.unpack_from('>I', data, 0)
+        if magic != KTRACE_MAGIC:
+            raise ValueError('not a ktrace dump')
+
+    header = struct.Struct(endian + 'IHHHHHHQ')
+    (_, version, cpus, record_size, ptr_size, name_size, _,
+     trace.resolution) = header.unpack_from(data, 0)
+    offset = header.size
+
+    ptr = 'Q' if ptr_size == 8 else 'I'
+    record = struct.Struct(endian + 'Q' + ptr + ptr + 'HBBI')
+
+    for _ in range(cpus):
+        cpu, count = struct.unpack_from(endian + 'II', data, offset)
+        offset += 8
+        for _ in range(count):
+            ts, arg0, arg1, event, rcpu, prio, seq = record.unpack_from(data, offset)
+            trace.records.append(Record(rcpu, seq, ts, event, arg0, arg1, prio))
+            offset += record_size
+
+    count, = struct.unpack_from(endian + 'I', data, offset)
+    offset += 4
+    entry_size = ptr_size + name_size
+    # the entries are padded to the alignment of a pointer
+    entry_size = (entry_size + ptr_size - 1) // ptr_size * ptr_size
+    for _ in range(count):
+        thread, = struct.unpack_from(endian + ptr, data, offset)
+        name = data[offset + ptr_size:offset + ptr_size + name_size]
+        trace.names[thread] = name.split(b'\0')[0].decode('ascii', 'replace')
+        offset += entry_size
+
+    return trace
+
+def load_text(lines):
+    trace = Trace()
+    for line in lines:
+        fields = line.split()
+        # the console may prefix the lines with the msh prompt or log tags
+        for start, field in enumerate(fields):
+            if field in ('KH', 'KT', 'KN'):
+                fields = fields[start:]
+                break
+        else:
+            continue
+
+        if fields[0] == 'KH':
+            trace.resolution = int(fields[3], 16)
+        elif fields[0] == 'KT' and len(fields) >= 8:
+            trace.records.append(Record(int(fields[1]), int(fields[2]), int(fields[3], 16),
+                                        int(fields[4]), int(fields[5], 16),
+                                        int(fields[6], 16), int(fields[7])))
+        elif fields[0] == 'KN' and len(fields) >= 2:
+            trace.names[int(fields[1], 16)] = fields[2] if len(fields) > 2 else ''
+
+    return trace
+
+def load(path):
+    with open(path, 'rb') as f:
+        data = f.read()
+
+    if len(data) >= 4 and struct.unpack_from('<I', data, 0)[0] in (KTRACE_MAGIC, 0x4b545243):
+        return load_binary(data)
+
+    return load_text(data.decode('ascii', 'replace').splitlines())
+
+def chrome_trace(trace):
+    events = []
+    records = sorted(trace.records, key=lambda r: (r.ts, r.cpu, r.seq))
+    running = {}        # cpu -> (thread, start)
+    irq_depth = {}
+
+    for r in records:
+        ts = trace.to_us(r.ts)
+        if r.event == EVENT_SWITCH:
+            prev = running.get(r.cpu)
+            if prev is not None:
+                events.append({'name': trace.thread_name(prev[0]), 'ph': 'X', 'pid': 0,
+                               'tid': 'cpu%d' % r.cpu, 'ts': prev[1], 'dur': ts - prev[1],
+                               'args': {'thread': '%#x' % prev[0]}})
+            running[r.cpu] = (r.arg1, ts)
+        elif r.event == EVENT_IRQ_ENTER:
+            irq_depth[r.cpu] = irq_depth.get(r.cpu, 0) + 1
+            events.append({'name': 'irq', 'ph': 'B', 'pid': 1, 'tid': 'cpu%d irq' % r.cpu,
+                           'ts': ts, 'args': {'nest': r.arg0}})
+        elif r.event == EVENT_IRQ_LEAVE:
+            # drop the leave events whose enter was overwritten in the ring
+            if irq_depth.get(r.cpu, 0) > 0:
+                irq_depth[r.cpu] -= 1
+                events.append({'name': 'irq', 'ph': 'E', 'pid': 1, 'tid': 'cpu%d irq' % r.cpu,
+                               'ts': ts})
+        elif r.event == EVENT_SUSPEND:
+            events.append({'name': 'suspend %s' % trace.thread_name(r.arg0), 'ph': 'i', 's': 't',
+                           'pid': 0, 'tid': 'cpu%d' % r.cpu, 'ts': ts})
+        elif r.event == EVENT_WAKEUP:
+            events.append({'name': 'wakeup %s' % trace.thread_name(r.arg0), 'ph': 'i', 's': 't',
+                           'pid': 0, 'tid': 'cpu%d' % r.cpu, 'ts': ts,
+                           'args': {'waker': trace.thread_name(r.arg1), 'prio': r.prio}})
+        elif r.event in OBJ_EVENT_NAMES:
+            events.append({'name': '%s %#x' % (OBJ_EVENT_NAMES[r.event], r.arg0), 'ph': 'i',
+                           's': 't', 'pid': 2, 'tid': 'cpu%d ipc' % r.cpu, 'ts': ts,
+                           'args': {'type': r.arg1}})
+
+    metadata = [
+        {'name': 'process_name', 'ph': 'M', 'pid': 0, 'args': {'name': 'threads'}},
+        {'name': 'process_name', 'ph': 'M', 'pid': 1, 'args': {'name': 'interrupts'}},
+        {'name': 'process_name', 'ph': 'M', 'pid': 2, 'args': {'name': 'ipc'}},
+    ]
+    return {'traceEvents': metadata + events, 'displayTimeUnit': 'ns'}
+
+def wakeup_latencies(trace):
+    '''The time from a thread being made ready to it being switched in.'''
+    records = sorted(trace.records, key=lambda r: (r.ts, r.cpu, r.seq))
+    pending = {}
+    latencies = {}
+
+    for r in records:
+        if r.event == EVENT_WAKEUP:
+            pending.setdefault(r.arg0, r.ts)
+        elif r.event == EVENT_SWITCH and r.arg1 in pending:
+            start = pending.pop(r.arg1)
+            latencies.setdefault(r.arg1, []).append(trace.to_us(r.ts - start))
+
+    return latencies
+
+def print_histogram(trace, latencies, out):
+    samples = [v for values in latencies.values() for v in values]
+    if not samples:
+        out.write('no wakeup latency samples\n')
+        return
+
+    def show(title, values):
+        values = sorted(values)
+        out.write('%s: %d samples, min %.2f us, avg %.2f us, p99 %.2f us, max %.2f us\n' % (
+            title, len(values), values[0], sum(values) / len(values),
+            values[min(len(values) - 1, int(len(values) * 0.99))], values[-1]))
+
+        buckets = {}
+        for v in values:
+            bound = 1
+            while v > bound:
+                bound *= 2
+            buckets[bound] = buckets.get(bound, 0) + 1
+
+        peak = max(buckets.values())
+        for bound in sorted(buckets):
+            bar = '#' * max(1, buckets[bound] * 50 // peak)
+            out.write('  <= %8d us %8d %s\n' % (bound, buckets[bound], bar))
+
+    show('all threads', samples)
+    for thread in sorted(latencies, key=lambda t: trace.thread_name(t)):
+        show(trace.thread_name(thread), latencies[thread])
+
+def main():
+    parser = argparse.ArgumentParser(description='decode the dumps of RT-Thread ktrace')
+    parser.add_argument('dump', help='binary dump file or captured console output')
+    parser.add_argument('-o', '--output', help='write Chrome/Perfetto trace JSON to this file')
+    parser.add_argument('--hist', action='store_true', help='print wakeup latency histograms')
+    args = parser.parse_args()
+
+    trace = load(args.dump)
+    if trace.resolution == 0:
+        sys.stderr.write('warning: no ktrace header, timestamps are not scaled\n')
+        trace.resolution = 1000 * 1000 * 1000
+
+    if args.output:
+        with open(args.output, 'w') as f:
+            json.dump(chrome_trace(trace), f)
+
+    if args.hist or not args.output:
+        print_histogram(trace, wakeup_latencies(trace), sys.stdout)
+
+if __name__ == '__main__':
+    main()